@@ -21,6 +21,7 @@
 #include "array.h"
 #include "condition_variable.h"
 #include "dstrings.h"
+#include <dlib/memory.h>
 #include <dlib/mutex.h>
 #include <dlib/static_assert.h>
 #include <dlib/spinlock.h>
@@ -41,6 +42,13 @@ namespace dmMessage
         MemoryPage* m_NextPage;
     };
 
+    // Messages that don't fit in a page get an allocation of their own
+    struct LargeMessage
+    {
+        LargeMessage*           m_Next;
+        uint8_t DM_ALIGNED(16)  m_Memory[0];
+    };
+
     struct MemoryAllocator
     {
         MemoryAllocator()
@@ -48,10 +56,12 @@ namespace dmMessage
             m_CurrentPage = 0;
             m_FreePages = 0;
             m_FullPages = 0;
+            m_LargeMessages = 0;
         }
-        MemoryPage* m_CurrentPage;
-        MemoryPage* m_FreePages;
-        MemoryPage* m_FullPages;
+        MemoryPage*   m_CurrentPage;
+        MemoryPage*   m_FreePages;
+        MemoryPage*   m_FullPages;
+        LargeMessage* m_LargeMessages;
     };
 
     struct GlobalInit
@@ -97,7 +107,18 @@ namespace dmMessage
         // At least ALIGNMENT bytes alignment of size in order to ensure that the next allocation is aligned
         size += DM_MESSAGE_ALIGNMENT-1;
         size &= ~(DM_MESSAGE_ALIGNMENT-1);
-        assert(size <= DM_MESSAGE_PAGE_SIZE);
+
+        if (size > DM_MESSAGE_PAGE_SIZE)
+        {
+            LargeMessage* large_message = 0;
+            if (dmMemory::AlignedMalloc((void**)&large_message, DM_MESSAGE_ALIGNMENT, sizeof(LargeMessage) + size) != dmMemory::RESULT_OK)
+            {
+                return 0;
+            }
+            large_message->m_Next = allocator->m_LargeMessages;
+            allocator->m_LargeMessages = large_message;
+            return &large_message->m_Memory[0];
+        }
 
         if (allocator->m_CurrentPage == 0 || (DM_MESSAGE_PAGE_SIZE-allocator->m_CurrentPage->m_Current) < size)
         {
@@ -111,6 +132,16 @@ namespace dmMessage
         return ret;
     }
 
+    static void FreeLargeMessages(LargeMessage* large_message)
+    {
+        while (large_message)
+        {
+            LargeMessage* next = large_message->m_Next;
+            dmMemory::AlignedFree(large_message);
+            large_message = next;
+        }
+    }
+
     struct MessageSocket
     {
         uint32_t        m_RefCount; // Is protected by "g_MessageContext->m_Spinlock"
@@ -228,6 +259,7 @@ namespace dmMessage
         {
             delete s->m_Allocator.m_CurrentPage;
         }
+        FreeLargeMessages(s->m_Allocator.m_LargeMessages);
 
         dmConditionVariable::Delete(s->m_Condition);
 
@@ -421,6 +453,12 @@ namespace dmMessage
         MemoryAllocator* allocator = &s->m_Allocator;
         uint32_t data_size = sizeof(Message) + message_data_size;
         Message *new_message = (Message *) AllocateMessage(allocator, data_size);
+        if (new_message == 0)
+        {
+            dmMutex::Unlock(s->m_Mutex);
+            ReleaseSocket(s);
+            return RESULT_SOCKET_OUT_OF_RESOURCES;
+        }
         if (sender != 0x0)
         {
             new_message->m_Sender = *sender;
@@ -533,6 +571,8 @@ namespace dmMessage
         // Unlink full pages
         MemoryPage* full_pages = allocator->m_FullPages;
         allocator->m_FullPages = 0;
+        LargeMessage* large_messages = allocator->m_LargeMessages;
+        allocator->m_LargeMessages = 0;
 
         dmMutex::Unlock(s->m_Mutex);
 
@@ -558,6 +598,8 @@ namespace dmMessage
         }
         dmMutex::Unlock(s->m_Mutex);
 
+        FreeLargeMessages(large_messages);
+
         ReleaseSocket(s);
 
         return dispatch_count;
@@ -0,0 +1,288 @@
+// Copyright 2020-2022 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "size_class_allocator.h"
+#include "memory.h"
+
+namespace dmSizeClassAllocator
+{
+    static const uint32_t PAGE_SIZE = 16 * 1024;
+    static const uint32_t BLOCK_ALIGNMENT = 16;
+
+    static const uint16_t SIZE_CLASSES[MAX_SIZE_CLASSES] = {
+        16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512
+    };
+
+    struct Page
+    {
+        Page*    m_Prev;
+        Page*    m_Next;
+        void*    m_FreeList;
+        uint32_t m_UsedCount;
+        uint32_t m_Untouched;   // Offset of the first block that has never been handed out
+    };
+
+    static const uint32_t PAGE_HEADER_SIZE = (sizeof(Page) + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+
+    struct SizeClass
+    {
+        Page*    m_Pages;       // Pages with at least one free block
+        Page*    m_EmptyPage;   // An empty page kept to avoid page churn at the boundary
+        uint32_t m_Size;
+        uint32_t m_BlocksPerPage;
+        uint32_t m_LiveCount;
+        uint32_t m_AllocationCount;
+        uint32_t m_PageCount;
+    };
+
+    struct Allocator
+    {
+        SizeClass m_SizeClasses[MAX_SIZE_CLASSES];
+        uint8_t   m_SizeToClass[MAX_SMALL_SIZE / BLOCK_ALIGNMENT + 1];
+        uint64_t  m_LargeLiveBytes;
+        uint32_t  m_LargeLiveCount;
+        uint32_t  m_LargeAllocationCount;
+    };
+
+    HAllocator New()
+    {
+        Allocator* allocator = new Allocator;
+        memset(allocator, 0, sizeof(*allocator));
+
+        uint32_t size_class = 0;
+        for (uint32_t i = 0; i < MAX_SIZE_CLASSES; ++i)
+        {
+            SizeClass* c = &allocator->m_SizeClasses[i];
+            c->m_Size = SIZE_CLASSES[i];
+            c->m_BlocksPerPage = (PAGE_SIZE - PAGE_HEADER_SIZE) / c->m_Size;
+        }
+        for (uint32_t i = 0; i <= MAX_SMALL_SIZE / BLOCK_ALIGNMENT; ++i)
+        {
+            while (SIZE_CLASSES[size_class] < i * BLOCK_ALIGNMENT)
+                ++size_class;
+            allocator->m_SizeToClass[i] = (uint8_t) size_class;
+        }
+        return allocator;
+    }
+
+    void Delete(HAllocator allocator)
+    {
+        for (uint32_t i = 0; i < MAX_SIZE_CLASSES; ++i)
+        {
+            SizeClass* c = &allocator->m_SizeClasses[i];
+            Page* page = c->m_Pages;
+            while (page)
+            {
+                Page* next = page->m_Next;
+                dmMemory::AlignedFree(page);
+                page = next;
+            }
+            if (c->m_EmptyPage)
+                dmMemory::AlignedFree(c->m_EmptyPage);
+            // Full pages are not linked anywhere, they are only freed if the user freed their blocks
+        }
+        delete allocator;
+    }
+
+    static inline void LinkPage(SizeClass* c, Page* page)
+    {
+        page->m_Prev = 0;
+        page->m_Next = c->m_Pages;
+        if (c->m_Pages)
+            c->m_Pages->m_Prev = page;
+        c->m_Pages = page;
+    }
+
+    static inline void UnlinkPage(SizeClass* c, Page* page)
+    {
+        if (page->m_Prev)
+            page->m_Prev->m_Next = page->m_Next;
+        else
+            c->m_Pages = page->m_Next;
+        if (page->m_Next)
+            page->m_Next->m_Prev = page->m_Prev;
+        page->m_Prev = 0;
+        page->m_Next = 0;
+    }
+
+    static Page* NewPage(SizeClass* c)
+    {
+        Page* page = c->m_EmptyPage;
+        if (page)
+        {
+            c->m_EmptyPage = 0;
+            return page;
+        }
+
+        void* memory = 0;
+        if (dmMemory::AlignedMalloc(&memory, PAGE_SIZE, PAGE_SIZE) != dmMemory::RESULT_OK)
+            return 0;
+
+        page = (Page*) memory;
+        page->m_Prev = 0;
+        page->m_Next = 0;
+        page->m_FreeList = 0;
+        page->m_UsedCount = 0;
+        page->m_Untouched = PAGE_HEADER_SIZE;
+        c->m_PageCount++;
+        return page;
+    }
+
+    static inline Page* GetPage(void* ptr)
+    {
+        return (Page*) ((uintptr_t) ptr & ~(uintptr_t) (PAGE_SIZE - 1));
+    }
+
+    static void* AllocLarge(HAllocator allocator, uint32_t size)
+    {
+        void* ptr = malloc(size);
+        if (ptr)
+        {
+            allocator->m_LargeLiveBytes += size;
+            allocator->m_LargeLiveCount++;
+            allocator->m_LargeAllocationCount++;
+        }
+        return ptr;
+    }
+
+    static void FreeLarge(HAllocator allocator, void* ptr, uint32_t size)
+    {
+        allocator->m_LargeLiveBytes -= size;
+        allocator->m_LargeLiveCount--;
+        free(ptr);
+    }
+
+    void* Alloc(HAllocator allocator, uint32_t size)
+    {
+        assert(size > 0);
+        if (size > MAX_SMALL_SIZE)
+            return AllocLarge(allocator, size);
+
+        SizeClass* c = &allocator->m_SizeClasses[allocator->m_SizeToClass[(size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT]];
+        Page* page = c->m_Pages;
+        if (!page)
+        {
+            page = NewPage(c);
+            if (!page)
+                return 0;
+            LinkPage(c, page);
+        }
+
+        void* block = page->m_FreeList;
+        if (block)
+        {
+            page->m_FreeList = *(void**) block;
+        }
+        else
+        {
+            block = (uint8_t*) page + page->m_Untouched;
+            page->m_Untouched += c->m_Size;
+        }
+
+        if (++page->m_UsedCount == c->m_BlocksPerPage)
+            UnlinkPage(c, page);
+
+        c->m_LiveCount++;
+        c->m_AllocationCount++;
+        return block;
+    }
+
+    void Free(HAllocator allocator, void* ptr, uint32_t size)
+    {
+        if (!ptr)
+            return;
+        if (size > MAX_SMALL_SIZE)
+        {
+            FreeLarge(allocator, ptr, size);
+            return;
+        }
+
+        SizeClass* c = &allocator->m_SizeClasses[allocator->m_SizeToClass[(size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT]];
+        Page* page = GetPage(ptr);
+        if (page->m_UsedCount == c->m_BlocksPerPage)
+            LinkPage(c, page);
+
+        *(void**) ptr = page->m_FreeList;
+        page->m_FreeList = ptr;
+        c->m_LiveCount--;
+
+        if (--page->m_UsedCount == 0)
+        {
+            UnlinkPage(c, page);
+            if (c->m_EmptyPage)
+            {
+                dmMemory::AlignedFree(page);
+                c->m_PageCount--;
+            }
+            else
+            {
+                c->m_EmptyPage = page;
+            }
+        }
+    }
+
+    void* Realloc(HAllocator allocator, void* ptr, uint32_t old_size, uint32_t new_size)
+    {
+        if (!ptr)
+            return new_size ? Alloc(allocator, new_size) : 0;
+        if (new_size == 0)
+        {
+            Free(allocator, ptr, old_size);
+            return 0;
+        }
+
+        if (old_size > MAX_SMALL_SIZE && new_size > MAX_SMALL_SIZE)
+        {
+            void* new_ptr = realloc(ptr, new_size);
+            if (new_ptr)
+            {
+                allocator->m_LargeLiveBytes += (int64_t) new_size - (int64_t) old_size;
+                allocator->m_LargeAllocationCount++;
+            }
+            return new_ptr;
+        }
+
+        if (old_size <= MAX_SMALL_SIZE && new_size <= MAX_SMALL_SIZE &&
+            allocator->m_SizeToClass[(old_size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT] == allocator->m_SizeToClass[(new_size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT])
+        {
+            return ptr;
+        }
+
+        void* new_ptr = Alloc(allocator, new_size);
+        if (!new_ptr)
+            return 0;
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        Free(allocator, ptr, old_size);
+        return new_ptr;
+    }
+
+    void GetStats(HAllocator allocator, Stats* stats)
+    {
+        for (uint32_t i = 0; i < MAX_SIZE_CLASSES; ++i)
+        {
+            const SizeClass* c = &allocator->m_SizeClasses[i];
+            SizeClassStats* s = &stats->m_SizeClasses[i];
+            s->m_Size = c->m_Size;
+            s->m_LiveCount = c->m_LiveCount;
+            s->m_AllocationCount = c->m_AllocationCount;
+            s->m_PageCount = c->m_PageCount;
+        }
+        stats->m_LargeLiveBytes = allocator->m_LargeLiveBytes;
+        stats->m_LargeLiveCount = allocator->m_LargeLiveCount;
+        stats->m_LargeAllocationCount = allocator->m_LargeAllocationCount;
+    }
+}
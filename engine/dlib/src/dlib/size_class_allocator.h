@@ -0,0 +1,99 @@
+// Copyright 2020-2022 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SIZE_CLASS_ALLOCATOR_H
+#define DM_SIZE_CLASS_ALLOCATOR_H
+
+#include <stdint.h>
+
+namespace dmSizeClassAllocator
+{
+    /**
+     * Size class allocator handle. Small allocations are served from pages of equally sized
+     * blocks, one set of pages per size class. Larger allocations fall through to malloc.
+     * The caller passes the size of a block when it is freed or reallocated, as with a lua_Alloc.
+     * All blocks are 16 byte aligned. The allocator is not thread safe.
+     */
+    typedef struct Allocator* HAllocator;
+
+    /// Largest allocation served from a size class
+    const uint32_t MAX_SMALL_SIZE = 512;
+
+    /// Number of size classes
+    const uint32_t MAX_SIZE_CLASSES = 16;
+
+    struct SizeClassStats
+    {
+        uint32_t m_Size;            //!< Block size of the class
+        uint32_t m_LiveCount;       //!< Number of allocated blocks
+        uint32_t m_AllocationCount; //!< Total number of allocations since the allocator was created
+        uint32_t m_PageCount;       //!< Number of pages held by the class
+    };
+
+    struct Stats
+    {
+        SizeClassStats m_SizeClasses[MAX_SIZE_CLASSES];
+        uint64_t       m_LargeLiveBytes;        //!< Bytes allocated through malloc
+        uint32_t       m_LargeLiveCount;        //!< Number of blocks allocated through malloc
+        uint32_t       m_LargeAllocationCount;  //!< Total number of malloc allocations
+    };
+
+    /**
+     * Create a new allocator
+     * @return allocator handle
+     */
+    HAllocator New();
+
+    /**
+     * Delete allocator and free all pages. Blocks allocated through malloc that are still
+     * live are not freed.
+     * @param allocator allocator handle
+     */
+    void Delete(HAllocator allocator);
+
+    /**
+     * Allocate memory
+     * @param allocator allocator handle
+     * @param size size in bytes, must be > 0
+     * @return pointer to memory, 0 if out of memory
+     */
+    void* Alloc(HAllocator allocator, uint32_t size);
+
+    /**
+     * Free memory
+     * @param allocator allocator handle
+     * @param ptr pointer returned by Alloc() or Realloc()
+     * @param size the size the block was allocated with
+     */
+    void Free(HAllocator allocator, void* ptr, uint32_t size);
+
+    /**
+     * Reallocate memory. A block that stays within its size class is returned as is.
+     * @param allocator allocator handle
+     * @param ptr pointer returned by Alloc() or Realloc(), or 0
+     * @param old_size the size the block was allocated with
+     * @param new_size new size, 0 frees the block
+     * @return pointer to memory, 0 if out of memory or new_size is 0
+     */
+    void* Realloc(HAllocator allocator, void* ptr, uint32_t old_size, uint32_t new_size);
+
+    /**
+     * Get allocation statistics
+     * @param allocator allocator handle
+     * @param stats [out] statistics
+     */
+    void GetStats(HAllocator allocator, Stats* stats);
+}
+
+#endif // DM_SIZE_CLASS_ALLOCATOR_H
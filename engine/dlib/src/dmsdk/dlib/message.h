@@ -229,7 +229,7 @@ namespace dmMessage
 
     /**
      * Post an message to a socket
-     * @note Message data is copied by value
+     * @note Message data is copied by value. Messages larger than a message page get an allocation of their own, which is freed after dispatch
      * @name Post
      * @param sender [type: dmMessage::URL*] The sender URL if the receiver wants to respond. 0x0 is accepted
      * @param receiver [type: dmMessage::URL*] The receiver URL, must not be 0x0
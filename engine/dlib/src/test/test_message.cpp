@@ -380,9 +380,12 @@ TEST(dmMessage, Integrity)
         dmMessage::DM_MESSAGE_MAX_DATA_SIZE / 2,
         dmMessage::DM_MESSAGE_MAX_DATA_SIZE / 2 + 1,
         dmMessage::DM_MESSAGE_MAX_DATA_SIZE - 1,
-        dmMessage::DM_MESSAGE_MAX_DATA_SIZE};
+        dmMessage::DM_MESSAGE_MAX_DATA_SIZE,
+        dmMessage::DM_MESSAGE_MAX_DATA_SIZE + 1,
+        dmMessage::DM_MESSAGE_PAGE_SIZE,
+        dmMessage::DM_MESSAGE_PAGE_SIZE * 3 + 7};
 
-    char msg[dmMessage::DM_MESSAGE_MAX_DATA_SIZE];
+    static char msg[dmMessage::DM_MESSAGE_PAGE_SIZE * 4];
     for (uint32_t n = 0; n < (sizeof(MESSAGE_SIZES) / sizeof(uint32_t)); ++n)
     {
         uint32_t size = MESSAGE_SIZES[n];
@@ -403,6 +406,33 @@ TEST(dmMessage, Integrity)
     ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
 }
 
+TEST(dmMessage, LargeMessages)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(&receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    // Large messages are dispatched in order with the messages that fit in a page
+    static char msg[dmMessage::DM_MESSAGE_PAGE_SIZE * 2];
+    for (uint32_t iter = 0; iter < 3; ++iter)
+    {
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            uint32_t size = (i % 2) ? sizeof(msg) - i : 16 + i;
+            for (uint32_t j = 0; j < size; ++j)
+            {
+                msg[j] = rand() % 255;
+            }
+            ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, dmHashBuffer64(msg, size), 0, 0x0, msg, size, 0));
+        }
+        ASSERT_EQ(8u, dmMessage::Dispatch(receiver.m_Socket, HandleIntegrityMessage, 0));
+    }
+
+    // Large messages that are never dispatched are freed with the socket
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, 0, 0, 0x0, msg, sizeof(msg), 0));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
 void HandleUserDataMessage(dmMessage::Message *message_object, void *user_ptr)
 {
     *((uint32_t*)user_ptr) = *((uint32_t*)message_object->m_UserData1);
@@ -0,0 +1,153 @@
+// Copyright 2020-2022 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "../dlib/size_class_allocator.h"
+
+struct Block
+{
+    uint8_t* m_Ptr;
+    uint32_t m_Size;
+    uint8_t  m_Value;
+};
+
+static void CheckBlock(const Block& b)
+{
+    for (uint32_t i = 0; i < b.m_Size; ++i)
+    {
+        ASSERT_EQ(b.m_Value, b.m_Ptr[i]);
+    }
+}
+
+TEST(dmSizeClassAllocator, Alignment)
+{
+    dmSizeClassAllocator::HAllocator allocator = dmSizeClassAllocator::New();
+    for (uint32_t size = 1; size <= 1024; ++size)
+    {
+        void* ptr = dmSizeClassAllocator::Alloc(allocator, size);
+        ASSERT_NE((void*) 0, ptr);
+        ASSERT_EQ(0u, (uint32_t) ((uintptr_t) ptr & 15));
+        dmSizeClassAllocator::Free(allocator, ptr, size);
+    }
+    dmSizeClassAllocator::Delete(allocator);
+}
+
+TEST(dmSizeClassAllocator, Random)
+{
+    dmSizeClassAllocator::HAllocator allocator = dmSizeClassAllocator::New();
+    std::vector<Block> blocks;
+
+    for (uint32_t i = 0; i < 20000; ++i)
+    {
+        uint32_t op = rand() % 3;
+        if (op == 0 || blocks.empty())
+        {
+            Block b;
+            b.m_Size = 1 + rand() % 1024;
+            b.m_Value = (uint8_t) rand();
+            b.m_Ptr = (uint8_t*) dmSizeClassAllocator::Alloc(allocator, b.m_Size);
+            ASSERT_NE((uint8_t*) 0, b.m_Ptr);
+            memset(b.m_Ptr, b.m_Value, b.m_Size);
+            blocks.push_back(b);
+        }
+        else if (op == 1)
+        {
+            uint32_t index = rand() % blocks.size();
+            Block& b = blocks[index];
+            CheckBlock(b);
+            uint32_t new_size = 1 + rand() % 1024;
+            b.m_Ptr = (uint8_t*) dmSizeClassAllocator::Realloc(allocator, b.m_Ptr, b.m_Size, new_size);
+            ASSERT_NE((uint8_t*) 0, b.m_Ptr);
+            b.m_Size = new_size < b.m_Size ? new_size : b.m_Size;
+            CheckBlock(b);
+            memset(b.m_Ptr, b.m_Value, new_size);
+            b.m_Size = new_size;
+        }
+        else
+        {
+            uint32_t index = rand() % blocks.size();
+            Block b = blocks[index];
+            CheckBlock(b);
+            dmSizeClassAllocator::Free(allocator, b.m_Ptr, b.m_Size);
+            blocks[index] = blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    for (uint32_t i = 0; i < blocks.size(); ++i)
+    {
+        CheckBlock(blocks[i]);
+        dmSizeClassAllocator::Free(allocator, blocks[i].m_Ptr, blocks[i].m_Size);
+    }
+
+    dmSizeClassAllocator::Stats stats;
+    dmSizeClassAllocator::GetStats(allocator, &stats);
+    for (uint32_t i = 0; i < dmSizeClassAllocator::MAX_SIZE_CLASSES; ++i)
+    {
+        ASSERT_EQ(0u, stats.m_SizeClasses[i].m_LiveCount);
+        // At most the cached empty page is kept
+        ASSERT_GE(1u, stats.m_SizeClasses[i].m_PageCount);
+    }
+    ASSERT_EQ(0u, stats.m_LargeLiveCount);
+    ASSERT_EQ(0u, (uint32_t) stats.m_LargeLiveBytes);
+
+    dmSizeClassAllocator::Delete(allocator);
+}
+
+TEST(dmSizeClassAllocator, Stats)
+{
+    dmSizeClassAllocator::HAllocator allocator = dmSizeClassAllocator::New();
+
+    void* small[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        small[i] = dmSizeClassAllocator::Alloc(allocator, 20);
+    }
+    void* large = dmSizeClassAllocator::Alloc(allocator, 4000);
+
+    dmSizeClassAllocator::Stats stats;
+    dmSizeClassAllocator::GetStats(allocator, &stats);
+    ASSERT_EQ(32u, stats.m_SizeClasses[1].m_Size);
+    ASSERT_EQ(3u, stats.m_SizeClasses[1].m_LiveCount);
+    ASSERT_EQ(3u, stats.m_SizeClasses[1].m_AllocationCount);
+    ASSERT_EQ(1u, stats.m_SizeClasses[1].m_PageCount);
+    ASSERT_EQ(1u, stats.m_LargeLiveCount);
+    ASSERT_EQ(4000u, (uint32_t) stats.m_LargeLiveBytes);
+
+    // Growing within the size class keeps the block
+    ASSERT_EQ(small[0], dmSizeClassAllocator::Realloc(allocator, small[0], 20, 32));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        dmSizeClassAllocator::Free(allocator, small[i], 20);
+    }
+    dmSizeClassAllocator::Free(allocator, large, 4000);
+
+    dmSizeClassAllocator::GetStats(allocator, &stats);
+    ASSERT_EQ(0u, stats.m_SizeClasses[1].m_LiveCount);
+    ASSERT_EQ(0u, stats.m_LargeLiveCount);
+
+    dmSizeClassAllocator::Delete(allocator);
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
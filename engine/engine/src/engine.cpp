@@ -243,6 +243,7 @@ namespace dmEngine
     , m_QuitOnEsc(false)
     , m_ConnectionAppMode(false)
     , m_RunWhileIconified(0)
+    , m_GCFrameBudget(0)
     , m_Width(960)
     , m_Height(640)
     , m_InvPhysicalWidth(1.0f/960)
@@ -349,6 +350,7 @@ namespace dmEngine
         if (engine->m_Factory) {
             dmResource::DeleteFactory(engine->m_Factory);
         }
+        dmGameSystem::FinalizeTextureStreaming();
 
         if (engine->m_GraphicsContext)
         {
@@ -800,6 +802,20 @@ namespace dmEngine
         graphics_context_params.m_UseValidationLayers = use_validation_layers || dmConfigFile::GetInt(engine->m_Config, "graphics.use_validationlayers", 0) != 0;
         graphics_context_params.m_GraphicsMemorySize = dmConfigFile::GetInt(engine->m_Config, "graphics.memory_size", 0) * 1024*1024; // MB -> bytes
 
+        // Compiled pipelines are kept between runs to avoid compiling them again the next time they are used
+        char pipeline_cache_path[DMPATH_MAX_PATH];
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.use_pipeline_cache", 1) != 0)
+        {
+            char application_support_path[DMPATH_MAX_PATH];
+            const char* application_name = dmConfigFile::GetString(engine->m_Config, "project.title_as_file_name", "defold");
+            if (dmSys::GetApplicationSupportPath(application_name, application_support_path, sizeof(application_support_path)) == dmSys::RESULT_OK)
+            {
+                dmPath::Concat(application_support_path, "pipeline_cache", pipeline_cache_path, sizeof(pipeline_cache_path));
+                graphics_context_params.m_PipelineCachePath    = pipeline_cache_path;
+                graphics_context_params.m_PipelineCacheVersion = dmEngineVersion::VERSION_SHA1;
+            }
+        }
+
         engine->m_GraphicsContext = dmGraphics::NewContext(graphics_context_params);
         if (engine->m_GraphicsContext == 0x0)
         {
@@ -947,6 +963,13 @@ namespace dmEngine
             module_script_contexts.Push(engine->m_GuiScriptContext);
         }
 
+        engine->m_GCFrameBudget = dmConfigFile::GetInt(engine->m_Config, "script.gc_frame_budget", 0);
+        uint32_t gc_heap_growth_limit = dmConfigFile::GetInt(engine->m_Config, "script.gc_heap_growth_limit", 200);
+        for (uint32_t i = 0; i < module_script_contexts.Size(); ++i)
+        {
+            dmScript::SetGarbageCollectionBudget(module_script_contexts[i], engine->m_GCFrameBudget, gc_heap_growth_limit);
+        }
+
         dmHID::Init(engine->m_HidContext);
 
         dmSound::InitializeParams sound_params;
@@ -1157,6 +1180,18 @@ namespace dmEngine
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
+        // Large textures are loaded with their lower mips only, and the top mips are loaded when they are drawn large enough on screen
+        if (dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming", 0) != 0)
+        {
+            dmGameSystem::TextureStreamingParams texture_streaming_params;
+            texture_streaming_params.m_Factory         = engine->m_Factory;
+            texture_streaming_params.m_GraphicsContext = engine->m_GraphicsContext;
+            texture_streaming_params.m_MemoryBudget    = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_memory_budget", 0) * 1024*1024; // MB -> bytes
+            texture_streaming_params.m_MinSize         = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_min_size", 256);
+            texture_streaming_params.m_EvictFrames     = dmConfigFile::GetInt(engine->m_Config, "graphics.texture_streaming_evict_frames", 300);
+            dmGameSystem::InitializeTextureStreaming(texture_streaming_params);
+        }
+
         go_result = dmGameSystem::RegisterComponentTypes(engine->m_Factory, engine->m_Register, engine->m_RenderContext, &engine->m_PhysicsContext, &engine->m_ParticleFXContext, &engine->m_SpriteContext,
                                                                                                 &engine->m_CollectionProxyContext, &engine->m_FactoryContext, &engine->m_CollectionFactoryContext,
                                                                                                 &engine->m_ModelContext, &engine->m_MeshContext, &engine->m_LabelContext, &engine->m_TilemapContext,
@@ -1484,6 +1519,7 @@ bail:
                 {
                     DM_PROFILE("Resource");
                     dmResource::UpdateFactory(engine->m_Factory);
+                    dmGameSystem::UpdateTextureStreaming();
                 }
 
                 {
@@ -1655,6 +1691,18 @@ bail:
 
             dmGraphics::Flip(engine->m_GraphicsContext);
 
+            {
+                // Garbage collection runs after the frame has been submitted. The contexts share the budget of the frame,
+                // and take turns to start so that each one gets the whole budget every few frames
+                dmArray<dmScript::HContext>& script_contexts = engine->m_ModuleContext.m_ScriptContexts;
+                uint64_t gc_end_time = dmTime::GetTime() + engine->m_GCFrameBudget;
+                uint32_t context_count = script_contexts.Size();
+                for (uint32_t i = 0; i < context_count; ++i)
+                {
+                    dmScript::StepGarbageCollection(script_contexts[(engine->m_Stats.m_FrameCount + i) % context_count], gc_end_time);
+                }
+            }
+
             RecordData* record_data = &engine->m_RecordData;
             if (record_data->m_Recorder)
             {
@@ -160,6 +160,7 @@ namespace dmEngine
         float                                       m_AccumFrameTime;           // Used to trigger frame updates when using m_UpdateFrequency != 0
         uint32_t                                    m_UpdateFrequency;
         uint32_t                                    m_FixedUpdateFrequency;
+        uint32_t                                    m_GCFrameBudget;            // Microseconds of garbage collection per frame, shared by the script contexts
         uint32_t                                    m_Width;
         uint32_t                                    m_Height;
         uint32_t                                    m_ClearColor;
@@ -227,12 +227,34 @@ namespace dmGameObject
         RunScriptParams run_params;
         run_params.m_UpdateContext = params.m_UpdateContext;
         CompScriptWorld* script_world = (CompScriptWorld*)params.m_World;
+        // Only update is throttled by go.set_update_interval, fixed_update runs every step
+        bool throttle = function == SCRIPT_FUNCTION_UPDATE;
+        uint32_t frame = script_world->m_UpdateFrame;
         uint32_t size = script_world->m_Instances.Size();
         for (uint32_t i = 0; i < size; ++i)
         {
             HScriptInstance script_instance = script_world->m_Instances[i];
             if (script_instance->m_Update) {
-                ScriptResult ret = RunScript(L, script_instance->m_Script, function, script_instance, run_params);
+                ScriptResult ret;
+                if (throttle && script_instance->m_UpdateInterval > 1)
+                {
+                    script_instance->m_UpdateDT += params.m_UpdateContext->m_DT;
+                    if (frame % script_instance->m_UpdateInterval != script_instance->m_UpdatePhase)
+                    {
+                        continue;
+                    }
+                    UpdateContext update_context = *params.m_UpdateContext;
+                    update_context.m_DT = script_instance->m_UpdateDT;
+                    script_instance->m_UpdateDT = 0.0f;
+
+                    RunScriptParams throttled_params;
+                    throttled_params.m_UpdateContext = &update_context;
+                    ret = RunScript(L, script_instance->m_Script, function, script_instance, throttled_params);
+                }
+                else
+                {
+                    ret = RunScript(L, script_instance->m_Script, function, script_instance, run_params);
+                }
                 if (ret == SCRIPT_RESULT_FAILED)
                 {
                     result = UPDATE_RESULT_UNKNOWN_ERROR;
@@ -240,8 +262,9 @@ namespace dmGameObject
             }
         }
 
-        // TODO: Find out if the scripts actually sent any transform events
-        update_result.m_TransformsUpdated = true;
+        // Transform writes from the scripts (go.set_position, go.set etc) flag the collection
+        // directly, so a pass that moved nothing doesn't trigger another transform update
+        update_result.m_TransformsUpdated = false;
 
         assert(top == lua_gettop(L));
         return result;
@@ -252,7 +275,9 @@ namespace dmGameObject
         CompScriptWorld* script_world = (CompScriptWorld*)params.m_World;
         dmScript::UpdateScriptWorld(script_world->m_ScriptWorld, params.m_UpdateContext->m_DT);
         DM_PROPERTY_ADD_U32(rmtp_ScriptCount, script_world->m_Instances.Size());
-        return CompScriptUpdateInternal(params, SCRIPT_FUNCTION_UPDATE, update_result);
+        UpdateResult result = CompScriptUpdateInternal(params, SCRIPT_FUNCTION_UPDATE, update_result);
+        script_world->m_UpdateFrame++;
+        return result;
     }
 
     UpdateResult CompScriptFixedUpdate(const ComponentsUpdateParams& params, ComponentsUpdateResult& update_result)
@@ -319,7 +344,7 @@ namespace dmGameObject
                 message_name = (const char*)dmHashReverse64(message->m_Id, 0);
             }
             if (message->m_DataSize > 0)
-                dmScript::PushTable(L, (const char*)message->m_Data, message->m_DataSize);
+                dmScript::PushMessageTable(L, (const char*)message->m_Data, message->m_DataSize);
             else
                 lua_newtable(L);
         }
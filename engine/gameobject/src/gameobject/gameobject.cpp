@@ -1215,6 +1215,12 @@ namespace dmGameObject
 
     static void ReparentChildNodes(Collection* collection, HInstance instance)
     {
+        // The world transforms of the child nodes change with their parent
+        if (instance->m_FirstChildIndex != INVALID_INSTANCE_INDEX)
+        {
+            collection->m_DirtyTransforms = 1;
+        }
+
         // Reparent child nodes
         uint32_t index = instance->m_FirstChildIndex;
         while (index != INVALID_INSTANCE_INDEX)
@@ -1397,6 +1403,8 @@ namespace dmGameObject
             // world transforms need to be up to date in time for the script init calls
             collection->m_WorldTransforms[new_instances[i]->m_Index] = dmTransform::ToMatrix4(new_instances[i]->m_Transform);
         }
+        // The children still need their parents applied
+        collection->m_DirtyTransforms = 1;
 
         // Create components and set properties
         //
@@ -2088,6 +2096,7 @@ namespace dmGameObject
 
     uint32_t SetBoneTransforms(HInstance instance, dmTransform::Transform& component_transform, dmTransform::Transform* transforms, uint32_t transform_count)
     {
+        instance->m_Collection->m_DirtyTransforms = 1;
         return DoSetBoneTransforms(instance->m_Collection->m_HCollection, &component_transform, instance->m_Index, transforms, transform_count);
     }
 
@@ -2938,6 +2947,7 @@ namespace dmGameObject
 
     void SetPosition(HInstance instance, Point3 position)
     {
+        instance->m_Collection->m_DirtyTransforms = 1;
         instance->m_Transform.SetTranslation(Vector3(position));
     }
 
@@ -2948,6 +2958,7 @@ namespace dmGameObject
 
     void SetRotation(HInstance instance, Quat rotation)
     {
+        instance->m_Collection->m_DirtyTransforms = 1;
         instance->m_Transform.SetRotation(rotation);
     }
 
@@ -2958,11 +2969,13 @@ namespace dmGameObject
 
     void SetScale(HInstance instance, float scale)
     {
+        instance->m_Collection->m_DirtyTransforms = 1;
         instance->m_Transform.SetUniformScale(scale);
     }
 
     void SetScale(HInstance instance, Vector3 scale)
     {
+        instance->m_Collection->m_DirtyTransforms = 1;
         instance->m_Transform.SetScale(scale);
     }
 
@@ -3027,6 +3040,7 @@ namespace dmGameObject
         }
 
         Collection* collection = child->m_Collection;
+        collection->m_DirtyTransforms = 1;
 
         if (parent != 0)
         {
@@ -3356,6 +3370,8 @@ namespace dmGameObject
             return PROPERTY_RESULT_INVALID_INSTANCE;
         if (component_id == 0)
         {
+            // All instance properties are transform properties
+            instance->m_Collection->m_DirtyTransforms = 1;
             float* position = instance->m_Transform.GetPositionPtr();
             float* rotation = instance->m_Transform.GetRotationPtr();
             float* scale = instance->m_Transform.GetScalePtr();
@@ -171,6 +171,8 @@ namespace dmGameObject
     CompScriptWorld::CompScriptWorld(uint32_t max_instance_count)
     : m_Instances()
     , m_ScriptWorld(0x0)
+    , m_UpdateFrame(0)
+    , m_NextUpdateSlot(0)
     {
         m_Instances.SetCapacity(max_instance_count);
     }
@@ -382,7 +384,7 @@ namespace dmGameObject
     {
         ScriptInstance* i = ScriptInstance_Check(L);
         Instance* instance = i->m_Instance;
-        if (lua_gettop(L) == instance_arg && !lua_isnil(L, instance_arg)) {
+        if (lua_gettop(L) >= instance_arg && !lua_isnil(L, instance_arg)) {
             dmMessage::URL receiver;
             dmScript::ResolveURL(L, instance_arg, &receiver, 0x0);
             if (receiver.m_Socket != dmGameObject::GetMessageSocket(i->m_Instance->m_Collection->m_HCollection))
@@ -932,6 +934,7 @@ namespace dmGameObject
      * @name go.get_position
      * @replaces request_transform transform_response
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the position for, by default the instance of the calling script
+     * @param [out] [type:vector3] optional vector3 to store the position in, it is returned instead of a new vector3
      * @return position [type:vector3] instance position
      * @examples
      *
@@ -946,11 +949,17 @@ namespace dmGameObject
      * ```lua
      * local pos = go.get_position("my_gameobject")
      * ```
+     *
+     * Get the position into an existing vector, without creating a new one:
+     *
+     * ```lua
+     * go.get_position(nil, self.pos)
+     * ```
      */
     int Script_GetPosition(lua_State* L)
     {
         Instance* instance = ResolveInstance(L, 1);
-        dmScript::PushVector3(L, dmVMath::Vector3(dmGameObject::GetPosition(instance)));
+        dmScript::PushVector3(L, dmVMath::Vector3(dmGameObject::GetPosition(instance)), 2);
         return 1;
     }
 
@@ -959,6 +968,7 @@ namespace dmGameObject
      *
      * @name go.get_rotation
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the rotation for, by default the instance of the calling script
+     * @param [out] [type:quaternion] optional quaternion to store the rotation in, it is returned instead of a new quaternion
      * @return rotation [type:quaternion] instance rotation
      * @examples
      *
@@ -977,7 +987,7 @@ namespace dmGameObject
     int Script_GetRotation(lua_State* L)
     {
         Instance* instance = ResolveInstance(L, 1);
-        dmScript::PushQuat(L, dmGameObject::GetRotation(instance));
+        dmScript::PushQuat(L, dmGameObject::GetRotation(instance), 2);
         return 1;
     }
 
@@ -986,6 +996,7 @@ namespace dmGameObject
      *
      * @name go.get_scale
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the scale for, by default the instance of the calling script
+     * @param [out] [type:vector3] optional vector3 to store the scale in, it is returned instead of a new vector3
      * @return scale [type:vector3] instance scale factor
      * @examples
      *
@@ -1004,7 +1015,7 @@ namespace dmGameObject
     int Script_GetScale(lua_State* L)
     {
         Instance* instance = ResolveInstance(L, 1);
-        dmScript::PushVector3(L, dmGameObject::GetScale(instance));
+        dmScript::PushVector3(L, dmGameObject::GetScale(instance), 2);
         return 1;
     }
 
@@ -1315,6 +1326,7 @@ namespace dmGameObject
      *
      * @name go.get_world_position
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the world position for, by default the instance of the calling script
+     * @param [out] [type:vector3] optional vector3 to store the position in, it is returned instead of a new vector3
      * @return position [type:vector3] instance world position
      * @examples
      *
@@ -1333,7 +1345,7 @@ namespace dmGameObject
     int Script_GetWorldPosition(lua_State* L)
     {
         Instance* instance = ResolveInstance(L, 1);
-        dmScript::PushVector3(L, dmVMath::Vector3(dmGameObject::GetWorldPosition(instance)));
+        dmScript::PushVector3(L, dmVMath::Vector3(dmGameObject::GetWorldPosition(instance)), 2);
         return 1;
     }
 
@@ -1343,6 +1355,7 @@ namespace dmGameObject
      *
      * @name go.get_world_rotation
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the world rotation for, by default the instance of the calling script
+     * @param [out] [type:quaternion] optional quaternion to store the rotation in, it is returned instead of a new quaternion
      * @return rotation [type:quaternion] instance world rotation
      * @examples
      *
@@ -1361,7 +1374,7 @@ namespace dmGameObject
     int Script_GetWorldRotation(lua_State* L)
     {
         Instance* instance = ResolveInstance(L, 1);
-        dmScript::PushQuat(L, dmGameObject::GetWorldRotation(instance));
+        dmScript::PushQuat(L, dmGameObject::GetWorldRotation(instance), 2);
         return 1;
     }
 
@@ -1373,6 +1386,7 @@ namespace dmGameObject
      *
      * @name go.get_world_scale
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the world scale for, by default the instance of the calling script
+     * @param [out] [type:vector3] optional vector3 to store the scale in, it is returned instead of a new vector3
      * @return scale [type:vector3] instance world 3D scale factor
      * @examples
      *
@@ -1391,7 +1405,7 @@ namespace dmGameObject
     int Script_GetWorldScale(lua_State* L)
     {
         Instance* instance = ResolveInstance(L, 1);
-        dmScript::PushVector3(L, dmGameObject::GetWorldScale(instance));
+        dmScript::PushVector3(L, dmGameObject::GetWorldScale(instance), 2);
         return 1;
     }
 
@@ -1428,6 +1442,7 @@ namespace dmGameObject
      *
      * @name go.get_world_transform
      * @param [id] [type:string|hash|url] optional id of the game object instance to get the world transform for, by default the instance of the calling script
+     * @param [out] [type:matrix4] optional matrix4 to store the transform in, it is returned instead of a new matrix4
      * @return transform [type:matrix4] instance world transform
      * @examples
      *
@@ -1446,7 +1461,7 @@ namespace dmGameObject
     int Script_GetWorldTransform(lua_State* L)
     {
         Instance* instance = ResolveInstance(L,1);
-        dmScript::PushMatrix4(L, dmGameObject::GetWorldMatrix(instance));
+        dmScript::PushMatrix4(L, dmGameObject::GetWorldMatrix(instance), 2);
         return 1;
     }
 
@@ -2052,6 +2067,58 @@ namespace dmGameObject
         return 2;
     }
 
+    /*# sets the update interval of the script
+     * Throttles the update function of the calling script component so that it is only called every
+     * <code>interval</code> frames. The <code>dt</code> passed to update is the time since the previous call,
+     * so code that integrates over time keeps working. Use this for large numbers of scripts that don't need
+     * to run every frame, such as AI or ambient props. The fixed_update function is still called every step.
+     *
+     * Scripts calling this function without a phase are spread evenly over the frames of the interval.
+     *
+     * @name go.set_update_interval
+     * @param interval [type:number] number of frames between updates, 1 updates every frame
+     * @param [phase] [type:number] the frame within the interval to update on, in the range [0, interval - 1]
+     * @examples
+     *
+     * Update an ambient prop every fourth frame:
+     *
+     * ```lua
+     * function init(self)
+     *     go.set_update_interval(4)
+     * end
+     *
+     * function update(self, dt)
+     *     -- dt is the time since the last update, about four frames
+     *     go.set_rotation(go.get_rotation() * vmath.quat_rotation_z(dt))
+     * end
+     * ```
+     */
+    int Script_SetUpdateInterval(lua_State* L)
+    {
+        DM_LUA_STACK_CHECK(L, 0);
+        ScriptInstance* i = ScriptInstance_Check(L);
+
+        lua_Number interval = luaL_checknumber(L, 1);
+        if (interval < 1 || interval > 0xffff)
+        {
+            return DM_LUA_ERROR("The update interval must be in the range [1, %d] (%g given).", 0xffff, interval);
+        }
+        uint16_t update_interval = (uint16_t)interval;
+        uint16_t update_phase = i->m_UpdateSlot % update_interval;
+        if (!lua_isnoneornil(L, 2))
+        {
+            lua_Number phase = luaL_checknumber(L, 2);
+            if (phase < 0 || phase >= update_interval)
+            {
+                return DM_LUA_ERROR("The update phase must be in the range [0, %d] (%g given).", update_interval - 1, phase);
+            }
+            update_phase = (uint16_t)phase;
+        }
+        i->m_UpdateInterval = update_interval;
+        i->m_UpdatePhase = update_phase;
+        return 0;
+    }
+
     /*# define a property for the script
      * This function defines a property which can then be used in the script through the self-reference.
      * The properties defined this way are automatically exposed in the editor in game objects and collections which use the script.
@@ -2158,6 +2225,7 @@ namespace dmGameObject
         {"delete",                  Script_Delete},
         {"delete_all",              Script_DeleteAll},
         {"screen_ray",              Script_ScreenRay},
+        {"set_update_interval",     Script_SetUpdateInterval},
         {"property",                Script_Property},
         {0, 0}
     };
@@ -2491,6 +2559,8 @@ bail:
         i->m_Instance = instance;
         i->m_ScriptWorld = script_world->m_ScriptWorld;
         i->m_ComponentIndex = component_index;
+        i->m_UpdateInterval = 1;
+        i->m_UpdateSlot = script_world->m_NextUpdateSlot++;
         NewPropertiesParams params;
         params.m_ResolvePathCallback = ScriptInstanceResolvePathCB;
         params.m_ResolvePathUserData = (uintptr_t)L;
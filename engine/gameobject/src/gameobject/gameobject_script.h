@@ -79,6 +79,10 @@ namespace dmGameObject
         int         m_ContextTableReference;
         uint16_t    m_ComponentIndex;
         HProperties m_Properties;
+        float       m_UpdateDT;         // Time accumulated since the last update, when throttled
+        uint16_t    m_UpdateInterval;   // Frames between updates, see go.set_update_interval
+        uint16_t    m_UpdatePhase;
+        uint16_t    m_UpdateSlot;       // Creation order, used to spread the default phases
         uint16_t    m_Update : 1;
         uint16_t    m_Padding : 15;
     };
@@ -89,6 +93,8 @@ namespace dmGameObject
 
         dmArray<ScriptInstance*> m_Instances;
         dmScript::HScriptWorld m_ScriptWorld;
+        uint32_t               m_UpdateFrame;
+        uint16_t               m_NextUpdateSlot;
     };
 
     void    InitializeScript(HRegister regist, dmScript::HContext context);
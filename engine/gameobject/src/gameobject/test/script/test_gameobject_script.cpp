@@ -319,6 +319,88 @@ TEST_F(ScriptTest, Null)
     dmGameObject::Delete(m_Collection, go, false);
 }
 
+TEST_F(ScriptTest, TestTransformsNotUpdated)
+{
+    dmGameObject::HInstance instance = dmGameObject::New(m_Collection, "/transform_idle.goc");
+    ASSERT_NE((void*) 0, (void*) instance);
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    // Scripts that don't write any transforms must not trigger a transform update,
+    // which would overwrite the bogus world transform
+    dmGameObject::Collection* collection = m_Collection->m_Collection;
+    collection->m_WorldTransforms[instance->m_Index] = dmVMath::Matrix4::translation(dmVMath::Vector3(100, 0, 0));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(100.0f, dmGameObject::GetWorldPosition(instance).getX());
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    dmGameObject::Delete(m_Collection, instance, false);
+}
+
+TEST_F(ScriptTest, TestTransformsUpdatedWhenParentDeleted)
+{
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/transform_idle.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/transform_idle.goc");
+    ASSERT_NE((void*) 0, (void*) parent);
+    ASSERT_NE((void*) 0, (void*) child);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(child, parent));
+    dmGameObject::SetPosition(parent, dmVMath::Point3(10, 0, 0));
+    dmGameObject::SetPosition(child, dmVMath::Point3(1, 0, 0));
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(11.0f, dmGameObject::GetWorldPosition(child).getX());
+
+    // The child is moved to the root when its parent is deleted, and its world transform
+    // is updated in the next frame even though the scripts don't write any transforms
+    dmGameObject::Delete(m_Collection, parent, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    ASSERT_EQ(1.0f, dmGameObject::GetWorldPosition(child).getX());
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    dmGameObject::Delete(m_Collection, child, false);
+}
+
+TEST_F(ScriptTest, TestTransformsUpdated)
+{
+    dmGameObject::HInstance instance = dmGameObject::New(m_Collection, "/transform_move.goc");
+    ASSERT_NE((void*) 0, (void*) instance);
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    // A script moving its instance updates the world transforms in the same frame
+    for (uint32_t i = 1; i <= 2; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_EQ((float) i, dmGameObject::GetPosition(instance).getX());
+        ASSERT_EQ((float) i, dmGameObject::GetWorldPosition(instance).getX());
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    dmGameObject::Delete(m_Collection, instance, false);
+}
+
+TEST_F(ScriptTest, TestUpdateInterval)
+{
+    dmGameObject::HInstance instance = dmGameObject::New(m_Collection, "/update_interval.goc");
+    ASSERT_NE((void*) 0, (void*) instance);
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    // The script updates every third frame, on the second frame of each interval,
+    // with the time accumulated since the last update
+    m_UpdateContext.m_DT = 1.0f;
+    float expected_updates[] = { 0, 1, 1, 1, 2, 2, 2 };
+    float expected_time[]    = { 0, 2, 2, 2, 5, 5, 5 };
+    for (uint32_t i = 0; i < sizeof(expected_updates) / sizeof(expected_updates[0]); ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+        ASSERT_EQ(expected_updates[i], dmGameObject::GetPosition(instance).getX());
+        ASSERT_EQ(expected_time[i], dmGameObject::GetPosition(instance).getY());
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+    dmGameObject::Delete(m_Collection, instance, false);
+}
+
 TEST_F(ScriptTest, TestModule)
 {
     dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/main.goc");
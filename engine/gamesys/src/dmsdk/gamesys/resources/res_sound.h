@@ -36,6 +36,7 @@ namespace dmGameSystem
         float               m_Speed;
         uint8_t             m_Loopcount;
         uint8_t             m_Looping:1;
+        uint8_t             m_Priority;
     };
 }
 
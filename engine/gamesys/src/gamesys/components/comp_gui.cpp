@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <string.h>
+#include <stdlib.h>
 
 #include <dlib/dlib.h>
 #include <dlib/array.h>
@@ -23,6 +24,7 @@
 #include <dlib/message.h>
 #include <dlib/profile.h>
 #include <dlib/dstrings.h>
+#include <dlib/time.h>
 #include <dlib/trig_lookup.h>
 #include <dmsdk/dlib/vmath.h>
 #include <graphics/graphics.h>
@@ -40,6 +42,7 @@
 #include "../resources/res_skeleton.h"
 #include "../resources/res_meshset.h"
 #include "../resources/res_animationset.h"
+#include "../resources/res_texture.h"
 #include "../gamesys.h"
 #include "../gamesys_private.h"
 #include <particle/particle.h>
@@ -49,6 +52,8 @@
 
 DM_PROPERTY_EXTERN(rmtp_Gui);
 DM_PROPERTY_U32(rmtp_GuiVertexCount, 0, FrameReset, "#", &rmtp_Gui);
+DM_PROPERTY_U32(rmtp_GuiReusedVertexCount, 0, FrameReset, "#", &rmtp_Gui);
+DM_PROPERTY_U32(rmtp_GuiUploadedVertexCount, 0, FrameReset, "#", &rmtp_Gui);
 
 namespace dmGameSystem
 {
@@ -157,6 +162,12 @@ namespace dmGameSystem
         gui_world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(dmRender::GetGraphicsContext(gui_context->m_RenderContext), ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
         // Grows automatically
         gui_world->m_ClientVertexBuffer.SetCapacity(512);
+        gui_world->m_RetainedVertexCount = 0;
+        gui_world->m_ReusedVertexCount = 0;
+        gui_world->m_CleanVertexRanges.SetCapacity(64);
+        gui_world->m_UploadedVertexCount = 0;
+        // Start at 1, so that a cleared cache entry (frame 0) is never considered written the previous frame
+        gui_world->m_RenderFrame = 1;
         gui_world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(gui_context->m_RenderContext), 0, 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
 
         uint8_t white_texture[] = { 0xff, 0xff, 0xff, 0xff,
@@ -204,6 +215,35 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    static void WaitForTextureUpload(dmGraphics::HTexture texture)
+    {
+        while (dmGraphics::GetTextureStatusFlags(texture) & dmGraphics::TEXTURE_STATUS_DATA_PENDING)
+        {
+            dmTime::Sleep(250);
+        }
+    }
+
+    // Frees the data of the completed uploads. If texture is set, waits for the uploads of that texture to complete
+    static void FreeTextureUploads(GuiWorld* gui_world, dmGraphics::HTexture texture)
+    {
+        uint32_t i = 0;
+        while (i < gui_world->m_TextureUploads.Size())
+        {
+            GuiTextureUpload& upload = gui_world->m_TextureUploads[i];
+            if (upload.m_Texture == texture)
+            {
+                WaitForTextureUpload(texture);
+            }
+            else if (dmGraphics::GetTextureStatusFlags(upload.m_Texture) & dmGraphics::TEXTURE_STATUS_DATA_PENDING)
+            {
+                ++i;
+                continue;
+            }
+            free(upload.m_Data);
+            gui_world->m_TextureUploads.EraseSwap(i);
+        }
+    }
+
     static dmGameObject::CreateResult CompGuiDeleteWorld(const dmGameObject::ComponentDeleteWorldParams& params)
     {
         GuiWorld* gui_world = (GuiWorld*)params.m_World;
@@ -243,6 +283,12 @@ namespace dmGameSystem
         dmGraphics::DeleteVertexBuffer(gui_world->m_VertexBuffer);
         dmGraphics::DeleteTexture(gui_world->m_WhiteTexture);
 
+        for (uint32_t i = 0; i < gui_world->m_TextureUploads.Size(); ++i)
+        {
+            WaitForTextureUpload(gui_world->m_TextureUploads[i].m_Texture);
+            free(gui_world->m_TextureUploads[i].m_Data);
+        }
+
         dmScript::DeleteScriptWorld(gui_world->m_ScriptWorld);
 
         delete gui_world;
@@ -791,6 +837,7 @@ namespace dmGameSystem
         dmRender::HRenderContext    m_RenderContext;
         dmRender::HMaterial         m_Material;
         GuiWorld*                   m_GuiWorld;
+        GuiComponent*               m_Component;
 
         // This order value is increased during rendering for each
         // render object generated, then used to make sure the final
@@ -898,6 +945,19 @@ namespace dmGameSystem
         return (dmGraphics::HTexture) result;
     }
 
+    // Grows the client vertex buffer without losing the vertices of the previous frame past the current size,
+    // which unchanged nodes reuse in place. See ReuseNodeVertices
+    static void ReserveClientVertices(GuiWorld* gui_world, uint32_t count)
+    {
+        dmArray<BoxVertex>& vb = gui_world->m_ClientVertexBuffer;
+        if (vb.Remaining() >= count)
+            return;
+        uint32_t size = vb.Size();
+        vb.SetSize(dmMath::Max(size, gui_world->m_RetainedVertexCount));
+        vb.OffsetCapacity(dmMath::Max(128U, count));
+        vb.SetSize(size);
+    }
+
     static void RenderTextNodes(dmGui::HScene scene,
                          const dmGui::RenderEntry* entries,
                          const Matrix4* node_transforms,
@@ -1026,9 +1086,7 @@ namespace dmGameSystem
 
         vertex_count = dmMath::Min(vertex_count, vb_max_size / (uint32_t)sizeof(ParticleGuiVertex));
 
-        if (gui_world->m_ClientVertexBuffer.Remaining() < vertex_count) {
-            gui_world->m_ClientVertexBuffer.OffsetCapacity(dmMath::Max(128U, vertex_count));
-        }
+        ReserveClientVertices(gui_world, vertex_count);
 
         ParticleGuiVertex *vb_begin = gui_world->m_ClientVertexBuffer.End();
         ParticleGuiVertex *vb_end = vb_begin;
@@ -1179,9 +1237,7 @@ namespace dmGameSystem
                 vertex.m_Color[3] = color.getW() * vertex.m_Color[3];
             }
 
-            if (gui_world->m_ClientVertexBuffer.Remaining() < node_vertex_count) {
-                gui_world->m_ClientVertexBuffer.OffsetCapacity(dmMath::Max(128U, node_vertex_count));
-            }
+            ReserveClientVertices(gui_world, node_vertex_count);
 
             uint32_t node_vertex_start = gui_world->m_ClientVertexBuffer.Size();
             gui_world->m_ClientVertexBuffer.SetSize(node_vertex_start + node_vertex_count);
@@ -1211,6 +1267,67 @@ namespace dmGameSystem
         }
     }
 
+    static GuiNodeVertexCache* GetNodeVertexCache(GuiComponent* component, dmGui::HNode node)
+    {
+        dmArray<GuiNodeVertexCache>& cache = component->m_NodeVertexCache;
+        uint32_t index = node & 0xffff;
+        uint32_t size = cache.Size();
+        if (index >= size)
+        {
+            if (index >= cache.Capacity())
+                cache.SetCapacity(index + 32);
+            cache.SetSize(index + 1);
+            memset(cache.Begin() + size, 0, (index + 1 - size) * sizeof(GuiNodeVertexCache));
+        }
+        return &cache[index];
+    }
+
+    static void AddCleanVertexRange(GuiWorld* gui_world, uint32_t start, uint32_t count)
+    {
+        dmArray<uint32_t>& ranges = gui_world->m_CleanVertexRanges;
+        uint32_t size = ranges.Size();
+        if (size > 0 && ranges[size-2] + ranges[size-1] == start)
+        {
+            ranges[size-1] += count;
+            return;
+        }
+        if (ranges.Remaining() < 2)
+            ranges.OffsetCapacity(64);
+        ranges.Push(start);
+        ranges.Push(count);
+    }
+
+    // If the node was rendered with the same inputs the previous frame, and its vertices end up at the same
+    // place in the client vertex buffer, they are still there and in the vertex buffer. Nodes that moved are
+    // generated again, since the vertices of the previous frame may already be overwritten.
+    static bool ReuseNodeVertices(GuiWorld* gui_world, GuiNodeVertexCache* entry, dmGui::HNode node, const GuiNodeVertexKey& key)
+    {
+        dmArray<BoxVertex>& vb = gui_world->m_ClientVertexBuffer;
+        uint32_t vertex_start = vb.Size();
+        if (entry->m_Node != node || entry->m_Frame + 1 != gui_world->m_RenderFrame || entry->m_VertexStart != vertex_start
+            || memcmp(&entry->m_Key, &key, sizeof(key)) != 0)
+            return false;
+
+        uint32_t vertex_count = entry->m_VertexCount;
+        assert(vertex_start + vertex_count <= gui_world->m_RetainedVertexCount);
+        vb.SetSize(vertex_start + vertex_count);
+        AddCleanVertexRange(gui_world, vertex_start, vertex_count);
+
+        entry->m_Frame = gui_world->m_RenderFrame;
+        gui_world->m_ReusedVertexCount += vertex_count;
+        DM_PROPERTY_ADD_U32(rmtp_GuiReusedVertexCount, vertex_count);
+        return true;
+    }
+
+    static void StoreNodeVertices(GuiWorld* gui_world, GuiNodeVertexCache* entry, dmGui::HNode node, const GuiNodeVertexKey& key, uint32_t vertex_start)
+    {
+        entry->m_Key = key;
+        entry->m_Node = node;
+        entry->m_VertexStart = vertex_start;
+        entry->m_VertexCount = gui_world->m_ClientVertexBuffer.Size() - vertex_start;
+        entry->m_Frame = gui_world->m_RenderFrame;
+    }
+
     static void RenderBoxNodes(dmGui::HScene scene,
                         const dmGui::RenderEntry* entries,
                         const Matrix4* node_transforms,
@@ -1257,9 +1374,7 @@ namespace dmGameSystem
         else
             ro.m_Textures[0] = gui_world->m_WhiteTexture;
 
-        if (gui_world->m_ClientVertexBuffer.Remaining() < (max_total_vertices)) {
-            gui_world->m_ClientVertexBuffer.OffsetCapacity(dmMath::Max(128U, max_total_vertices));
-        }
+        ReserveClientVertices(gui_world, max_total_vertices);
 
         // 9-slice values are specified with reference to the original graphics and not by
         // the possibly stretched texture.
@@ -1289,6 +1404,38 @@ namespace dmGameSystem
             Vector4 slice9 = dmGui::GetNodeSlice9(scene, node);
             bool use_slice_nine = sum(slice9) != 0;
 
+            dmGui::TextureSetAnimDesc* anim_desc = dmGui::GetNodeTextureSet(scene, node);
+            Point3 size = dmGui::GetNodeSize(scene, node);
+
+            bool flip_u = false;
+            bool flip_v = false;
+            if (!manually_set_texture)
+                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
+
+            GuiNodeVertexKey key;
+            memset(&key, 0, sizeof(key));
+            key.m_Transform = node_transforms[i];
+            key.m_Color = pm_color;
+            key.m_Params = slice9;
+            memcpy(key.m_TexCoords, tc, sizeof(key.m_TexCoords));
+            key.m_Size[0] = size.getX();
+            key.m_Size[1] = size.getY();
+            key.m_TextureSize[0] = org_width;
+            key.m_TextureSize[1] = org_height;
+            key.m_Texture = texture;
+            key.m_TextureSet = anim_desc ? anim_desc->m_TextureSet : 0;
+            key.m_AnimationFrame = anim_desc ? dmGui::GetNodeAnimationFrame(scene, node) : 0;
+            key.m_Flags = (manually_set_texture ? 1 : 0) | (flip_u ? 2 : 0) | (flip_v ? 4 : 0);
+
+            GuiNodeVertexCache* cache_entry = GetNodeVertexCache(gui_context->m_Component, node);
+            if (ReuseNodeVertices(gui_world, cache_entry, node, key))
+            {
+                rendered_vert_count += cache_entry->m_VertexCount;
+                continue;
+            }
+
+            uint32_t vertex_start = gui_world->m_ClientVertexBuffer.Size();
+
             // render simple quad ignoring 9-slicing
             if ((!use_slice_nine && manually_set_texture) || !texture)
             {
@@ -1320,18 +1467,13 @@ namespace dmGameSystem
                 gui_world->m_ClientVertexBuffer.Push(v01);
 
                 rendered_vert_count += 6;
+                StoreNodeVertices(gui_world, cache_entry, node, key, vertex_start);
                 continue;
             }
 
-            dmGui::TextureSetAnimDesc* anim_desc = dmGui::GetNodeTextureSet(scene, node);
             dmGameSystemDDF::TextureSet* texture_set_ddf = anim_desc ? (dmGameSystemDDF::TextureSet*)anim_desc->m_TextureSet : 0;
             bool use_geometries = texture_set_ddf && texture_set_ddf->m_Geometries.m_Count > 0;
 
-            bool flip_u = false;
-            bool flip_v = false;
-            if (!manually_set_texture)
-                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
-
             // render using geometries without 9-slicing
             if (!use_slice_nine && use_geometries)
             {
@@ -1375,6 +1517,7 @@ namespace dmGameSystem
                 }
 
                 rendered_vert_count += index_count;
+                StoreNodeVertices(gui_world, cache_entry, node, key, vertex_start);
                 continue;
             }
 
@@ -1403,7 +1546,6 @@ namespace dmGameSystem
             const float su = 1.0f / org_width;
             const float sv = 1.0f / org_height;
 
-            Point3 size = dmGui::GetNodeSize(scene, node);
             const float sx = size.getX() > s9_min_dim ? 1.0f / size.getX() : 0;
             const float sy = size.getY() > s9_min_dim ? 1.0f / size.getY() : 0;
 
@@ -1491,6 +1633,7 @@ namespace dmGameSystem
                 }
             }
             rendered_vert_count += verts_per_node;
+            StoreNodeVertices(gui_world, cache_entry, node, key, vertex_start);
         }
 
         ro.m_VertexCount = rendered_vert_count;
@@ -1562,9 +1705,7 @@ namespace dmGameSystem
             max_total_vertices += ComputeRequiredVertices(dmGui::GetNodePerimeterVertices(scene, entries[i].m_Node));
         }
 
-        if (gui_world->m_ClientVertexBuffer.Remaining() < max_total_vertices) {
-            gui_world->m_ClientVertexBuffer.OffsetCapacity(dmMath::Max(128U, max_total_vertices));
-        }
+        ReserveClientVertices(gui_world, max_total_vertices);
 
         for (uint32_t i = 0; i < node_count; ++i)
         {
@@ -1580,13 +1721,36 @@ namespace dmGameSystem
             Vector4 pm_color(color.getXYZ(), node_opacities[i]);
 
             const uint32_t perimeterVertices = dmMath::Max<uint32_t>(4, dmGui::GetNodePerimeterVertices(scene, node));
-            const float innerMultiplier = dmGui::GetNodeInnerRadius(scene, node) / size.getX();
+            const float innerRadius = dmGui::GetNodeInnerRadius(scene, node);
+            const float innerMultiplier = innerRadius / size.getX();
             const dmGui::PieBounds outerBounds = dmGui::GetNodeOuterBounds(scene, node);
+            const float fillAngle = dmGui::GetNodePieFillAngle(scene, node);
+            const float* tc = dmGui::GetNodeFlipbookAnimUV(scene, node);
+            bool flip_u = false;
+            bool flip_v = false;
+            if (tc)
+                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
+
+            GuiNodeVertexKey key;
+            memset(&key, 0, sizeof(key));
+            key.m_Transform = node_transforms[i];
+            key.m_Color = pm_color;
+            key.m_Params = Vector4(innerRadius, fillAngle, (float)perimeterVertices, (float)outerBounds);
+            if (tc)
+                memcpy(key.m_TexCoords, tc, sizeof(key.m_TexCoords));
+            key.m_Size[0] = size.getX();
+            key.m_Size[1] = size.getY();
+            key.m_Texture = texture;
+            key.m_Flags = (tc ? 1 : 0) | (flip_u ? 2 : 0) | (flip_v ? 4 : 0);
+
+            GuiNodeVertexCache* cache_entry = GetNodeVertexCache(gui_context->m_Component, node);
+            if (ReuseNodeVertices(gui_world, cache_entry, node, key))
+                continue;
 
             const float PI = 3.1415926535f;
             const float ad = PI * 2.0f / (float)perimeterVertices;
 
-            float stopAngle = dmGui::GetNodePieFillAngle(scene, node);
+            float stopAngle = fillAngle;
             bool backwards = false;
             if (stopAngle < 0)
             {
@@ -1609,11 +1773,8 @@ namespace dmGameSystem
 
             float u0,su,v0,sv;
             bool uv_rotated;
-            const float* tc = dmGui::GetNodeFlipbookAnimUV(scene, node);
             if(tc)
             {
-                bool flip_u, flip_v;
-                GetNodeFlipbookAnimUVFlip(scene, node, flip_u, flip_v);
                 uv_rotated = tc[0] != tc[2] && tc[3] != tc[5];
                 if(uv_rotated ? flip_v : flip_u)
                 {
@@ -1705,6 +1866,7 @@ namespace dmGameSystem
             }
 
             assert((gui_world->m_ClientVertexBuffer.Size() - sizeBefore) <= ComputeRequiredVertices(dmGui::GetNodePerimeterVertices(scene, entries[i].m_Node)));
+            StoreNodeVertices(gui_world, cache_entry, node, key, sizeBefore);
         }
 
         ro.m_VertexCount = gui_world->m_ClientVertexBuffer.Size() - ro.m_VertexStart;
@@ -1858,13 +2020,6 @@ namespace dmGameSystem
                     break;
             }
         }
-
-        dmGraphics::SetVertexBufferData(gui_world->m_VertexBuffer,
-                                        gui_world->m_ClientVertexBuffer.Size() * sizeof(BoxVertex),
-                                        gui_world->m_ClientVertexBuffer.Begin(),
-                                        dmGraphics::BUFFER_USAGE_STREAM_DRAW);
-
-        DM_PROPERTY_ADD_U32(rmtp_GuiVertexCount, gui_world->m_ClientVertexBuffer.Size());
     }
 
     static dmGraphics::TextureFormat ToGraphicsFormat(dmImage::Type type) {
@@ -1884,6 +2039,25 @@ namespace dmGameSystem
         return (dmGraphics::TextureFormat) 0; // Never reached
     }
 
+    // The gui frees the buffer as soon as the callback returns, so the upload is done from a copy that is
+    // freed once the upload has completed
+    static void SetTextureAsync(GuiWorld* gui_world, dmGraphics::HTexture texture, dmGraphics::TextureParams& tparams)
+    {
+        GuiTextureUpload upload;
+        upload.m_Texture = texture;
+        upload.m_Data = malloc(tparams.m_DataSize);
+        memcpy(upload.m_Data, tparams.m_Data, tparams.m_DataSize);
+
+        if (gui_world->m_TextureUploads.Full())
+        {
+            gui_world->m_TextureUploads.OffsetCapacity(16);
+        }
+        gui_world->m_TextureUploads.Push(upload);
+
+        tparams.m_Data = upload.m_Data;
+        dmGraphics::SetTextureAsync(texture, tparams);
+    }
+
     static void* NewTexture(dmGui::HScene scene, uint32_t width, uint32_t height, dmImage::Type type, const void* buffer, void* context)
     {
         RenderGuiContext* gui_context = (RenderGuiContext*) context;
@@ -1906,12 +2080,14 @@ namespace dmGameSystem
         tparams.m_Format = ToGraphicsFormat(type);
 
         dmGraphics::HTexture t =  dmGraphics::NewTexture(gcontext, tcparams);
-        dmGraphics::SetTexture(t, tparams);
+        SetTextureAsync(gui_context->m_GuiWorld, t, tparams);
         return (void*) t;
     }
 
     static void DeleteTexture(dmGui::HScene scene, void* texture, void* context)
     {
+        RenderGuiContext* gui_context = (RenderGuiContext*) context;
+        FreeTextureUploads(gui_context->m_GuiWorld, (dmGraphics::HTexture) texture);
         dmGraphics::DeleteTexture((dmGraphics::HTexture) texture);
     }
 
@@ -1925,7 +2101,8 @@ namespace dmGameSystem
         tparams.m_Data = buffer;
         tparams.m_DataSize = dmImage::BytesPerPixel(type) * width * height;
         tparams.m_Format = ToGraphicsFormat(type);
-        dmGraphics::SetTexture((dmGraphics::HTexture) texture, tparams);
+        RenderGuiContext* gui_context = (RenderGuiContext*) context;
+        SetTextureAsync(gui_context->m_GuiWorld, (dmGraphics::HTexture) texture, tparams);
     }
 
     static dmGui::FetchTextureSetAnimResult FetchTextureSetAnimCallback(void* texture_set_ptr, dmhash_t animation, dmGui::TextureSetAnimDesc* out_data)
@@ -2062,18 +2239,83 @@ namespace dmGameSystem
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
+    // Requests the mip level of a streamed texture needed to draw the nodes of a render object on screen.
+    // Called when the render object is drawn, with the view projection the gui is drawn with
+    static void RequestGuiTextureMipLevel(GuiWorld* gui_world, dmRender::HRenderContext render_context, const dmRender::RenderObject* ro)
+    {
+        // Text nodes are drawn from the vertex buffers of their fonts
+        if (ro->m_VertexBuffer != gui_world->m_VertexBuffer || !IsTextureStreamed(ro->m_Textures[0]))
+            return;
+
+        const dmArray<BoxVertex>& vb = gui_world->m_ClientVertexBuffer;
+        if (ro->m_VertexStart + ro->m_VertexCount > vb.Size())
+            return;
+
+        RequestTextureMipLevel(render_context, ro->m_Textures[0], Matrix4::identity(), vb.Begin() + ro->m_VertexStart, ro->m_VertexCount,
+                               sizeof(BoxVertex), offsetof(BoxVertex, m_Position), offsetof(BoxVertex, m_UV));
+    }
+
     static void RenderListDispatch(dmRender::RenderListDispatchParams const &params)
     {
         if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
         {
+            GuiWorld* gui_world = (GuiWorld*) params.m_UserData;
             for (uint32_t *i=params.m_Begin;i!=params.m_End;i++)
             {
                 dmRender::RenderObject *ro = (dmRender::RenderObject*) params.m_Buf[*i].m_UserData;
+                RequestGuiTextureMipLevel(gui_world, params.m_Context, ro);
                 dmRender::AddToRender(params.m_Context, ro);
             }
         }
     }
 
+    // Uploads the vertices of all gui scenes once per frame. If the vertex count is the same as the
+    // previous frame, only the ranges that aren't already in the vertex buffer are uploaded.
+    static void UploadVertexBuffer(GuiWorld* gui_world)
+    {
+        DM_PROFILE("UploadVertexBuffer");
+
+        const dmArray<BoxVertex>& vb = gui_world->m_ClientVertexBuffer;
+        const dmArray<uint32_t>& clean_ranges = gui_world->m_CleanVertexRanges;
+        const uint32_t vertex_count = vb.Size();
+
+        DM_PROPERTY_ADD_U32(rmtp_GuiVertexCount, vertex_count);
+
+        if (vertex_count == 0)
+        {
+            gui_world->m_UploadedVertexCount = 0;
+            return;
+        }
+
+        uint32_t clean_count = 0;
+        for (uint32_t i = 0; i < clean_ranges.Size(); i += 2)
+        {
+            clean_count += clean_ranges[i+1];
+        }
+
+        // Uploading the whole buffer in one call is cheaper than many small uploads
+        if (vertex_count != gui_world->m_UploadedVertexCount || clean_count < vertex_count / 2)
+        {
+            dmGraphics::SetVertexBufferData(gui_world->m_VertexBuffer, vertex_count * sizeof(BoxVertex), vb.Begin(), dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+            gui_world->m_UploadedVertexCount = vertex_count;
+            DM_PROPERTY_ADD_U32(rmtp_GuiUploadedVertexCount, vertex_count);
+            return;
+        }
+
+        uint32_t start = 0;
+        for (uint32_t i = 0; i <= clean_ranges.Size(); i += 2)
+        {
+            uint32_t end = i < clean_ranges.Size() ? clean_ranges[i] : vertex_count;
+            if (end > start)
+            {
+                dmGraphics::SetVertexBufferSubData(gui_world->m_VertexBuffer, start * sizeof(BoxVertex), (end - start) * sizeof(BoxVertex), vb.Begin() + start);
+                DM_PROPERTY_ADD_U32(rmtp_GuiUploadedVertexCount, end - start);
+            }
+            if (i < clean_ranges.Size())
+                start = clean_ranges[i] + clean_ranges[i+1];
+        }
+    }
+
     static inline dmRender::HMaterial GetMaterial(GuiComponent* component, GuiSceneResource* resource) {
         return component->m_Material ? component->m_Material : resource->m_Material;
     }
@@ -2094,6 +2336,11 @@ namespace dmGameSystem
         render_gui_context.m_GuiWorld = gui_world;
         render_gui_context.m_NextSortOrder = 0;
 
+        if (gui_world->m_TextureUploads.Size() > 0)
+        {
+            FreeTextureUploads(gui_world, 0);
+        }
+
         uint32_t total_node_count = 0;
         for (uint32_t i = 0; i < gui_world->m_Components.Size(); ++i)
         {
@@ -2116,7 +2363,13 @@ namespace dmGameSystem
         }
 
         gui_world->m_GuiRenderObjects.SetSize(0);
+
+        // The vertices of the previous frame are kept in the buffer, so that unchanged nodes can reuse them
+        gui_world->m_RetainedVertexCount = gui_world->m_ClientVertexBuffer.Size();
+        gui_world->m_ReusedVertexCount = 0;
         gui_world->m_ClientVertexBuffer.SetSize(0);
+        gui_world->m_CleanVertexRanges.SetSize(0);
+        gui_world->m_RenderFrame++;
 
         uint32_t lastEnd = 0;
 
@@ -2128,6 +2381,7 @@ namespace dmGameSystem
 
             // Render scene and see how many render objects it added, then we add those individually.
             render_gui_context.m_Material = GetMaterial(c, c->m_Resource);
+            render_gui_context.m_Component = c;
             dmGui::RenderScene(c->m_Scene, rp, &render_gui_context);
             const uint32_t count = gui_world->m_GuiRenderObjects.Size() - lastEnd;
 
@@ -2153,6 +2407,8 @@ namespace dmGameSystem
             dmRender::RenderListSubmit(gui_context->m_RenderContext, render_list, write_ptr);
         }
 
+        UploadVertexBuffer(gui_world);
+
         return dmGameObject::UPDATE_RESULT_OK;
     }
 
@@ -30,6 +30,34 @@ namespace dmGameSystem
     struct GuiSceneResource;
     struct CompGuiContext;
 
+    // The inputs used to generate the vertices of a box or pie node.
+    // If these are unchanged since the previous frame, and the vertices of the node start at the
+    // same offset in the client vertex buffer, they are reused in place instead of being generated
+    // again. Nodes whose vertices moved to another offset are generated again, see ReuseNodeVertices.
+    // The key is compared with memcmp, and must be cleared before it's filled in.
+    struct GuiNodeVertexKey
+    {
+        dmVMath::Matrix4        m_Transform;
+        dmVMath::Vector4        m_Color;
+        dmVMath::Vector4        m_Params;       // box: slice9, pie: inner radius, fill angle, perimeter vertices, outer bounds
+        float                   m_TexCoords[6];
+        float                   m_Size[2];
+        float                   m_TextureSize[2];
+        dmGraphics::HTexture    m_Texture;
+        const void*             m_TextureSet;
+        int32_t                 m_AnimationFrame;
+        uint32_t                m_Flags;
+    };
+
+    struct GuiNodeVertexCache
+    {
+        GuiNodeVertexKey        m_Key;
+        dmGui::HNode            m_Node;
+        uint32_t                m_VertexStart;  // Offset into the client vertex buffer of frame m_Frame
+        uint32_t                m_VertexCount;
+        uint32_t                m_Frame;
+    };
+
     struct GuiComponent
     {
         struct GuiWorld*        m_World;
@@ -41,6 +69,7 @@ namespace dmGameSystem
         uint8_t                 m_Enabled : 1;
         uint8_t                 m_AddedToUpdate : 1;
         dmArray<void*>          m_ResourcePropertyPointers;
+        dmArray<GuiNodeVertexCache> m_NodeVertexCache; // Indexed by node index
     };
 
     struct BoxVertex
@@ -119,6 +148,13 @@ namespace dmGameSystem
     };
 
 
+    // Copy of the data of a dynamic texture, kept until its SetTextureAsync upload has completed
+    struct GuiTextureUpload
+    {
+        dmGraphics::HTexture m_Texture;
+        void*                m_Data;
+    };
+
     struct GuiWorld
     {
         dmArray<GuiRenderObject>            m_GuiRenderObjects;
@@ -127,7 +163,13 @@ namespace dmGameSystem
         dmGraphics::HVertexDeclaration      m_VertexDeclaration;
         dmGraphics::HVertexBuffer           m_VertexBuffer;
         dmArray<BoxVertex>                  m_ClientVertexBuffer;
+        uint32_t                            m_RetainedVertexCount;          // Size of the client vertex buffer the previous frame
+        uint32_t                            m_ReusedVertexCount;            // Vertices reused from the previous frame, see ReuseNodeVertices
+        dmArray<uint32_t>                   m_CleanVertexRanges;            // Pairs of (start, count) equal to the uploaded vertex buffer
+        uint32_t                            m_UploadedVertexCount;
+        uint32_t                            m_RenderFrame;
         dmGraphics::HTexture                m_WhiteTexture;
+        dmArray<GuiTextureUpload>           m_TextureUploads;
         dmParticle::HParticleContext        m_ParticleContext;
         uint32_t                            m_MaxParticleFXCount;
         uint32_t                            m_MaxParticleCount;
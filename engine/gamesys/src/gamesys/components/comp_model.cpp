@@ -38,6 +38,7 @@
 #include "../resources/res_skeleton.h"
 #include "../resources/res_animationset.h"
 #include "../resources/res_meshset.h"
+#include "../resources/res_texture.h"
 #include "comp_private.h"
 
 #include <gamesys/gamesys_ddf.h>
@@ -48,6 +49,7 @@ DM_PROPERTY_EXTERN(rmtp_Components);
 DM_PROPERTY_U32(rmtp_Model, 0, FrameReset, "# components", &rmtp_Components);
 DM_PROPERTY_U32(rmtp_ModelVertexCount, 0, FrameReset, "# vertices", &rmtp_Model);
 DM_PROPERTY_U32(rmtp_ModelVertexSize, 0, FrameReset, "size of vertices in bytes", &rmtp_Model);
+DM_PROPERTY_U32(rmtp_ModelInstanceCount, 0, FrameReset, "# instanced components", &rmtp_Model);
 
 namespace dmGameSystem
 {
@@ -92,6 +94,12 @@ namespace dmGameSystem
         uint32_t                        m_MaxElementsVertices;
         uint32_t                        m_VertexBufferSwapChainIndex;
         uint32_t                        m_VertexBufferSwapChainSize;
+        // Instancing of local space models. One instance vertex buffer is used per instanced render object.
+        dmGraphics::HVertexDeclaration  m_InstanceVertexDeclaration;
+        dmArray<dmGraphics::HVertexBuffer> m_InstanceVertexBuffers;
+        dmArray<Matrix4>                m_InstanceData;
+        uint32_t                        m_InstanceVertexBufferIndex;
+        uint8_t                         m_InstancingSupported : 1;
     };
 
     static const uint32_t VERTEX_BUFFER_MAX_BATCHES = 16;     // Max dmRender::RenderListEntry.m_MinorOrder (4 bits)
@@ -103,6 +111,10 @@ namespace dmGameSystem
 
     static const uint32_t MAX_TEXTURE_COUNT = dmRender::RenderObject::MAX_TEXTURE_COUNT;
 
+    // A local space material is drawn instanced if its vertex program has this (mat4) attribute.
+    // It then holds the world transform of each model, instead of the world transform constants.
+    static const char* INSTANCE_ATTRIBUTE_WORLD = "mtx_world";
+
     static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params);
     static void DestroyComponent(ModelWorld* world, uint32_t index);
 
@@ -135,6 +147,17 @@ namespace dmGameSystem
         dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
         world->m_MaxElementsVertices = dmGraphics::GetMaxElementsVertices(graphics_context);
+        // One stream per matrix column
+        dmGraphics::VertexElement ve_instance[] =
+        {
+                {INSTANCE_ATTRIBUTE_WORLD, 0, 4, dmGraphics::TYPE_FLOAT, false},
+                {INSTANCE_ATTRIBUTE_WORLD, 1, 4, dmGraphics::TYPE_FLOAT, false},
+                {INSTANCE_ATTRIBUTE_WORLD, 2, 4, dmGraphics::TYPE_FLOAT, false},
+                {INSTANCE_ATTRIBUTE_WORLD, 3, 4, dmGraphics::TYPE_FLOAT, false},
+        };
+        world->m_InstanceVertexDeclaration = dmGraphics::NewVertexDeclaration(graphics_context, ve_instance, sizeof(ve_instance) / sizeof(dmGraphics::VertexElement), sizeof(Matrix4));
+        world->m_InstanceVertexBufferIndex = 0;
+        world->m_InstancingSupported = dmGraphics::IsInstancingSupported(graphics_context);
         world->m_VertexBuffers = new dmGraphics::HVertexBuffer[VERTEX_BUFFER_MAX_BATCHES];
         world->m_VertexBufferData = new dmArray<dmRig::RigModelVertex>[VERTEX_BUFFER_MAX_BATCHES];
         for(uint32_t i = 0; i < VERTEX_BUFFER_MAX_BATCHES; ++i)
@@ -157,6 +180,11 @@ namespace dmGameSystem
         {
             dmGraphics::DeleteVertexBuffer(world->m_VertexBuffers[i]);
         }
+        dmGraphics::DeleteVertexDeclaration(world->m_InstanceVertexDeclaration);
+        for(uint32_t i = 0; i < world->m_InstanceVertexBuffers.Size(); ++i)
+        {
+            dmGraphics::DeleteVertexBuffer(world->m_InstanceVertexBuffers[i]);
+        }
 
         dmResource::UnregisterResourceReloadedCallback(((ModelContext*)params.m_Context)->m_Factory, ResourceReloadedCallback, world);
 
@@ -264,6 +292,11 @@ namespace dmGameSystem
         if (component->m_RenderConstants) {
             dmGameSystem::HashRenderConstants(component->m_RenderConstants, &state);
         }
+        // Local space models are instanced per mesh, while world space models are merged into one vertex buffer
+        if (dmRender::GetMaterialVertexSpace(material) == dmRenderDDF::MaterialDesc::VERTEX_SPACE_LOCAL) {
+            dmHashUpdateBuffer32(&state, &resource->m_VertexBuffer, sizeof(resource->m_VertexBuffer));
+            dmHashUpdateBuffer32(&state, &resource->m_IndexBuffer, sizeof(resource->m_IndexBuffer));
+        }
         component->m_MixedHash = dmHashFinal32(&state);
         component->m_ReHash = 0;
     }
@@ -466,10 +499,171 @@ namespace dmGameSystem
         return dmGameObject::CREATE_RESULT_OK;
     }
 
+    static bool UseInstancing(ModelWorld* world, dmRender::HMaterial material)
+    {
+        if (dmGraphics::GetAttributeLocation(dmRender::GetMaterialProgram(material), INSTANCE_ATTRIBUTE_WORLD) == -1)
+            return false;
+
+        if (!world->m_InstancingSupported)
+        {
+            dmLogOnceWarning("The material uses the '%s' attribute, but instancing isn't supported by the graphics device", INSTANCE_ATTRIBUTE_WORLD);
+            return false;
+        }
+        return true;
+    }
+
+    static dmGraphics::HVertexBuffer GetInstanceVertexBuffer(ModelWorld* world, dmRender::HRenderContext render_context)
+    {
+        dmArray<dmGraphics::HVertexBuffer>& buffers = world->m_InstanceVertexBuffers;
+        if (world->m_InstanceVertexBufferIndex == buffers.Size())
+        {
+            if (buffers.Full())
+                buffers.OffsetCapacity(8);
+            buffers.Push(dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(render_context), 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW));
+        }
+        return buffers[world->m_InstanceVertexBufferIndex++];
+    }
+
+    static inline bool IsSameMesh(const ModelResource* a, const ModelResource* b)
+    {
+        return a->m_VertexBuffer == b->m_VertexBuffer && a->m_IndexBuffer == b->m_IndexBuffer && a->m_ElementCount == b->m_ElementCount;
+    }
+
+    // Requests the mip levels of the streamed textures of a model, from its triangles drawn with the world transform
+    static void RequestModelTextureMipLevels(dmRender::HRenderContext render_context, const ModelComponent* component, const ModelResource* resource,
+                                             const dmRig::RigModelVertex* vertices, uint32_t vertex_count, const Matrix4& world)
+    {
+        for (uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i)
+        {
+            dmGraphics::HTexture texture = GetTexture(component, resource, i);
+            if (texture && IsTextureStreamed(texture))
+            {
+                RequestTextureMipLevel(render_context, texture, world, vertices, vertex_count, sizeof(dmRig::RigModelVertex),
+                                       offsetof(dmRig::RigModelVertex, x), offsetof(dmRig::RigModelVertex, u));
+            }
+        }
+    }
+
+    // Local space models have their mesh in GPU memory only. A few of its triangles are read from the mesh
+    // resource instead, to estimate the mip levels of the streamed textures of the model.
+    static void RequestLocalModelTextureMipLevels(dmRender::HRenderContext render_context, const ModelComponent* component, const ModelResource* resource)
+    {
+        bool streamed = false;
+        for (uint32_t i = 0; i < MAX_TEXTURE_COUNT && !streamed; ++i)
+        {
+            dmGraphics::HTexture texture = GetTexture(component, resource, i);
+            streamed = texture && IsTextureStreamed(texture);
+        }
+        const dmRigDDF::MeshSet* mesh_set = resource->m_RigScene->m_MeshSetRes->m_MeshSet;
+        if (!streamed || !mesh_set || mesh_set->m_MeshAttachments.m_Count == 0)
+            return;
+
+        const dmRigDDF::Mesh& mesh = mesh_set->m_MeshAttachments[0];
+        bool indices_32 = mesh.m_IndicesFormat == dmRig::INDEXBUFFER_FORMAT_32;
+        uint32_t index_count = indices_32 ? mesh.m_Indices.m_Count >> 2 : mesh.m_Indices.m_Count >> 1;
+
+        const uint32_t max_triangles = 8;
+        dmRig::RigModelVertex vertices[max_triangles * 3];
+        uint32_t triangle_count = index_count / 3;
+        uint32_t step = dmMath::Max(1U, triangle_count / max_triangles);
+        uint32_t vertex_count = 0;
+        for (uint32_t t = 0; t < triangle_count && vertex_count < max_triangles * 3; t += step)
+        {
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                uint32_t index = t * 3 + i;
+                index = indices_32 ? ((const uint32_t*) mesh.m_Indices.m_Data)[index] : ((const uint16_t*) mesh.m_Indices.m_Data)[index];
+                const dmRigDDF::MeshVertexIndices& mvi = mesh.m_Vertices[index];
+                dmRig::RigModelVertex& v = vertices[vertex_count++];
+                v.x = mesh.m_Positions[mvi.m_Position*3+0];
+                v.y = mesh.m_Positions[mvi.m_Position*3+1];
+                v.z = mesh.m_Positions[mvi.m_Position*3+2];
+                v.u = mesh.m_Texcoord0[mvi.m_Texcoord0*2+0];
+                v.v = mesh.m_Texcoord0[mvi.m_Texcoord0*2+1];
+            }
+        }
+        RequestModelTextureMipLevels(render_context, component, resource, vertices, vertex_count, component->m_World);
+    }
+
+    // Draws each run of models sharing the same mesh with one instanced draw call.
+    // The batch already shares material, textures and constants.
+    static void RenderBatchLocalVSInstanced(ModelWorld* world, dmRender::HMaterial material, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE("RenderBatchLocalInstanced");
+
+        uint32_t* run_begin = begin;
+        while (run_begin != end)
+        {
+            const ModelComponent* first = (ModelComponent*) buf[*run_begin].m_UserData;
+            const ModelResource* mr = first->m_Resource;
+            assert(mr->m_VertexBuffer);
+
+            uint32_t* run_end = run_begin + 1;
+            while (run_end != end && IsSameMesh(mr, ((ModelComponent*) buf[*run_end].m_UserData)->m_Resource))
+                ++run_end;
+
+            uint32_t instance_count = run_end - run_begin;
+            dmArray<Matrix4>& instance_data = world->m_InstanceData;
+            instance_data.SetSize(0);
+            if (instance_data.Capacity() < instance_count)
+                instance_data.SetCapacity(instance_count);
+            for (uint32_t *i=run_begin;i!=run_end;i++)
+            {
+                const ModelComponent* component = (ModelComponent*) buf[*i].m_UserData;
+                instance_data.Push(component->m_World);
+                RequestLocalModelTextureMipLevels(render_context, component, component->m_Resource);
+            }
+
+            dmGraphics::HVertexBuffer instance_buffer = GetInstanceVertexBuffer(world, render_context);
+            dmGraphics::SetVertexBufferData(instance_buffer, sizeof(Matrix4) * instance_count, instance_data.Begin(), dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+
+            dmRender::RenderObject& ro = *world->m_RenderObjects.End();
+            world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
+
+            ro.Init();
+            ro.m_VertexDeclaration = world->m_VertexDeclaration;
+            ro.m_VertexBuffer = mr->m_VertexBuffer;
+            ro.m_Material = GetMaterial(first, mr);
+            ro.m_PrimitiveType = dmGraphics::PRIMITIVE_TRIANGLES;
+            ro.m_VertexStart = 0;
+            ro.m_VertexCount = mr->m_ElementCount;
+            ro.m_InstanceVertexDeclaration = world->m_InstanceVertexDeclaration;
+            ro.m_InstanceVertexBuffer = instance_buffer;
+            ro.m_InstanceCount = instance_count;
+
+            if(mr->m_IndexBuffer)
+            {
+                ro.m_IndexBuffer = mr->m_IndexBuffer;
+                ro.m_IndexType = mr->m_IndexBufferElementType;
+            }
+
+            for(uint32_t i = 0; i < MAX_TEXTURE_COUNT; ++i)
+            {
+                ro.m_Textures[i] = GetTexture(first, mr, i);
+            }
+
+            if (first->m_RenderConstants) {
+                dmGameSystem::EnableRenderObjectConstants(&ro, first->m_RenderConstants);
+            }
+
+            dmRender::AddToRender(render_context, &ro);
+            DM_PROPERTY_ADD_U32(rmtp_ModelInstanceCount, instance_count);
+
+            run_begin = run_end;
+        }
+    }
+
     static inline void RenderBatchLocalVS(ModelWorld* world, dmRender::HMaterial material, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE("RenderBatchLocal");
 
+        const ModelComponent* first = (ModelComponent*) buf[*begin].m_UserData;
+        if (UseInstancing(world, GetMaterial(first, first->m_Resource)))
+        {
+            RenderBatchLocalVSInstanced(world, material, render_context, buf, begin, end);
+            return;
+        }
+
         for (uint32_t *i=begin;i!=end;i++)
         {
             dmRender::RenderObject& ro = *world->m_RenderObjects.End();
@@ -479,6 +673,8 @@ namespace dmGameSystem
             const ModelResource* mr = component->m_Resource;
             assert(mr->m_VertexBuffer);
 
+            RequestLocalModelTextureMipLevels(render_context, component, mr);
+
             ro.Init();
             ro.m_VertexDeclaration = world->m_VertexDeclaration;
             ro.m_VertexBuffer = mr->m_VertexBuffer;
@@ -549,6 +745,9 @@ namespace dmGameSystem
         }
         vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
 
+        // The vertices are generated in world space
+        RequestModelTextureMipLevels(render_context, first, resource, vb_begin, vb_end - vb_begin, Matrix4::identity());
+
         // Ninja in-place writing of render object.
         dmRender::RenderObject& ro = *world->m_RenderObjects.End();
         world->m_RenderObjects.SetSize(world->m_RenderObjects.Size()+1);
@@ -675,6 +874,7 @@ namespace dmGameSystem
             case dmRender::RENDER_LIST_OPERATION_BEGIN:
             {
                 world->m_RenderObjects.SetSize(0);
+                world->m_InstanceVertexBufferIndex = 0;
                 for (uint32_t batch_index = 0; batch_index < VERTEX_BUFFER_MAX_BATCHES; ++batch_index)
                 {
                     world->m_VertexBufferData[batch_index].SetSize(0);
@@ -33,6 +33,7 @@
 #include "../gamesys_private.h"
 
 #include "resources/res_particlefx.h"
+#include "resources/res_texture.h"
 #include "resources/res_textureset.h"
 
 DM_PROPERTY_EXTERN(rmtp_Components);
@@ -274,6 +275,10 @@ namespace dmGameSystem
         uint32_t ro_vertex_count = vb_end - vb_begin;
         vertex_buffer.SetSize(vb_end - vertex_buffer.Begin());
 
+        // The particles are generated in world space
+        RequestTextureMipLevel(render_context, (dmGraphics::HTexture)first->m_Texture, Matrix4::identity(), vb_begin, ro_vertex_count,
+                               sizeof(dmParticle::Vertex), offsetof(dmParticle::Vertex, m_X), offsetof(dmParticle::Vertex, m_U));
+
         // In place writing of render object
         uint32_t ro_index = pfx_world->m_RenderObjects.Size();
         pfx_world->m_RenderObjects.SetSize(ro_index+1);
@@ -33,6 +33,7 @@
 #include <gameobject/gameobject_ddf.h>
 
 #include "../resources/res_sprite.h"
+#include "../resources/res_texture.h"
 #include "../gamesys.h"
 #include "../gamesys_private.h"
 #include "comp_private.h"
@@ -108,9 +109,9 @@ namespace dmGameSystem
         dmArray<float>                  m_BoundingVolumes;
         uint32_t                        m_RenderObjectsInUse;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
-        dmGraphics::HVertexBuffer       m_VertexBuffer;
-        SpriteVertex*                   m_VertexBufferData;
-        SpriteVertex*                   m_VertexBufferWritePtr;
+        dmGraphics::HTransientBuffer    m_VertexBuffer;
+        dmArray<dmGraphics::HTransientBuffer> m_RetiredVertexBuffers; // Replaced by a larger buffer during the last frame
+        uint32_t                        m_VertexCount;
         dmGraphics::HIndexBuffer        m_IndexBuffer;
         uint8_t*                        m_IndexBufferData;
         uint8_t*                        m_IndexBufferWritePtr;
@@ -144,19 +145,24 @@ namespace dmGameSystem
         }
     }
 
+    static void DeleteRetiredVertexBuffers(SpriteWorld* sprite_world, dmGraphics::HContext graphics_context)
+    {
+        for (uint32_t i = 0; i < sprite_world->m_RetiredVertexBuffers.Size(); ++i)
+        {
+            dmGraphics::DeleteTransientBuffer(graphics_context, sprite_world->m_RetiredVertexBuffers[i]);
+        }
+        sprite_world->m_RetiredVertexBuffers.SetSize(0);
+    }
+
     static void ReAllocateBuffers(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, uint32_t max_sprite_count, uint32_t num_vertices_per_sprite, uint32_t num_indices_per_sprite) {
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
         if (sprite_world->m_VertexBuffer) {
-            dmGraphics::DeleteVertexBuffer(sprite_world->m_VertexBuffer);
+            dmGraphics::DeleteTransientBuffer(graphics_context, sprite_world->m_VertexBuffer);
             sprite_world->m_VertexBuffer = 0;
         }
 
-        if (sprite_world->m_VertexBuffer == 0)
-            sprite_world->m_VertexBuffer = dmGraphics::NewVertexBuffer(dmRender::GetGraphicsContext(render_context), 0, 0x0, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
-
-        {
-            uint32_t memsize = sizeof(SpriteVertex) * num_vertices_per_sprite * max_sprite_count;
-            sprite_world->m_VertexBufferData = (SpriteVertex*) malloc(memsize);
-        }
+        // The vertices are written straight into slices of a transient buffer each frame
+        sprite_world->m_VertexBuffer = dmGraphics::NewTransientBuffer(graphics_context, sizeof(SpriteVertex) * num_vertices_per_sprite * max_sprite_count);
 
         {
             uint32_t vertex_count = num_vertices_per_sprite * max_sprite_count;
@@ -208,7 +214,7 @@ namespace dmGameSystem
         sprite_world->m_VertexDeclaration = dmGraphics::NewVertexDeclaration(dmRender::GetGraphicsContext(render_context), ve, sizeof(ve) / sizeof(dmGraphics::VertexElement));
 
         sprite_world->m_VertexBuffer = 0;
-        sprite_world->m_VertexBufferData = 0;
+        sprite_world->m_VertexCount = 0;
         sprite_world->m_IndexBuffer = 0;
         sprite_world->m_IndexBufferData = 0;
 
@@ -228,9 +234,12 @@ namespace dmGameSystem
             delete sprite_world->m_RenderObjects[i];
         }
 
+        SpriteContext* sprite_context = (SpriteContext*)params.m_Context;
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(sprite_context->m_RenderContext);
+
         dmGraphics::DeleteVertexDeclaration(sprite_world->m_VertexDeclaration);
-        dmGraphics::DeleteVertexBuffer(sprite_world->m_VertexBuffer);
-        free(sprite_world->m_VertexBufferData);
+        dmGraphics::DeleteTransientBuffer(graphics_context, sprite_world->m_VertexBuffer);
+        DeleteRetiredVertexBuffers(sprite_world, graphics_context);
         dmGraphics::DeleteIndexBuffer(sprite_world->m_IndexBuffer);
         free(sprite_world->m_IndexBufferData);
 
@@ -438,8 +447,8 @@ namespace dmGameSystem
         {
             const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
 
-            // The offset for the indices
-            uint32_t vertex_offset = *vb_where - sprite_world->m_VertexBufferData;
+            // The indices are relative to the vertices of the batch, which are bound at the offset of their slice
+            uint32_t vertex_offset = 0;
 
             for (uint32_t* i = begin; i != end; ++i)
             {
@@ -584,6 +593,96 @@ namespace dmGameSystem
         *ib_where = indices;
     }
 
+    static uint32_t GetVertexCount(SpriteWorld* sprite_world, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        if (!sprite_world->m_UseGeometries)
+        {
+            return (end - begin) * 4;
+        }
+
+        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+        const dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
+        const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
+        const uint32_t* frame_indices = texture_set_ddf->m_FrameIndices.m_Data;
+        const dmArray<SpriteComponent>& components = sprite_world->m_Components.m_Objects;
+
+        uint32_t vertex_count = 0;
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            const SpriteComponent* component = &components[(uint32_t)buf[*i].m_UserData];
+            const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+            uint32_t frame_index = frame_indices[animation_ddf->m_Start + component->m_CurrentAnimationFrame];
+            vertex_count += geometries[frame_index].m_Vertices.m_Count / 2;
+        }
+        return vertex_count;
+    }
+
+    static SpriteVertex* AllocVertices(SpriteWorld* sprite_world, dmGraphics::HContext graphics_context, uint32_t vertex_count, dmGraphics::HVertexBuffer* vertex_buffer, uint32_t* vertex_buffer_offset)
+    {
+        uint32_t size = vertex_count * sizeof(SpriteVertex);
+        void* vertices = dmGraphics::AllocTransientBuffer(graphics_context, sprite_world->m_VertexBuffer, size, sizeof(float), vertex_buffer, vertex_buffer_offset);
+        if (!vertices)
+        {
+            // The buffer is full this frame (e.g. when the sprites are drawn by several predicates).
+            // It's replaced by a larger buffer, and deleted once the frame has been rendered.
+            dmGraphics::FlushTransientBuffer(graphics_context, sprite_world->m_VertexBuffer);
+            uint32_t new_size = dmMath::Max(size, dmGraphics::GetTransientBufferSize(sprite_world->m_VertexBuffer) * 2);
+
+            if (sprite_world->m_RetiredVertexBuffers.Full())
+            {
+                sprite_world->m_RetiredVertexBuffers.OffsetCapacity(2);
+            }
+            sprite_world->m_RetiredVertexBuffers.Push(sprite_world->m_VertexBuffer);
+
+            sprite_world->m_VertexBuffer = dmGraphics::NewTransientBuffer(graphics_context, new_size);
+            vertices = dmGraphics::AllocTransientBuffer(graphics_context, sprite_world->m_VertexBuffer, size, sizeof(float), vertex_buffer, vertex_buffer_offset);
+            assert(vertices);
+        }
+        return (SpriteVertex*) vertices;
+    }
+
+    // Requests the mip level of a streamed texture needed to draw the sprites of a batch at their size on screen
+    static void RequestSpriteTextureMipLevel(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmGraphics::HTexture texture, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        const Matrix4& view_proj = dmRender::GetViewProjectionMatrix(render_context);
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        float half_width = 0.5f * dmGraphics::GetWidth(graphics_context);
+        float half_height = 0.5f * dmGraphics::GetHeight(graphics_context);
+
+        const dmArray<SpriteComponent>& components = sprite_world->m_Components.m_Objects;
+        float min_texels_per_pixel = FLT_MAX;
+        for (uint32_t* i = begin; i != end; ++i)
+        {
+            const SpriteComponent* component = &components[(uint32_t)buf[*i].m_UserData];
+
+            // The world transform is scaled with the size of the sprite, so the x and y axes span the sprite on screen
+            Matrix4 m = view_proj * component->m_World;
+            float w = m.getCol3().getW();
+            if (w <= 0.0f)
+                continue;
+
+            float x0 = m.getCol0().getX() * half_width;
+            float y0 = m.getCol0().getY() * half_height;
+            float x1 = m.getCol1().getX() * half_width;
+            float y1 = m.getCol1().getY() * half_height;
+            float pixels_x = sqrtf(x0 * x0 + y0 * y0) / w;
+            float pixels_y = sqrtf(x1 * x1 + y1 * y1) / w;
+            if (pixels_x <= 0.0f || pixels_y <= 0.0f)
+                continue;
+
+            float texels_per_pixel = dmMath::Max(component->m_Size.getX() / pixels_x, component->m_Size.getY() / pixels_y);
+            min_texels_per_pixel = dmMath::Min(min_texels_per_pixel, texels_per_pixel);
+        }
+
+        if (min_texels_per_pixel == FLT_MAX)
+            return;
+
+        uint32_t mip_level = min_texels_per_pixel > 1.0f ? (uint32_t) log2f(min_texels_per_pixel) : 0;
+        RequestTextureMipLevel(texture, mip_level);
+    }
+
     static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
     {
         DM_PROFILE("SpriteRenderBatch");
@@ -595,6 +694,11 @@ namespace dmGameSystem
         SpriteResource* resource = first->m_Resource;
         TextureSetResource* texture_set = GetTextureSet(first, resource);
 
+        if (IsTextureStreamed(texture_set->m_Texture))
+        {
+            RequestSpriteTextureMipLevel(sprite_world, render_context, texture_set->m_Texture, buf, begin, end);
+        }
+
         // Although we generally like to preallocate it, we cannot since we
         // 1) don't want to preallocate max_sprite number of render objects and
         // 2) We cannot keep the render object in a (small) fixed array and then reallocate it, since we pass the pointer to the render engine
@@ -608,18 +712,25 @@ namespace dmGameSystem
         dmRender::RenderObject& ro = *sprite_world->m_RenderObjects[sprite_world->m_RenderObjectsInUse++];
 
         // Fill in vertex buffer
-        SpriteVertex* vb_begin = sprite_world->m_VertexBufferWritePtr;
-        uint8_t* ib_begin = (uint8_t*)sprite_world->m_IndexBufferWritePtr;
+        uint32_t vertex_count = GetVertexCount(sprite_world, texture_set, buf, begin, end);
+        dmGraphics::HVertexBuffer vertex_buffer = 0;
+        uint32_t vertex_buffer_offset = 0;
+        SpriteVertex* vb_begin = AllocVertices(sprite_world, dmRender::GetGraphicsContext(render_context), vertex_count, &vertex_buffer, &vertex_buffer_offset);
+
+        // The quad indices are the same for every batch, since the vertices of each batch start at index 0
+        uint8_t* ib_begin = sprite_world->m_UseGeometries ? sprite_world->m_IndexBufferWritePtr : sprite_world->m_IndexBufferData;
         SpriteVertex* vb_iter = vb_begin;
         uint8_t* ib_iter = ib_begin;
         CreateVertexData(sprite_world, &vb_iter, &ib_iter, texture_set, buf, begin, end);
+        assert((uint32_t)(vb_iter - vb_begin) == vertex_count);
 
-        sprite_world->m_VertexBufferWritePtr = vb_iter;
+        sprite_world->m_VertexCount += vertex_count;
         sprite_world->m_IndexBufferWritePtr = ib_iter;
 
         ro.Init();
         ro.m_VertexDeclaration = sprite_world->m_VertexDeclaration;
-        ro.m_VertexBuffer = sprite_world->m_VertexBuffer;
+        ro.m_VertexBuffer = vertex_buffer;
+        ro.m_VertexBufferOffset = vertex_buffer_offset;
         ro.m_IndexBuffer = sprite_world->m_IndexBuffer;
         ro.m_Material = GetMaterial(first, resource);
         ro.m_Textures[0] = texture_set->m_Texture;
@@ -914,18 +1025,17 @@ namespace dmGameSystem
         switch (params.m_Operation)
         {
             case dmRender::RENDER_LIST_OPERATION_BEGIN:
-                world->m_VertexBufferWritePtr = world->m_VertexBufferData;
+                world->m_VertexCount = 0;
                 world->m_IndexBufferWritePtr = world->m_IndexBufferData;
                 world->m_RenderObjectsInUse = 0;
                 break;
             case dmRender::RENDER_LIST_OPERATION_END:
                 {
-                    uint32_t vertex_count = world->m_VertexBufferWritePtr - world->m_VertexBufferData;
+                    uint32_t vertex_count = world->m_VertexCount;
                     uint32_t vertex_size = sizeof(SpriteVertex) * vertex_count;
                     if (vertex_size)
                     {
-                        dmGraphics::SetVertexBufferData(world->m_VertexBuffer, vertex_size,
-                                                        world->m_VertexBufferData, dmGraphics::BUFFER_USAGE_DYNAMIC_DRAW);
+                        dmGraphics::FlushTransientBuffer(dmRender::GetGraphicsContext(params.m_Context), world->m_VertexBuffer);
 
                         DM_PROPERTY_ADD_U32(rmtp_SpriteVertexCount, vertex_count);
                         DM_PROPERTY_ADD_U32(rmtp_SpriteVertexSize, vertex_size);
@@ -967,6 +1077,8 @@ namespace dmGameSystem
         if (!sprite_count)
             return dmGameObject::UPDATE_RESULT_OK;
 
+        DeleteRetiredVertexBuffers(sprite_world, dmRender::GetGraphicsContext(render_context));
+
         if (sprite_world->m_ReallocBuffers)
         {
             // Old version has always 4 vertices. New version has up to 8 vertices.
@@ -24,6 +24,7 @@
 #include <input/input.h>
 #include <render/render.h>
 #include <resource/resource.h>
+#include <sound/sound.h>
 
 #include "resources/res_collection_proxy.h"
 #include "resources/res_collision_object.h"
@@ -107,6 +108,10 @@ namespace dmGameSystem
         // gui_scriptc: res_gui_script.cpp
         REGISTER_RESOURCE_TYPE("wavc", 0, 0, ResSoundDataCreate, 0, ResSoundDataDestroy, ResSoundDataRecreate);
         REGISTER_RESOURCE_TYPE("oggc", 0, 0, ResSoundDataCreate, 0, ResSoundDataDestroy, ResSoundDataRecreate);
+        // Large ogg sounds are streamed by the sound system instead of being loaded
+        e = dmResource::SetStreamingThreshold(factory, "oggc", dmSound::GetStreamingThreshold());
+        if (e != dmResource::RESULT_OK)
+            return e;
         REGISTER_RESOURCE_TYPE("soundc", 0, ResSoundPreload, ResSoundCreate, 0, ResSoundDestroy, ResSoundRecreate);
         REGISTER_RESOURCE_TYPE("camerac", 0, 0, ResCameraCreate, 0, ResCameraDestroy, ResCameraRecreate);
         REGISTER_RESOURCE_TYPE("input_bindingc", input_context, 0, ResInputBindingCreate, 0, ResInputBindingDestroy, ResInputBindingRecreate);
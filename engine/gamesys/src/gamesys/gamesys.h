@@ -192,6 +192,34 @@ namespace dmGameSystem
         uint32_t m_MaxCollectionFactoryCount;
     };
 
+    struct TextureStreamingParams
+    {
+        TextureStreamingParams()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+        dmResource::HFactory    m_Factory;
+        dmGraphics::HContext    m_GraphicsContext;
+        uint32_t                m_MemoryBudget;     // Texture memory budget in bytes for the streamed textures. 0 means no budget
+        uint32_t                m_MinSize;          // Streamed textures are loaded with their top mip no larger than this
+        uint32_t                m_EvictFrames;      // Top mips of textures that haven't been drawn for this many frames are dropped
+    };
+
+    /**
+     * Enable streaming of the mip levels of 2D textures. A streamed texture is loaded with its
+     * lower mips only, and higher mips are loaded when render components request them.
+     * Must be called before any textures are loaded, and finalized after the factory is deleted.
+     */
+    void InitializeTextureStreaming(const TextureStreamingParams& params);
+    void FinalizeTextureStreaming();
+
+    /**
+     * Loads or drops the top mips of the streamed textures, based on the requests of the previous frame.
+     * One texture is streamed at a time. Its file is read on a separate thread, and its mips are
+     * uploaded in a later call.
+     */
+    void UpdateTextureStreaming();
+
     bool InitializeScriptLibs(const ScriptLibContext& context);
     void FinalizeScriptLibs(const ScriptLibContext& context);
 
@@ -34,6 +34,7 @@
 #include "scripts/script_window.h"
 #include "scripts/script_collectionproxy.h"
 #include "scripts/script_buffer.h"
+#include "scripts/script_go_batch.h"
 #include "components/comp_gui.h"
 #include <liveupdate/liveupdate.h>
 
@@ -126,6 +127,7 @@ namespace dmGameSystem
         ScriptModelRegister(context);
         ScriptWindowRegister(context);
         ScriptCollectionProxyRegister(context);
+        ScriptGameObjectBatchRegister(context);
 
         assert(top == lua_gettop(L));
         return result;
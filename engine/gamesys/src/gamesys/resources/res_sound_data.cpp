@@ -12,12 +12,47 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#include <stdlib.h>
 #include <string.h>
+#include <dlib/log.h>
 #include <sound/sound.h>
 #include "res_sound_data.h"
 
 namespace dmGameSystem
 {
+    static dmSound::Result ReadSoundDataStream(void* context, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+    {
+        dmResource::Result r = dmResource::ReadResourceStream((dmResource::HResourceStream) context, offset, size, buffer, nread);
+        return r == dmResource::RESULT_OK ? dmSound::RESULT_OK : dmSound::RESULT_INVALID_STREAM_DATA;
+    }
+
+    static void CloseSoundDataStream(void* context)
+    {
+        dmResource::CloseResourceStream((dmResource::HResourceStream) context);
+    }
+
+    // Large ogg sounds are created without data (see dmResource::SetStreamingThreshold), and streamed while playing
+    static dmResource::Result NewSoundDataStreaming(const dmResource::ResourceCreateParams& params, dmSound::HSoundData* sound_data)
+    {
+        dmResource::HResourceStream stream;
+        uint32_t size;
+        dmResource::Result r = dmResource::OpenResourceStream(params.m_Factory, params.m_Filename, &stream, &size);
+        if (r != dmResource::RESULT_OK)
+        {
+            dmLogError("Failed to open sound stream '%s' (%d)", params.m_Filename, r);
+            return r;
+        }
+
+        dmSound::Result sr = dmSound::NewSoundDataStreaming(ReadSoundDataStream, CloseSoundDataStream, stream, size, dmSound::SOUND_DATA_TYPE_OGG_VORBIS,
+                                                            sound_data, params.m_Resource->m_NameHash);
+        if (sr != dmSound::RESULT_OK)
+        {
+            dmResource::CloseResourceStream(stream);
+            return sr == dmSound::RESULT_OUT_OF_INSTANCES ? dmResource::RESULT_OUT_OF_RESOURCES : dmResource::RESULT_INVALID_DATA;
+        }
+        return dmResource::RESULT_OK;
+    }
+
     dmResource::Result ResSoundDataCreate(const dmResource::ResourceCreateParams& params)
     {
         dmSound::HSoundData sound_data;
@@ -30,10 +65,21 @@ namespace dmGameSystem
             type = dmSound::SOUND_DATA_TYPE_OGG_VORBIS;
         }
 
-        dmSound::Result r = dmSound::NewSoundData(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
-        if (r != dmSound::RESULT_OK)
+        if (type == dmSound::SOUND_DATA_TYPE_OGG_VORBIS && params.m_BufferSize == 0)
+        {
+            dmResource::Result r = NewSoundDataStreaming(params, &sound_data);
+            if (r != dmResource::RESULT_OK)
+            {
+                return r;
+            }
+        }
+        else
         {
-            return dmResource::RESULT_OUT_OF_RESOURCES;
+            dmSound::Result r = dmSound::NewSoundData(params.m_Buffer, params.m_BufferSize, type, &sound_data, params.m_Resource->m_NameHash);
+            if (r != dmSound::RESULT_OK)
+            {
+                return dmResource::RESULT_OUT_OF_RESOURCES;
+            }
         }
 
         params.m_Resource->m_Resource = (void*) sound_data;
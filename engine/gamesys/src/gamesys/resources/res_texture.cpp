@@ -14,14 +14,26 @@
 
 #include "res_texture.h"
 
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlib/condition_variable.h>
+#include <dlib/hashtable.h>
 #include <dlib/log.h>
+#include <dlib/mutex.h>
 #include <dlib/profile.h>
+#include <dlib/thread.h>
 #include <dlib/time.h>
 #include <dlib/math.h>
 #include <graphics/graphics.h>
+#include <render/render.h>
+#include <resource/resource.h>
+#include "../gamesys.h"
 
 namespace dmGameSystem
 {
+    using namespace dmVMath;
+
     static const uint32_t s_MaxMipCount = 32;
     struct ImageDesc
     {
@@ -31,6 +43,59 @@ namespace dmGameSystem
         bool m_UseBlankTexture;
     };
 
+    // A texture that is streamed keeps only the mips from m_ResidentMip and down uploaded.
+    // Higher mips are requested by the render components that draw the texture, and unused
+    // top mips are dropped again when the texture memory budget is exceeded.
+    struct StreamingTexture
+    {
+        char*       m_Path;
+        uint64_t    m_PathHash;
+        uint32_t    m_ResidentSize;         // GPU memory of the resident mips
+        uint32_t    m_LastUsedFrame;
+        uint16_t    m_Width;                // Size of mip 0
+        uint16_t    m_Height;
+        uint8_t     m_StartMip;             // Top mip that is uploaded when the texture is loaded
+        uint8_t     m_ResidentMip;          // Top mip that is currently uploaded
+        uint8_t     m_RequestedMip;         // Lowest mip level requested since the last update
+        uint8_t     m_PendingMip;           // Top mip of the mip change in progress
+    };
+
+    enum StreamingState
+    {
+        STREAMING_STATE_IDLE,
+        STREAMING_STATE_LOADING,            // The texture file is read on the streaming thread
+        STREAMING_STATE_LOADED,             // The texture file is read, and the mips are ready to be uploaded
+        STREAMING_STATE_UPLOADING,          // The mips are uploaded by the graphics adapter
+    };
+
+    struct TextureStreaming
+    {
+        dmResource::HFactory            m_Factory;
+        dmGraphics::HContext            m_GraphicsContext;
+        dmHashTable64<StreamingTexture> m_Textures;     // Keyed by the texture handle
+        dmThread::Thread                m_Thread;       // 0 on platforms without threads, where the file is read in UpdateTextureStreaming()
+        dmMutex::HMutex                 m_Mutex;
+        dmConditionVariable::HConditionVariable m_Condition;
+        bool                            m_Active;
+
+        // The mip change in progress. One texture is streamed at a time.
+        // m_State, m_PendingImage and m_PendingResult are shared with the streaming thread.
+        StreamingState                  m_State;
+        dmGraphics::HTexture            m_PendingTexture;   // 0 if the texture was destroyed while its file was read
+        char*                           m_PendingPath;
+        dmGraphics::TextureImage*       m_PendingImage;
+        ImageDesc*                      m_PendingImageDesc;
+        dmResource::Result              m_PendingResult;
+
+        uint32_t                        m_MemoryBudget;
+        uint32_t                        m_MemoryUsage;
+        uint32_t                        m_MinSize;
+        uint32_t                        m_EvictFrames;
+        uint32_t                        m_Frame;
+    };
+
+    static TextureStreaming* g_TextureStreaming = 0;
+
     static dmGraphics::TextureFormat TextureImageToTextureFormat(dmGraphics::TextureImage::TextureFormat format)
     {
 #define CASE_TF(_X) case dmGraphics::TextureImage::TEXTURE_FORMAT_ ## _X:    return dmGraphics::TEXTURE_FORMAT_ ## _X
@@ -84,7 +149,9 @@ namespace dmGameSystem
         dmGraphics::SetTextureAsync(texture, params);
     }
 
-    dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, ImageDesc* image_desc, dmGraphics::HTexture texture, dmGraphics::HTexture* texture_out)
+    // Uploads the mips from start_mip and down. The size of the texture is the size of start_mip.
+    // With resize_mip_chain, an existing texture is resized to the new mip chain, keeping its smallest mip level.
+    dmResource::Result AcquireResources(const char* path, dmResource::SResourceDescriptor* resource_desc, dmGraphics::HContext context, ImageDesc* image_desc, dmGraphics::HTexture texture, uint32_t start_mip, bool resize_mip_chain, dmGraphics::HTexture* texture_out)
     {
         DM_PROFILE_DYN(path, 0);
 
@@ -116,12 +183,15 @@ namespace dmGameSystem
 
             result = dmResource::RESULT_OK;
 
+            uint32_t mip_offset = dmMath::Min(start_mip, num_mips > 0 ? num_mips - 1 : 0);
+
             dmGraphics::TextureCreationParams creation_params;
             dmGraphics::TextureParams params;
             dmGraphics::GetDefaultTextureFilters(context, params.m_MinFilter, params.m_MagFilter);
             params.m_Format = output_format;
-            params.m_Width = image->m_Width;
-            params.m_Height = image->m_Height;
+            params.m_Width = dmMath::Max(1U, image->m_Width >> mip_offset);
+            params.m_Height = dmMath::Max(1U, image->m_Height >> mip_offset);
+            params.m_ResizeMipChain = resize_mip_chain;
 
             assert(image->m_MipMapOffset.m_Count <= s_MaxMipCount);
 
@@ -132,11 +202,11 @@ namespace dmGameSystem
             } else {
                 assert(0);
             }
-            creation_params.m_Width = image->m_Width;
-            creation_params.m_Height = image->m_Height;
+            creation_params.m_Width = params.m_Width;
+            creation_params.m_Height = params.m_Height;
             creation_params.m_OriginalWidth = image->m_OriginalWidth;
             creation_params.m_OriginalHeight = image->m_OriginalHeight;
-            creation_params.m_MipMapCount = image->m_MipMapOffset.m_Count;
+            creation_params.m_MipMapCount = image->m_MipMapOffset.m_Count > mip_offset ? image->m_MipMapOffset.m_Count - mip_offset : 1;
 
             if (!texture)
                 texture = dmGraphics::NewTexture(context, creation_params);
@@ -164,9 +234,9 @@ namespace dmGameSystem
                 break;
             }
 
-            for (uint32_t i = 0; i < num_mips; ++i)
+            for (uint32_t i = mip_offset; i < num_mips; ++i)
             {
-                params.m_MipMap = i;
+                params.m_MipMap = i - mip_offset;
                 params.m_Data = image_desc->m_DecompressedData[i] == 0 ? &image->m_Data[image->m_MipMapOffset[i]] : image_desc->m_DecompressedData[i];
                 params.m_DataSize = image_desc->m_DecompressedData[i] == 0 ? image->m_MipMapSize[i] : image_desc->m_DecompressedDataSize[i];
                 dmGraphics::SetTextureAsync(texture, params);
@@ -230,6 +300,461 @@ namespace dmGameSystem
         delete image_desc;
     }
 
+    static inline uint64_t GetStreamingTextureKey(dmGraphics::HTexture texture)
+    {
+        return (uint64_t)(uintptr_t) texture;
+    }
+
+    static StreamingTexture* GetStreamingTexture(dmGraphics::HTexture texture)
+    {
+        return g_TextureStreaming ? g_TextureStreaming->m_Textures.Get(GetStreamingTextureKey(texture)) : 0;
+    }
+
+    // Returns the top mip a texture is loaded with, or 0 if the texture isn't streamed
+    static uint32_t GetStreamingStartMip(const dmGraphics::TextureImage* texture_image)
+    {
+        if (!g_TextureStreaming || texture_image->m_Type != dmGraphics::TextureImage::TYPE_2D || texture_image->m_Alternatives.m_Count == 0)
+            return 0;
+
+        const dmGraphics::TextureImage::Image* image = &texture_image->m_Alternatives[0];
+        uint32_t mip_count = image->m_MipMapOffset.m_Count;
+        uint32_t size = dmMath::Max(image->m_Width, image->m_Height);
+        uint32_t mip = 0;
+        while (mip + 1 < mip_count && (size >> mip) > g_TextureStreaming->m_MinSize)
+        {
+            ++mip;
+        }
+        return mip;
+    }
+
+    static void AddStreamingTexture(const char* path, uint64_t path_hash, dmGraphics::HTexture texture, const dmGraphics::TextureImage* texture_image, uint32_t start_mip)
+    {
+        TextureStreaming* ts = g_TextureStreaming;
+        if (ts->m_Textures.Full())
+        {
+            uint32_t capacity = ts->m_Textures.Capacity() + 64;
+            ts->m_Textures.SetCapacity(dmMath::Max(17U, capacity / 2), capacity);
+        }
+
+        const dmGraphics::TextureImage::Image* image = &texture_image->m_Alternatives[0];
+        StreamingTexture entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.m_Path          = strdup(path);
+        entry.m_PathHash      = path_hash;
+        entry.m_LastUsedFrame = ts->m_Frame;
+        entry.m_Width         = (uint16_t) image->m_Width;
+        entry.m_Height        = (uint16_t) image->m_Height;
+        entry.m_StartMip      = (uint8_t) start_mip;
+        entry.m_ResidentMip   = (uint8_t) start_mip;
+        entry.m_RequestedMip  = (uint8_t) start_mip;
+        entry.m_PendingMip    = (uint8_t) start_mip;
+        ts->m_Textures.Put(GetStreamingTextureKey(texture), entry);
+    }
+
+    static void SetStreamingTextureSize(StreamingTexture* entry, uint32_t size)
+    {
+        g_TextureStreaming->m_MemoryUsage = g_TextureStreaming->m_MemoryUsage - entry->m_ResidentSize + size;
+        entry->m_ResidentSize = size;
+    }
+
+    // Reads and parses the texture file. Called on the streaming thread
+    static dmResource::Result LoadStreamingImage(dmResource::HFactory factory, const char* path, dmGraphics::TextureImage** texture_image)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        void* buffer = 0;
+        uint32_t buffer_size = 0;
+        dmResource::Result r = dmResource::GetRaw(factory, path, &buffer, &buffer_size);
+        if (r != dmResource::RESULT_OK)
+            return r;
+
+        dmDDF::Result e = dmDDF::LoadMessage<dmGraphics::TextureImage>(buffer, buffer_size, texture_image);
+        free(buffer);
+        return e == dmDDF::RESULT_OK ? dmResource::RESULT_OK : dmResource::RESULT_FORMAT_ERROR;
+    }
+
+    static void StreamingThread(void* args)
+    {
+        TextureStreaming* ts = (TextureStreaming*) args;
+        while (true)
+        {
+            const char* path;
+            {
+                dmMutex::ScopedLock lk(ts->m_Mutex);
+                while (ts->m_Active && ts->m_State != STREAMING_STATE_LOADING)
+                    dmConditionVariable::Wait(ts->m_Condition, ts->m_Mutex);
+                if (!ts->m_Active)
+                    break;
+                path = ts->m_PendingPath;
+            }
+
+            dmGraphics::TextureImage* texture_image = 0;
+            dmResource::Result r = LoadStreamingImage(ts->m_Factory, path, &texture_image);
+
+            dmMutex::ScopedLock lk(ts->m_Mutex);
+            ts->m_PendingImage  = texture_image;
+            ts->m_PendingResult = r;
+            ts->m_State         = STREAMING_STATE_LOADED;
+            dmConditionVariable::Broadcast(ts->m_Condition);
+        }
+    }
+
+    // Returns the state of the mip change in progress, and waits for the texture file to be read if wait is set
+    static StreamingState GetStreamingState(TextureStreaming* ts, bool wait)
+    {
+        if (!ts->m_Thread)
+            return ts->m_State;
+
+        dmMutex::ScopedLock lk(ts->m_Mutex);
+        while (wait && ts->m_State == STREAMING_STATE_LOADING)
+            dmConditionVariable::Wait(ts->m_Condition, ts->m_Mutex);
+        return ts->m_State;
+    }
+
+    // Starts a mip change, by reading the texture file again on the streaming thread.
+    // The mips from mip and down are uploaded once the file is read
+    static void StartStreamingLoad(TextureStreaming* ts, dmGraphics::HTexture texture, StreamingTexture* entry, uint32_t mip)
+    {
+        entry->m_PendingMip  = (uint8_t) mip;
+        ts->m_PendingTexture = texture;
+        ts->m_PendingPath    = strdup(entry->m_Path);
+
+        if (!ts->m_Thread)
+        {
+            ts->m_PendingResult = LoadStreamingImage(ts->m_Factory, ts->m_PendingPath, &ts->m_PendingImage);
+            ts->m_State         = STREAMING_STATE_LOADED;
+            return;
+        }
+
+        dmMutex::ScopedLock lk(ts->m_Mutex);
+        ts->m_State = STREAMING_STATE_LOADING;
+        dmConditionVariable::Broadcast(ts->m_Condition);
+    }
+
+    static void RemoveStreamingTexture(dmGraphics::HTexture texture);
+
+    // Uploads the mips of a texture file that has been read. Only the mips from the pending mip and down are uploaded
+    static void StartStreamingUpload(TextureStreaming* ts)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        dmGraphics::HTexture texture = ts->m_PendingTexture;
+        StreamingTexture* entry = texture ? GetStreamingTexture(texture) : 0;
+        if (!entry || ts->m_PendingResult != dmResource::RESULT_OK)
+        {
+            if (entry)
+            {
+                dmLogWarning("Unable to stream texture %s (%s), the texture will no longer be streamed.", ts->m_PendingPath, dmResource::ResultToString(ts->m_PendingResult));
+            }
+            if (ts->m_PendingImage)
+                dmDDF::FreeMessage(ts->m_PendingImage);
+            free(ts->m_PendingPath);
+            ts->m_PendingTexture = 0;
+            ts->m_PendingPath    = 0;
+            ts->m_PendingImage   = 0;
+            ts->m_State          = STREAMING_STATE_IDLE;
+            if (entry)
+                RemoveStreamingTexture(texture);
+            return;
+        }
+
+        ImageDesc* image_desc = CreateImage(entry->m_Path, ts->m_GraphicsContext, ts->m_PendingImage);
+        dmGraphics::HTexture texture_out = texture;
+        AcquireResources(entry->m_Path, 0, ts->m_GraphicsContext, image_desc, texture, entry->m_PendingMip, true, &texture_out);
+
+        ts->m_PendingImageDesc = image_desc;
+        ts->m_State            = STREAMING_STATE_UPLOADING;
+    }
+
+    static void FinishStreamingUpload(TextureStreaming* ts)
+    {
+        dmGraphics::HTexture texture = ts->m_PendingTexture;
+
+        DestroyImage(ts->m_PendingImageDesc);
+        dmDDF::FreeMessage(ts->m_PendingImage);
+        free(ts->m_PendingPath);
+        ts->m_PendingTexture   = 0;
+        ts->m_PendingPath      = 0;
+        ts->m_PendingImage     = 0;
+        ts->m_PendingImageDesc = 0;
+        ts->m_State            = STREAMING_STATE_IDLE;
+
+        StreamingTexture* entry = ts->m_Textures.Get(GetStreamingTextureKey(texture));
+        if (!entry)
+            return;
+
+        uint32_t size = dmGraphics::GetTextureResourceSize(texture);
+        SetStreamingTextureSize(entry, size);
+        entry->m_ResidentMip = entry->m_PendingMip;
+
+        dmResource::SResourceDescriptor* rd = dmResource::FindByHash(ts->m_Factory, entry->m_PathHash);
+        if (rd)
+        {
+            rd->m_ResourceSize = size;
+        }
+    }
+
+    static void RemoveStreamingTexture(dmGraphics::HTexture texture)
+    {
+        StreamingTexture* entry = GetStreamingTexture(texture);
+        if (!entry)
+            return;
+
+        TextureStreaming* ts = g_TextureStreaming;
+        if (ts->m_PendingTexture == texture)
+        {
+            // The streaming thread reads its own copy of the path, and the result is discarded once the file is read
+            StreamingState state = GetStreamingState(ts, false);
+            if (state == STREAMING_STATE_UPLOADING)
+            {
+                SynchronizeTexture(texture, true);
+                FinishStreamingUpload(ts);
+            }
+            else
+            {
+                ts->m_PendingTexture = 0;
+            }
+        }
+        ts->m_MemoryUsage -= entry->m_ResidentSize;
+        free(entry->m_Path);
+        ts->m_Textures.Erase(GetStreamingTextureKey(texture));
+    }
+
+    struct StreamingCandidates
+    {
+        uint32_t                m_Frame;
+        uint32_t                m_EvictFrames;
+        dmGraphics::HTexture    m_Upgrade;          // The texture with the most mips requested above its resident mips
+        uint32_t                m_UpgradeMips;
+        dmGraphics::HTexture    m_Evict;            // The least recently used texture with mips above its start mip
+        uint32_t                m_EvictFrame;
+    };
+
+    static void FindStreamingCandidates(StreamingCandidates* candidates, const uint64_t* key, StreamingTexture* entry)
+    {
+        dmGraphics::HTexture texture = (dmGraphics::HTexture)(uintptr_t) *key;
+
+        // Only textures drawn in the previous frame have their requests honored
+        if (entry->m_RequestedMip < entry->m_ResidentMip && entry->m_LastUsedFrame + 1 >= candidates->m_Frame)
+        {
+            uint32_t mips = entry->m_ResidentMip - entry->m_RequestedMip;
+            if (mips > candidates->m_UpgradeMips)
+            {
+                candidates->m_Upgrade     = texture;
+                candidates->m_UpgradeMips = mips;
+            }
+        }
+
+        if (entry->m_ResidentMip < entry->m_StartMip && (!candidates->m_Evict || entry->m_LastUsedFrame < candidates->m_EvictFrame))
+        {
+            candidates->m_Evict      = texture;
+            candidates->m_EvictFrame = entry->m_LastUsedFrame;
+        }
+
+        entry->m_RequestedMip = entry->m_StartMip;
+    }
+
+    void InitializeTextureStreaming(const TextureStreamingParams& params)
+    {
+        assert(g_TextureStreaming == 0);
+        TextureStreaming* ts = new TextureStreaming;
+        ts->m_Factory          = params.m_Factory;
+        ts->m_GraphicsContext  = params.m_GraphicsContext;
+        ts->m_Thread           = 0;
+        ts->m_Mutex            = 0;
+        ts->m_Condition        = 0;
+        ts->m_Active           = true;
+        ts->m_State            = STREAMING_STATE_IDLE;
+        ts->m_PendingTexture   = 0;
+        ts->m_PendingPath      = 0;
+        ts->m_PendingImage     = 0;
+        ts->m_PendingImageDesc = 0;
+        ts->m_PendingResult    = dmResource::RESULT_OK;
+        ts->m_MemoryBudget     = params.m_MemoryBudget;
+        ts->m_MemoryUsage      = 0;
+        ts->m_MinSize          = dmMath::Max(1U, params.m_MinSize);
+        ts->m_EvictFrames      = params.m_EvictFrames;
+        ts->m_Frame            = 0;
+#if !defined(__EMSCRIPTEN__)
+        ts->m_Mutex     = dmMutex::New();
+        ts->m_Condition = dmConditionVariable::New();
+        ts->m_Thread    = dmThread::New(StreamingThread, 0x80000, ts, "texturestreaming");
+#endif
+        g_TextureStreaming = ts;
+    }
+
+    void FinalizeTextureStreaming()
+    {
+        TextureStreaming* ts = g_TextureStreaming;
+        if (!ts)
+            return;
+        // The factory has been deleted, and all the textures with it
+        assert(ts->m_Textures.Size() == 0);
+
+        if (ts->m_Thread)
+        {
+            // Any texture file that is still read belongs to a texture that has been destroyed
+            GetStreamingState(ts, true);
+            {
+                dmMutex::ScopedLock lk(ts->m_Mutex);
+                ts->m_Active = false;
+                dmConditionVariable::Broadcast(ts->m_Condition);
+            }
+            dmThread::Join(ts->m_Thread);
+            dmConditionVariable::Delete(ts->m_Condition);
+            dmMutex::Delete(ts->m_Mutex);
+        }
+        if (ts->m_PendingImage)
+            dmDDF::FreeMessage(ts->m_PendingImage);
+        free(ts->m_PendingPath);
+
+        delete ts;
+        g_TextureStreaming = 0;
+    }
+
+    void UpdateTextureStreaming()
+    {
+        TextureStreaming* ts = g_TextureStreaming;
+        if (!ts)
+            return;
+
+        DM_PROFILE(__FUNCTION__);
+        ts->m_Frame++;
+
+        switch (GetStreamingState(ts, false))
+        {
+            case STREAMING_STATE_LOADING:
+                return;
+            case STREAMING_STATE_LOADED:
+                StartStreamingUpload(ts);
+                return;
+            case STREAMING_STATE_UPLOADING:
+                if (!SynchronizeTexture(ts->m_PendingTexture, false))
+                    return;
+                FinishStreamingUpload(ts);
+                break;
+            default:
+                break;
+        }
+
+        StreamingCandidates candidates;
+        memset(&candidates, 0, sizeof(candidates));
+        candidates.m_Frame = ts->m_Frame;
+        ts->m_Textures.Iterate(FindStreamingCandidates, &candidates);
+
+        bool over_budget = ts->m_MemoryBudget > 0 && ts->m_MemoryUsage > ts->m_MemoryBudget;
+
+        // Drop the top mips of the least recently used texture when over budget, or when it hasn't been drawn in a while
+        if (candidates.m_Evict && candidates.m_Evict != candidates.m_Upgrade)
+        {
+            StreamingTexture* entry = GetStreamingTexture(candidates.m_Evict);
+            bool unused = ts->m_Frame - entry->m_LastUsedFrame > ts->m_EvictFrames;
+            if (unused || over_budget)
+            {
+                if (SynchronizeTexture(candidates.m_Evict, false))
+                {
+                    StartStreamingLoad(ts, candidates.m_Evict, entry, unused ? entry->m_StartMip : entry->m_ResidentMip + 1);
+                }
+                return;
+            }
+        }
+
+        if (candidates.m_Upgrade && !over_budget)
+        {
+            StreamingTexture* entry = GetStreamingTexture(candidates.m_Upgrade);
+            uint32_t mip = entry->m_ResidentMip - candidates.m_UpgradeMips;
+
+            // Each mip level up needs four times the memory of the current mips
+            if (ts->m_MemoryBudget > 0)
+            {
+                uint64_t usage = ts->m_MemoryUsage - entry->m_ResidentSize;
+                while (mip < entry->m_ResidentMip && usage + ((uint64_t) entry->m_ResidentSize << (2 * (entry->m_ResidentMip - mip))) > ts->m_MemoryBudget)
+                {
+                    ++mip;
+                }
+            }
+
+            if (mip < entry->m_ResidentMip && SynchronizeTexture(candidates.m_Upgrade, false))
+            {
+                StartStreamingLoad(ts, candidates.m_Upgrade, entry, mip);
+            }
+        }
+    }
+
+    bool IsTextureStreamed(dmGraphics::HTexture texture)
+    {
+        return GetStreamingTexture(texture) != 0;
+    }
+
+    void RequestTextureMipLevel(dmGraphics::HTexture texture, uint32_t mip_level)
+    {
+        StreamingTexture* entry = GetStreamingTexture(texture);
+        if (!entry)
+            return;
+        entry->m_LastUsedFrame = g_TextureStreaming->m_Frame;
+        if (mip_level < entry->m_RequestedMip)
+        {
+            entry->m_RequestedMip = (uint8_t) mip_level;
+        }
+    }
+
+    void RequestTextureMipLevel(dmRender::HRenderContext render_context, dmGraphics::HTexture texture, const Matrix4& world,
+                                const void* vertices, uint32_t vertex_count, uint32_t vertex_stride, uint32_t position_offset, uint32_t uv_offset)
+    {
+        StreamingTexture* entry = GetStreamingTexture(texture);
+        if (!entry || vertex_count < 3)
+            return;
+
+        DM_PROFILE(__FUNCTION__);
+
+        const Matrix4 m = dmRender::GetViewProjectionMatrix(render_context) * world;
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        float half_width = 0.5f * dmGraphics::GetWidth(graphics_context);
+        float half_height = 0.5f * dmGraphics::GetHeight(graphics_context);
+        float texture_area = (float) entry->m_Width * (float) entry->m_Height;
+
+        // A few triangles spread over the vertices are enough to estimate the texel density
+        const uint32_t max_sampled_triangles = 16;
+        uint32_t triangle_count = vertex_count / 3;
+        uint32_t step = dmMath::Max(1U, triangle_count / max_sampled_triangles);
+
+        float min_area_ratio = FLT_MAX;
+        const uint8_t* base = (const uint8_t*) vertices;
+        for (uint32_t t = 0; t < triangle_count; t += step)
+        {
+            float x[3], y[3], u[3], v[3];
+            uint32_t i = 0;
+            for (; i < 3; ++i)
+            {
+                const uint8_t* vertex = base + (t * 3 + i) * vertex_stride;
+                const float* position = (const float*) (vertex + position_offset);
+                const float* uv = (const float*) (vertex + uv_offset);
+                Vector4 clip = m * Point3(position[0], position[1], position[2]);
+                if (clip.getW() <= 0.0f)
+                    break;
+                x[i] = clip.getX() / clip.getW() * half_width;
+                y[i] = clip.getY() / clip.getW() * half_height;
+                u[i] = uv[0];
+                v[i] = uv[1];
+            }
+            if (i < 3)
+                continue;
+
+            float pixel_area = fabsf((x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]));
+            float texel_area = fabsf((u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0])) * texture_area;
+            if (pixel_area <= 0.0001f || texel_area <= 0.0f)
+                continue;
+            min_area_ratio = dmMath::Min(min_area_ratio, texel_area / pixel_area);
+        }
+
+        if (min_area_ratio == FLT_MAX)
+            return;
+
+        // The ratio of the areas is the square of the texels per pixel
+        uint32_t mip_level = min_area_ratio > 1.0f ? (uint32_t) (0.5f * log2f(min_area_ratio)) : 0;
+        RequestTextureMipLevel(texture, mip_level);
+    }
+
     dmResource::Result ResTexturePreload(const dmResource::ResourcePreloadParams& params)
     {
         DM_PROFILE(__FUNCTION__);
@@ -258,23 +783,36 @@ namespace dmGameSystem
         dmDDF::FreeMessage(image_desc->m_DDFImage);
         DestroyImage(image_desc);
         params.m_Resource->m_ResourceSize = dmGraphics::GetTextureResourceSize(texture);
+
+        StreamingTexture* entry = GetStreamingTexture(texture);
+        if (entry)
+        {
+            SetStreamingTextureSize(entry, params.m_Resource->m_ResourceSize);
+        }
         return dmResource::RESULT_OK;
     }
 
     dmResource::Result ResTextureCreate(const dmResource::ResourceCreateParams& params)
     {
         dmGraphics::HContext graphics_context = (dmGraphics::HContext) params.m_Context;
+        ImageDesc* image_desc = (ImageDesc*) params.m_PreloadData;
+        uint32_t start_mip = GetStreamingStartMip(image_desc->m_DDFImage);
         dmGraphics::HTexture texture;
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, (ImageDesc*) params.m_PreloadData, 0, &texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, 0, start_mip, false, &texture);
         if (r == dmResource::RESULT_OK)
         {
             params.m_Resource->m_Resource = (void*) texture;
+            if (start_mip > 0)
+            {
+                AddStreamingTexture(params.m_Filename, params.m_Resource->m_NameHash, texture, image_desc->m_DDFImage, start_mip);
+            }
         }
         return r;
     }
 
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params)
     {
+        RemoveStreamingTexture((dmGraphics::HTexture) params.m_Resource->m_Resource);
         dmGraphics::DeleteTexture((dmGraphics::HTexture) params.m_Resource->m_Resource);
         return dmResource::RESULT_OK;
     }
@@ -297,13 +835,24 @@ namespace dmGameSystem
         // Note that the image desc for performance reasons keeps references to the DDF image, meaning they're invalid after the DDF message has been free'd!
         ImageDesc* image_desc = CreateImage(params.m_Filename, (dmGraphics::HContext) params.m_Context, texture_image);
 
+        // Textures set from scripts have no file to stream the mips from, and are uploaded in full
+        bool was_streamed = IsTextureStreamed(texture);
+        RemoveStreamingTexture(texture);
+        uint32_t start_mip = params.m_Filename ? GetStreamingStartMip(texture_image) : 0;
+
         // Set up the new texture (version), wait for it to finish before issuing new requests
         SynchronizeTexture(texture, true);
-        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, texture, &texture);
+        dmResource::Result r = AcquireResources(params.m_Filename, params.m_Resource, graphics_context, image_desc, texture, start_mip, was_streamed || start_mip > 0, &texture);
 
         // Wait for any async texture uploads
         SynchronizeTexture(texture, true);
 
+        if (r == dmResource::RESULT_OK && start_mip > 0)
+        {
+            AddStreamingTexture(params.m_Filename, params.m_NameHash, texture, texture_image, start_mip);
+            SetStreamingTextureSize(GetStreamingTexture(texture), dmGraphics::GetTextureResourceSize(texture));
+        }
+
         DestroyImage(image_desc);
 
         if( params.m_Message == 0 )
@@ -15,7 +15,10 @@
 #ifndef DM_GAMESYS_RES_TEXTURE_H
 #define DM_GAMESYS_RES_TEXTURE_H
 
+#include <dmsdk/dlib/vmath.h>
 #include <resource/resource.h>
+#include <graphics/graphics.h>
+#include <render/render.h>
 #include <dmsdk/gamesys/resources/res_texture.h>
 
 namespace dmGameSystem
@@ -29,6 +32,19 @@ namespace dmGameSystem
     dmResource::Result ResTextureDestroy(const dmResource::ResourceDestroyParams& params);
 
     dmResource::Result ResTextureRecreate(const dmResource::ResourceRecreateParams& params);
+
+    // Returns true if the texture has its mip levels streamed
+    bool IsTextureStreamed(dmGraphics::HTexture texture);
+
+    // Called by render components drawing a streamed texture, with the highest resolution mip level
+    // they need on screen (0 being the full size texture)
+    void RequestTextureMipLevel(dmGraphics::HTexture texture, uint32_t mip_level);
+
+    // Requests the mip level of a streamed texture needed to draw a triangle list with the current view projection,
+    // estimated from the ratio of the triangles' areas in texels and in pixels. Each vertex has a position at
+    // position_offset, transformed by world, and texture coordinates at uv_offset.
+    void RequestTextureMipLevel(dmRender::HRenderContext render_context, dmGraphics::HTexture texture, const dmVMath::Matrix4& world,
+                                const void* vertices, uint32_t vertex_count, uint32_t vertex_stride, uint32_t position_offset, uint32_t uv_offset);
 }
 
 #endif
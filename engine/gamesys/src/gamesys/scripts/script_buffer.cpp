@@ -125,7 +125,7 @@ namespace dmGameSystem
         int                 m_BufferRef;// Holds a reference to the Lua object
     };
 
-    static inline dmBuffer::HBuffer UnpackLuaBuffer(dmScript::LuaHBuffer* lua_buffer)
+    dmBuffer::HBuffer UnpackLuaBuffer(dmScript::LuaHBuffer* lua_buffer)
     {
         if (lua_buffer->m_Owner == dmScript::OWNER_RES) {
             BufferResource* res = (BufferResource*)lua_buffer->m_BufferRes;
@@ -15,9 +15,19 @@
 #ifndef DM_GAMESYS_SCRIPT_BUFFER_H
 #define DM_GAMESYS_SCRIPT_BUFFER_H
 
+#include <dmsdk/dlib/buffer.h>
+
+namespace dmScript
+{
+    struct LuaHBuffer;
+}
+
 namespace dmGameSystem
 {
     void ScriptBufferRegister(const struct ScriptLibContext& context);
+
+    // Returns the buffer of a Lua buffer, whether it is owned by Lua, C or a resource
+    dmBuffer::HBuffer UnpackLuaBuffer(dmScript::LuaHBuffer* lua_buffer);
 }
 
 #endif // DM_GAMESYS_SCRIPT_BUFFER_H
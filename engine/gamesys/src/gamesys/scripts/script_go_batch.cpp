@@ -0,0 +1,331 @@
+// Copyright 2020-2022 The Defold Foundation
+// Copyright 2014-2020 King
+// Copyright 2009-2014 Ragnar Svensson, Christian Murray
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+// 
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+// 
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+
+#include <dlib/buffer.h>
+#include <dlib/hash.h>
+#include <dlib/profile.h>
+#include <gameobject/gameobject.h>
+#include <gameobject/script.h>
+
+#include "script_go_batch.h"
+#include "script_buffer.h"
+#include "../gamesys.h"
+
+#include <dmsdk/script/script.h>
+#include <dmsdk/gamesys/script.h>
+
+extern "C"
+{
+#include <lua/lauxlib.h>
+#include <lua/lualib.h>
+}
+
+namespace dmGameSystem
+{
+    /*# Game object batch API documentation
+     *
+     * Functions for reading and writing the transforms of many game objects
+     * in one call, through buffer streams. The functions extend the "go"
+     * namespace, and are accessible from game object script files.
+     *
+     * @document
+     * @name Game object batch
+     * @namespace go
+     */
+
+    enum BatchTransform
+    {
+        BATCH_TRANSFORM_POSITION,
+        BATCH_TRANSFORM_ROTATION,
+        BATCH_TRANSFORM_SCALE,
+    };
+
+    static const char* BATCH_FUNCTION_NAMES[][2] =
+    {
+        {"go.get_positions", "go.set_positions"},
+        {"go.get_rotations", "go.set_rotations"},
+        {"go.get_scales", "go.set_scales"},
+    };
+
+    static const char* BATCH_STREAM_NAMES[] = {"position", "rotation", "scale"};
+
+    static dmGameObject::HInstance ResolveBatchInstance(lua_State* L, dmGameObject::HCollection collection, int index, const char* function_name)
+    {
+        dmhash_t id;
+        if (dmScript::IsHash(L, index))
+        {
+            // Hashes are looked up directly, without resolving a URL
+            id = dmScript::CheckHash(L, index);
+        }
+        else
+        {
+            dmMessage::URL url;
+            dmScript::ResolveURL(L, index, &url, 0x0);
+            if (url.m_Socket != dmGameObject::GetMessageSocket(collection))
+            {
+                luaL_error(L, "%s can only access instances within the same collection.", function_name);
+            }
+            id = url.m_Path;
+        }
+
+        dmGameObject::HInstance instance = dmGameObject::GetInstanceFromIdentifier(collection, id);
+        if (!instance)
+        {
+            luaL_error(L, "%s: instance %s not found", function_name, dmHashReverseSafe64(id));
+        }
+        return instance;
+    }
+
+    // Resolves the arguments (ids, buffer, [stream_name]) shared by all batch functions
+    static float* CheckBatchArguments(lua_State* L, BatchTransform transform, bool set, uint32_t* out_count, uint32_t* out_stride, dmGameObject::HCollection* out_collection)
+    {
+        const char* function_name = BATCH_FUNCTION_NAMES[transform][set ? 1 : 0];
+
+        dmGameObject::HInstance self = dmGameObject::GetInstanceFromLua(L);
+        if (!self)
+        {
+            luaL_error(L, "%s can only be called from a game object script.", function_name);
+        }
+        luaL_checktype(L, 1, LUA_TTABLE);
+
+        dmBuffer::HBuffer buffer = UnpackLuaBuffer(dmScript::CheckBuffer(L, 2));
+        dmhash_t stream_name = lua_isnoneornil(L, 3) ? dmHashString64(BATCH_STREAM_NAMES[transform]) : dmScript::CheckHashOrString(L, 3);
+
+        dmBuffer::ValueType type;
+        uint32_t components = 0;
+        dmBuffer::Result r = dmBuffer::GetStreamType(buffer, stream_name, &type, &components);
+        if (r != dmBuffer::RESULT_OK)
+        {
+            luaL_error(L, "%s: the buffer has no stream '%s'", function_name, dmHashReverseSafe64(stream_name));
+        }
+        uint32_t required_components = transform == BATCH_TRANSFORM_ROTATION ? 4 : 3;
+        if (type != dmBuffer::VALUE_TYPE_FLOAT32 || components < required_components)
+        {
+            luaL_error(L, "%s: the stream '%s' must have at least %d float32 components", function_name, dmHashReverseSafe64(stream_name), required_components);
+        }
+
+        float* data = 0;
+        uint32_t count = 0;
+        uint32_t stride = 0;
+        dmBuffer::GetStream(buffer, stream_name, (void**)&data, &count, &components, &stride);
+
+        uint32_t id_count = (uint32_t) lua_objlen(L, 1);
+        if (id_count > count)
+        {
+            luaL_error(L, "%s: %d ids but the stream only has room for %d elements", function_name, id_count, count);
+        }
+
+        *out_count = id_count;
+        *out_stride = stride;
+        *out_collection = dmGameObject::GetCollection(self);
+        return data;
+    }
+
+    static int GetTransforms(lua_State* L, BatchTransform transform)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        uint32_t count, stride;
+        dmGameObject::HCollection collection;
+        float* data = CheckBatchArguments(L, transform, false, &count, &stride, &collection);
+
+        for (uint32_t i = 0; i < count; ++i, data += stride)
+        {
+            lua_rawgeti(L, 1, i + 1);
+            dmGameObject::HInstance instance = ResolveBatchInstance(L, collection, -1, BATCH_FUNCTION_NAMES[transform][0]);
+            lua_pop(L, 1);
+
+            if (transform == BATCH_TRANSFORM_POSITION)
+            {
+                dmVMath::Point3 p = dmGameObject::GetPosition(instance);
+                data[0] = p.getX(); data[1] = p.getY(); data[2] = p.getZ();
+            }
+            else if (transform == BATCH_TRANSFORM_ROTATION)
+            {
+                dmVMath::Quat q = dmGameObject::GetRotation(instance);
+                data[0] = q.getX(); data[1] = q.getY(); data[2] = q.getZ(); data[3] = q.getW();
+            }
+            else
+            {
+                dmVMath::Vector3 s = dmGameObject::GetScale(instance);
+                data[0] = s.getX(); data[1] = s.getY(); data[2] = s.getZ();
+            }
+        }
+        return 0;
+    }
+
+    static int SetTransforms(lua_State* L, BatchTransform transform)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        uint32_t count, stride;
+        dmGameObject::HCollection collection;
+        const float* data = CheckBatchArguments(L, transform, true, &count, &stride, &collection);
+
+        for (uint32_t i = 0; i < count; ++i, data += stride)
+        {
+            lua_rawgeti(L, 1, i + 1);
+            dmGameObject::HInstance instance = ResolveBatchInstance(L, collection, -1, BATCH_FUNCTION_NAMES[transform][1]);
+            lua_pop(L, 1);
+
+            if (transform == BATCH_TRANSFORM_POSITION)
+            {
+                dmGameObject::SetPosition(instance, dmVMath::Point3(data[0], data[1], data[2]));
+            }
+            else if (transform == BATCH_TRANSFORM_ROTATION)
+            {
+                dmGameObject::SetRotation(instance, dmVMath::Quat(data[0], data[1], data[2], data[3]));
+            }
+            else
+            {
+                dmGameObject::SetScale(instance, dmVMath::Vector3(data[0], data[1], data[2]));
+            }
+        }
+        return 0;
+    }
+
+    /*# gets the positions of several game object instances
+     * Reads the positions of a list of game object instances into a buffer stream in one call.
+     * Element i of the stream receives the position of the instance at index i of the list.
+     * Ids given as hashes are looked up directly and are cheaper than strings or urls.
+     * The positions are relative to the parents, as with [ref:go.get_position].
+     *
+     * @name go.get_positions
+     * @param ids [type:table] list of game object ids, each a [type:hash], [type:string] or [type:url]
+     * @param buffer [type:buffer] buffer to write the positions to
+     * @param [stream_name] [type:hash|string] name of a float32 stream with at least 3 components, "position" by default
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *     self.ids = { hash("/boid1"), hash("/boid2") }
+     *     self.buffer = buffer.create(#self.ids, { {name=hash("position"), type=buffer.VALUE_TYPE_FLOAT32, count=3} })
+     *     self.positions = buffer.get_stream(self.buffer, "position")
+     * end
+     *
+     * function update(self, dt)
+     *     go.get_positions(self.ids, self.buffer)
+     *     for i = 1, #self.positions, 3 do
+     *         self.positions[i] = self.positions[i] + dt
+     *     end
+     *     go.set_positions(self.ids, self.buffer)
+     * end
+     * ```
+     */
+    static int Script_GetPositions(lua_State* L)
+    {
+        return GetTransforms(L, BATCH_TRANSFORM_POSITION);
+    }
+
+    /*# sets the positions of several game object instances
+     * Sets the positions of a list of game object instances from a buffer stream in one call.
+     * Element i of the stream is the position of the instance at index i of the list.
+     *
+     * @name go.set_positions
+     * @param ids [type:table] list of game object ids, each a [type:hash], [type:string] or [type:url]
+     * @param buffer [type:buffer] buffer to read the positions from
+     * @param [stream_name] [type:hash|string] name of a float32 stream with at least 3 components, "position" by default
+     */
+    static int Script_SetPositions(lua_State* L)
+    {
+        return SetTransforms(L, BATCH_TRANSFORM_POSITION);
+    }
+
+    /*# gets the rotations of several game object instances
+     * Reads the rotations of a list of game object instances into a buffer stream in one call.
+     * The quaternions are stored as x, y, z, w.
+     *
+     * @name go.get_rotations
+     * @param ids [type:table] list of game object ids, each a [type:hash], [type:string] or [type:url]
+     * @param buffer [type:buffer] buffer to write the rotations to
+     * @param [stream_name] [type:hash|string] name of a float32 stream with at least 4 components, "rotation" by default
+     */
+    static int Script_GetRotations(lua_State* L)
+    {
+        return GetTransforms(L, BATCH_TRANSFORM_ROTATION);
+    }
+
+    /*# sets the rotations of several game object instances
+     * Sets the rotations of a list of game object instances from a buffer stream in one call.
+     * The quaternions are read as x, y, z, w.
+     *
+     * @name go.set_rotations
+     * @param ids [type:table] list of game object ids, each a [type:hash], [type:string] or [type:url]
+     * @param buffer [type:buffer] buffer to read the rotations from
+     * @param [stream_name] [type:hash|string] name of a float32 stream with at least 4 components, "rotation" by default
+     */
+    static int Script_SetRotations(lua_State* L)
+    {
+        return SetTransforms(L, BATCH_TRANSFORM_ROTATION);
+    }
+
+    /*# gets the 3D scales of several game object instances
+     * Reads the 3D scale factors of a list of game object instances into a buffer stream in one call.
+     *
+     * @name go.get_scales
+     * @param ids [type:table] list of game object ids, each a [type:hash], [type:string] or [type:url]
+     * @param buffer [type:buffer] buffer to write the scales to
+     * @param [stream_name] [type:hash|string] name of a float32 stream with at least 3 components, "scale" by default
+     */
+    static int Script_GetScales(lua_State* L)
+    {
+        return GetTransforms(L, BATCH_TRANSFORM_SCALE);
+    }
+
+    /*# sets the 3D scales of several game object instances
+     * Sets the 3D scale factors of a list of game object instances from a buffer stream in one call.
+     *
+     * @name go.set_scales
+     * @param ids [type:table] list of game object ids, each a [type:hash], [type:string] or [type:url]
+     * @param buffer [type:buffer] buffer to read the scales from
+     * @param [stream_name] [type:hash|string] name of a float32 stream with at least 3 components, "scale" by default
+     */
+    static int Script_SetScales(lua_State* L)
+    {
+        return SetTransforms(L, BATCH_TRANSFORM_SCALE);
+    }
+
+    static const luaL_reg Module_methods[] =
+    {
+        {"get_positions", Script_GetPositions},
+        {"set_positions", Script_SetPositions},
+        {"get_rotations", Script_GetRotations},
+        {"set_rotations", Script_SetRotations},
+        {"get_scales", Script_GetScales},
+        {"set_scales", Script_SetScales},
+        {0, 0}
+    };
+
+    void ScriptGameObjectBatchRegister(const ScriptLibContext& context)
+    {
+        lua_State* L = context.m_LuaState;
+        int top = lua_gettop(L);
+        (void)top;
+
+        // Extends the go namespace registered by the game object library. The gui scripts
+        // have no go namespace, and don't get one.
+        lua_getglobal(L, "go");
+        bool has_go = lua_istable(L, -1);
+        lua_pop(L, 1);
+        if (has_go)
+        {
+            luaL_register(L, "go", Module_methods);
+            lua_pop(L, 1);
+        }
+
+        assert(top == lua_gettop(L));
+    }
+}
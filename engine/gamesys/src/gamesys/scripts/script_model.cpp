@@ -38,6 +38,12 @@ namespace dmGameSystem
      *
      * Functions and messages for interacting with model components.
      *
+     * Models using a local space material are drawn instanced, with one draw call for all models
+     * sharing mesh, material, textures and constants, if the vertex program of the material
+     * declares a `mat4` attribute named `mtx_world`. It holds the world transform of each model and
+     * replaces the world transform constants, which can't vary per instance. The builtin model
+     * materials don't declare it, so instancing requires a custom material.
+     *
      * @document
      * @name Model
      * @namespace model
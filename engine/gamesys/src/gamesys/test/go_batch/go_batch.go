@@ -0,0 +1,4 @@
+components {
+  id: "script"
+  component: "/go_batch/go_batch.script"
+}
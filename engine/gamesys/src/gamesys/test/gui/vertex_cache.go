@@ -0,0 +1,15 @@
+components {
+  id: "gui"
+  component: "/gui/vertex_cache.gui"
+  position {
+    x: 0.0
+    y: 0.0
+    z: 0.0
+  }
+  rotation {
+    x: 0.0
+    y: 0.0
+    z: 0.0
+    w: 1.0
+  }
+}
@@ -17,6 +17,7 @@
 #include "../../../../graphics/src/graphics_private.h"
 #include "../../../../resource/src/resource_private.h"
 
+#include "gamesys/resources/res_texture.h"
 #include "gamesys/resources/res_textureset.h"
 
 #include <stdio.h>
@@ -167,6 +168,70 @@ TEST_F(ResourceTest, TestReloadTextureSet)
     dmResource::Release(m_Factory, (void**) resource);
 }
 
+// Runs the streaming updates until the texture has the expected width, or gives up
+static bool WaitForStreamedTextureWidth(dmGraphics::HTexture texture, uint32_t width, bool request)
+{
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        if (request)
+            dmGameSystem::RequestTextureMipLevel(texture, 0);
+        dmGameSystem::UpdateTextureStreaming();
+        if (dmGraphics::GetTextureWidth(texture) == width)
+            return true;
+        dmTime::Sleep(1000);
+    }
+    return false;
+}
+
+TEST_F(TextureStreamingTest, LoadAndEvictMips)
+{
+    dmGraphics::HTexture texture = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/blank_4096_png.texturec", (void**) &texture));
+    ASSERT_NE((dmGraphics::HTexture) 0, texture);
+
+    // Only the mips up to the streaming min size are loaded up front
+    ASSERT_TRUE(dmGameSystem::IsTextureStreamed(texture));
+    ASSERT_EQ(256u, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(256u, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(4096u, dmGraphics::GetOriginalTextureWidth(texture));
+
+    // Mips that aren't requested are never loaded
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        dmGameSystem::UpdateTextureStreaming();
+    }
+    ASSERT_EQ(256u, dmGraphics::GetTextureWidth(texture));
+
+    // The file is read on the streaming thread, and the mips are uploaded in a later update
+    ASSERT_TRUE(WaitForStreamedTextureWidth(texture, 4096, true));
+    ASSERT_EQ(4096u, dmGraphics::GetTextureHeight(texture));
+
+    // The top mips are dropped again once the texture isn't drawn
+    ASSERT_TRUE(WaitForStreamedTextureWidth(texture, 256, false));
+
+    dmResource::Release(m_Factory, (void*) texture);
+}
+
+TEST_F(TextureStreamingTest, ReleaseWhileLoading)
+{
+    dmGraphics::HTexture texture = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, "/texture/blank_4096_png.texturec", (void**) &texture));
+    ASSERT_TRUE(dmGameSystem::IsTextureStreamed(texture));
+
+    // Starts reading the texture file, which is discarded when the texture is gone
+    dmGameSystem::RequestTextureMipLevel(texture, 0);
+    dmGameSystem::UpdateTextureStreaming();
+    dmGameSystem::UpdateTextureStreaming();
+
+    dmResource::Release(m_Factory, (void*) texture);
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        dmGameSystem::UpdateTextureStreaming();
+        dmTime::Sleep(1000);
+    }
+}
+
 TEST_P(ResourceFailTest, Test)
 {
     const ResourceFailParams& p = GetParam();
@@ -941,6 +1006,42 @@ TEST_F(WindowEventTest, Test)
     dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
 }
 
+TEST_F(GameObjectBatchTest, GetSetTransforms)
+{
+    dmGameSystem::ScriptLibContext scriptlibcontext;
+    scriptlibcontext.m_Factory = m_Factory;
+    scriptlibcontext.m_Register = m_Register;
+    scriptlibcontext.m_LuaState = dmScript::GetLuaState(m_ScriptContext);
+    dmGameSystem::InitializeScriptLibs(scriptlibcontext);
+
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/go_batch/go_batch.goc", dmHashString64("/go_batch"), 0, 0, Point3(1, 2, 3), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+    dmGameObject::HInstance other = Spawn(m_Factory, m_Collection, "/go_batch/go_batch.goc", dmHashString64("/go_batch_other"), 0, 0, Point3(4, 5, 6), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, other);
+
+    // The script asserts on the values read and written through the buffer
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    ASSERT_EQ(10.0f, dmGameObject::GetPosition(go).getX());
+    ASSERT_EQ(40.0f, dmGameObject::GetPosition(other).getX());
+    ASSERT_EQ(2.0f, dmGameObject::GetScale(go).getX());
+
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+
+    dmGameSystem::FinalizeScriptLibs(scriptlibcontext);
+}
+
+// Script contexts without the go namespace, like the gui one, don't get the batch functions either
+TEST_F(ScriptBufferTest, GameObjectBatchOnlyWithGo)
+{
+    lua_getglobal(L, "go");
+    ASSERT_TRUE(lua_isnil(L, -1));
+    lua_pop(L, 1);
+}
+
 /* Factory dynamic and static loading */
 
 TEST_P(FactoryTest, Test)
@@ -1389,6 +1490,114 @@ TEST_P(BoxRenderTest, BoxRender)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+/* GUI vertex cache */
+
+static void RenderGuiFrame(dmRender::HRenderContext render_context, dmGameObject::HCollection collection, dmGameSystem::GuiWorld* world, dmArray<dmGameSystem::BoxVertex>& vertices)
+{
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    dmRender::DrawRenderList(render_context, 0x0, 0x0, 0x0);
+
+    vertices.SetCapacity(world->m_ClientVertexBuffer.Size());
+    vertices.SetSize(world->m_ClientVertexBuffer.Size());
+    memcpy(vertices.Begin(), world->m_ClientVertexBuffer.Begin(), vertices.Size() * sizeof(dmGameSystem::BoxVertex));
+}
+
+// Renders a frame after a change, and then an unchanged frame that must reuse all vertices of the first
+static void RenderChangedGuiFrame(dmRender::HRenderContext render_context, dmGameObject::HCollection collection, dmGameSystem::GuiWorld* world, uint32_t* reused)
+{
+    dmArray<dmGameSystem::BoxVertex> changed;
+    RenderGuiFrame(render_context, collection, world, changed);
+    *reused = world->m_ReusedVertexCount;
+
+    dmArray<dmGameSystem::BoxVertex> unchanged;
+    RenderGuiFrame(render_context, collection, world, unchanged);
+    ASSERT_EQ(changed.Size(), world->m_ReusedVertexCount);
+    ASSERT_EQ(changed.Size(), unchanged.Size());
+    ASSERT_EQ(0, memcmp(changed.Begin(), unchanged.Begin(), changed.Size() * sizeof(dmGameSystem::BoxVertex)));
+}
+
+TEST_F(GuiTest, VertexCache)
+{
+    ASSERT_TRUE(dmGameObject::Init(m_Collection));
+
+    dmGameObject::HInstance go = Spawn(m_Factory, m_Collection, "/gui/vertex_cache.goc", dmHashString64("/go"), 0, 0, Point3(0, 0, 0), Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+    ASSERT_NE((void*)0, go);
+
+    m_UpdateContext.m_DT = 0.0f;
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+
+    uint32_t component_type_index = dmGameObject::GetComponentTypeIndex(m_Collection, dmHashString64("guic"));
+    dmGameSystem::GuiWorld* world = (dmGameSystem::GuiWorld*)dmGameObject::GetWorld(m_Collection, component_type_index);
+    dmGui::HScene scene = world->m_Components[0]->m_Scene;
+    dmGui::HNode box_a = dmGui::GetNodeById(scene, "box_a");
+    dmGui::HNode box_b = dmGui::GetNodeById(scene, "box_b");
+    dmGui::HNode pie = dmGui::GetNodeById(scene, "pie");
+    ASSERT_NE(0U, box_a);
+    ASSERT_NE(0U, box_b);
+    ASSERT_NE(0U, pie);
+
+    // Nothing to reuse the first frame
+    uint32_t reused;
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(0U, reused);
+    const uint32_t vertex_count = world->m_ClientVertexBuffer.Size();
+    const uint32_t box_a_vertex_count = 6; // Untextured quad
+
+    // Changes to a node only regenerate that node, as long as the nodes after it don't move
+    dmGui::SetNodePosition(scene, box_a, Point3(1.0f, 2.0f, 0.0f));
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(vertex_count - box_a_vertex_count, reused);
+
+    dmGui::SetNodeProperty(scene, box_a, dmGui::PROPERTY_COLOR, Vector4(1.0f, 0.0f, 0.0f, 1.0f));
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(vertex_count - box_a_vertex_count, reused);
+
+    // The flipbook animation of box_b moves to the next frame
+    m_UpdateContext.m_DT = 1.0f;
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_GT(vertex_count - box_a_vertex_count, reused);
+    const uint32_t box_b_vertex_count = vertex_count - reused;
+    const uint32_t pie_vertex_count = vertex_count - box_a_vertex_count - box_b_vertex_count;
+
+    dmGui::SetNodeProperty(scene, box_b, dmGui::PROPERTY_SIZE, Vector4(48.0f, 48.0f, 0.0f, 0.0f));
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(vertex_count - box_b_vertex_count, reused);
+
+    dmGui::SetNodePieFillAngle(scene, pie, 180.0f);
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(box_a_vertex_count + box_b_vertex_count, reused);
+    dmGui::SetNodePieFillAngle(scene, pie, 360.0f);
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(box_a_vertex_count + box_b_vertex_count, reused);
+    ASSERT_EQ(vertex_count, world->m_ClientVertexBuffer.Size());
+
+    // Setting the texture of box_a regenerates it
+    dmGui::SetNodeTexture(scene, box_a, "flipbook");
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_GE(world->m_ClientVertexBuffer.Size() - box_a_vertex_count, reused);
+    dmGui::SetNodeTexture(scene, box_a, "");
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_GE(vertex_count - box_a_vertex_count, reused);
+    ASSERT_EQ(vertex_count, world->m_ClientVertexBuffer.Size());
+
+    // Reordered nodes end up at other places in the buffer, and are regenerated
+    dmGui::MoveNodeAbove(scene, box_a, box_b);
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(pie_vertex_count, reused);
+
+    // The nodes after a deleted node move
+    dmGui::DeleteNode(scene, box_b, false);
+    ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    RenderChangedGuiFrame(m_RenderContext, m_Collection, world, &reused);
+    ASSERT_EQ(0U, reused);
+    ASSERT_EQ(vertex_count - box_b_vertex_count, world->m_ClientVertexBuffer.Size());
+
+    ASSERT_TRUE(dmGameObject::Final(m_Collection));
+}
+
 /* Gamepad connected */
 
 TEST_F(GamepadConnectedTest, TestGamepadConnectedInputEvent)
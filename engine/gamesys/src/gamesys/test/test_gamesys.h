@@ -166,6 +166,31 @@ public:
     virtual ~ResourceTest() {}
 };
 
+class TextureStreamingTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~TextureStreamingTest() {}
+
+protected:
+    virtual void SetUp()
+    {
+        GamesysTest<const char*>::SetUp();
+
+        dmGameSystem::TextureStreamingParams params;
+        params.m_Factory         = m_Factory;
+        params.m_GraphicsContext = m_GraphicsContext;
+        params.m_MinSize         = 256;
+        params.m_EvictFrames     = 2;
+        dmGameSystem::InitializeTextureStreaming(params);
+    }
+
+    virtual void TearDown()
+    {
+        GamesysTest<const char*>::TearDown();
+        dmGameSystem::FinalizeTextureStreaming();
+    }
+};
+
 struct ResourceReloadParams
 {
     const char* m_FilenameEnding;
@@ -254,6 +279,12 @@ public:
     virtual ~WindowEventTest() {}
 };
 
+class GameObjectBatchTest : public GamesysTest<const char*>
+{
+public:
+    virtual ~GameObjectBatchTest() {}
+};
+
 struct DrawCountParams
 {
     const char* m_GOPath;
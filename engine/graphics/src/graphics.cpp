@@ -14,25 +14,35 @@
 
 #include "graphics.h"
 #include "graphics_adapter.h"
+#include "graphics_private.h"
 
 #if defined(__MACH__) && ( defined(__arm__) || defined(__arm64__) || defined(IOS_SIMULATOR))
 #include <graphics/glfw/glfw_native.h> // for glfwAppBootstrap
 #endif
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <dlib/profile.h>
 
 DM_PROPERTY_GROUP(rmtp_Graphics, "Graphics");
 DM_PROPERTY_U32(rmtp_DrawCalls, 0, FrameReset, "# vertices", &rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_CpuFrameTime, 0, NoFlags, "cpu time from BeginFrame to Flip (us)", &rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_GpuFrameTime, 0, NoFlags, "gpu time of a recent frame (us)", &rmtp_Graphics);
+DM_PROPERTY_U32(rmtp_GpuRenderTargetTime, 0, NoFlags, "gpu time drawing to render targets (us)", &rmtp_Graphics);
 
 #include <dlib/log.h>
 #include <dlib/dstrings.h>
+#include <dlib/hash.h>
+#include <dlib/sys.h>
+#include <dlib/time.h>
 
 namespace dmGraphics
 {
     static GraphicsAdapter*             g_adapter_list = 0;
     static GraphicsAdapter*             g_adapter = 0;
     static GraphicsAdapterFunctionTable g_functions;
+    static uint64_t                     g_BeginFrameTime = 0;
 
     void RegisterGraphicsAdapter(GraphicsAdapter* adapter, GraphicsAdapterIsSupportedCb is_supported_cb, GraphicsAdapterRegisterFunctionsCb register_functions_cb, int8_t priority)
     {
@@ -142,6 +152,8 @@ namespace dmGraphics
     : m_DefaultTextureMinFilter(TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST)
     , m_DefaultTextureMagFilter(TEXTURE_FILTER_LINEAR)
     , m_GraphicsMemorySize(0)
+    , m_PipelineCachePath(0)
+    , m_PipelineCacheVersion(0)
     , m_VerifyGraphicsCalls(false)
     , m_RenderDocSupport(0)
     , m_UseValidationLayers(0)
@@ -250,6 +262,174 @@ namespace dmGraphics
         }
     }
 
+    int32_t BeginGpuTimerQuery(GpuTimers* timers, uint32_t timer)
+    {
+        GpuTimerFrame& frame = timers->m_Frames[timers->m_FrameIndex];
+        if (timer >= MAX_GPU_TIMERS || timers->m_OpenQueries[timer] != 0 || frame.m_QueryCount == MAX_GPU_TIMER_QUERIES)
+        {
+            return -1;
+        }
+        uint32_t query = frame.m_QueryCount++;
+        frame.m_Timers[query] = (uint8_t) timer;
+        timers->m_OpenQueries[timer] = (uint16_t) (query + 1);
+        return (int32_t) query;
+    }
+
+    int32_t EndGpuTimerQuery(GpuTimers* timers, uint32_t timer)
+    {
+        if (timer >= MAX_GPU_TIMERS || timers->m_OpenQueries[timer] == 0)
+        {
+            return -1;
+        }
+        int32_t query = (int32_t) timers->m_OpenQueries[timer] - 1;
+        timers->m_OpenQueries[timer] = 0;
+        return query;
+    }
+
+    GpuTimerFrame* NextGpuTimerFrame(GpuTimers* timers)
+    {
+        // Timers that weren't ended have no end timestamp, and are dropped
+        GpuTimerFrame& frame = timers->m_Frames[timers->m_FrameIndex];
+        for (uint32_t i = 0; i < MAX_GPU_TIMERS; ++i)
+        {
+            if (timers->m_OpenQueries[i] != 0)
+            {
+                frame.m_Timers[timers->m_OpenQueries[i] - 1] = GPU_TIMER_QUERY_DROPPED;
+                timers->m_OpenQueries[i] = 0;
+            }
+        }
+        timers->m_FrameIndex = (timers->m_FrameIndex + 1) % GPU_TIMER_FRAME_LATENCY;
+        return &timers->m_Frames[timers->m_FrameIndex];
+    }
+
+    void ResolveGpuTimerFrame(GpuTimers* timers, GpuTimerFrame* frame, const uint64_t* timestamps)
+    {
+        if (timestamps && frame->m_QueryCount > 0)
+        {
+            memset(timers->m_Results, 0, sizeof(timers->m_Results));
+            for (uint32_t i = 0; i < frame->m_QueryCount; ++i)
+            {
+                if (frame->m_Timers[i] == GPU_TIMER_QUERY_DROPPED)
+                {
+                    continue;
+                }
+                uint64_t begin = timestamps[i * 2];
+                uint64_t end   = timestamps[i * 2 + 1];
+                timers->m_Results[frame->m_Timers[i]] += end > begin ? end - begin : 0;
+            }
+            timers->m_HasResults = 1;
+        }
+        frame->m_QueryCount = 0;
+    }
+
+    bool GetGpuTimerResult(const GpuTimers* timers, uint32_t timer, uint64_t* out_nanoseconds)
+    {
+        if (!timers->m_HasResults || timer >= MAX_GPU_TIMERS)
+        {
+            return false;
+        }
+        *out_nanoseconds = timers->m_Results[timer];
+        return true;
+    }
+
+    // Written in front of the pipeline cache data in the file
+    struct PipelineCacheFileHeader
+    {
+        uint32_t m_Magic;
+        uint32_t m_DataSize;
+        uint64_t m_VersionHash;
+        uint32_t m_DataHash;
+        uint32_t m_Reserved;
+    };
+
+    // The header that starts the pipeline cache data (VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+    struct PipelineCacheDataHeader
+    {
+        uint32_t m_HeaderSize;
+        uint32_t m_HeaderVersion;
+        uint32_t m_VendorID;
+        uint32_t m_DeviceID;
+        uint8_t  m_PipelineCacheUUID[PIPELINE_CACHE_UUID_SIZE];
+    };
+
+    static const uint32_t PIPELINE_CACHE_FILE_MAGIC          = 0x48435044; // 'DPCH'
+    static const uint32_t PIPELINE_CACHE_HEADER_VERSION_ONE  = 1;
+
+    bool WritePipelineCacheFile(const char* path, uint64_t version_hash, const void* data, uint32_t data_size)
+    {
+        PipelineCacheFileHeader file_header;
+        memset(&file_header, 0, sizeof(file_header));
+        file_header.m_Magic       = PIPELINE_CACHE_FILE_MAGIC;
+        file_header.m_DataSize    = data_size;
+        file_header.m_VersionHash = version_hash;
+        file_header.m_DataHash    = dmHashBuffer32(data, data_size);
+
+        // Write to a temporary file first, so that a partially written file never replaces a valid one
+        char tmp_path[1024];
+        dmSnPrintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+        bool result = false;
+        FILE* file  = fopen(tmp_path, "wb");
+        if (file)
+        {
+            result = fwrite(&file_header, 1, sizeof(file_header), file) == sizeof(file_header);
+            result = result && fwrite(data, 1, data_size, file) == data_size;
+            result = (fclose(file) == 0) && result;
+        }
+
+        if (!result || dmSys::RenameFile(path, tmp_path) != dmSys::RESULT_OK)
+        {
+            dmSys::Unlink(tmp_path);
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t* ReadPipelineCacheFile(const char* path, uint64_t version_hash, const PipelineCacheDevice& device, uint32_t* data_size_out)
+    {
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            return 0;
+        }
+
+        uint8_t* data = 0;
+        PipelineCacheFileHeader file_header;
+        if (fread(&file_header, 1, sizeof(file_header), file) == sizeof(file_header) &&
+            file_header.m_Magic == PIPELINE_CACHE_FILE_MAGIC &&
+            file_header.m_VersionHash == version_hash &&
+            file_header.m_DataSize >= sizeof(PipelineCacheDataHeader))
+        {
+            data = (uint8_t*) malloc(file_header.m_DataSize);
+            if (fread(data, 1, file_header.m_DataSize, file) != file_header.m_DataSize ||
+                dmHashBuffer32(data, file_header.m_DataSize) != file_header.m_DataHash)
+            {
+                free(data);
+                data = 0;
+            }
+        }
+        fclose(file);
+
+        if (!data)
+        {
+            return 0;
+        }
+
+        // The driver is supposed to validate the data, but not all of them do
+        const PipelineCacheDataHeader* data_header = (const PipelineCacheDataHeader*) data;
+        if (data_header->m_HeaderVersion != PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            data_header->m_VendorID != device.m_VendorID ||
+            data_header->m_DeviceID != device.m_DeviceID ||
+            memcmp(data_header->m_PipelineCacheUUID, device.m_PipelineCacheUUID, PIPELINE_CACHE_UUID_SIZE) != 0)
+        {
+            free(data);
+            return 0;
+        }
+
+        *data_size_out = file_header.m_DataSize;
+        return data;
+    }
+
     static bool IsFormatRGBA(dmGraphics::TextureFormat format)
     {
         switch(format)
@@ -514,10 +694,25 @@ namespace dmGraphics
     }
     void BeginFrame(HContext context)
     {
+        g_BeginFrameTime = dmTime::GetTime();
         g_functions.m_BeginFrame(context);
+        g_functions.m_BeginGpuTimer(context, GPU_TIMER_FRAME);
     }
     void Flip(HContext context)
     {
+        g_functions.m_EndGpuTimer(context, GPU_TIMER_FRAME);
+        DM_PROPERTY_SET_U32(rmtp_CpuFrameTime, (uint32_t) (dmTime::GetTime() - g_BeginFrameTime));
+
+        uint64_t gpu_time;
+        if (g_functions.m_GetGpuTimerResult(context, GPU_TIMER_FRAME, &gpu_time))
+        {
+            DM_PROPERTY_SET_U32(rmtp_GpuFrameTime, (uint32_t) (gpu_time / 1000));
+        }
+        if (g_functions.m_GetGpuTimerResult(context, GPU_TIMER_RENDER_TARGET, &gpu_time))
+        {
+            DM_PROPERTY_SET_U32(rmtp_GpuRenderTargetTime, (uint32_t) (gpu_time / 1000));
+        }
+
         g_functions.m_Flip(context);
     }
     void SetSwapInterval(HContext context, uint32_t swap_interval)
@@ -610,7 +805,11 @@ namespace dmGraphics
     }
     void EnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
     {
-        g_functions.m_EnableVertexDeclarationProgram(context, vertex_declaration, vertex_buffer, program);
+        g_functions.m_EnableVertexDeclarationProgram(context, vertex_declaration, vertex_buffer, 0, program);
+    }
+    void EnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset, HProgram program)
+    {
+        g_functions.m_EnableVertexDeclarationProgram(context, vertex_declaration, vertex_buffer, vertex_buffer_offset, program);
     }
     void DisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
     {
@@ -628,6 +827,91 @@ namespace dmGraphics
     {
         g_functions.m_Draw(context, prim_type, first, count);
     }
+    bool IsInstancingSupported(HContext context)
+    {
+        return g_functions.m_IsInstancingSupported(context);
+    }
+    void EnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    {
+        g_functions.m_EnableInstanceVertexDeclaration(context, vertex_declaration, vertex_buffer, program);
+    }
+    void DisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        g_functions.m_DisableInstanceVertexDeclaration(context, vertex_declaration);
+    }
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        g_functions.m_DrawElementsInstanced(context, prim_type, first, count, instance_count, type, index_buffer);
+    }
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        g_functions.m_DrawInstanced(context, prim_type, first, count, instance_count);
+    }
+    HTransientBuffer NewTransientBuffer(HContext context, uint32_t size)
+    {
+        return g_functions.m_NewTransientBuffer(context, size);
+    }
+    void DeleteTransientBuffer(HContext context, HTransientBuffer buffer)
+    {
+        g_functions.m_DeleteTransientBuffer(context, buffer);
+    }
+    void* AllocTransientBuffer(HContext context, HTransientBuffer buffer, uint32_t size, uint32_t alignment, HVertexBuffer* vertex_buffer_out, uint32_t* offset_out)
+    {
+        return g_functions.m_AllocTransientBuffer(context, buffer, size, alignment, vertex_buffer_out, offset_out);
+    }
+    void FlushTransientBuffer(HContext context, HTransientBuffer buffer)
+    {
+        g_functions.m_FlushTransientBuffer(context, buffer);
+    }
+    uint32_t GetTransientBufferSize(HTransientBuffer buffer)
+    {
+        return g_functions.m_GetTransientBufferSize(buffer);
+    }
+    bool IsCommandRecorderSupported(HContext context)
+    {
+        return g_functions.m_IsCommandRecorderSupported(context);
+    }
+    HCommandRecorder NewCommandRecorder(HContext context)
+    {
+        return g_functions.m_NewCommandRecorder(context);
+    }
+    void DeleteCommandRecorder(HContext context, HCommandRecorder recorder)
+    {
+        g_functions.m_DeleteCommandRecorder(context, recorder);
+    }
+    void BeginCommandRecorder(HContext context, HCommandRecorder recorder)
+    {
+        g_functions.m_BeginCommandRecorder(context, recorder);
+    }
+    void EndCommandRecorder(HContext context, HCommandRecorder recorder)
+    {
+        g_functions.m_EndCommandRecorder(context, recorder);
+    }
+    void ExecuteCommandRecorders(HContext context, HCommandRecorder* recorders, uint32_t recorder_count)
+    {
+        g_functions.m_ExecuteCommandRecorders(context, recorders, recorder_count);
+    }
+    bool IsGpuTimerEnabled()
+    {
+#if defined(NDEBUG) || defined(DM_PROFILE_NULL)
+        return false;
+#else
+        // The release engine links the null profiler, which is never initialized
+        return dmProfile::IsInitialized();
+#endif
+    }
+    void BeginGpuTimer(HContext context, uint32_t timer)
+    {
+        g_functions.m_BeginGpuTimer(context, timer);
+    }
+    void EndGpuTimer(HContext context, uint32_t timer)
+    {
+        g_functions.m_EndGpuTimer(context, timer);
+    }
+    bool GetGpuTimerResult(HContext context, uint32_t timer, uint64_t* out_nanoseconds)
+    {
+        return g_functions.m_GetGpuTimerResult(context, timer, out_nanoseconds);
+    }
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf)
     {
         return g_functions.m_NewVertexProgram(context, ddf);
@@ -688,6 +972,10 @@ namespace dmGraphics
     {
         return g_functions.m_GetUniformLocation(prog, name);
     }
+    int32_t  GetAttributeLocation(HProgram prog, const char* name)
+    {
+        return g_functions.m_GetAttributeLocation(prog, name);
+    }
     void SetConstantV4(HContext context, const dmVMath::Vector4* data, int count, int base_register)
     {
         g_functions.m_SetConstantV4(context, data, count, base_register);
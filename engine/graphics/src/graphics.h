@@ -25,6 +25,8 @@
 
 namespace dmGraphics
 {
+    typedef struct CommandRecorder* HCommandRecorder;
+    typedef struct TransientBuffer* HTransientBuffer;
 
     typedef void (*WindowResizeCallback)(void* user_data, uint32_t width, uint32_t height);
 
@@ -220,6 +222,7 @@ namespace dmGraphics
         , m_SubUpdate(false)
         , m_X(0)
         , m_Y(0)
+        , m_ResizeMipChain(false)
         {}
 
         TextureFormat m_Format;
@@ -237,6 +240,10 @@ namespace dmGraphics
         bool m_SubUpdate;
         uint32_t m_X;
         uint32_t m_Y;
+
+        // Set on mip 0 when a mipmapped texture is given a new size along with its mip chain
+        // (e.g. by texture streaming). The mip chain then keeps its smallest level.
+        bool m_ResizeMipChain;
     };
 
     // Parameters structure for OpenWindow
@@ -287,6 +294,8 @@ namespace dmGraphics
         TextureFilter m_DefaultTextureMinFilter;
         TextureFilter m_DefaultTextureMagFilter;
         uint32_t      m_GraphicsMemorySize;             // The max allowed Gfx memory (default 0)
+        const char*   m_PipelineCachePath;              // Vulkan only. File to load and save compiled pipelines (default 0)
+        const char*   m_PipelineCacheVersion;           // Vulkan only. Pipeline cache files of other versions are ignored
         uint8_t       m_VerifyGraphicsCalls : 1;
         uint8_t       m_RenderDocSupport : 1;           // Vulkan only
         uint8_t       m_UseValidationLayers : 1;        // Vulkan only
@@ -519,12 +528,65 @@ namespace dmGraphics
     bool SetStreamOffset(HVertexDeclaration vertex_declaration, uint32_t stream_index, uint16_t offset);
     void EnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer);
     void EnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program);
+    void EnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset, HProgram program);
     void DisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration);
     void HashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration);
 
     void DrawElements(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     void Draw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
 
+    // Instanced rendering. The instance vertex declaration describes per-instance streams, which advance once per instance.
+    // A matrix attribute is described as consecutive streams with the same name, one per column.
+    bool IsInstancingSupported(HContext context);
+    void EnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program);
+    void DisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration);
+    void DrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer);
+    void DrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
+
+    // Transient buffers are for vertex data that is generated every frame. Each frame, slices are allocated from
+    // a ring buffer and written in place, instead of reallocating or orphaning a vertex buffer. A slice is bound
+    // with the returned vertex buffer and byte offset, and is valid until Flip. Slices must be flushed with
+    // FlushTransientBuffer after they are written and before they are drawn. A transient buffer must only be
+    // used by one thread at a time.
+    HTransientBuffer NewTransientBuffer(HContext context, uint32_t size);
+    void DeleteTransientBuffer(HContext context, HTransientBuffer buffer);
+    // Returns 0 if there isn't room for the slice in the remaining part of the buffer this frame
+    void* AllocTransientBuffer(HContext context, HTransientBuffer buffer, uint32_t size, uint32_t alignment, HVertexBuffer* vertex_buffer_out, uint32_t* offset_out);
+    void FlushTransientBuffer(HContext context, HTransientBuffer buffer);
+    uint32_t GetTransientBufferSize(HTransientBuffer buffer);
+
+    // Command recorders let worker threads record draw calls into the current render target in parallel.
+    // Between BeginCommandRecorder and EndCommandRecorder, all state and draw functions called from that thread
+    // are recorded into the recorder instead of the main command stream. Each recorder starts out with the
+    // state of the main thread at the time BeginCommandRecorder is called, and is used by one thread at a time.
+    // The recorders are then executed in the given order by the main thread, once per frame. The main thread
+    // must not change state, create resources or draw while the worker threads are recording.
+    bool IsCommandRecorderSupported(HContext context);
+    HCommandRecorder NewCommandRecorder(HContext context);
+    void DeleteCommandRecorder(HContext context, HCommandRecorder recorder);
+    void BeginCommandRecorder(HContext context, HCommandRecorder recorder);
+    void EndCommandRecorder(HContext context, HCommandRecorder recorder);
+    void ExecuteCommandRecorders(HContext context, HCommandRecorder* recorders, uint32_t recorder_count);
+
+    // GPU timers measure the gpu time of the commands issued between BeginGpuTimer and EndGpuTimer, on the
+    // main thread. The time of all begin/end pairs of a timer during a frame is summed. The gpu is measured
+    // with timestamp queries that are read back a few frames later, so GetGpuTimerResult returns the time of
+    // an earlier frame, and false if the adapter doesn't support timer queries or has no result yet.
+    // The OpenGL and Vulkan adapters only issue timer queries while IsGpuTimerEnabled() returns true.
+    enum GpuTimer
+    {
+        GPU_TIMER_FRAME         = 0, // From BeginFrame to Flip
+        GPU_TIMER_RENDER_TARGET = 1, // Drawing to render targets other than the main one
+        GPU_TIMER_USER          = 2, // First timer free to use, up to MAX_GPU_TIMERS
+    };
+    const static uint32_t MAX_GPU_TIMERS = 32;
+
+    // Returns true if the profiler is compiled in and running
+    bool IsGpuTimerEnabled();
+    void BeginGpuTimer(HContext context, uint32_t timer);
+    void EndGpuTimer(HContext context, uint32_t timer);
+    bool GetGpuTimerResult(HContext context, uint32_t timer, uint64_t* out_nanoseconds);
+
     HVertexProgram NewVertexProgram(HContext context, ShaderDesc::Shader* ddf);
     HFragmentProgram NewFragmentProgram(HContext context, ShaderDesc::Shader* ddf);
     HProgram NewProgram(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -544,6 +606,7 @@ namespace dmGraphics
     uint32_t GetUniformName(HProgram prog, uint32_t index, char* buffer, uint32_t buffer_size, Type* type, int32_t* size);
     uint32_t GetUniformCount(HProgram prog);
     int32_t  GetUniformLocation(HProgram prog, const char* name);
+    int32_t  GetAttributeLocation(HProgram prog, const char* name);
 
     void SetConstantV4(HContext context, const Vectormath::Aos::Vector4* data, int count, int base_register);
     void SetConstantM4(HContext context, const Vectormath::Aos::Vector4* data, int count, int base_register);
@@ -97,11 +97,21 @@ namespace dmGraphics
     typedef bool (*SetStreamOffsetFn)(HVertexDeclaration vertex_declaration, uint32_t stream_index, uint16_t offset);
     typedef void (*DeleteVertexDeclarationFn)(HVertexDeclaration vertex_declaration);
     typedef void (*EnableVertexDeclarationFn)(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer);
-    typedef void (*EnableVertexDeclarationProgramFn)(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program);
+    typedef void (*EnableVertexDeclarationProgramFn)(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset, HProgram program);
     typedef void (*DisableVertexDeclarationFn)(HContext context, HVertexDeclaration vertex_declaration);
     typedef void (*HashVertexDeclarationFn)(HashState32* state, HVertexDeclaration vertex_declaration);
     typedef void (*DrawElementsFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, Type type, HIndexBuffer index_buffer);
     typedef void (*DrawFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count);
+    typedef bool (*IsInstancingSupportedFn)(HContext context);
+    typedef void (*EnableInstanceVertexDeclarationFn)(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program);
+    typedef void (*DisableInstanceVertexDeclarationFn)(HContext context, HVertexDeclaration vertex_declaration);
+    typedef void (*DrawElementsInstancedFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer);
+    typedef void (*DrawInstancedFn)(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count);
+    typedef HTransientBuffer (*NewTransientBufferFn)(HContext context, uint32_t size);
+    typedef void (*DeleteTransientBufferFn)(HContext context, HTransientBuffer buffer);
+    typedef void* (*AllocTransientBufferFn)(HContext context, HTransientBuffer buffer, uint32_t size, uint32_t alignment, HVertexBuffer* vertex_buffer_out, uint32_t* offset_out);
+    typedef void (*FlushTransientBufferFn)(HContext context, HTransientBuffer buffer);
+    typedef uint32_t (*GetTransientBufferSizeFn)(HTransientBuffer buffer);
     typedef HVertexProgram (*NewVertexProgramFn)(HContext context, ShaderDesc::Shader* ddf);
     typedef HFragmentProgram (*NewFragmentProgramFn)(HContext context, ShaderDesc::Shader* ddf);
     typedef HProgram (*NewProgramFn)(HContext context, HVertexProgram vertex_program, HFragmentProgram fragment_program);
@@ -117,6 +127,7 @@ namespace dmGraphics
     typedef uint32_t (*GetUniformNameFn)(HProgram prog, uint32_t index, char* buffer, uint32_t buffer_size, Type* type, int32_t* size);
     typedef uint32_t (*GetUniformCountFn)(HProgram prog);
     typedef int32_t (* GetUniformLocationFn)(HProgram prog, const char* name);
+    typedef int32_t (* GetAttributeLocationFn)(HProgram prog, const char* name);
     typedef void (*SetConstantV4Fn)(HContext context, const dmVMath::Vector4* data, int count, int base_register);
     typedef void (*SetConstantM4Fn)(HContext context, const dmVMath::Vector4* data, int count, int base_register);
     typedef void (*SetSamplerFn)(HContext context, int32_t location, int32_t unit);
@@ -164,6 +175,15 @@ namespace dmGraphics
     typedef uint32_t (*GetNumSupportedExtensionsFn)(HContext context);
     typedef const char* (*GetSupportedExtensionFn)(HContext context, uint32_t index);
     typedef bool (*IsMultiTargetRenderingSupportedFn)(HContext context);
+    typedef bool (*IsCommandRecorderSupportedFn)(HContext context);
+    typedef HCommandRecorder (*NewCommandRecorderFn)(HContext context);
+    typedef void (*DeleteCommandRecorderFn)(HContext context, HCommandRecorder recorder);
+    typedef void (*BeginCommandRecorderFn)(HContext context, HCommandRecorder recorder);
+    typedef void (*EndCommandRecorderFn)(HContext context, HCommandRecorder recorder);
+    typedef void (*ExecuteCommandRecordersFn)(HContext context, HCommandRecorder* recorders, uint32_t recorder_count);
+    typedef void (*BeginGpuTimerFn)(HContext context, uint32_t timer);
+    typedef void (*EndGpuTimerFn)(HContext context, uint32_t timer);
+    typedef bool (*GetGpuTimerResultFn)(HContext context, uint32_t timer, uint64_t* out_nanoseconds);
 
     struct GraphicsAdapterFunctionTable
     {
@@ -214,6 +234,16 @@ namespace dmGraphics
         HashVertexDeclarationFn m_HashVertexDeclaration;
         DrawElementsFn m_DrawElements;
         DrawFn m_Draw;
+        IsInstancingSupportedFn m_IsInstancingSupported;
+        EnableInstanceVertexDeclarationFn m_EnableInstanceVertexDeclaration;
+        DisableInstanceVertexDeclarationFn m_DisableInstanceVertexDeclaration;
+        DrawElementsInstancedFn m_DrawElementsInstanced;
+        DrawInstancedFn m_DrawInstanced;
+        NewTransientBufferFn m_NewTransientBuffer;
+        DeleteTransientBufferFn m_DeleteTransientBuffer;
+        AllocTransientBufferFn m_AllocTransientBuffer;
+        FlushTransientBufferFn m_FlushTransientBuffer;
+        GetTransientBufferSizeFn m_GetTransientBufferSize;
         NewVertexProgramFn m_NewVertexProgram;
         NewFragmentProgramFn m_NewFragmentProgram;
         NewProgramFn m_NewProgram;
@@ -229,6 +259,7 @@ namespace dmGraphics
         GetUniformNameFn m_GetUniformName;
         GetUniformCountFn m_GetUniformCount;
         GetUniformLocationFn m_GetUniformLocation;
+        GetAttributeLocationFn m_GetAttributeLocation;
         SetConstantV4Fn m_SetConstantV4;
         SetConstantM4Fn m_SetConstantM4;
         SetSamplerFn m_SetSampler;
@@ -277,6 +308,15 @@ namespace dmGraphics
         GetSupportedExtensionFn m_GetSupportedExtension;
         IsMultiTargetRenderingSupportedFn m_IsMultiTargetRenderingSupported;
         GetPipelineStateFn m_GetPipelineState;
+        IsCommandRecorderSupportedFn m_IsCommandRecorderSupported;
+        NewCommandRecorderFn m_NewCommandRecorder;
+        DeleteCommandRecorderFn m_DeleteCommandRecorder;
+        BeginCommandRecorderFn m_BeginCommandRecorder;
+        EndCommandRecorderFn m_EndCommandRecorder;
+        ExecuteCommandRecordersFn m_ExecuteCommandRecorders;
+        BeginGpuTimerFn m_BeginGpuTimer;
+        EndGpuTimerFn m_EndGpuTimer;
+        GetGpuTimerResultFn m_GetGpuTimerResult;
     };
 }
 
@@ -23,6 +23,18 @@ namespace dmGraphics
     PipelineState GetDefaultPipelineState();
     void SetPipelineStateValue(PipelineState& pipeline_state, State state, uint8_t value);
     uint64_t GetDrawCount();
+
+    // Number of state calls made to the null adapter, for tests
+    struct NullStateCallCounts
+    {
+        uint32_t m_EnableProgram;
+        uint32_t m_EnableVertexDeclaration;
+        uint32_t m_EnableTexture;
+        uint32_t m_DisableTexture;
+        uint32_t m_SetConstant;
+    };
+    NullStateCallCounts GetNullStateCallCounts();
+    void ResetNullStateCallCounts();
     void SetForceFragmentReloadFail(bool should_fail);
     void SetForceVertexReloadFail(bool should_fail);
 
@@ -30,6 +42,86 @@ namespace dmGraphics
     uint32_t GetTextureFormatBitsPerPixel(TextureFormat format);
 
     bool IsTextureFormatCompressed(TextureFormat format);
+
+    // Begin/end query pairs of GPU timers that can be issued per frame
+    const static uint32_t MAX_GPU_TIMER_QUERIES   = 128;
+    // Number of frames the timestamps are kept, before they are read back
+    const static uint32_t GPU_TIMER_FRAME_LATENCY = 3;
+
+    // Timer of a query pair that was begun but never ended, so it has no end timestamp
+    const static uint8_t  GPU_TIMER_QUERY_DROPPED = 0xff;
+
+    struct GpuTimerFrame
+    {
+        uint8_t  m_Timers[MAX_GPU_TIMER_QUERIES]; // The timer of each query pair, or GPU_TIMER_QUERY_DROPPED
+        uint32_t m_QueryCount;
+    };
+
+    // Bookkeeping of the timestamp queries shared by the adapters. The adapter writes the begin and end
+    // timestamps of query pair q in frame f to its query slots (f * MAX_GPU_TIMER_QUERIES + q) * 2 and +1.
+    // A zeroed struct is valid.
+    struct GpuTimers
+    {
+        GpuTimerFrame m_Frames[GPU_TIMER_FRAME_LATENCY];
+        uint64_t      m_Results[MAX_GPU_TIMERS];
+        uint16_t      m_OpenQueries[MAX_GPU_TIMERS]; // Query pair index + 1 of the timers that are begun, 0 otherwise
+        uint8_t       m_FrameIndex;
+        uint8_t       m_HasResults : 1;
+    };
+
+    // Returns the query pair to write the begin timestamp to, or -1 if the timer can't be begun
+    int32_t BeginGpuTimerQuery(GpuTimers* timers, uint32_t timer);
+    // Returns the query pair to write the end timestamp to, or -1 if the timer wasn't begun
+    int32_t EndGpuTimerQuery(GpuTimers* timers, uint32_t timer);
+    // Moves to the next frame, and returns the frame slot that is reused. Its queries are the oldest ones,
+    // which should be read back and passed to ResolveGpuTimerFrame before new queries are issued.
+    GpuTimerFrame* NextGpuTimerFrame(GpuTimers* timers);
+    // Sums the timestamps (in nanoseconds, two per query pair) into the timer results, and clears the frame.
+    // If timestamps is 0, the results of the frame aren't available and the frame is only cleared.
+    void ResolveGpuTimerFrame(GpuTimers* timers, GpuTimerFrame* frame, const uint64_t* timestamps);
+    bool GetGpuTimerResult(const GpuTimers* timers, uint32_t timer, uint64_t* out_nanoseconds);
+
+    const static uint32_t PIPELINE_CACHE_UUID_SIZE = 16;
+
+    // The device a pipeline cache was created on, as in the header of the cache data
+    struct PipelineCacheDevice
+    {
+        uint32_t m_VendorID;
+        uint32_t m_DeviceID;
+        uint8_t  m_PipelineCacheUUID[PIPELINE_CACHE_UUID_SIZE];
+    };
+
+    // Saves pipeline cache data (e.g. from vkGetPipelineCacheData) to a file, tagged with the engine version
+    // and a hash of the data. The file is replaced only once it has been written completely.
+    bool WritePipelineCacheFile(const char* path, uint64_t version_hash, const void* data, uint32_t data_size);
+    // Returns the pipeline cache data in the file if it's intact, and was written by the same engine version
+    // for the same device and driver, otherwise 0. The data must be freed by the caller.
+    uint8_t* ReadPipelineCacheFile(const char* path, uint64_t version_hash, const PipelineCacheDevice& device, uint32_t* data_size_out);
+
+    // Rounds a transient buffer offset up to the alignment, which doesn't have to be a power of two (e.g. a vertex stride)
+    static inline uint32_t AlignTransientBufferOffset(uint32_t offset, uint32_t alignment)
+    {
+        return alignment > 1 ? ((offset + alignment - 1) / alignment) * alignment : offset;
+    }
+
+    // When mip 0 of a mipmapped texture is set to a new size with TextureParams::m_ResizeMipChain, the mip chain
+    // keeps its smallest level. This lets a streamed texture add or drop its top mips by uploading a new chain at a different size.
+    static inline uint16_t GetResizedMipMapCount(uint16_t mipmap_count, uint32_t old_width, uint32_t old_height, uint32_t new_width, uint32_t new_height)
+    {
+        if (mipmap_count <= 1 || old_width == 0 || old_height == 0 || new_width == 0 || new_height == 0)
+            return mipmap_count;
+
+        int32_t old_levels = 0, new_levels = 0;
+        for (uint32_t s = old_width > old_height ? old_width : old_height; s > 1; s >>= 1) ++old_levels;
+        for (uint32_t s = new_width > new_height ? new_width : new_height; s > 1; s >>= 1) ++new_levels;
+
+        int32_t count = (int32_t) mipmap_count + new_levels - old_levels;
+        if (count < 1)
+            count = 1;
+        if (count > new_levels + 1)
+            count = new_levels + 1;
+        return (uint16_t) count;
+    }
 }
 
 #endif // #ifndef DM_GRAPHICS_PRIVATE_H
@@ -29,6 +29,7 @@
 
 uint64_t g_DrawCount = 0;
 uint64_t g_Flipped = 0;
+dmGraphics::NullStateCallCounts g_StateCallCounts = {};
 
 // Used only for tests
 bool g_ForceFragmentReloadFail = false;
@@ -50,9 +51,12 @@ namespace dmGraphics
     };
 
     bool g_ContextCreated = false;
+    static Context* g_NullContext = 0;
 
     static GraphicsAdapterFunctionTable NullRegisterFunctionTable();
     static bool                         NullIsSupported();
+    // The synthetic gpu time of a draw call, in nanoseconds
+    static const uint64_t  NULL_DRAW_GPU_TIME = 1000;
     static const int8_t    g_null_adapter_priority = 2;
     static GraphicsAdapter g_null_adapter(ADAPTER_TYPE_NULL);
 
@@ -82,12 +86,46 @@ namespace dmGraphics
         m_TextureFormatSupport |= 1 << TEXTURE_FORMAT_RGB_ETC1;
     }
 
+    static void NullSetTexture(HTexture texture, const TextureParams& params);
+
+    static void UploadThread(void* arg)
+    {
+        Context* context = (Context*) arg;
+        dmMutex::ScopedLock lk(context->m_UploadMutex);
+        while (!context->m_UploadThreadQuit)
+        {
+            if (context->m_TextureUploads.Empty())
+            {
+                dmConditionVariable::Wait(context->m_UploadCond, context->m_UploadMutex);
+                continue;
+            }
+
+            // Uploads are done in the order they were requested, since later mip levels depend on the size set by mip 0
+            TextureUpload upload = context->m_TextureUploads[0];
+            uint32_t count = context->m_TextureUploads.Size() - 1;
+            memmove(context->m_TextureUploads.Begin(), context->m_TextureUploads.Begin() + 1, count * sizeof(TextureUpload));
+            context->m_TextureUploads.SetSize(count);
+
+            NullSetTexture(upload.m_Texture, upload.m_Params);
+            upload.m_Texture->m_PendingUploads--;
+            dmConditionVariable::Broadcast(context->m_UploadCond);
+        }
+    }
+
     static HContext NullNewContext(const ContextParams& params)
     {
         if (!g_ContextCreated)
         {
             g_ContextCreated = true;
-            return new Context(params);
+            Context* context = new Context(params);
+            g_NullContext = context;
+            context->m_UploadMutex = dmMutex::New();
+            context->m_UploadCond = dmConditionVariable::New();
+            context->m_UploadThreadQuit = 0;
+#if !defined(__EMSCRIPTEN__)
+            context->m_UploadThread = dmThread::New(UploadThread, 0x80000, context, "graphicsupload");
+#endif
+            return context;
         }
         else
         {
@@ -105,7 +143,18 @@ namespace dmGraphics
         assert(context);
         if (g_ContextCreated)
         {
+            {
+                dmMutex::ScopedLock lk(context->m_UploadMutex);
+                context->m_UploadThreadQuit = 1;
+                dmConditionVariable::Broadcast(context->m_UploadCond);
+            }
+#if !defined(__EMSCRIPTEN__)
+            dmThread::Join(context->m_UploadThread);
+#endif
+            dmConditionVariable::Delete(context->m_UploadCond);
+            dmMutex::Delete(context->m_UploadMutex);
             delete context;
+            g_NullContext = 0;
             g_ContextCreated = false;
         }
     }
@@ -308,7 +357,9 @@ namespace dmGraphics
 
     static void NullBeginFrame(HContext context)
     {
-        // NOP
+        GpuTimerFrame* frame = NextGpuTimerFrame(&context->m_GpuTimers);
+        uint32_t first_query = (uint32_t) (frame - context->m_GpuTimers.m_Frames) * MAX_GPU_TIMER_QUERIES * 2;
+        ResolveGpuTimerFrame(&context->m_GpuTimers, frame, &context->m_GpuTimestamps[first_query]);
     }
 
     static void NullFlip(HContext context)
@@ -323,6 +374,7 @@ namespace dmGraphics
         }
 
         g_Flipped = 1;
+        context->m_FrameCount++;
     }
 
     static void NullSetSwapInterval(HContext /*context*/, uint32_t /*swap_interval*/)
@@ -371,6 +423,56 @@ namespace dmGraphics
         delete vb;
     }
 
+    static HTransientBuffer NullNewTransientBuffer(HContext context, uint32_t size)
+    {
+        TransientBuffer* buffer = new TransientBuffer();
+        buffer->m_VertexBuffer  = NullNewVertexBuffer(context, size, 0, BUFFER_USAGE_STREAM_DRAW);
+        buffer->m_Size          = size;
+        buffer->m_Offset        = 0;
+        buffer->m_Frame         = context->m_FrameCount;
+        return (HTransientBuffer) buffer;
+    }
+
+    static void NullDeleteTransientBuffer(HContext context, HTransientBuffer transient_buffer)
+    {
+        if (!transient_buffer)
+            return;
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+        NullDeleteVertexBuffer(buffer->m_VertexBuffer);
+        delete buffer;
+    }
+
+    static void* NullAllocTransientBuffer(HContext context, HTransientBuffer transient_buffer, uint32_t size, uint32_t alignment, HVertexBuffer* vertex_buffer_out, uint32_t* offset_out)
+    {
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+
+        if (buffer->m_Frame != context->m_FrameCount)
+        {
+            buffer->m_Frame  = context->m_FrameCount;
+            buffer->m_Offset = 0;
+        }
+
+        uint32_t offset = AlignTransientBufferOffset(buffer->m_Offset, alignment);
+        if (offset + size > buffer->m_Size)
+        {
+            return 0;
+        }
+        buffer->m_Offset = offset + size;
+
+        *vertex_buffer_out = buffer->m_VertexBuffer;
+        *offset_out        = offset;
+        return ((VertexBuffer*) buffer->m_VertexBuffer)->m_Buffer + offset;
+    }
+
+    static void NullFlushTransientBuffer(HContext context, HTransientBuffer transient_buffer)
+    {
+    }
+
+    static uint32_t NullGetTransientBufferSize(HTransientBuffer transient_buffer)
+    {
+        return ((TransientBuffer*) transient_buffer)->m_Size;
+    }
+
     static void NullSetVertexBufferData(HVertexBuffer buffer, uint32_t size, const void* data, BufferUsage buffer_usage)
     {
         VertexBuffer* vb = (VertexBuffer*)buffer;
@@ -481,6 +583,57 @@ namespace dmGraphics
         return true;
     }
 
+    // Draw calls are only recorded on the main thread
+    static bool NullIsCommandRecorderSupported(HContext context)
+    {
+        return false;
+    }
+
+    static HCommandRecorder NullNewCommandRecorder(HContext context)
+    {
+        return 0;
+    }
+
+    static void NullDeleteCommandRecorder(HContext context, HCommandRecorder recorder)
+    {}
+
+    static void NullBeginCommandRecorder(HContext context, HCommandRecorder recorder)
+    {}
+
+    static void NullEndCommandRecorder(HContext context, HCommandRecorder recorder)
+    {}
+
+    static void NullExecuteCommandRecorders(HContext context, HCommandRecorder* recorders, uint32_t recorder_count)
+    {}
+
+    static void NullBeginGpuTimer(HContext context, uint32_t timer)
+    {
+        int32_t query = BeginGpuTimerQuery(&context->m_GpuTimers, timer);
+        if (query >= 0)
+        {
+            context->m_GpuTimestamps[(context->m_GpuTimers.m_FrameIndex * MAX_GPU_TIMER_QUERIES + query) * 2] = context->m_GpuTime;
+        }
+    }
+
+    static void NullEndGpuTimer(HContext context, uint32_t timer)
+    {
+        int32_t query = EndGpuTimerQuery(&context->m_GpuTimers, timer);
+        if (query >= 0)
+        {
+            context->m_GpuTimestamps[(context->m_GpuTimers.m_FrameIndex * MAX_GPU_TIMER_QUERIES + query) * 2 + 1] = context->m_GpuTime;
+        }
+    }
+
+    static bool NullGetGpuTimerResult(HContext context, uint32_t timer, uint64_t* out_nanoseconds)
+    {
+        return GetGpuTimerResult(&context->m_GpuTimers, timer, out_nanoseconds);
+    }
+
+    static bool NullIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
     static HVertexDeclaration NullNewVertexDeclarationStride(HContext context, VertexElement* element, uint32_t count, uint32_t stride)
     {
         return NewVertexDeclaration(context, element, count);
@@ -538,7 +691,7 @@ namespace dmGraphics
         s.m_Source = 0x0;
     }
 
-    static void NullEnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer)
+    static void EnableVertexDeclarationStreams(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset)
     {
         assert(context);
         assert(vertex_declaration);
@@ -553,15 +706,22 @@ namespace dmGraphics
             VertexElement& ve = vertex_declaration->m_Elements[i];
             if (ve.m_Size > 0)
             {
-                EnableVertexStream(context, i, ve.m_Size, ve.m_Type, stride, &vb->m_Buffer[offset]);
+                EnableVertexStream(context, i, ve.m_Size, ve.m_Type, stride, &vb->m_Buffer[vertex_buffer_offset + offset]);
                 offset += ve.m_Size * TYPE_SIZE[ve.m_Type - dmGraphics::TYPE_BYTE];
             }
         }
     }
 
-    static void NullEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    static void NullEnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer)
+    {
+        g_StateCallCounts.m_EnableVertexDeclaration++;
+        EnableVertexDeclarationStreams(context, vertex_declaration, vertex_buffer, 0);
+    }
+
+    static void NullEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset, HProgram program)
     {
-        NullEnableVertexDeclaration(context, vertex_declaration, vertex_buffer);
+        g_StateCallCounts.m_EnableVertexDeclaration++;
+        EnableVertexDeclarationStreams(context, vertex_declaration, vertex_buffer, vertex_buffer_offset);
     }
 
     static void NullDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
@@ -653,6 +813,7 @@ namespace dmGraphics
             g_DrawCount = 0;
         }
         g_DrawCount++;
+        context->m_GpuTime += NULL_DRAW_GPU_TIME;
     }
 
     static void NullDraw(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count)
@@ -665,6 +826,32 @@ namespace dmGraphics
             g_DrawCount = 0;
         }
         g_DrawCount++;
+        context->m_GpuTime += NULL_DRAW_GPU_TIME;
+    }
+
+    static void NullEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    {
+        assert(context);
+        assert(vertex_declaration);
+        assert(vertex_buffer);
+    }
+
+    static void NullDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        assert(context);
+        assert(vertex_declaration);
+    }
+
+    static void NullDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        assert(instance_count > 0);
+        NullDrawElements(context, prim_type, first, count, type, index_buffer);
+    }
+
+    static void NullDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        assert(instance_count > 0);
+        NullDraw(context, prim_type, first, count);
     }
 
     // For tests
@@ -673,9 +860,21 @@ namespace dmGraphics
         return g_DrawCount;
     }
 
+    NullStateCallCounts GetNullStateCallCounts()
+    {
+        return g_StateCallCounts;
+    }
+
+    void ResetNullStateCallCounts()
+    {
+        memset(&g_StateCallCounts, 0, sizeof(g_StateCallCounts));
+    }
+
     struct VertexProgram
     {
-        char* m_Data;
+        char*              m_Data;
+        dmArray<dmhash_t>  m_AttributeNameHashes;
+        dmArray<uint32_t>  m_AttributeBindings;
     };
 
     struct FragmentProgram
@@ -749,6 +948,21 @@ namespace dmGraphics
         delete (Program*) program;
     }
 
+    // The attributes are taken from the reflection data of the shader, like the Vulkan adapter does
+    static void SetVertexProgramAttributes(VertexProgram* p, ShaderDesc::Shader* ddf)
+    {
+        uint32_t count = ddf->m_Attributes.m_Count;
+        p->m_AttributeNameHashes.SetCapacity(count);
+        p->m_AttributeNameHashes.SetSize(count);
+        p->m_AttributeBindings.SetCapacity(count);
+        p->m_AttributeBindings.SetSize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            p->m_AttributeNameHashes[i] = dmHashString64(ddf->m_Attributes[i].m_Name);
+            p->m_AttributeBindings[i]   = ddf->m_Attributes[i].m_Binding;
+        }
+    }
+
     static HVertexProgram NullNewVertexProgram(HContext context, ShaderDesc::Shader* ddf)
     {
         assert(ddf);
@@ -756,6 +970,7 @@ namespace dmGraphics
         p->m_Data = new char[ddf->m_Source.m_Count+1];
         memcpy(p->m_Data, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
         p->m_Data[ddf->m_Source.m_Count] = '\0';
+        SetVertexProgramAttributes(p, ddf);
         return (uintptr_t)p;
     }
 
@@ -777,6 +992,7 @@ namespace dmGraphics
         delete [] (char*)p->m_Data;
         p->m_Data = new char[ddf->m_Source.m_Count];
         memcpy((char*)p->m_Data, ddf->m_Source.m_Data, ddf->m_Source.m_Count);
+        SetVertexProgramAttributes(p, ddf);
         return !g_ForceVertexReloadFail;
     }
 
@@ -815,6 +1031,7 @@ namespace dmGraphics
     static void NullEnableProgram(HContext context, HProgram program)
     {
         assert(context);
+        g_StateCallCounts.m_EnableProgram++;
         context->m_Program = (void*)program;
     }
 
@@ -864,6 +1081,24 @@ namespace dmGraphics
         return -1;
     }
 
+    static int32_t NullGetAttributeLocation(HProgram prog, const char* name)
+    {
+        Program* program = (Program*)prog;
+        if (program->m_VP == 0x0)
+            return -1;
+
+        VertexProgram* vp = program->m_VP;
+        dmhash_t name_hash = dmHashString64(name);
+        for (uint32_t i = 0; i < vp->m_AttributeNameHashes.Size(); ++i)
+        {
+            if (vp->m_AttributeNameHashes[i] == name_hash)
+            {
+                return (int32_t)vp->m_AttributeBindings[i];
+            }
+        }
+        return -1;
+    }
+
     static void NullSetViewport(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
     {
         assert(context);
@@ -881,6 +1116,7 @@ namespace dmGraphics
     {
         assert(context);
         assert(context->m_Program != 0x0);
+        g_StateCallCounts.m_SetConstant++;
         memcpy(&context->m_ProgramRegisters[base_register], data, sizeof(Vector4) * count);
     }
 
@@ -888,6 +1124,7 @@ namespace dmGraphics
     {
         assert(context);
         assert(context->m_Program != 0x0);
+        g_StateCallCounts.m_SetConstant++;
         memcpy(&context->m_ProgramRegisters[base_register], data, sizeof(Vector4) * 4 * count);
     }
 
@@ -1063,6 +1300,7 @@ namespace dmGraphics
         tex->m_Width = params.m_Width;
         tex->m_Height = params.m_Height;
         tex->m_MipMapCount = 0;
+        tex->m_PendingUploads = 0;
         tex->m_Data = 0;
 
         if (params.m_OriginalWidth == 0) {
@@ -1076,9 +1314,24 @@ namespace dmGraphics
         return tex;
     }
 
+    static void WaitForTextureUploads(HTexture texture)
+    {
+        Context* context = g_NullContext;
+        if (!context)
+        {
+            return;
+        }
+        dmMutex::ScopedLock lk(context->m_UploadMutex);
+        while (texture->m_PendingUploads > 0)
+        {
+            dmConditionVariable::Wait(context->m_UploadCond, context->m_UploadMutex);
+        }
+    }
+
     static void NullDeleteTexture(HTexture t)
     {
         assert(t);
+        WaitForTextureUploads(t);
         if (t->m_Data != 0x0)
             delete [] (char*)t->m_Data;
         delete t;
@@ -1116,6 +1369,14 @@ namespace dmGraphics
         if (params.m_Data != 0x0)
             memcpy(texture->m_Data, params.m_Data, params.m_DataSize);
         texture->m_MipMapCount = dmMath::Max(texture->m_MipMapCount, (uint16_t)(params.m_MipMap+1));
+
+        if (!params.m_SubUpdate && params.m_MipMap == 0)
+        {
+            if (params.m_ResizeMipChain)
+                texture->m_MipMapCount = GetResizedMipMapCount(texture->m_MipMapCount, texture->m_Width, texture->m_Height, params.m_Width, params.m_Height);
+            texture->m_Width  = params.m_Width;
+            texture->m_Height = params.m_Height;
+        }
     }
 
     // Not used?
@@ -1166,6 +1427,7 @@ namespace dmGraphics
         assert(unit < MAX_TEXTURE_COUNT);
         assert(texture);
         assert(texture->m_Data);
+        g_StateCallCounts.m_EnableTexture++;
         context->m_Textures[unit] = texture;
     }
 
@@ -1173,6 +1435,7 @@ namespace dmGraphics
     {
         assert(context);
         assert(unit < MAX_TEXTURE_COUNT);
+        g_StateCallCounts.m_DisableTexture++;
         context->m_Textures[unit] = 0;
     }
 
@@ -1324,12 +1587,30 @@ namespace dmGraphics
 
     static void NullSetTextureAsync(HTexture texture, const TextureParams& params)
     {
+#if defined(__EMSCRIPTEN__)
         SetTexture(texture, params);
+#else
+        // As with the other adapters, params.m_Data must be valid until the upload has completed
+        Context* context = g_NullContext;
+        dmMutex::ScopedLock lk(context->m_UploadMutex);
+        if (context->m_TextureUploads.Full())
+        {
+            context->m_TextureUploads.OffsetCapacity(16);
+        }
+        TextureUpload upload;
+        upload.m_Texture = texture;
+        upload.m_Params  = params;
+        context->m_TextureUploads.Push(upload);
+        texture->m_PendingUploads++;
+        dmConditionVariable::Broadcast(context->m_UploadCond);
+#endif
     }
 
     static uint32_t NullGetTextureStatusFlags(HTexture texture)
     {
-        return TEXTURE_STATUS_OK;
+        Context* context = g_NullContext;
+        dmMutex::ScopedLock lk(context->m_UploadMutex);
+        return texture->m_PendingUploads > 0 ? TEXTURE_STATUS_DATA_PENDING : TEXTURE_STATUS_OK;
     }
 
     // Tests only
@@ -1394,6 +1675,16 @@ namespace dmGraphics
         fn_table.m_HashVertexDeclaration = NullHashVertexDeclaration;
         fn_table.m_DrawElements = NullDrawElements;
         fn_table.m_Draw = NullDraw;
+        fn_table.m_IsInstancingSupported = NullIsInstancingSupported;
+        fn_table.m_EnableInstanceVertexDeclaration = NullEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = NullDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = NullDrawElementsInstanced;
+        fn_table.m_DrawInstanced = NullDrawInstanced;
+        fn_table.m_NewTransientBuffer = NullNewTransientBuffer;
+        fn_table.m_DeleteTransientBuffer = NullDeleteTransientBuffer;
+        fn_table.m_AllocTransientBuffer = NullAllocTransientBuffer;
+        fn_table.m_FlushTransientBuffer = NullFlushTransientBuffer;
+        fn_table.m_GetTransientBufferSize = NullGetTransientBufferSize;
         fn_table.m_NewVertexProgram = NullNewVertexProgram;
         fn_table.m_NewFragmentProgram = NullNewFragmentProgram;
         fn_table.m_NewProgram = NullNewProgram;
@@ -1409,6 +1700,7 @@ namespace dmGraphics
         fn_table.m_GetUniformName = NullGetUniformName;
         fn_table.m_GetUniformCount = NullGetUniformCount;
         fn_table.m_GetUniformLocation = NullGetUniformLocation;
+        fn_table.m_GetAttributeLocation = NullGetAttributeLocation;
         fn_table.m_SetConstantV4 = NullSetConstantV4;
         fn_table.m_SetConstantM4 = NullSetConstantM4;
         fn_table.m_SetSampler = NullSetSampler;
@@ -1452,6 +1744,15 @@ namespace dmGraphics
         fn_table.m_GetMaxElementsIndices = NullGetMaxElementsIndices;
         fn_table.m_IsMultiTargetRenderingSupported = NullIsMultiTargetRenderingSupported;
         fn_table.m_GetPipelineState = NullGetPipelineState;
+        fn_table.m_IsCommandRecorderSupported = NullIsCommandRecorderSupported;
+        fn_table.m_NewCommandRecorder = NullNewCommandRecorder;
+        fn_table.m_DeleteCommandRecorder = NullDeleteCommandRecorder;
+        fn_table.m_BeginCommandRecorder = NullBeginCommandRecorder;
+        fn_table.m_EndCommandRecorder = NullEndCommandRecorder;
+        fn_table.m_ExecuteCommandRecorders = NullExecuteCommandRecorders;
+        fn_table.m_BeginGpuTimer = NullBeginGpuTimer;
+        fn_table.m_EndGpuTimer = NullEndGpuTimer;
+        fn_table.m_GetGpuTimerResult = NullGetGpuTimerResult;
         fn_table.m_SetStencilFuncSeparate = NullSetStencilFuncSeparate;
         fn_table.m_SetStencilOpSeparate = NullSetStencilOpSeparate;
         fn_table.m_SetFaceWinding = NullSetFaceWinding;
@@ -16,6 +16,12 @@
 #define GRAPHICS_DEVICE_NULL
 
 #include <dmsdk/dlib/vmath.h>
+#include <dlib/array.h>
+#include <dlib/condition_variable.h>
+#include <dlib/mutex.h>
+#include <dlib/thread.h>
+
+#include "../graphics_private.h"
 
 namespace dmGraphics
 {
@@ -29,6 +35,14 @@ namespace dmGraphics
         uint32_t m_OriginalWidth;
         uint32_t m_OriginalHeight;
         uint16_t m_MipMapCount;
+        // Uploads from SetTextureAsync that haven't been processed by the upload thread
+        uint16_t m_PendingUploads;
+    };
+
+    struct TextureUpload
+    {
+        HTexture      m_Texture;
+        TextureParams m_Params;
     };
 
     struct VertexStream
@@ -66,6 +80,14 @@ namespace dmGraphics
         uint32_t m_Size;
     };
 
+    struct TransientBuffer
+    {
+        HVertexBuffer m_VertexBuffer;
+        uint32_t      m_Size;
+        uint32_t      m_Offset;
+        uint32_t      m_Frame;
+    };
+
     struct IndexBuffer
     {
         char* m_Buffer;
@@ -106,6 +128,17 @@ namespace dmGraphics
         uint32_t                    m_Dpi;
         int32_t                     m_ScissorRect[4];
         uint32_t                    m_TextureFormatSupport;
+        uint32_t                    m_FrameCount;
+        // SetTextureAsync uploads are done on a worker thread, to mimic the asynchronous uploads of the other adapters
+        dmArray<TextureUpload>      m_TextureUploads;
+        dmThread::Thread            m_UploadThread;
+        dmMutex::HMutex             m_UploadMutex;
+        dmConditionVariable::HConditionVariable m_UploadCond;
+        // Synthetic gpu timestamps, advanced by each draw call
+        GpuTimers                   m_GpuTimers;
+        uint64_t                    m_GpuTimestamps[GPU_TIMER_FRAME_LATENCY * MAX_GPU_TIMER_QUERIES * 2];
+        uint64_t                    m_GpuTime;
+        uint32_t                    m_UploadThreadQuit : 1;
         uint32_t                    m_WindowOpened : 1;
         // Only use for testing
         uint32_t                    m_RequestWindowClose : 1;
@@ -361,6 +361,43 @@ static void LogFrameBufferError(GLenum status)
     typedef void (* DM_PFNGLDRAWBUFFERSPROC) (GLsizei n, const GLenum *bufs);
     DM_PFNGLDRAWBUFFERSPROC PFN_glDrawBuffers = NULL;
 
+    typedef void (* DM_PFNGLDRAWARRAYSINSTANCEDPROC) (GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+    DM_PFNGLDRAWARRAYSINSTANCEDPROC PFN_glDrawArraysInstanced = NULL;
+
+    typedef void (* DM_PFNGLDRAWELEMENTSINSTANCEDPROC) (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount);
+    DM_PFNGLDRAWELEMENTSINSTANCEDPROC PFN_glDrawElementsInstanced = NULL;
+
+    typedef void (* DM_PFNGLVERTEXATTRIBDIVISORPROC) (GLuint index, GLuint divisor);
+    DM_PFNGLVERTEXATTRIBDIVISORPROC PFN_glVertexAttribDivisor = NULL;
+
+    typedef void (* DM_PFNGLGENQUERIESPROC) (GLsizei n, GLuint* ids);
+    DM_PFNGLGENQUERIESPROC PFN_glGenQueries = NULL;
+
+    typedef void (* DM_PFNGLDELETEQUERIESPROC) (GLsizei n, const GLuint* ids);
+    DM_PFNGLDELETEQUERIESPROC PFN_glDeleteQueries = NULL;
+
+    typedef void (* DM_PFNGLQUERYCOUNTERPROC) (GLuint id, GLenum target);
+    DM_PFNGLQUERYCOUNTERPROC PFN_glQueryCounter = NULL;
+
+    typedef void (* DM_PFNGLGETQUERYOBJECTUIVPROC) (GLuint id, GLenum pname, GLuint* params);
+    DM_PFNGLGETQUERYOBJECTUIVPROC PFN_glGetQueryObjectuiv = NULL;
+
+    typedef void (* DM_PFNGLGETQUERYOBJECTUI64VPROC) (GLuint id, GLenum pname, uint64_t* params);
+    DM_PFNGLGETQUERYOBJECTUI64VPROC PFN_glGetQueryObjectui64v = NULL;
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
     Context* g_Context = 0x0;
 
     Context::Context(const ContextParams& params)
@@ -605,6 +642,34 @@ static void LogFrameBufferError(GLenum status)
         return PFN_glDrawBuffers != 0x0;
     }
 
+    // Draw calls are only recorded on the main thread
+    static bool OpenGLIsCommandRecorderSupported(HContext context)
+    {
+        return false;
+    }
+
+    static HCommandRecorder OpenGLNewCommandRecorder(HContext context)
+    {
+        return 0;
+    }
+
+    static void OpenGLDeleteCommandRecorder(HContext context, HCommandRecorder recorder)
+    {}
+
+    static void OpenGLBeginCommandRecorder(HContext context, HCommandRecorder recorder)
+    {}
+
+    static void OpenGLEndCommandRecorder(HContext context, HCommandRecorder recorder)
+    {}
+
+    static void OpenGLExecuteCommandRecorders(HContext context, HCommandRecorder* recorders, uint32_t recorder_count)
+    {}
+
+    static bool OpenGLIsInstancingSupported(HContext context)
+    {
+        return PFN_glDrawArraysInstanced != 0x0 && PFN_glDrawElementsInstanced != 0x0 && PFN_glVertexAttribDivisor != 0x0;
+    }
+
 
 static uintptr_t GetExtProcAddress(const char* name, const char* extension_name, const char* core_name, HContext context)
 {
@@ -1036,6 +1101,28 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glInvalidateFramebuffer, "glDiscardFramebuffer", "discard_framebuffer", "glInvalidateFramebuffer", DM_PFNGLINVALIDATEFRAMEBUFFERPROC, context);
         DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawBuffers, "glDrawBuffers", "draw_buffers", "glDrawBuffers", DM_PFNGLDRAWBUFFERSPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawArraysInstanced, "glDrawArraysInstanced", "draw_instanced", "glDrawArraysInstanced", DM_PFNGLDRAWARRAYSINSTANCEDPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDrawElementsInstanced, "glDrawElementsInstanced", "draw_instanced", "glDrawElementsInstanced", DM_PFNGLDRAWELEMENTSINSTANCEDPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glVertexAttribDivisor, "glVertexAttribDivisor", "instanced_arrays", "glVertexAttribDivisor", DM_PFNGLVERTEXATTRIBDIVISORPROC, context);
+
+        // Timestamp queries are core in OpenGL 3.3 (ARB_timer_query), and an extension on OpenGL ES (EXT_disjoint_timer_query)
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glQueryCounter, "glQueryCounter", "timer_query", "glQueryCounter", DM_PFNGLQUERYCOUNTERPROC, context);
+        DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glQueryCounter, "glQueryCounter", "disjoint_timer_query", 0, DM_PFNGLQUERYCOUNTERPROC, context);
+        if (PFN_glQueryCounter)
+        {
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGenQueries, "glGenQueries", "timer_query", "glGenQueries", DM_PFNGLGENQUERIESPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGenQueries, "glGenQueries", "disjoint_timer_query", 0, DM_PFNGLGENQUERIESPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDeleteQueries, "glDeleteQueries", "timer_query", "glDeleteQueries", DM_PFNGLDELETEQUERIESPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glDeleteQueries, "glDeleteQueries", "disjoint_timer_query", 0, DM_PFNGLDELETEQUERIESPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetQueryObjectuiv, "glGetQueryObjectuiv", "timer_query", "glGetQueryObjectuiv", DM_PFNGLGETQUERYOBJECTUIVPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetQueryObjectuiv, "glGetQueryObjectuiv", "disjoint_timer_query", 0, DM_PFNGLGETQUERYOBJECTUIVPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetQueryObjectui64v, "glGetQueryObjectui64v", "timer_query", "glGetQueryObjectui64v", DM_PFNGLGETQUERYOBJECTUI64VPROC, context);
+            DMGRAPHICS_GET_PROC_ADDRESS_EXT(PFN_glGetQueryObjectui64v, "glGetQueryObjectui64v", "disjoint_timer_query", 0, DM_PFNGLGETQUERYOBJECTUI64VPROC, context);
+        }
+
+        // The queries are created by the first frame that is profiled
+        context->m_GpuTimerSupport = PFN_glQueryCounter && PFN_glGenQueries && PFN_glDeleteQueries && PFN_glGetQueryObjectuiv && PFN_glGetQueryObjectui64v;
+        context->m_GpuTimerDisjointSupport = OpenGLIsExtensionSupported(context, "GL_EXT_disjoint_timer_query");
 
         if (OpenGLIsExtensionSupported(context, "GL_IMG_texture_compression_pvrtc") ||
             OpenGLIsExtensionSupported(context, "WEBGL_compressed_texture_pvrtc"))
@@ -1232,6 +1319,12 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         {
             JobQueueFinalize();
             PostDeleteTextures(true);
+            if (context->m_GpuTimerQueriesCreated)
+            {
+                PFN_glDeleteQueries(DM_ARRAY_SIZE(context->m_GpuTimerQueries), context->m_GpuTimerQueries);
+                memset(&context->m_GpuTimers, 0, sizeof(context->m_GpuTimers));
+                context->m_GpuTimerQueriesCreated = 0;
+            }
             glfwCloseWindow();
             context->m_WindowResizeCallback = 0x0;
             context->m_Width = 0;
@@ -1395,6 +1488,88 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 #if defined(ANDROID)
         glfwAndroidBeginFrame();
 #endif
+
+        if (context->m_GpuTimerSupport && !context->m_GpuTimerQueriesCreated && IsGpuTimerEnabled())
+        {
+            PFN_glGenQueries(DM_ARRAY_SIZE(context->m_GpuTimerQueries), context->m_GpuTimerQueries);
+            context->m_GpuTimerQueriesCreated = glGetError() == GL_NO_ERROR;
+            context->m_GpuTimerSupport = context->m_GpuTimerQueriesCreated;
+        }
+
+        if (context->m_GpuTimerQueriesCreated)
+        {
+            // A disjoint operation (e.g. a change of the gpu frequency) makes the timestamps of the frames in flight
+            // meaningless. The flag is cleared when read, so the frames are counted down until they are all read back.
+            if (context->m_GpuTimerDisjointSupport)
+            {
+                GLint disjoint = 0;
+                glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+                if (disjoint)
+                {
+                    context->m_GpuTimerDisjointFrames = GPU_TIMER_FRAME_LATENCY;
+                }
+            }
+
+            GpuTimerFrame* frame = NextGpuTimerFrame(&context->m_GpuTimers);
+            const GLuint* queries = &context->m_GpuTimerQueries[(frame - context->m_GpuTimers.m_Frames) * MAX_GPU_TIMER_QUERIES * 2];
+
+            // The queries were issued GPU_TIMER_FRAME_LATENCY frames ago, and are normally available. If they aren't,
+            // the results of the frame are skipped rather than stalling on them.
+            uint64_t timestamps[MAX_GPU_TIMER_QUERIES * 2];
+            GLuint available = frame->m_QueryCount > 0;
+            for (uint32_t i = 0; i < frame->m_QueryCount && available; ++i)
+            {
+                if (frame->m_Timers[i] == GPU_TIMER_QUERY_DROPPED)
+                {
+                    continue;
+                }
+                PFN_glGetQueryObjectuiv(queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available)
+                {
+                    PFN_glGetQueryObjectui64v(queries[i * 2], GL_QUERY_RESULT, &timestamps[i * 2]);
+                    PFN_glGetQueryObjectui64v(queries[i * 2 + 1], GL_QUERY_RESULT, &timestamps[i * 2 + 1]);
+                }
+            }
+            if (context->m_GpuTimerDisjointFrames > 0)
+            {
+                context->m_GpuTimerDisjointFrames--;
+                available = 0;
+            }
+            ResolveGpuTimerFrame(&context->m_GpuTimers, frame, available ? timestamps : 0);
+        }
+    }
+
+    static void OpenGLBeginGpuTimer(HContext context, uint32_t timer)
+    {
+        if (!context->m_GpuTimerQueriesCreated)
+        {
+            return;
+        }
+        int32_t query = BeginGpuTimerQuery(&context->m_GpuTimers, timer);
+        if (query >= 0)
+        {
+            PFN_glQueryCounter(context->m_GpuTimerQueries[(context->m_GpuTimers.m_FrameIndex * MAX_GPU_TIMER_QUERIES + query) * 2], GL_TIMESTAMP);
+            CHECK_GL_ERROR;
+        }
+    }
+
+    static void OpenGLEndGpuTimer(HContext context, uint32_t timer)
+    {
+        if (!context->m_GpuTimerQueriesCreated)
+        {
+            return;
+        }
+        int32_t query = EndGpuTimerQuery(&context->m_GpuTimers, timer);
+        if (query >= 0)
+        {
+            PFN_glQueryCounter(context->m_GpuTimerQueries[(context->m_GpuTimers.m_FrameIndex * MAX_GPU_TIMER_QUERIES + query) * 2 + 1], GL_TIMESTAMP);
+            CHECK_GL_ERROR;
+        }
+    }
+
+    static bool OpenGLGetGpuTimerResult(HContext context, uint32_t timer, uint64_t* out_nanoseconds)
+    {
+        return GetGpuTimerResult(&context->m_GpuTimers, timer, out_nanoseconds);
     }
 
     static void OpenGLFlip(HContext context)
@@ -1403,6 +1578,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         PostDeleteTextures(false);
         glfwSwapBuffers();
         CHECK_GL_ERROR;
+        context->m_FrameCount++;
     }
 
     static void OpenGLSetSwapInterval(HContext context, uint32_t swap_interval)
@@ -1460,6 +1636,85 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR;
     }
 
+    static HTransientBuffer OpenGLNewTransientBuffer(HContext context, uint32_t size)
+    {
+        TransientBuffer* buffer = new TransientBuffer();
+        memset(buffer, 0, sizeof(*buffer));
+        buffer->m_Data  = (uint8_t*) malloc(size);
+        buffer->m_Size  = size;
+        buffer->m_Frame = context->m_FrameCount - 1;
+
+        // The buffer is allocated once, and the regions are updated with glBufferSubData
+        glGenBuffersARB(1, &buffer->m_Buffer);
+        CHECK_GL_ERROR;
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, buffer->m_Buffer);
+        CHECK_GL_ERROR;
+        glBufferDataARB(GL_ARRAY_BUFFER_ARB, size * TRANSIENT_BUFFER_FRAME_COUNT, 0, GL_STREAM_DRAW);
+        CHECK_GL_ERROR;
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        CHECK_GL_ERROR;
+        return (HTransientBuffer) buffer;
+    }
+
+    static void OpenGLDeleteTransientBuffer(HContext context, HTransientBuffer transient_buffer)
+    {
+        if (!transient_buffer)
+            return;
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+        glDeleteBuffersARB(1, &buffer->m_Buffer);
+        CHECK_GL_ERROR;
+        free(buffer->m_Data);
+        delete buffer;
+    }
+
+    static void* OpenGLAllocTransientBuffer(HContext context, HTransientBuffer transient_buffer, uint32_t size, uint32_t alignment, HVertexBuffer* vertex_buffer_out, uint32_t* offset_out)
+    {
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+
+        if (buffer->m_Frame != context->m_FrameCount)
+        {
+            buffer->m_Frame         = context->m_FrameCount;
+            buffer->m_RegionOffset  = (context->m_FrameCount % TRANSIENT_BUFFER_FRAME_COUNT) * buffer->m_Size;
+            buffer->m_Offset        = 0;
+            buffer->m_FlushedOffset = 0;
+        }
+
+        uint32_t offset = AlignTransientBufferOffset(buffer->m_Offset, alignment);
+        if (offset + size > buffer->m_Size)
+        {
+            return 0;
+        }
+        buffer->m_Offset = offset + size;
+
+        *vertex_buffer_out = (HVertexBuffer) buffer->m_Buffer;
+        *offset_out        = buffer->m_RegionOffset + offset;
+        return buffer->m_Data + offset;
+    }
+
+    static void OpenGLFlushTransientBuffer(HContext context, HTransientBuffer transient_buffer)
+    {
+        DM_PROFILE(__FUNCTION__);
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+        if (buffer->m_Frame != context->m_FrameCount || buffer->m_FlushedOffset == buffer->m_Offset)
+        {
+            return;
+        }
+
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, buffer->m_Buffer);
+        CHECK_GL_ERROR;
+        glBufferSubDataARB(GL_ARRAY_BUFFER_ARB, buffer->m_RegionOffset + buffer->m_FlushedOffset,
+            buffer->m_Offset - buffer->m_FlushedOffset, buffer->m_Data + buffer->m_FlushedOffset);
+        CHECK_GL_ERROR;
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        CHECK_GL_ERROR;
+        buffer->m_FlushedOffset = buffer->m_Offset;
+    }
+
+    static uint32_t OpenGLGetTransientBufferSize(HTransientBuffer transient_buffer)
+    {
+        return ((TransientBuffer*) transient_buffer)->m_Size;
+    }
+
     static void OpenGLSetVertexBufferSubData(HVertexBuffer buffer, uint32_t offset, uint32_t size, const void* data)
     {
         DM_PROFILE(__FUNCTION__);
@@ -1625,6 +1880,13 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         VertexDeclaration::Stream* streams = &vertex_declaration->m_Streams[0];
         for (uint32_t i=0; i < n; i++)
         {
+            // Consecutive streams with the same name are the columns of a matrix attribute
+            if (i > 0 && strcmp(streams[i].m_Name, streams[i-1].m_Name) == 0)
+            {
+                streams[i].m_PhysicalIndex = streams[i-1].m_PhysicalIndex != -1 ? streams[i-1].m_PhysicalIndex + 1 : -1;
+                continue;
+            }
+
             GLint location = glGetAttribLocation(program, streams[i].m_Name);
             if (location != -1)
             {
@@ -1643,7 +1905,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         vertex_declaration->m_ModificationVersion = context->m_ModificationVersion;
     }
 
-    static void OpenGLEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    static void OpenGLEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset, HProgram program)
     {
         assert(context);
         assert(vertex_buffer);
@@ -1671,7 +1933,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
                         GetOpenGLType(vertex_declaration->m_Streams[i].m_Type),
                         vertex_declaration->m_Streams[i].m_Normalize,
                         vertex_declaration->m_Stride,
-                BUFFER_OFFSET(vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
+                BUFFER_OFFSET(vertex_buffer_offset + vertex_declaration->m_Streams[i].m_Offset) );   //The starting point of the VBO, for the vertices
 
                 CHECK_GL_ERROR;
             }
@@ -1698,6 +1960,62 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR;
     }
 
+    static void OpenGLEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    {
+        assert(context);
+        assert(vertex_buffer);
+        assert(vertex_declaration);
+        assert(PFN_glVertexAttribDivisor);
+
+        if (!(context->m_ModificationVersion == vertex_declaration->m_ModificationVersion && vertex_declaration->m_BoundForProgram == program))
+        {
+            BindVertexDeclarationProgram(context, vertex_declaration, program);
+        }
+
+        #define BUFFER_OFFSET(i) ((char*)0x0 + (i))
+
+        glBindBufferARB(GL_ARRAY_BUFFER, vertex_buffer);
+        CHECK_GL_ERROR;
+
+        for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+        {
+            const VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            if (stream.m_PhysicalIndex != -1)
+            {
+                glEnableVertexAttribArray(stream.m_PhysicalIndex);
+                CHECK_GL_ERROR;
+                glVertexAttribPointer(stream.m_PhysicalIndex, stream.m_Size, GetOpenGLType(stream.m_Type), stream.m_Normalize, vertex_declaration->m_Stride, BUFFER_OFFSET(stream.m_Offset));
+                CHECK_GL_ERROR;
+                PFN_glVertexAttribDivisor(stream.m_PhysicalIndex, 1);
+                CHECK_GL_ERROR;
+            }
+        }
+
+        #undef BUFFER_OFFSET
+    }
+
+    static void OpenGLDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        assert(context);
+        assert(vertex_declaration);
+
+        for (uint32_t i=0; i<vertex_declaration->m_StreamCount; i++)
+        {
+            const VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            if (stream.m_PhysicalIndex != -1)
+            {
+                // The attribute location might be used by a per-vertex stream in the next draw call
+                PFN_glVertexAttribDivisor(stream.m_PhysicalIndex, 0);
+                CHECK_GL_ERROR;
+                glDisableVertexAttribArray(stream.m_PhysicalIndex);
+                CHECK_GL_ERROR;
+            }
+        }
+
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+        CHECK_GL_ERROR;
+    }
+
     void OpenGLHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
     {
         uint16_t stream_count = vertex_declaration->m_StreamCount;
@@ -1739,6 +2057,30 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         CHECK_GL_ERROR
     }
 
+    static void OpenGLDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
+        assert(context);
+        assert(index_buffer);
+        assert(PFN_glDrawElementsInstanced);
+        glBindBufferARB(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        CHECK_GL_ERROR;
+
+        PFN_glDrawElementsInstanced(GetOpenGLPrimitiveType(prim_type), count, GetOpenGLType(type), (GLvoid*)(uintptr_t) first, instance_count);
+        CHECK_GL_ERROR
+    }
+
+    static void OpenGLDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
+        assert(context);
+        assert(PFN_glDrawArraysInstanced);
+        PFN_glDrawArraysInstanced(GetOpenGLPrimitiveType(prim_type), first, count, instance_count);
+        CHECK_GL_ERROR
+    }
+
     static uint32_t CreateShader(GLenum type, const void* program, uint32_t program_size)
     {
         GLuint s = glCreateShader(type);
@@ -2021,6 +2363,16 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         return (uint32_t) location;
     }
 
+    static int32_t OpenGLGetAttributeLocation(HProgram prog, const char* name)
+    {
+        GLint location = glGetAttribLocation(prog, name);
+        if (location == -1)
+        {
+            CLEAR_GL_ERROR
+        }
+        return location;
+    }
+
     static void OpenGLSetViewport(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
     {
         assert(context);
@@ -2598,6 +2950,8 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
 
             if (params.m_MipMap == 0)
             {
+                if (params.m_ResizeMipChain)
+                    texture->m_MipMapCount = GetResizedMipMapCount(texture->m_MipMapCount, texture->m_Width, texture->m_Height, params.m_Width, params.m_Height);
                 texture->m_Width  = params.m_Width;
                 texture->m_Height = params.m_Height;
             }
@@ -3252,6 +3606,16 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_HashVertexDeclaration = OpenGLHashVertexDeclaration;
         fn_table.m_DrawElements = OpenGLDrawElements;
         fn_table.m_Draw = OpenGLDraw;
+        fn_table.m_IsInstancingSupported = OpenGLIsInstancingSupported;
+        fn_table.m_EnableInstanceVertexDeclaration = OpenGLEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = OpenGLDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = OpenGLDrawElementsInstanced;
+        fn_table.m_DrawInstanced = OpenGLDrawInstanced;
+        fn_table.m_NewTransientBuffer = OpenGLNewTransientBuffer;
+        fn_table.m_DeleteTransientBuffer = OpenGLDeleteTransientBuffer;
+        fn_table.m_AllocTransientBuffer = OpenGLAllocTransientBuffer;
+        fn_table.m_FlushTransientBuffer = OpenGLFlushTransientBuffer;
+        fn_table.m_GetTransientBufferSize = OpenGLGetTransientBufferSize;
         fn_table.m_NewVertexProgram = OpenGLNewVertexProgram;
         fn_table.m_NewFragmentProgram = OpenGLNewFragmentProgram;
         fn_table.m_NewProgram = OpenGLNewProgram;
@@ -3267,6 +3631,7 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_GetUniformName = OpenGLGetUniformName;
         fn_table.m_GetUniformCount = OpenGLGetUniformCount;
         fn_table.m_GetUniformLocation = OpenGLGetUniformLocation;
+        fn_table.m_GetAttributeLocation = OpenGLGetAttributeLocation;
         fn_table.m_SetConstantV4 = OpenGLSetConstantV4;
         fn_table.m_SetConstantM4 = OpenGLSetConstantM4;
         fn_table.m_SetSampler = OpenGLSetSampler;
@@ -3316,6 +3681,15 @@ static uintptr_t GetExtProcAddress(const char* name, const char* extension_name,
         fn_table.m_GetSupportedExtension = OpenGLGetSupportedExtension;
         fn_table.m_IsMultiTargetRenderingSupported = OpenGLIsMultiTargetRenderingSupported;
         fn_table.m_GetPipelineState = OpenGLGetPipelineState;
+        fn_table.m_IsCommandRecorderSupported = OpenGLIsCommandRecorderSupported;
+        fn_table.m_NewCommandRecorder = OpenGLNewCommandRecorder;
+        fn_table.m_DeleteCommandRecorder = OpenGLDeleteCommandRecorder;
+        fn_table.m_BeginCommandRecorder = OpenGLBeginCommandRecorder;
+        fn_table.m_EndCommandRecorder = OpenGLEndCommandRecorder;
+        fn_table.m_ExecuteCommandRecorders = OpenGLExecuteCommandRecorders;
+        fn_table.m_BeginGpuTimer = OpenGLBeginGpuTimer;
+        fn_table.m_EndGpuTimer = OpenGLEndGpuTimer;
+        fn_table.m_GetGpuTimerResult = OpenGLGetGpuTimerResult;
         return fn_table;
     }
 }
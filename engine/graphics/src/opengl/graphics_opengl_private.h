@@ -56,6 +56,9 @@ namespace dmGraphics
         uint64_t                m_TextureFormatSupport;
         uint32_t                m_DepthBufferBits;
         uint32_t                m_FrameBufferInvalidateBits;
+        uint32_t                m_FrameCount;
+        GpuTimers               m_GpuTimers;
+        GLuint                  m_GpuTimerQueries[GPU_TIMER_FRAME_LATENCY * MAX_GPU_TIMER_QUERIES * 2];
         float                   m_MaxAnisotropy;
         uint8_t                 m_AnisotropySupport                : 1;
         uint8_t                 m_FrameBufferInvalidateAttachments : 1;
@@ -65,6 +68,25 @@ namespace dmGraphics
         uint8_t                 m_RenderDocSupport                 : 1;
         uint8_t                 m_IsGles3Version                   : 1; // 0 == gles 2, 1 == gles 3
         uint8_t                 m_IsShaderLanguageGles             : 1; // 0 == glsl, 1 == gles
+        uint8_t                 m_GpuTimerSupport                  : 1;
+        uint8_t                 m_GpuTimerQueriesCreated           : 1;
+        uint8_t                 m_GpuTimerDisjointSupport          : 1; // EXT_disjoint_timer_query
+        uint8_t                 m_GpuTimerDisjointFrames;           // Frames of timestamps to drop after a disjoint operation
+    };
+
+    // Number of frames the regions of a transient buffer are reused after. The ring buffer has one region
+    // for each of these frames, so that a region isn't written to while the GPU might still be reading it.
+    static const uint32_t TRANSIENT_BUFFER_FRAME_COUNT = 3;
+
+    struct TransientBuffer
+    {
+        GLuint                  m_Buffer;           // TRANSIENT_BUFFER_FRAME_COUNT regions of m_Size bytes
+        uint8_t*                m_Data;             // The slices of this frame, until they are flushed
+        uint32_t                m_Size;
+        uint32_t                m_RegionOffset;     // Offset of the region of this frame in m_Buffer
+        uint32_t                m_Offset;           // End of the slices allocated this frame, relative to the region
+        uint32_t                m_FlushedOffset;    // End of the slices uploaded to m_Buffer, relative to the region
+        uint32_t                m_Frame;            // The frame the slices were allocated in
     };
 
     static inline void IncreaseModificationVersion(Context* context)
@@ -20,7 +20,10 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 
+#include <dlib/array.h>
+#include <dlib/atomic.h>
 #include <dlib/log.h>
+#include <dlib/thread.h>
 #include <dlib/time.h>
 #include "../graphics.h"
 
@@ -133,8 +136,31 @@ struct EngineCtx
     uint64_t m_TimeStart;
 
     dmGraphics::HContext m_GraphicsContext;
+
+    // Each frame, the command recorders clear the back buffer from worker threads
+    dmGraphics::HCommandRecorder m_CommandRecorders[2];
+    int32_atomic_t               m_RecordedCount;
+    int                          m_CommandRecorderSupported;
 } g_EngineCtx;
 
+struct RecordCtx
+{
+    EngineCtx*                   m_Engine;
+    dmGraphics::HCommandRecorder m_CommandRecorder;
+    uint8_t                      m_Color;
+};
+
+static void RecordThread(void* _ctx)
+{
+    RecordCtx* ctx = (RecordCtx*)_ctx;
+    dmGraphics::HContext context = ctx->m_Engine->m_GraphicsContext;
+    dmGraphics::BeginCommandRecorder(context, ctx->m_CommandRecorder);
+    dmGraphics::SetViewport(context, 0, 0, dmGraphics::GetWindowWidth(context), dmGraphics::GetWindowHeight(context));
+    dmGraphics::Clear(context, dmGraphics::BUFFER_TYPE_COLOR0_BIT, ctx->m_Color, 0, 0, 255, 1.0f, 0);
+    dmGraphics::EndCommandRecorder(context, ctx->m_CommandRecorder);
+    dmAtomicIncrement32(&ctx->m_Engine->m_RecordedCount);
+}
+
 static void* EngineCreate(int argc, char** argv)
 {
     if (!dmGraphics::Initialize())
@@ -170,6 +196,15 @@ static void* EngineCreate(int argc, char** argv)
 
     (void)dmGraphics::OpenWindow(engine->m_GraphicsContext, &window_params);
 
+    engine->m_CommandRecorderSupported = dmGraphics::IsCommandRecorderSupported(engine->m_GraphicsContext);
+    if (engine->m_CommandRecorderSupported)
+    {
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(engine->m_CommandRecorders); ++i)
+        {
+            engine->m_CommandRecorders[i] = dmGraphics::NewCommandRecorder(engine->m_GraphicsContext);
+        }
+    }
+
     g_EngineCtx.m_WasCreated++;
     g_EngineCtx.m_TimeStart = dmTime::GetTime();
     return &g_EngineCtx;
@@ -178,6 +213,11 @@ static void* EngineCreate(int argc, char** argv)
 static void EngineDestroy(void* _engine)
 {
     EngineCtx* engine = (EngineCtx*)_engine;
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(engine->m_CommandRecorders); ++i)
+    {
+        if (engine->m_CommandRecorders[i])
+            dmGraphics::DeleteCommandRecorder(engine->m_GraphicsContext, engine->m_CommandRecorders[i]);
+    }
     dmGraphics::CloseWindow(engine->m_GraphicsContext);
     dmGraphics::DeleteContext(engine->m_GraphicsContext);
     dmGraphics::Finalize();
@@ -205,6 +245,32 @@ static UpdateResult EngineUpdate(void* _engine)
                                 (float)color_b,
                                 (float)color_a,
                                 1.0f, 0);
+
+    if (engine->m_CommandRecorderSupported)
+    {
+        const uint32_t recorder_count = DM_ARRAY_SIZE(engine->m_CommandRecorders);
+        RecordCtx record_ctx[recorder_count];
+        dmThread::Thread threads[recorder_count];
+        for (uint32_t i = 0; i < recorder_count; ++i)
+        {
+            record_ctx[i].m_Engine          = engine;
+            record_ctx[i].m_CommandRecorder = engine->m_CommandRecorders[i];
+            record_ctx[i].m_Color           = (uint8_t) (color_b + i * 64);
+            threads[i] = dmThread::New(RecordThread, 0x80000, &record_ctx[i], "recorder");
+        }
+        for (uint32_t i = 0; i < recorder_count; ++i)
+        {
+            dmThread::Join(threads[i]);
+        }
+
+        // The recordings are executed in the given order, and only once
+        dmGraphics::ExecuteCommandRecorders(engine->m_GraphicsContext, engine->m_CommandRecorders, recorder_count);
+        dmGraphics::ExecuteCommandRecorders(engine->m_GraphicsContext, engine->m_CommandRecorders, recorder_count);
+
+        // The main thread can keep drawing into the same render pass after the recorders
+        dmGraphics::Clear(engine->m_GraphicsContext, dmGraphics::BUFFER_TYPE_DEPTH_BIT, 0, 0, 0, 0, 1.0f, 0);
+    }
+
     dmGraphics::Flip(engine->m_GraphicsContext);
 
     color_b += 2;
@@ -248,6 +314,9 @@ TEST(App, Run)
     //ASSERT_EQ(200, g_EngineCtx.m_WasRun);
     ASSERT_EQ(1, g_EngineCtx.m_WasDestroyed);
     ASSERT_EQ(1, g_EngineCtx.m_WasResultCalled);
+
+    ASSERT_TRUE(g_EngineCtx.m_CommandRecorderSupported);
+    ASSERT_EQ(g_EngineCtx.m_WasRun * (int32_t) DM_ARRAY_SIZE(g_EngineCtx.m_CommandRecorders), (int32_t) g_EngineCtx.m_RecordedCount);
 }
 
 
@@ -13,10 +13,16 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 
 #include <dlib/log.h>
+#include <dlib/dstrings.h>
+#include <dlib/math.h>
+#include <dlib/sys.h>
+#include <dlib/time.h>
 
 #include "graphics.h"
 #include "graphics_private.h"
@@ -329,6 +335,88 @@ TEST_F(dmGraphicsTest, Drawing)
     dmGraphics::DeleteVertexDeclaration(vd);
 }
 
+TEST_F(dmGraphicsTest, DrawingInstanced)
+{
+    ASSERT_TRUE(dmGraphics::IsInstancingSupported(m_Context));
+
+    float v[] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f };
+    uint32_t i[] = { 0, 1, 2 };
+    float instances[] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+
+    dmGraphics::VertexElement ve[] =
+    {
+        {"position", 0, 3, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::VertexElement ve_instance[] =
+    {
+        {"offset", 0, 3, dmGraphics::TYPE_FLOAT, false }
+    };
+    dmGraphics::HVertexDeclaration vd = dmGraphics::NewVertexDeclaration(m_Context, ve, 1);
+    dmGraphics::HVertexDeclaration vd_instance = dmGraphics::NewVertexDeclaration(m_Context, ve_instance, 1);
+    dmGraphics::HVertexBuffer vb = dmGraphics::NewVertexBuffer(m_Context, sizeof(v), v, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+    dmGraphics::HVertexBuffer vb_instance = dmGraphics::NewVertexBuffer(m_Context, sizeof(instances), instances, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+    dmGraphics::HIndexBuffer ib = dmGraphics::NewIndexBuffer(m_Context, sizeof(i), i, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
+
+    dmGraphics::EnableVertexDeclaration(m_Context, vd, vb);
+    dmGraphics::EnableInstanceVertexDeclaration(m_Context, vd_instance, vb_instance, 0);
+    dmGraphics::DrawElementsInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, 2, dmGraphics::TYPE_UNSIGNED_INT, ib);
+    uint64_t draw_count = dmGraphics::GetDrawCount();
+    dmGraphics::DrawInstanced(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3, 2);
+    dmGraphics::DisableInstanceVertexDeclaration(m_Context, vd_instance);
+    dmGraphics::DisableVertexDeclaration(m_Context, vd);
+
+    // One draw call per instanced draw, regardless of the instance count
+    ASSERT_EQ(draw_count + 1, dmGraphics::GetDrawCount());
+
+    dmGraphics::DeleteIndexBuffer(ib);
+    dmGraphics::DeleteVertexBuffer(vb_instance);
+    dmGraphics::DeleteVertexBuffer(vb);
+    dmGraphics::DeleteVertexDeclaration(vd_instance);
+    dmGraphics::DeleteVertexDeclaration(vd);
+}
+
+TEST_F(dmGraphicsTest, TestGpuTimers)
+{
+    const uint32_t timer = dmGraphics::GPU_TIMER_USER;
+    uint64_t result;
+
+    // The test runs with the null profiler, so the OpenGL and Vulkan adapters wouldn't issue any queries.
+    // The null adapter always records its synthetic timestamps.
+    ASSERT_FALSE(dmGraphics::IsGpuTimerEnabled());
+
+    for (uint32_t i = 0; i < dmGraphics::GPU_TIMER_FRAME_LATENCY; ++i)
+    {
+        dmGraphics::BeginFrame(m_Context);
+        ASSERT_FALSE(dmGraphics::GetGpuTimerResult(m_Context, timer, &result));
+
+        dmGraphics::BeginGpuTimer(m_Context, timer);
+        dmGraphics::Draw(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3);
+        dmGraphics::Draw(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3);
+        dmGraphics::EndGpuTimer(m_Context, timer);
+        dmGraphics::Draw(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3);
+
+        // The begin/end pairs of a timer are summed
+        dmGraphics::BeginGpuTimer(m_Context, timer);
+        dmGraphics::Draw(m_Context, dmGraphics::PRIMITIVE_TRIANGLES, 0, 3);
+        dmGraphics::EndGpuTimer(m_Context, timer);
+
+        // Not ended, and dropped
+        dmGraphics::BeginGpuTimer(m_Context, timer + 1);
+        dmGraphics::Flip(m_Context);
+    }
+
+    // The timestamps of the first frame are read back when its queries are reused
+    dmGraphics::BeginFrame(m_Context);
+    ASSERT_TRUE(dmGraphics::GetGpuTimerResult(m_Context, timer, &result));
+    ASSERT_EQ(3000u, result);
+    ASSERT_TRUE(dmGraphics::GetGpuTimerResult(m_Context, dmGraphics::GPU_TIMER_FRAME, &result));
+    ASSERT_EQ(4000u, result);
+    ASSERT_TRUE(dmGraphics::GetGpuTimerResult(m_Context, timer + 1, &result));
+    ASSERT_EQ(0u, result);
+    ASSERT_FALSE(dmGraphics::GetGpuTimerResult(m_Context, dmGraphics::MAX_GPU_TIMERS, &result));
+    dmGraphics::Flip(m_Context);
+}
+
 static inline dmGraphics::ShaderDesc::Shader MakeDDFShader(const char* data, uint32_t count)
 {
     dmGraphics::ShaderDesc::Shader ddf;
@@ -373,6 +461,18 @@ TEST_F(dmGraphicsTest, TestProgram)
     dmGraphics::ShaderDesc::Shader vs_shader = MakeDDFShader(vertex_data, (uint32_t) strlen(vertex_data));
     dmGraphics::ShaderDesc::Shader fs_shader = MakeDDFShader(fragment_data, (uint32_t) strlen(fragment_data));
 
+    // The attribute locations come from the reflection data of the shader
+    dmGraphics::ShaderDesc::ResourceBinding attributes[2];
+    memset(attributes, 0, sizeof(attributes));
+    attributes[0].m_Name    = "position";
+    attributes[0].m_Type    = dmGraphics::ShaderDesc::SHADER_TYPE_VEC4;
+    attributes[0].m_Binding = 0;
+    attributes[1].m_Name    = "texcoord0";
+    attributes[1].m_Type    = dmGraphics::ShaderDesc::SHADER_TYPE_VEC2;
+    attributes[1].m_Binding = 1;
+    vs_shader.m_Attributes.m_Data  = attributes;
+    vs_shader.m_Attributes.m_Count = DM_ARRAY_SIZE(attributes);
+
     dmGraphics::HVertexProgram vp = dmGraphics::NewVertexProgram(m_Context, &vs_shader);
     dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(m_Context, &fs_shader);
     dmGraphics::HProgram program = dmGraphics::NewProgram(m_Context, vp, fp);
@@ -381,6 +481,10 @@ TEST_F(dmGraphicsTest, TestProgram)
     ASSERT_EQ(1, dmGraphics::GetUniformLocation(program, "world"));
     ASSERT_EQ(2, dmGraphics::GetUniformLocation(program, "texture_sampler"));
     ASSERT_EQ(3, dmGraphics::GetUniformLocation(program, "tint"));
+    ASSERT_EQ(0, dmGraphics::GetAttributeLocation(program, "position"));
+    ASSERT_EQ(1, dmGraphics::GetAttributeLocation(program, "texcoord0"));
+    ASSERT_EQ(-1, dmGraphics::GetAttributeLocation(program, "view_proj"));
+    ASSERT_EQ(-1, dmGraphics::GetAttributeLocation(program, "mtx_world"));
     char buffer[64];
     dmGraphics::Type type;
     int32_t size;
@@ -454,6 +558,41 @@ TEST_F(dmGraphicsTest, TestTexture)
     dmGraphics::DeleteTexture(texture);
 }
 
+TEST_F(dmGraphicsTest, TestSetTextureAsync)
+{
+    dmGraphics::TextureCreationParams creation_params;
+    dmGraphics::TextureParams params;
+
+    creation_params.m_Width = WIDTH;
+    creation_params.m_Height = HEIGHT;
+
+    params.m_DataSize = WIDTH * HEIGHT;
+    params.m_Data = new char[params.m_DataSize];
+    memset((void*)params.m_Data, 0xAB, params.m_DataSize);
+    params.m_Width = WIDTH;
+    params.m_Height = HEIGHT;
+    params.m_Format = dmGraphics::TEXTURE_FORMAT_LUMINANCE;
+    dmGraphics::HTexture texture = dmGraphics::NewTexture(m_Context, creation_params);
+    dmGraphics::SetTextureAsync(texture, params);
+
+    while (dmGraphics::GetTextureStatusFlags(texture) & dmGraphics::TEXTURE_STATUS_DATA_PENDING)
+    {
+        dmTime::Sleep(1000);
+    }
+
+    delete [] (char*)params.m_Data;
+    ASSERT_EQ(WIDTH, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(HEIGHT, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(0xAB, ((uint8_t*)texture->m_Data)[0]);
+    ASSERT_EQ(0xAB, ((uint8_t*)texture->m_Data)[WIDTH * HEIGHT - 1]);
+
+    // Deleting a texture waits for its pending uploads
+    params.m_Data = new char[params.m_DataSize];
+    dmGraphics::SetTextureAsync(texture, params);
+    dmGraphics::DeleteTexture(texture);
+    delete [] (char*)params.m_Data;
+}
+
 TEST_F(dmGraphicsTest, TestSetTextureBounds)
 {
     dmGraphics::TextureCreationParams creation_params;
@@ -523,6 +662,65 @@ TEST_F(dmGraphicsTest, TestTextureDefautlOriginalDimension)
     dmGraphics::DeleteTexture(texture);
 }
 
+static void SetTextureMipChain(dmGraphics::HTexture texture, uint16_t width, uint16_t height, char* data, bool resize_mip_chain)
+{
+    dmGraphics::TextureParams params;
+    params.m_Format = dmGraphics::TEXTURE_FORMAT_RGBA;
+    params.m_Width  = width;
+    params.m_Height = height;
+    params.m_Data   = data;
+    params.m_ResizeMipChain = resize_mip_chain;
+    while (true)
+    {
+        params.m_DataSize = params.m_Width * params.m_Height * 4;
+        dmGraphics::SetTexture(texture, params);
+        if (params.m_Width == 1 && params.m_Height == 1)
+            break;
+        params.m_MipMap++;
+        params.m_Width  = dmMath::Max(1, params.m_Width >> 1);
+        params.m_Height = dmMath::Max(1, params.m_Height >> 1);
+    }
+}
+
+// Dropping or adding top mips by setting a new mip chain keeps the smallest mip level
+TEST_F(dmGraphicsTest, TestTextureResizeMipChain)
+{
+    char* data = new char[16 * 16 * 4];
+
+    dmGraphics::TextureCreationParams creation_params;
+    creation_params.m_MipMapCount = 5;
+
+    creation_params.m_Width = 4;
+    creation_params.m_Height = 4;
+    dmGraphics::HTexture small_texture = dmGraphics::NewTexture(m_Context, creation_params);
+    SetTextureMipChain(small_texture, 4, 4, data, false);
+    uint32_t small_size = dmGraphics::GetTextureResourceSize(small_texture);
+
+    creation_params.m_Width = 16;
+    creation_params.m_Height = 16;
+    dmGraphics::HTexture texture = dmGraphics::NewTexture(m_Context, creation_params);
+    SetTextureMipChain(texture, 16, 16, data, false);
+    uint32_t full_size = dmGraphics::GetTextureResourceSize(texture);
+
+    SetTextureMipChain(texture, 4, 4, data, true);
+    ASSERT_EQ(4, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(4, dmGraphics::GetTextureHeight(texture));
+    ASSERT_EQ(small_size, dmGraphics::GetTextureResourceSize(texture));
+
+    SetTextureMipChain(texture, 16, 16, data, true);
+    ASSERT_EQ(16, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(full_size, dmGraphics::GetTextureResourceSize(texture));
+
+    // Without m_ResizeMipChain, the texture keeps its mip count
+    SetTextureMipChain(texture, 4, 4, data, false);
+    ASSERT_EQ(4, dmGraphics::GetTextureWidth(texture));
+    ASSERT_LT(small_size, dmGraphics::GetTextureResourceSize(texture));
+
+    dmGraphics::DeleteTexture(small_texture);
+    dmGraphics::DeleteTexture(texture);
+    delete [] data;
+}
+
 TEST_F(dmGraphicsTest, TestRenderTarget)
 {
     dmGraphics::TextureCreationParams creation_params[dmGraphics::MAX_BUFFER_TYPE_COUNT];
@@ -745,6 +943,117 @@ TEST_F(dmGraphicsTest, TestTextureFormatBPP)
     }
 }
 
+TEST_F(dmGraphicsTest, TestTransientBuffer)
+{
+    dmGraphics::HTransientBuffer buffer = dmGraphics::NewTransientBuffer(m_Context, 64);
+    ASSERT_EQ(64u, dmGraphics::GetTransientBufferSize(buffer));
+
+    dmGraphics::HVertexBuffer vertex_buffer = 0;
+    uint32_t offset = ~0u;
+    void* data = dmGraphics::AllocTransientBuffer(m_Context, buffer, 16, 4, &vertex_buffer, &offset);
+    ASSERT_NE((void*) 0, data);
+    ASSERT_NE((dmGraphics::HVertexBuffer) 0, vertex_buffer);
+    ASSERT_EQ(0u, offset);
+    memset(data, 1, 16);
+
+    // The alignment doesn't have to be a power of two, e.g. a vertex stride
+    data = dmGraphics::AllocTransientBuffer(m_Context, buffer, 20, 12, &vertex_buffer, &offset);
+    ASSERT_NE((void*) 0, data);
+    ASSERT_EQ(24u, offset);
+
+    ASSERT_EQ((void*) 0, dmGraphics::AllocTransientBuffer(m_Context, buffer, 24, 4, &vertex_buffer, &offset));
+    dmGraphics::FlushTransientBuffer(m_Context, buffer);
+
+    // The whole buffer is available again the next frame
+    dmGraphics::Flip(m_Context);
+    data = dmGraphics::AllocTransientBuffer(m_Context, buffer, 64, 4, &vertex_buffer, &offset);
+    ASSERT_NE((void*) 0, data);
+    ASSERT_EQ(0u, offset);
+
+    dmGraphics::DeleteTransientBuffer(m_Context, buffer);
+}
+
+TEST_F(dmGraphicsTest, TestCommandRecorderNotSupported)
+{
+    ASSERT_FALSE(dmGraphics::IsCommandRecorderSupported(m_Context));
+    ASSERT_EQ((dmGraphics::HCommandRecorder) 0, dmGraphics::NewCommandRecorder(m_Context));
+}
+
+static const char* MakeHostPath(char* dst, uint32_t dst_len, const char* path)
+{
+#if defined(__NX__)
+    dmStrlCpy(dst, "host:/", dst_len);
+    dmStrlCat(dst, path, dst_len);
+    return dst;
+#else
+    return path;
+#endif
+}
+
+TEST(dmGraphicsPipelineCache, ReadWrite)
+{
+    char path_buffer[512];
+    const char* path = MakeHostPath(path_buffer, sizeof(path_buffer), "__PIPELINE_CACHE__");
+
+    dmGraphics::PipelineCacheDevice device;
+    device.m_VendorID = 0x10de;
+    device.m_DeviceID = 0x1234;
+    for (uint32_t i = 0; i < dmGraphics::PIPELINE_CACHE_UUID_SIZE; ++i)
+        device.m_PipelineCacheUUID[i] = (uint8_t) i;
+
+    // The data starts with the header of a VkPipelineCache, followed by driver specific data
+    uint8_t data[256];
+    uint32_t header[4] = { 16 + dmGraphics::PIPELINE_CACHE_UUID_SIZE, 1, device.m_VendorID, device.m_DeviceID };
+    memcpy(data, header, sizeof(header));
+    memcpy(data + sizeof(header), device.m_PipelineCacheUUID, dmGraphics::PIPELINE_CACHE_UUID_SIZE);
+    for (uint32_t i = sizeof(header) + dmGraphics::PIPELINE_CACHE_UUID_SIZE; i < sizeof(data); ++i)
+        data[i] = (uint8_t) (i * 7);
+
+    ASSERT_TRUE(dmGraphics::WritePipelineCacheFile(path, 1, data, sizeof(data)));
+
+    uint32_t data_size = 0;
+    uint8_t* read_data = dmGraphics::ReadPipelineCacheFile(path, 1, device, &data_size);
+    ASSERT_NE((uint8_t*) 0, read_data);
+    ASSERT_EQ(sizeof(data), data_size);
+    ASSERT_EQ(0, memcmp(data, read_data, sizeof(data)));
+    free(read_data);
+
+    // Written by another engine version
+    ASSERT_EQ((uint8_t*) 0, dmGraphics::ReadPipelineCacheFile(path, 2, device, &data_size));
+
+    // Written for another device
+    dmGraphics::PipelineCacheDevice other_device = device;
+    other_device.m_DeviceID++;
+    ASSERT_EQ((uint8_t*) 0, dmGraphics::ReadPipelineCacheFile(path, 1, other_device, &data_size));
+    other_device = device;
+    other_device.m_PipelineCacheUUID[3]++;
+    ASSERT_EQ((uint8_t*) 0, dmGraphics::ReadPipelineCacheFile(path, 1, other_device, &data_size));
+
+    // Corrupted driver data
+    FILE* file = fopen(path, "r+b");
+    ASSERT_NE((FILE*) 0, file);
+    ASSERT_EQ(0, fseek(file, -10, SEEK_END));
+    ASSERT_EQ(1u, (uint32_t) fwrite("x", 1, 1, file));
+    fclose(file);
+    ASSERT_EQ((uint8_t*) 0, dmGraphics::ReadPipelineCacheFile(path, 1, device, &data_size));
+
+    // Truncated file
+    file = fopen(path, "wb");
+    ASSERT_NE((FILE*) 0, file);
+    ASSERT_EQ(8u, (uint32_t) fwrite(data, 1, 8, file));
+    fclose(file);
+    ASSERT_EQ((uint8_t*) 0, dmGraphics::ReadPipelineCacheFile(path, 1, device, &data_size));
+
+    // A valid file replaces the broken one
+    ASSERT_TRUE(dmGraphics::WritePipelineCacheFile(path, 1, data, sizeof(data)));
+    read_data = dmGraphics::ReadPipelineCacheFile(path, 1, device, &data_size);
+    ASSERT_NE((uint8_t*) 0, read_data);
+    free(read_data);
+
+    dmSys::Unlink(path);
+    ASSERT_EQ((uint8_t*) 0, dmGraphics::ReadPipelineCacheFile(path, 1, device, &data_size));
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
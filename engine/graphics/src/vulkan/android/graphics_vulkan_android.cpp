@@ -80,6 +80,7 @@ PFN_vkQueueWaitIdle vkQueueWaitIdle;
 PFN_vkDeviceWaitIdle vkDeviceWaitIdle;
 PFN_vkCreateFramebuffer vkCreateFramebuffer;
 PFN_vkCreatePipelineCache vkCreatePipelineCache;
+PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 PFN_vkCreatePipelineLayout vkCreatePipelineLayout;
 PFN_vkCreateGraphicsPipelines vkCreateGraphicsPipelines;
 PFN_vkCreateComputePipelines vkCreateComputePipelines;
@@ -120,6 +121,7 @@ PFN_vkCmdBeginQuery vkCmdBeginQuery;
 PFN_vkCmdEndQuery vkCmdEndQuery;
 PFN_vkCmdResetQueryPool vkCmdResetQueryPool;
 PFN_vkCmdCopyQueryPoolResults vkCmdCopyQueryPoolResults;
+PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp;
 PFN_vkCreateAndroidSurfaceKHR vkCreateAndroidSurfaceKHR;
 PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
 PFN_vkGetPhysicalDeviceSurfaceSupportKHR vkGetPhysicalDeviceSurfaceSupportKHR;
@@ -226,6 +228,7 @@ namespace dmGraphics
         vkDeviceWaitIdle = (PFN_vkDeviceWaitIdle) vkGetInstanceProcAddr(vk_instance, "vkDeviceWaitIdle");
         vkCreateFramebuffer = (PFN_vkCreateFramebuffer) vkGetInstanceProcAddr(vk_instance, "vkCreateFramebuffer");
         vkCreatePipelineCache = (PFN_vkCreatePipelineCache) vkGetInstanceProcAddr(vk_instance, "vkCreatePipelineCache");
+        vkGetPipelineCacheData = (PFN_vkGetPipelineCacheData) vkGetInstanceProcAddr(vk_instance, "vkGetPipelineCacheData");
         vkCreatePipelineLayout = (PFN_vkCreatePipelineLayout) vkGetInstanceProcAddr(vk_instance, "vkCreatePipelineLayout");
         vkCreateGraphicsPipelines = (PFN_vkCreateGraphicsPipelines) vkGetInstanceProcAddr(vk_instance, "vkCreateGraphicsPipelines");
         vkCreateComputePipelines = (PFN_vkCreateComputePipelines) vkGetInstanceProcAddr(vk_instance, "vkCreateComputePipelines");
@@ -266,6 +269,7 @@ namespace dmGraphics
         vkCmdEndQuery = (PFN_vkCmdEndQuery) vkGetInstanceProcAddr(vk_instance, "vkCmdEndQuery");
         vkCmdResetQueryPool = (PFN_vkCmdResetQueryPool) vkGetInstanceProcAddr(vk_instance, "vkCmdResetQueryPool");
         vkCmdCopyQueryPoolResults = (PFN_vkCmdCopyQueryPoolResults) vkGetInstanceProcAddr(vk_instance, "vkCmdCopyQueryPoolResults");
+        vkCmdWriteTimestamp = (PFN_vkCmdWriteTimestamp) vkGetInstanceProcAddr(vk_instance, "vkCmdWriteTimestamp");
         vkCreateAndroidSurfaceKHR = (PFN_vkCreateAndroidSurfaceKHR) vkGetInstanceProcAddr(vk_instance, "vkCreateAndroidSurfaceKHR");
         vkDestroySurfaceKHR = (PFN_vkDestroySurfaceKHR) vkGetInstanceProcAddr(vk_instance, "vkDestroySurfaceKHR");
         vkGetPhysicalDeviceSurfaceSupportKHR = (PFN_vkGetPhysicalDeviceSurfaceSupportKHR) vkGetInstanceProcAddr(vk_instance, "vkGetPhysicalDeviceSurfaceSupportKHR");
@@ -125,6 +125,12 @@ namespace dmGraphics
         {
             g_VulkanContext->m_WindowFocusCallback(g_VulkanContext->m_WindowFocusCallbackUserData, focus);
         }
+
+        // Mobile applications are often killed in the background without closing the window
+        if (!focus && g_VulkanContext->m_WindowOpened)
+        {
+            SavePipelineCache(g_VulkanContext);
+        }
     }
 
     uint32_t VulkanGetWindowRefreshRate(HContext context)
@@ -195,13 +201,27 @@ namespace dmGraphics
 
             glfwCloseWindow();
 
+            UpdateTextureUploads(context, true);
+            context->m_TextureUploads.SetCapacity(0);
+
+            if (context->m_GpuTimerQueryPool != VK_NULL_HANDLE)
+            {
+                vkDestroyQueryPool(vk_device, context->m_GpuTimerQueryPool, 0);
+                context->m_GpuTimerQueryPool = VK_NULL_HANDLE;
+            }
+
             context->m_PipelineCache.Iterate(DestroyPipelineCacheCb, context);
 
+            SavePipelineCache(context);
+            vkDestroyPipelineCache(vk_device, context->m_VkPipelineCache, 0);
+            context->m_VkPipelineCache = VK_NULL_HANDLE;
+
             DestroyDeviceBuffer(vk_device, &context->m_MainTextureDepthStencil.m_DeviceBuffer.m_Handle);
             DestroyTexture(vk_device, &context->m_MainTextureDepthStencil.m_Handle);
             DestroyTexture(vk_device, &context->m_DefaultTexture->m_Handle);
 
             vkDestroyRenderPass(vk_device, context->m_MainRenderPass, 0);
+            vkDestroyRenderPass(vk_device, context->m_MainRenderPassContinue, 0);
 
             vkFreeCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, context->m_MainCommandBuffers.Size(), context->m_MainCommandBuffers.Begin());
             vkFreeCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &context->m_MainCommandBufferUploadHelper);
@@ -248,11 +268,14 @@ namespace dmGraphics
 
             context->m_WindowOpened = 0;
 
-            if (context->m_DynamicOffsetBuffer)
+            if (context->m_MainCommandRecorder.m_DrawState.m_DynamicOffsetBuffer)
             {
-                free(context->m_DynamicOffsetBuffer);
+                free(context->m_MainCommandRecorder.m_DrawState.m_DynamicOffsetBuffer);
             }
 
+            dmThread::FreeTls(context->m_CommandRecorderKey);
+            dmMutex::Delete(context->m_CommandRecorderMutex);
+
             delete context->m_SwapChain->m_ResolveTexture;
             delete context->m_SwapChain;
         }
@@ -17,6 +17,7 @@
 #include <dlib/profile.h>
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dlib/hash.h>
 
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 
@@ -149,6 +150,12 @@ namespace dmGraphics
         m_UseValidationLayers     = params.m_UseValidationLayers;
         m_RenderDocSupport        = params.m_RenderDocSupport;
 
+        if (params.m_PipelineCachePath)
+        {
+            m_PipelineCachePath        = strdup(params.m_PipelineCachePath);
+            m_PipelineCacheVersionHash = dmHashString64(params.m_PipelineCacheVersion ? params.m_PipelineCacheVersion : "");
+        }
+
         DM_STATIC_ASSERT(sizeof(m_TextureFormatSupport)*4 >= TEXTURE_FORMAT_COUNT, Invalid_Struct_Size );
     }
 
@@ -165,6 +172,18 @@ namespace dmGraphics
         return next_id++;
     }
 
+    // Returns the recorder of the calling thread, or the main recorder if the thread isn't recording with a recorder of its own
+    static inline CommandRecorder* GetCommandRecorder(HContext context)
+    {
+        CommandRecorder* recorder = (CommandRecorder*) dmThread::GetTlsValue(context->m_CommandRecorderKey);
+        return recorder ? recorder : &context->m_MainCommandRecorder;
+    }
+
+    static inline DrawState* GetDrawState(HContext context)
+    {
+        return &GetCommandRecorder(context)->m_DrawState;
+    }
+
     static VkResult CreateMainFrameSyncObjects(VkDevice vk_device, uint8_t frame_resource_count, FrameResource* frame_resources_out)
     {
         VkSemaphoreCreateInfo vk_create_semaphore_info;
@@ -189,7 +208,7 @@ namespace dmGraphics
         return VK_SUCCESS;
     }
 
-    static VkResult CreateMainScratchBuffers(VkPhysicalDevice vk_physical_device, VkDevice vk_device,
+    static VkResult CreateScratchBuffers(VkPhysicalDevice vk_physical_device, VkDevice vk_device,
         uint8_t swap_chain_image_count, uint32_t scratch_buffer_size, uint16_t descriptor_count,
         DescriptorAllocator* descriptor_allocators_out, ScratchBuffer* scratch_buffers_out)
     {
@@ -342,7 +361,8 @@ namespace dmGraphics
         return true;
     }
 
-    static void BeginRenderPass(HContext context, RenderTarget* rt)
+    // A continue pass keeps what was rendered to the render target earlier in the frame, instead of discarding it
+    static void BeginRenderPass(HContext context, RenderTarget* rt, VkSubpassContents vk_contents, bool continue_pass)
     {
         assert(context->m_CurrentRenderTarget);
         if (context->m_CurrentRenderTarget->m_Id == rt->m_Id &&
@@ -373,7 +393,7 @@ namespace dmGraphics
 
         VkRenderPassBeginInfo vk_render_pass_begin_info;
         vk_render_pass_begin_info.sType               = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        vk_render_pass_begin_info.renderPass          = rt->m_RenderPass;
+        vk_render_pass_begin_info.renderPass          = continue_pass ? rt->m_RenderPassContinue : rt->m_RenderPass;
         vk_render_pass_begin_info.framebuffer         = rt->m_Framebuffer;
         vk_render_pass_begin_info.pNext               = 0;
         vk_render_pass_begin_info.renderArea.offset.x = 0;
@@ -382,7 +402,7 @@ namespace dmGraphics
         vk_render_pass_begin_info.clearValueCount = rt->m_ColorAttachmentCount + 1;
         vk_render_pass_begin_info.pClearValues    = vk_clear_values;
 
-        vkCmdBeginRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], &vk_render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], &vk_render_pass_begin_info, vk_contents);
 
         context->m_CurrentRenderTarget = rt;
         context->m_CurrentRenderTarget->m_IsBound = 1;
@@ -516,6 +536,7 @@ namespace dmGraphics
         // with the framebuffer objects created per swap chain.
         RenderTarget& rt          = context->m_MainRenderTarget;
         rt.m_RenderPass           = context->m_MainRenderPass;
+        rt.m_RenderPassContinue   = context->m_MainRenderPassContinue;
         rt.m_Framebuffer          = context->m_MainFrameBuffers[0];
         rt.m_Extent               = context->m_SwapChain->m_ImageExtent;
         rt.m_ColorAttachmentCount = 1;
@@ -523,6 +544,88 @@ namespace dmGraphics
         return VK_SUCCESS;
     }
 
+    // Returns the pipeline cache data in the file if it was written by the same engine version
+    // for the same device and driver, otherwise 0. The data must be freed by the caller.
+    static uint8_t* LoadPipelineCacheData(HContext context, uint32_t* data_size_out)
+    {
+        DM_STATIC_ASSERT(PIPELINE_CACHE_UUID_SIZE == VK_UUID_SIZE, Invalid_Pipeline_Cache_UUID_Size);
+        const VkPhysicalDeviceProperties& properties = context->m_PhysicalDevice.m_Properties;
+        PipelineCacheDevice device;
+        device.m_VendorID = properties.vendorID;
+        device.m_DeviceID = properties.deviceID;
+        memcpy(device.m_PipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        return ReadPipelineCacheFile(context->m_PipelineCachePath, context->m_PipelineCacheVersionHash, device, data_size_out);
+    }
+
+    static VkResult CreateMainPipelineCache(HContext context)
+    {
+        uint8_t* data      = 0;
+        uint32_t data_size = 0;
+        if (context->m_PipelineCachePath)
+        {
+            data = LoadPipelineCacheData(context, &data_size);
+        }
+
+        VkPipelineCacheCreateInfo vk_pipeline_cache_create_info;
+        memset(&vk_pipeline_cache_create_info, 0, sizeof(vk_pipeline_cache_create_info));
+        vk_pipeline_cache_create_info.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        vk_pipeline_cache_create_info.initialDataSize = data_size;
+        vk_pipeline_cache_create_info.pInitialData    = data;
+
+        VkResult res = vkCreatePipelineCache(context->m_LogicalDevice.m_Device, &vk_pipeline_cache_create_info, 0, &context->m_VkPipelineCache);
+        if (res != VK_SUCCESS && data)
+        {
+            // Start over with an empty cache if the driver rejects the data
+            vk_pipeline_cache_create_info.initialDataSize = 0;
+            vk_pipeline_cache_create_info.pInitialData    = 0;
+            res = vkCreatePipelineCache(context->m_LogicalDevice.m_Device, &vk_pipeline_cache_create_info, 0, &context->m_VkPipelineCache);
+        }
+
+        if (data)
+        {
+            dmLogInfo("Loaded %u bytes of pipeline cache data from '%s'", data_size, context->m_PipelineCachePath);
+            free(data);
+        }
+        return res;
+    }
+
+    void SavePipelineCache(HContext context)
+    {
+        if (!context->m_PipelineCachePath || context->m_VkPipelineCache == VK_NULL_HANDLE)
+        {
+            return;
+        }
+
+        // Nothing new to save unless pipelines have been created since the last time
+        if (context->m_PipelineCache.Size() == context->m_PipelineCacheSavedCount)
+        {
+            return;
+        }
+        context->m_PipelineCacheSavedCount = context->m_PipelineCache.Size();
+
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        size_t data_size   = 0;
+        VkResult res       = vkGetPipelineCacheData(vk_device, context->m_VkPipelineCache, &data_size, 0);
+        if (res != VK_SUCCESS || data_size == 0)
+        {
+            return;
+        }
+
+        uint8_t* data = (uint8_t*) malloc(data_size);
+        res = vkGetPipelineCacheData(vk_device, context->m_VkPipelineCache, &data_size, data);
+        if (res != VK_SUCCESS)
+        {
+            free(data);
+            return;
+        }
+
+        if (!WritePipelineCacheFile(context->m_PipelineCachePath, context->m_PipelineCacheVersionHash, data, (uint32_t) data_size))
+        {
+            dmLogWarning("Unable to write the pipeline cache to '%s'", context->m_PipelineCachePath);
+        }
+        free(data);
+    }
+
     static VkResult CreateMainRenderingResources(HContext context)
     {
         VkDevice vk_device = context->m_LogicalDevice.m_Device;
@@ -556,7 +659,10 @@ namespace dmGraphics
             attachment_resolve = &attachments[2];
         }
 
-        res = CreateRenderPass(vk_device, context->m_SwapChain->m_SampleCountFlag, attachments, 1, &attachments[1], attachment_resolve, &context->m_MainRenderPass);
+        res = CreateRenderPass(vk_device, context->m_SwapChain->m_SampleCountFlag, attachments, 1, &attachments[1], attachment_resolve, false, &context->m_MainRenderPass);
+        CHECK_VK_ERROR(res);
+
+        res = CreateRenderPass(vk_device, context->m_SwapChain->m_SampleCountFlag, attachments, 1, &attachments[1], attachment_resolve, true, &context->m_MainRenderPassContinue);
         CHECK_VK_ERROR(res);
 
         res = CreateMainFrameBuffers(context);
@@ -573,12 +679,13 @@ namespace dmGraphics
 
         res = CreateCommandBuffers(vk_device,
             context->m_LogicalDevice.m_CommandPool,
+            VK_COMMAND_BUFFER_LEVEL_PRIMARY,
             context->m_MainCommandBuffers.Size(),
             context->m_MainCommandBuffers.Begin());
         CHECK_VK_ERROR(res);
 
         // Create an additional single-time buffer for device uploading
-        CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &context->m_MainCommandBufferUploadHelper);
+        CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &context->m_MainCommandBufferUploadHelper);
 
         // Create main resources-to-destroy lists, one for each command buffer
         for (uint32_t i = 0; i < num_swap_chain_images; ++i)
@@ -591,6 +698,9 @@ namespace dmGraphics
         res = CreateMainFrameSyncObjects(vk_device, g_max_frames_in_flight, context->m_FrameResources);
         CHECK_VK_ERROR(res);
 
+        res = CreateMainPipelineCache(context);
+        CHECK_VK_ERROR(res);
+
 
         // Create scratch buffer and descriptor allocators, one for each swap chain image
         //   Note: These constants are guessed and equals roughly 256 draw calls and 64kb
@@ -604,12 +714,14 @@ namespace dmGraphics
         context->m_MainDescriptorAllocators.SetCapacity(num_swap_chain_images);
         context->m_MainDescriptorAllocators.SetSize(num_swap_chain_images);
 
-        res = CreateMainScratchBuffers(context->m_PhysicalDevice.m_Device, vk_device,
+        res = CreateScratchBuffers(context->m_PhysicalDevice.m_Device, vk_device,
             num_swap_chain_images, buffer_size, descriptor_count_per_pool,
             context->m_MainDescriptorAllocators.Begin(), context->m_MainScratchBuffers.Begin());
         CHECK_VK_ERROR(res);
 
-        context->m_PipelineState = GetDefaultPipelineState();
+        context->m_MainCommandRecorder.m_DrawState.m_PipelineState = GetDefaultPipelineState();
+        context->m_CommandRecorderKey   = dmThread::AllocTls();
+        context->m_CommandRecorderMutex = dmMutex::New();
 
         // Create default texture sampler
         CreateVulkanTextureSampler(vk_device, context->m_TextureSamplers, TEXTURE_FILTER_LINEAR, TEXTURE_FILTER_LINEAR, TEXTURE_WRAP_REPEAT, TEXTURE_WRAP_REPEAT, 1, 1.0f);
@@ -634,7 +746,7 @@ namespace dmGraphics
 
         for (int i = 0; i < DM_MAX_TEXTURE_UNITS; ++i)
         {
-            context->m_TextureUnits[i] = context->m_DefaultTexture;
+            context->m_MainCommandRecorder.m_DrawState.m_TextureUnits[i] = context->m_DefaultTexture;
         }
 
         return res;
@@ -996,6 +1108,14 @@ namespace dmGraphics
             goto bail;
         }
 
+        {
+            // The graphics queue has no timestamps if it has no valid bits. The query pool of the gpu timers
+            // is created by the first frame that is profiled.
+            uint32_t timestamp_valid_bits = context->m_PhysicalDevice.m_QueueFamilyProperties[context->m_SwapChain->m_QueueFamily.m_GraphicsQueueIx].timestampValidBits;
+            context->m_GpuTimestampMask   = timestamp_valid_bits >= 64 ? ~0ULL : (1ULL << timestamp_valid_bits) - 1;
+            context->m_GpuTimestampPeriod = context->m_PhysicalDevice.m_Properties.limits.timestampPeriod;
+        }
+
         return true;
 bail:
         if (context->m_SwapChain)
@@ -1076,6 +1196,7 @@ bail:
                 context->m_Instance = VK_NULL_HANDLE;
             }
 
+            free(context->m_PipelineCachePath);
             delete context;
             g_VulkanContext = 0x0;
         }
@@ -1097,6 +1218,58 @@ bail:
         out_mag_filter = context->m_DefaultTextureMagFilter;
     }
 
+    static void CreateGpuTimerQueryPool(HContext context)
+    {
+        VkQueryPoolCreateInfo vk_query_pool_create_info;
+        memset(&vk_query_pool_create_info, 0, sizeof(vk_query_pool_create_info));
+        vk_query_pool_create_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        vk_query_pool_create_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        vk_query_pool_create_info.queryCount = GPU_TIMER_FRAME_LATENCY * MAX_GPU_TIMER_QUERIES * 2;
+
+        // The gpu timers are optional, so failing to create the pool only disables them
+        if (vkCreateQueryPool(context->m_LogicalDevice.m_Device, &vk_query_pool_create_info, 0, &context->m_GpuTimerQueryPool) != VK_SUCCESS)
+        {
+            context->m_GpuTimerQueryPool = VK_NULL_HANDLE;
+            context->m_GpuTimestampMask  = 0;
+        }
+    }
+
+    // Converts a pair of timestamps to nanoseconds. Only the valid bits of a timestamp are kept, and the
+    // end timestamp may have wrapped around.
+    static inline void ConvertGpuTimestamps(HContext context, uint64_t* timestamps)
+    {
+        uint64_t begin = timestamps[0] & context->m_GpuTimestampMask;
+        uint64_t end   = timestamps[1] & context->m_GpuTimestampMask;
+        uint64_t ticks = (end - begin) & context->m_GpuTimestampMask;
+        timestamps[0]  = 0;
+        timestamps[1]  = (uint64_t) (ticks * (double) context->m_GpuTimestampPeriod);
+    }
+
+    // Reads back the timestamps of the oldest frame of gpu timers, and resets its queries for this frame.
+    // The frame was submitted GPU_TIMER_FRAME_LATENCY frames ago, which is more than the frames in flight.
+    static void UpdateGpuTimers(HContext context, VkCommandBuffer vk_command_buffer)
+    {
+        GpuTimerFrame* frame     = NextGpuTimerFrame(&context->m_GpuTimers);
+        uint32_t first_query     = (uint32_t) (frame - context->m_GpuTimers.m_Frames) * MAX_GPU_TIMER_QUERIES * 2;
+        VkDevice vk_device       = context->m_LogicalDevice.m_Device;
+
+        uint64_t timestamps[MAX_GPU_TIMER_QUERIES * 2];
+        bool available = frame->m_QueryCount > 0;
+        for (uint32_t i = 0; i < frame->m_QueryCount && available; ++i)
+        {
+            if (frame->m_Timers[i] == GPU_TIMER_QUERY_DROPPED)
+            {
+                continue;
+            }
+            available = vkGetQueryPoolResults(vk_device, context->m_GpuTimerQueryPool, first_query + i * 2, 2,
+                sizeof(uint64_t) * 2, &timestamps[i * 2], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+            ConvertGpuTimestamps(context, &timestamps[i * 2]);
+        }
+        ResolveGpuTimerFrame(&context->m_GpuTimers, frame, available ? timestamps : 0);
+
+        vkCmdResetQueryPool(vk_command_buffer, context->m_GpuTimerQueryPool, first_query, MAX_GPU_TIMER_QUERIES * 2);
+    }
+
     static void VulkanBeginFrame(HContext context)
     {
         NativeBeginFrame(context);
@@ -1140,6 +1313,11 @@ bail:
             FlushResourcesToDestroy(vk_device, context->m_MainResourcesToDestroy[frame_ix]);
         }
 
+        if (context->m_TextureUploads.Size() > 0)
+        {
+            UpdateTextureUploads(context, false);
+        }
+
         // Reset the scratch buffer for this swapchain image, so we can reuse its descriptors
         // for the uniform resource bindings.
         ScratchBuffer* scratchBuffer = &context->m_MainScratchBuffers[frame_ix];
@@ -1157,10 +1335,21 @@ bail:
         vk_command_buffer_begin_info.pNext            = 0;
 
         vkBeginCommandBuffer(context->m_MainCommandBuffers[frame_ix], &vk_command_buffer_begin_info);
+        context->m_MainCommandRecorder.m_CommandBuffer = context->m_MainCommandBuffers[frame_ix];
+
+        if (context->m_GpuTimerQueryPool == VK_NULL_HANDLE && context->m_GpuTimestampMask != 0 && IsGpuTimerEnabled())
+        {
+            CreateGpuTimerQueryPool(context);
+        }
+        if (context->m_GpuTimerQueryPool != VK_NULL_HANDLE)
+        {
+            UpdateGpuTimers(context, context->m_MainCommandBuffers[frame_ix]);
+        }
+        context->m_MainCommandRecorder.m_ScratchBuffer = scratchBuffer;
         context->m_FrameBegun                     = 1;
         context->m_MainRenderTarget.m_Framebuffer = context->m_MainFrameBuffers[frame_ix];
 
-        BeginRenderPass(context, context->m_CurrentRenderTarget);
+        BeginRenderPass(context, context->m_CurrentRenderTarget, VK_SUBPASS_CONTENTS_INLINE, false);
     }
 
     static void VulkanFlip(HContext context)
@@ -1212,6 +1401,7 @@ bail:
         // Advance frame index
         context->m_CurrentFrameInFlight = (context->m_CurrentFrameInFlight + 1) % g_max_frames_in_flight;
         context->m_FrameBegun           = 0;
+        context->m_FrameCount++;
 
         NativeSwapBuffers(context);
     }
@@ -1274,7 +1464,7 @@ bail:
             vk_depth_attachment.clearValue.depthStencil.depth   = depth;
         }
 
-        vkCmdClearAttachments(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
+        vkCmdClearAttachments(GetCommandRecorder(context)->m_CommandBuffer,
             attachment_count, vk_clear_attachments, 1, &vk_clear_rect);
 
     }
@@ -1357,19 +1547,27 @@ bail:
         resource->m_Destroyed = 1;
     }
 
-    static Pipeline* GetOrCreatePipeline(VkDevice vk_device, VkSampleCountFlagBits vk_sample_count,
-        const PipelineState pipelineState, PipelineCache& pipelineCache,
-        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration)
+    static uint64_t GetPipelineHash(VkSampleCountFlagBits vk_sample_count, const PipelineState& pipelineState,
+        Program* program, RenderTarget* rt, HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceVertexDeclaration)
     {
         HashState64 pipeline_hash_state;
         dmHashInit64(&pipeline_hash_state, false);
         dmHashUpdateBuffer64(&pipeline_hash_state, &program->m_Hash, sizeof(program->m_Hash));
         dmHashUpdateBuffer64(&pipeline_hash_state, &pipelineState, sizeof(pipelineState));
         dmHashUpdateBuffer64(&pipeline_hash_state, &vertexDeclaration->m_Hash, sizeof(vertexDeclaration->m_Hash));
+        if (instanceVertexDeclaration)
+        {
+            dmHashUpdateBuffer64(&pipeline_hash_state, &instanceVertexDeclaration->m_Hash, sizeof(instanceVertexDeclaration->m_Hash));
+        }
         dmHashUpdateBuffer64(&pipeline_hash_state, &rt->m_Id, sizeof(rt->m_Id));
         dmHashUpdateBuffer64(&pipeline_hash_state, &vk_sample_count, sizeof(vk_sample_count));
-        uint64_t pipeline_hash = dmHashFinal64(&pipeline_hash_state);
+        return dmHashFinal64(&pipeline_hash_state);
+    }
 
+    static Pipeline* GetOrCreatePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkSampleCountFlagBits vk_sample_count, uint64_t pipeline_hash,
+        const PipelineState pipelineState, PipelineCache& pipelineCache,
+        Program* program, RenderTarget* rt, DeviceBuffer* vertexBuffer, HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceVertexDeclaration)
+    {
         Pipeline* cached_pipeline = pipelineCache.Get(pipeline_hash);
 
         if (!cached_pipeline)
@@ -1382,7 +1580,7 @@ bail:
             vk_scissor.offset.x = 0;
             vk_scissor.offset.y = 0;
 
-            VkResult res = CreatePipeline(vk_device, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, rt, &new_pipeline);
+            VkResult res = CreatePipeline(vk_device, vk_pipeline_cache, vk_scissor, vk_sample_count, pipelineState, program, vertexBuffer, vertexDeclaration, instanceVertexDeclaration, rt, &new_pipeline);
             CHECK_VK_ERROR(res);
 
             if (pipelineCache.Full())
@@ -1452,6 +1650,83 @@ bail:
         DeviceBufferUploadHelper(g_VulkanContext, data, size, offset, buffer_ptr);
     }
 
+    static HTransientBuffer VulkanNewTransientBuffer(HContext context, uint32_t size)
+    {
+        VkDevice vk_device                  = context->m_LogicalDevice.m_Device;
+        const uint8_t num_swap_chain_images = context->m_SwapChain->m_Images.Size();
+
+        TransientBuffer* buffer = new TransientBuffer();
+        buffer->m_Size          = size;
+        buffer->m_Offset        = 0;
+        buffer->m_Frame         = context->m_FrameCount;
+        buffer->m_DeviceBuffers.SetCapacity(num_swap_chain_images);
+
+        // Each swap chain image has a buffer of its own, which is safe to write to once
+        // the image has been acquired, the same way as the main scratch buffers.
+        for (uint8_t i = 0; i < num_swap_chain_images; ++i)
+        {
+            DeviceBuffer* device_buffer = new DeviceBuffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+            VkResult res = CreateDeviceBuffer(context->m_PhysicalDevice.m_Device, vk_device, size,
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, device_buffer);
+            CHECK_VK_ERROR(res);
+            res = device_buffer->MapMemory(vk_device);
+            CHECK_VK_ERROR(res);
+            buffer->m_DeviceBuffers.Push(device_buffer);
+        }
+
+        return (HTransientBuffer) buffer;
+    }
+
+    static void VulkanDeleteTransientBuffer(HContext context, HTransientBuffer transient_buffer)
+    {
+        if (!transient_buffer)
+            return;
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+
+        for (uint32_t i = 0; i < buffer->m_DeviceBuffers.Size(); ++i)
+        {
+            DeviceBuffer* device_buffer = buffer->m_DeviceBuffers[i];
+            device_buffer->UnmapMemory(context->m_LogicalDevice.m_Device);
+            DestroyResourceDeferred(context->m_MainResourcesToDestroy[context->m_SwapChain->m_ImageIndex], device_buffer);
+            delete device_buffer;
+        }
+        delete buffer;
+    }
+
+    static void* VulkanAllocTransientBuffer(HContext context, HTransientBuffer transient_buffer, uint32_t size, uint32_t alignment, HVertexBuffer* vertex_buffer_out, uint32_t* offset_out)
+    {
+        assert(context->m_FrameBegun);
+        TransientBuffer* buffer = (TransientBuffer*) transient_buffer;
+
+        if (buffer->m_Frame != context->m_FrameCount)
+        {
+            buffer->m_Frame  = context->m_FrameCount;
+            buffer->m_Offset = 0;
+        }
+
+        uint32_t offset = AlignTransientBufferOffset(buffer->m_Offset, alignment);
+        if (offset + size > buffer->m_Size)
+        {
+            return 0;
+        }
+        buffer->m_Offset = offset + size;
+
+        DeviceBuffer* device_buffer = buffer->m_DeviceBuffers[context->m_SwapChain->m_ImageIndex];
+        *vertex_buffer_out          = (HVertexBuffer) device_buffer;
+        *offset_out                 = offset;
+        return (uint8_t*) device_buffer->m_MappedDataPtr + offset;
+    }
+
+    static void VulkanFlushTransientBuffer(HContext context, HTransientBuffer transient_buffer)
+    {
+        // The memory is host coherent, so the writes are visible to the device when the frame is submitted
+    }
+
+    static uint32_t VulkanGetTransientBufferSize(HTransientBuffer transient_buffer)
+    {
+        return ((TransientBuffer*) transient_buffer)->m_Size;
+    }
+
     static uint32_t VulkanGetMaxElementsVertices(HContext context)
     {
         return context->m_PhysicalDevice.m_Properties.limits.maxDrawIndexedIndexValue;
@@ -1662,18 +1937,32 @@ bail:
 
     static void VulkanEnableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer)
     {
-        context->m_CurrentVertexBuffer      = (DeviceBuffer*) vertex_buffer;
-        context->m_CurrentVertexDeclaration = (VertexDeclaration*) vertex_declaration;
+        DrawState* draw_state                   = GetDrawState(context);
+        draw_state->m_CurrentVertexBuffer       = (DeviceBuffer*) vertex_buffer;
+        draw_state->m_CurrentVertexBufferOffset = 0;
+        draw_state->m_CurrentVertexDeclaration  = (VertexDeclaration*) vertex_declaration;
     }
 
-    static void VulkanEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    // The locations depend on the program, so they are resolved into a copy of the declaration owned by the draw state.
+    // The declaration itself can be used by several recorders at the same time.
+    static VertexDeclaration* ResolveVertexDeclarationLocations(VertexDeclaration* resolved, HVertexDeclaration vertex_declaration, Program* program_ptr)
     {
-        Program* program_ptr = (Program*) program;
-        VulkanEnableVertexDeclaration(context, vertex_declaration, vertex_buffer);
+        resolved->m_Hash        = vertex_declaration->m_Hash;
+        resolved->m_StreamCount = vertex_declaration->m_StreamCount;
+        resolved->m_Stride      = vertex_declaration->m_Stride;
+        memcpy(resolved->m_Streams, vertex_declaration->m_Streams, sizeof(VertexDeclaration::Stream) * vertex_declaration->m_StreamCount);
 
-        for (uint32_t i=0; i < vertex_declaration->m_StreamCount; i++)
+        for (uint32_t i=0; i < resolved->m_StreamCount; i++)
         {
-            VertexDeclaration::Stream& stream = vertex_declaration->m_Streams[i];
+            VertexDeclaration::Stream& stream = resolved->m_Streams[i];
+
+            // Consecutive streams with the same name are the columns of a matrix attribute
+            if (i > 0 && stream.m_NameHash == resolved->m_Streams[i-1].m_NameHash)
+            {
+                uint16_t prev_location = resolved->m_Streams[i-1].m_Location;
+                stream.m_Location = prev_location != 0xffff ? prev_location + 1 : 0xffff;
+                continue;
+            }
 
             stream.m_Location = 0xffff;
 
@@ -1688,11 +1977,39 @@ bail:
                 }
             }
         }
+        return resolved;
+    }
+
+    static void VulkanEnableVertexDeclarationProgram(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, uint32_t vertex_buffer_offset, HProgram program)
+    {
+        VulkanEnableVertexDeclaration(context, vertex_declaration, vertex_buffer);
+        DrawState* draw_state                   = GetDrawState(context);
+        draw_state->m_CurrentVertexBufferOffset = vertex_buffer_offset;
+        draw_state->m_CurrentVertexDeclaration  = ResolveVertexDeclarationLocations(&draw_state->m_ResolvedVertexDeclaration, vertex_declaration, (Program*) program);
     }
 
     static void VulkanDisableVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
     {
-        context->m_CurrentVertexDeclaration = 0;
+        GetDrawState(context)->m_CurrentVertexDeclaration = 0;
+    }
+
+    static bool VulkanIsInstancingSupported(HContext context)
+    {
+        return true;
+    }
+
+    static void VulkanEnableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration, HVertexBuffer vertex_buffer, HProgram program)
+    {
+        DrawState* draw_state                          = GetDrawState(context);
+        draw_state->m_CurrentInstanceVertexBuffer      = (DeviceBuffer*) vertex_buffer;
+        draw_state->m_CurrentInstanceVertexDeclaration = ResolveVertexDeclarationLocations(&draw_state->m_ResolvedInstanceVertexDeclaration, vertex_declaration, (Program*) program);
+    }
+
+    static void VulkanDisableInstanceVertexDeclaration(HContext context, HVertexDeclaration vertex_declaration)
+    {
+        DrawState* draw_state                          = GetDrawState(context);
+        draw_state->m_CurrentInstanceVertexBuffer      = 0;
+        draw_state->m_CurrentInstanceVertexDeclaration = 0;
     }
 
     static inline bool IsUniformTextureSampler(ShaderResourceBinding uniform)
@@ -1707,6 +2024,9 @@ bail:
         VkDescriptorSet     vk_descriptor_set,
         Program*            program,
         Program::ModuleType module_type,
+        Texture**           texture_units,
+        const uint16_t*     sampler_units,
+        const uint8_t*      uniform_data,
         ScratchBuffer*      scratch_buffer,
         uint32_t            dynamic_alignment,
         uint32_t*           dynamic_offsets_out)
@@ -1725,6 +2045,7 @@ bail:
             shader_module        = program->m_FragmentModule;
             uniform_data_offsets = &program->m_UniformDataOffsets[program->m_VertexModule->m_UniformCount];
             dynamic_offsets      = &dynamic_offsets_out[program->m_VertexModule->m_UniformCount];
+            sampler_units        = sampler_units ? &sampler_units[program->m_VertexModule->m_UniformCount] : 0;
         }
         else
         {
@@ -1748,7 +2069,8 @@ bail:
 
         while(uniforms_to_write > 0)
         {
-            ShaderResourceBinding& res = shader_module->m_Uniforms[uniform_index++];
+            const uint16_t res_index   = uniform_index++;
+            ShaderResourceBinding& res = shader_module->m_Uniforms[res_index];
             VkWriteDescriptorSet& vk_write_desc_info = vk_write_descriptors[uniform_to_write_index++];
             vk_write_desc_info.sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             vk_write_desc_info.pNext            = 0;
@@ -1762,7 +2084,7 @@ bail:
 
             if (IsUniformTextureSampler(res))
             {
-                Texture* texture = g_VulkanContext->m_TextureUnits[res.m_TextureUnit];
+                Texture* texture = texture_units[sampler_units ? sampler_units[res_index] : res.m_TextureUnit];
                 VkDescriptorImageInfo& vk_image_info = vk_write_image_descriptors[image_to_write_index++];
                 vk_image_info.imageLayout         = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
                 vk_image_info.imageView           = texture->m_Handle.m_ImageView;
@@ -1781,7 +2103,7 @@ bail:
                 // i.e the source buffer.
                 const uint32_t data_offset = uniform_data_offsets[res.m_UniformDataIndex];
                 memcpy(&((uint8_t*)scratch_buffer->m_DeviceBuffer.m_MappedDataPtr)[scratch_buffer->m_MappedDataCursor],
-                    &program->m_UniformData[data_offset], uniform_size_nonalign);
+                    &uniform_data[data_offset], uniform_size_nonalign);
 
                 // Note in the spec about the offset being zero:
                 //   "For VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC and VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC descriptor types,
@@ -1816,7 +2138,7 @@ bail:
     }
 
     static VkResult CommitUniforms(VkCommandBuffer vk_command_buffer, VkDevice vk_device,
-        Program* program_ptr, ScratchBuffer* scratch_buffer,
+        Program* program_ptr, Texture** texture_units, const uint16_t* sampler_units, const uint8_t* uniform_data, ScratchBuffer* scratch_buffer,
         uint32_t* dynamic_offsets, const uint32_t alignment)
     {
         VkDescriptorSet* vk_descriptor_set_list = 0x0;
@@ -1831,10 +2153,10 @@ bail:
         VkDescriptorSet fs_set = vk_descriptor_set_list[Program::MODULE_TYPE_FRAGMENT];
 
         UpdateDescriptorSets(vk_device, vs_set, program_ptr,
-            Program::MODULE_TYPE_VERTEX, scratch_buffer,
+            Program::MODULE_TYPE_VERTEX, texture_units, sampler_units, uniform_data, scratch_buffer,
             alignment, dynamic_offsets);
         UpdateDescriptorSets(vk_device, fs_set, program_ptr,
-            Program::MODULE_TYPE_FRAGMENT, scratch_buffer,
+            Program::MODULE_TYPE_FRAGMENT, texture_units, sampler_units, uniform_data, scratch_buffer,
             alignment, dynamic_offsets);
 
         vkCmdBindDescriptorSets(vk_command_buffer,
@@ -1847,6 +2169,8 @@ bail:
 
     static VkResult ResizeDescriptorAllocator(HContext context, DescriptorAllocator* allocator, uint32_t newDescriptorCount)
     {
+        // The resources to destroy are shared with the command recorders of worker threads
+        DM_MUTEX_SCOPED_LOCK(context->m_CommandRecorderMutex);
         DestroyResourceDeferred(context->m_MainResourcesToDestroy[context->m_SwapChain->m_ImageIndex], allocator);
         return CreateDescriptorAllocator(context->m_LogicalDevice.m_Device, newDescriptorCount, allocator);
     }
@@ -1854,6 +2178,7 @@ bail:
     static VkResult ResizeScratchBuffer(HContext context, uint32_t newDataSize, ScratchBuffer* scratchBuffer)
     {
         // Put old buffer on the delete queue so we don't mess the descriptors already in-use
+        DM_MUTEX_SCOPED_LOCK(context->m_CommandRecorderMutex);
         DestroyResourceDeferred(context->m_MainResourcesToDestroy[context->m_SwapChain->m_ImageIndex], &scratchBuffer->m_DeviceBuffer);
 
         VkResult res = CreateScratchBuffer(context->m_PhysicalDevice.m_Device, context->m_LogicalDevice.m_Device,
@@ -1863,11 +2188,14 @@ bail:
         return res;
     }
 
-    static void DrawSetup(HContext context, VkCommandBuffer vk_command_buffer, ScratchBuffer* scratchBuffer, DeviceBuffer* indexBuffer, Type indexBufferType)
+    static void DrawSetup(HContext context, CommandRecorder* recorder, DeviceBuffer* indexBuffer, Type indexBufferType)
     {
-        DeviceBuffer* vertex_buffer = context->m_CurrentVertexBuffer;
-        Program* program_ptr        = context->m_CurrentProgram;
-        VkDevice vk_device          = context->m_LogicalDevice.m_Device;
+        DrawState* draw_state             = &recorder->m_DrawState;
+        VkCommandBuffer vk_command_buffer = recorder->m_CommandBuffer;
+        ScratchBuffer* scratchBuffer      = recorder->m_ScratchBuffer;
+        DeviceBuffer* vertex_buffer       = draw_state->m_CurrentVertexBuffer;
+        Program* program_ptr              = draw_state->m_CurrentProgram;
+        VkDevice vk_device                = context->m_LogicalDevice.m_Device;
 
         // Ensure there is room in the descriptor allocator to support this draw call
         bool resize_desc_allocator = (scratchBuffer->m_DescriptorAllocator->m_DescriptorIndex + DM_MAX_SET_COUNT) >
@@ -1892,61 +2220,62 @@ bail:
         // Ensure we have enough room in the dynamic offset buffer to support the uniforms for this draw call
         const uint32_t num_uniform_buffers = program_ptr->m_VertexModule->m_UniformBufferCount + program_ptr->m_FragmentModule->m_UniformBufferCount;
 
-        if (context->m_DynamicOffsetBufferSize < num_uniform_buffers)
+        if (draw_state->m_DynamicOffsetBufferSize < num_uniform_buffers)
         {
-            if (context->m_DynamicOffsetBuffer == 0x0)
+            if (draw_state->m_DynamicOffsetBuffer == 0x0)
             {
-                context->m_DynamicOffsetBuffer = (uint32_t*) malloc(sizeof(uint32_t) * num_uniform_buffers);
+                draw_state->m_DynamicOffsetBuffer = (uint32_t*) malloc(sizeof(uint32_t) * num_uniform_buffers);
             }
             else
             {
-                context->m_DynamicOffsetBuffer = (uint32_t*) realloc(context->m_DynamicOffsetBuffer, sizeof(uint32_t) * num_uniform_buffers);
+                draw_state->m_DynamicOffsetBuffer = (uint32_t*) realloc(draw_state->m_DynamicOffsetBuffer, sizeof(uint32_t) * num_uniform_buffers);
             }
 
-            context->m_DynamicOffsetBufferSize = num_uniform_buffers;
+            draw_state->m_DynamicOffsetBufferSize = num_uniform_buffers;
         }
 
         // Write the uniform data to the descriptors
         uint32_t dynamic_alignment = (uint32_t) context->m_PhysicalDevice.m_Properties.limits.minUniformBufferOffsetAlignment;
+        const uint8_t* uniform_data = draw_state->m_UniformData ? draw_state->m_UniformData : program_ptr->m_UniformData;
         VkResult res = CommitUniforms(vk_command_buffer, vk_device,
-            program_ptr, scratchBuffer, context->m_DynamicOffsetBuffer, dynamic_alignment);
+            program_ptr, draw_state->m_TextureUnits, draw_state->m_SamplerUnits, uniform_data, scratchBuffer, draw_state->m_DynamicOffsetBuffer, dynamic_alignment);
         CHECK_VK_ERROR(res);
 
         // If the culling, or viewport has changed, make sure to flip the
         // culling flag if we are rendering to the backbuffer.
         // This is needed because we are rendering with a negative viewport
         // which means that the face direction is inverted.
-        if (context->m_CullFaceChanged || context->m_ViewportChanged)
+        if (draw_state->m_CullFaceChanged || draw_state->m_ViewportChanged)
         {
             if (context->m_CurrentRenderTarget->m_Id != DM_RENDERTARGET_BACKBUFFER_ID)
             {
-                if (context->m_PipelineState.m_CullFaceType == FACE_TYPE_BACK)
+                if (draw_state->m_PipelineState.m_CullFaceType == FACE_TYPE_BACK)
                 {
-                    context->m_PipelineState.m_CullFaceType = FACE_TYPE_FRONT;
+                    draw_state->m_PipelineState.m_CullFaceType = FACE_TYPE_FRONT;
                 }
-                else if (context->m_PipelineState.m_CullFaceType == FACE_TYPE_FRONT)
+                else if (draw_state->m_PipelineState.m_CullFaceType == FACE_TYPE_FRONT)
                 {
-                    context->m_PipelineState.m_CullFaceType = FACE_TYPE_BACK;
+                    draw_state->m_PipelineState.m_CullFaceType = FACE_TYPE_BACK;
                 }
             }
-            context->m_CullFaceChanged = 0;
+            draw_state->m_CullFaceChanged = 0;
         }
         // Update the viewport
-        if (context->m_ViewportChanged)
+        if (draw_state->m_ViewportChanged)
         {
-            Viewport& vp = context->m_MainViewport;
+            Viewport& vp = draw_state->m_Viewport;
 
             // If we are rendering to the backbuffer, we must invert the viewport on
             // the y axis. Otherwise we just use the values as-is.
             // If we don't, all FBO rendering will be upside down.
             if (context->m_CurrentRenderTarget->m_Id == DM_RENDERTARGET_BACKBUFFER_ID)
             {
-                SetViewportHelper(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
+                SetViewportHelper(vk_command_buffer,
                     vp.m_X, (context->m_WindowHeight - vp.m_Y), vp.m_W, -vp.m_H);
             }
             else
             {
-                SetViewportHelper(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
+                SetViewportHelper(vk_command_buffer,
                     vp.m_X, vp.m_Y, vp.m_W, vp.m_H);
             }
 
@@ -1955,9 +2284,9 @@ bail:
             vk_scissor.offset.x = 0;
             vk_scissor.offset.y = 0;
 
-            vkCmdSetScissor(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex], 0, 1, &vk_scissor);
+            vkCmdSetScissor(vk_command_buffer, 0, 1, &vk_scissor);
 
-            context->m_ViewportChanged = 0;
+            draw_state->m_ViewportChanged = 0;
         }
 
         // Get the pipeline for the active draw state
@@ -1967,10 +2296,43 @@ bail:
             vk_sample_count = context->m_SwapChain->m_SampleCountFlag;
         }
 
-        Pipeline* pipeline = GetOrCreatePipeline(vk_device, vk_sample_count,
-            context->m_PipelineState, context->m_PipelineCache,
+        uint64_t pipeline_hash = GetPipelineHash(vk_sample_count, draw_state->m_PipelineState,
             program_ptr, context->m_CurrentRenderTarget,
-            vertex_buffer, context->m_CurrentVertexDeclaration);
+            draw_state->m_CurrentVertexDeclaration, draw_state->m_CurrentInstanceVertexDeclaration);
+
+        Pipeline* pipeline = 0;
+        if (recorder == &context->m_MainCommandRecorder)
+        {
+            pipeline = GetOrCreatePipeline(vk_device, context->m_VkPipelineCache, vk_sample_count, pipeline_hash,
+                draw_state->m_PipelineState, context->m_PipelineCache,
+                program_ptr, context->m_CurrentRenderTarget,
+                vertex_buffer, draw_state->m_CurrentVertexDeclaration, draw_state->m_CurrentInstanceVertexDeclaration);
+        }
+        else
+        {
+            // Worker threads share the pipeline cache of the context, but keep the pipelines
+            // they have used in a cache of their own to avoid taking the lock for every draw call.
+            // Pipelines are never removed from the cache of the context.
+            pipeline = recorder->m_PipelineCache.Get(pipeline_hash);
+            if (!pipeline)
+            {
+                Pipeline shared_pipeline;
+                {
+                    DM_MUTEX_SCOPED_LOCK(context->m_CommandRecorderMutex);
+                    shared_pipeline = *GetOrCreatePipeline(vk_device, context->m_VkPipelineCache, vk_sample_count, pipeline_hash,
+                        draw_state->m_PipelineState, context->m_PipelineCache,
+                        program_ptr, context->m_CurrentRenderTarget,
+                        vertex_buffer, draw_state->m_CurrentVertexDeclaration, draw_state->m_CurrentInstanceVertexDeclaration);
+                }
+
+                if (recorder->m_PipelineCache.Full())
+                {
+                    recorder->m_PipelineCache.SetCapacity(32, recorder->m_PipelineCache.Capacity() + 16);
+                }
+                recorder->m_PipelineCache.Put(pipeline_hash, shared_pipeline);
+                pipeline = recorder->m_PipelineCache.Get(pipeline_hash);
+            }
+        }
         vkCmdBindPipeline(vk_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, *pipeline);
 
 
@@ -1989,9 +2351,16 @@ bail:
         }
 
         // Bind the vertex buffers
-        VkBuffer vk_vertex_buffer             = vertex_buffer->m_Handle.m_Buffer;
-        VkDeviceSize vk_vertex_buffer_offsets = 0;
-        vkCmdBindVertexBuffers(vk_command_buffer, 0, 1, &vk_vertex_buffer, &vk_vertex_buffer_offsets);
+        VkBuffer vk_vertex_buffers[2]            = { vertex_buffer->m_Handle.m_Buffer, VK_NULL_HANDLE };
+        VkDeviceSize vk_vertex_buffer_offsets[2] = { draw_state->m_CurrentVertexBufferOffset, 0 };
+        uint32_t num_vertex_buffers              = 1;
+
+        if (draw_state->m_CurrentInstanceVertexDeclaration)
+        {
+            vk_vertex_buffers[num_vertex_buffers++] = draw_state->m_CurrentInstanceVertexBuffer->m_Handle.m_Buffer;
+        }
+
+        vkCmdBindVertexBuffers(vk_command_buffer, 0, num_vertex_buffers, vk_vertex_buffers, vk_vertex_buffer_offsets);
     }
 
     void VulkanHashVertexDeclaration(HashState32 *state, HVertexDeclaration vertex_declaration)
@@ -2012,10 +2381,10 @@ bail:
         DM_PROFILE(__FUNCTION__);
         DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
         assert(context->m_FrameBegun);
-        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
-        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
-        context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], (DeviceBuffer*) index_buffer, type);
+        CommandRecorder* recorder = GetCommandRecorder(context);
+        VkCommandBuffer vk_command_buffer = recorder->m_CommandBuffer;
+        recorder->m_DrawState.m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, recorder, (DeviceBuffer*) index_buffer, type);
 
         // The 'first' value that comes in is intended to be a byte offset,
         // but vkCmdDrawIndexed only operates with actual offset values into the index buffer
@@ -2028,13 +2397,39 @@ bail:
         DM_PROFILE(__FUNCTION__);
         DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
         assert(context->m_FrameBegun);
-        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
-        VkCommandBuffer vk_command_buffer = context->m_MainCommandBuffers[image_ix];
-        context->m_PipelineState.m_PrimtiveType = prim_type;
-        DrawSetup(context, vk_command_buffer, &context->m_MainScratchBuffers[image_ix], 0, TYPE_BYTE);
+        CommandRecorder* recorder = GetCommandRecorder(context);
+        VkCommandBuffer vk_command_buffer = recorder->m_CommandBuffer;
+        recorder->m_DrawState.m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, recorder, 0, TYPE_BYTE);
         vkCmdDraw(vk_command_buffer, count, 1, first, 0);
     }
 
+    static void VulkanDrawElementsInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count, Type type, HIndexBuffer index_buffer)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
+        assert(context->m_FrameBegun);
+        CommandRecorder* recorder = GetCommandRecorder(context);
+        VkCommandBuffer vk_command_buffer = recorder->m_CommandBuffer;
+        recorder->m_DrawState.m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, recorder, (DeviceBuffer*) index_buffer, type);
+
+        uint32_t index_offset = first / (type == TYPE_UNSIGNED_SHORT ? 2 : 4);
+        vkCmdDrawIndexed(vk_command_buffer, count, instance_count, index_offset, 0, 0);
+    }
+
+    static void VulkanDrawInstanced(HContext context, PrimitiveType prim_type, uint32_t first, uint32_t count, uint32_t instance_count)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_PROPERTY_ADD_U32(rmtp_DrawCalls, 1);
+        assert(context->m_FrameBegun);
+        CommandRecorder* recorder = GetCommandRecorder(context);
+        VkCommandBuffer vk_command_buffer = recorder->m_CommandBuffer;
+        recorder->m_DrawState.m_PipelineState.m_PrimtiveType = prim_type;
+        DrawSetup(context, recorder, 0, TYPE_BYTE);
+        vkCmdDraw(vk_command_buffer, count, instance_count, first, 0);
+    }
+
     static void CreateShaderResourceBindings(ShaderModule* shader, ShaderDesc::Shader* ddf, uint32_t dynamicAlignment)
     {
         if (ddf->m_Uniforms.m_Count > 0)
@@ -2183,6 +2578,7 @@ bail:
         program->m_Hash               = 0;
         program->m_UniformDataOffsets = 0;
         program->m_UniformData        = 0;
+        program->m_UniformDataSize    = 0;
         program->m_VertexModule       = vertex_module;
         program->m_FragmentModule     = fragment_module;
 
@@ -2222,8 +2618,9 @@ bail:
                 vs_last_offset, &program->m_UniformDataOffsets[vertex_module->m_UniformBufferCount], num_buffers,
                 &fs_last_offset, &vk_descriptor_set_bindings[vertex_module->m_UniformCount]);
 
-            program->m_UniformData = new uint8_t[vs_last_offset + fs_last_offset];
-            memset(program->m_UniformData, 0, vs_last_offset + fs_last_offset);
+            program->m_UniformDataSize = vs_last_offset + fs_last_offset;
+            program->m_UniformData     = new uint8_t[program->m_UniformDataSize];
+            memset(program->m_UniformData, 0, program->m_UniformDataSize);
 
             VkDescriptorSetLayoutCreateInfo vk_set_create_info[Program::MODULE_TYPE_COUNT];
             memset(&vk_set_create_info, 0, sizeof(vk_set_create_info));
@@ -2365,14 +2762,66 @@ bail:
         return ShaderDesc::LANGUAGE_SPIRV;
     }
 
+    // Recorders of worker threads set constants and samplers on a copy of the uniform data and
+    // sampler units of the program, since the program can be used by several threads at the same time
+    static void CopyProgramUniformData(CommandRecorder* recorder, Program* program)
+    {
+        dmArray<uint8_t>& uniform_data = recorder->m_UniformData;
+        if (uniform_data.Capacity() < program->m_UniformDataSize)
+        {
+            uniform_data.SetCapacity(program->m_UniformDataSize);
+        }
+        uniform_data.SetSize(program->m_UniformDataSize);
+
+        if (program->m_UniformDataSize > 0)
+        {
+            memcpy(uniform_data.Begin(), program->m_UniformData, program->m_UniformDataSize);
+            recorder->m_DrawState.m_UniformData = uniform_data.Begin();
+        }
+        else
+        {
+            recorder->m_DrawState.m_UniformData = 0;
+        }
+
+        // Same layout as the uniform data offsets, the vertex module uniforms followed by the fragment module uniforms
+        const uint32_t vs_uniform_count = program->m_VertexModule->m_UniformCount;
+        const uint32_t uniform_count    = vs_uniform_count + program->m_FragmentModule->m_UniformCount;
+        dmArray<uint16_t>& sampler_units = recorder->m_SamplerUnits;
+        if (sampler_units.Capacity() < uniform_count)
+        {
+            sampler_units.SetCapacity(uniform_count);
+        }
+        sampler_units.SetSize(uniform_count);
+
+        for (uint32_t i = 0; i < vs_uniform_count; ++i)
+        {
+            sampler_units[i] = program->m_VertexModule->m_Uniforms[i].m_TextureUnit;
+        }
+        for (uint32_t i = vs_uniform_count; i < uniform_count; ++i)
+        {
+            sampler_units[i] = program->m_FragmentModule->m_Uniforms[i - vs_uniform_count].m_TextureUnit;
+        }
+
+        recorder->m_DrawState.m_SamplerUnits = uniform_count > 0 ? sampler_units.Begin() : 0;
+    }
+
     static void VulkanEnableProgram(HContext context, HProgram program)
     {
-        context->m_CurrentProgram = (Program*) program;
+        CommandRecorder* recorder = GetCommandRecorder(context);
+        Program* program_ptr      = (Program*) program;
+        if (recorder != &context->m_MainCommandRecorder && recorder->m_DrawState.m_CurrentProgram != program_ptr)
+        {
+            CopyProgramUniformData(recorder, program_ptr);
+        }
+        recorder->m_DrawState.m_CurrentProgram = program_ptr;
     }
 
     static void VulkanDisableProgram(HContext context)
     {
-        context->m_CurrentProgram = 0;
+        DrawState* draw_state        = GetDrawState(context);
+        draw_state->m_CurrentProgram = 0;
+        draw_state->m_UniformData    = 0;
+        draw_state->m_SamplerUnits   = 0;
     }
 
     static bool VulkanReloadProgram(HContext context, HProgram program, HVertexProgram vert_program, HFragmentProgram frag_program)
@@ -2482,11 +2931,28 @@ bail:
         return -1;
     }
 
+    static int32_t VulkanGetAttributeLocation(HProgram prog, const char* name)
+    {
+        assert(prog);
+        ShaderModule* vs = ((Program*) prog)->m_VertexModule;
+        uint64_t name_hash = dmHashString64(name);
+        for (uint32_t i = 0; i < vs->m_AttributeCount; ++i)
+        {
+            if (vs->m_Attributes[i].m_NameHash == name_hash)
+            {
+                return vs->m_Attributes[i].m_Binding;
+            }
+        }
+        return -1;
+    }
+
     static void VulkanSetConstantV4(HContext context, const dmVMath::Vector4* data, int count, int base_register)
     {
-        assert(context->m_CurrentProgram);
+        DrawState* draw_state = GetDrawState(context);
+        assert(draw_state->m_CurrentProgram);
         assert(base_register >= 0);
-        Program* program_ptr = (Program*) context->m_CurrentProgram;
+        Program* program_ptr  = draw_state->m_CurrentProgram;
+        uint8_t* uniform_data = draw_state->m_UniformData ? draw_state->m_UniformData : program_ptr->m_UniformData;
 
         uint32_t index_vs  = UNIFORM_LOCATION_GET_VS(base_register);
         uint32_t index_fs  = UNIFORM_LOCATION_GET_FS(base_register);
@@ -2499,7 +2965,7 @@ bail:
             assert(!IsUniformTextureSampler(res));
             uint32_t offset_index      = res.m_UniformDataIndex;
             uint32_t offset            = program_ptr->m_UniformDataOffsets[offset_index];
-            memcpy(&program_ptr->m_UniformData[offset], data, sizeof(dmVMath::Vector4) * count);
+            memcpy(&uniform_data[offset], data, sizeof(dmVMath::Vector4) * count);
         }
 
         if (index_fs != UNIFORM_LOCATION_MAX)
@@ -2510,13 +2976,15 @@ bail:
             // Fragment uniforms are packed behind vertex uniforms hence the extra offset here
             uint32_t offset_index = program_ptr->m_VertexModule->m_UniformBufferCount + res.m_UniformDataIndex;
             uint32_t offset       = program_ptr->m_UniformDataOffsets[offset_index];
-            memcpy(&program_ptr->m_UniformData[offset], data, sizeof(dmVMath::Vector4) * count);
+            memcpy(&uniform_data[offset], data, sizeof(dmVMath::Vector4) * count);
         }
     }
 
     static void VulkanSetConstantM4(HContext context, const dmVMath::Vector4* data, int count, int base_register)
     {
-        Program* program_ptr = (Program*) context->m_CurrentProgram;
+        DrawState* draw_state = GetDrawState(context);
+        Program* program_ptr  = draw_state->m_CurrentProgram;
+        uint8_t* uniform_data = draw_state->m_UniformData ? draw_state->m_UniformData : program_ptr->m_UniformData;
 
         uint32_t index_vs  = UNIFORM_LOCATION_GET_VS(base_register);
         uint32_t index_fs  = UNIFORM_LOCATION_GET_FS(base_register);
@@ -2529,7 +2997,7 @@ bail:
             assert(!IsUniformTextureSampler(res));
             uint32_t offset_index      = res.m_UniformDataIndex;
             uint32_t offset            = program_ptr->m_UniformDataOffsets[offset_index];
-            memcpy(&program_ptr->m_UniformData[offset], data, sizeof(dmVMath::Vector4) * 4 * count);
+            memcpy(&uniform_data[offset], data, sizeof(dmVMath::Vector4) * 4 * count);
         }
 
         if (index_fs != UNIFORM_LOCATION_MAX)
@@ -2540,25 +3008,33 @@ bail:
             // Fragment uniforms are packed behind vertex uniforms hence the extra offset here
             uint32_t offset_index = program_ptr->m_VertexModule->m_UniformBufferCount + res.m_UniformDataIndex;
             uint32_t offset       = program_ptr->m_UniformDataOffsets[offset_index];
-            memcpy(&program_ptr->m_UniformData[offset], data, sizeof(dmVMath::Vector4) * 4 * count);
+            memcpy(&uniform_data[offset], data, sizeof(dmVMath::Vector4) * 4 * count);
         }
     }
 
     static void VulkanSetSampler(HContext context, int32_t location, int32_t unit)
     {
-        assert(context && context->m_CurrentProgram);
-        Program* program_ptr = (Program*) context->m_CurrentProgram;
+        assert(context);
+        DrawState* draw_state = GetDrawState(context);
+        Program* program_ptr  = draw_state->m_CurrentProgram;
+        assert(program_ptr);
 
         uint32_t index_vs  = UNIFORM_LOCATION_GET_VS(location);
         uint32_t index_fs  = UNIFORM_LOCATION_GET_FS(location);
         assert(!(index_vs == UNIFORM_LOCATION_MAX && index_fs == UNIFORM_LOCATION_MAX));
 
+        // Worker thread recorders write to their own copy of the sampler units
+        uint16_t* sampler_units = draw_state->m_SamplerUnits;
+
         if (index_vs != UNIFORM_LOCATION_MAX)
         {
             ShaderResourceBinding& res = program_ptr->m_VertexModule->m_Uniforms[index_vs];
             assert(index_vs < program_ptr->m_VertexModule->m_UniformCount);
             assert(IsUniformTextureSampler(res));
-            program_ptr->m_VertexModule->m_Uniforms[index_vs].m_TextureUnit = (uint16_t) unit;
+            if (sampler_units)
+                sampler_units[index_vs] = (uint16_t) unit;
+            else
+                res.m_TextureUnit = (uint16_t) unit;
         }
 
         if (index_fs != UNIFORM_LOCATION_MAX)
@@ -2566,7 +3042,10 @@ bail:
             ShaderResourceBinding& res = program_ptr->m_FragmentModule->m_Uniforms[index_fs];
             assert(index_fs < program_ptr->m_FragmentModule->m_UniformCount);
             assert(IsUniformTextureSampler(res));
-            program_ptr->m_FragmentModule->m_Uniforms[index_fs].m_TextureUnit = (uint16_t) unit;
+            if (sampler_units)
+                sampler_units[program_ptr->m_VertexModule->m_UniformCount + index_fs] = (uint16_t) unit;
+            else
+                res.m_TextureUnit = (uint16_t) unit;
         }
     }
 
@@ -2580,53 +3059,58 @@ bail:
         // Defer the update to when we actually draw, since we *might* need to invert the viewport
         // depending on wether or not we have set a different rendertarget from when
         // this call was made.
-        Viewport& viewport    = context->m_MainViewport;
+        DrawState* draw_state = GetDrawState(context);
+        Viewport& viewport    = draw_state->m_Viewport;
         viewport.m_X          = (uint16_t) x;
         viewport.m_Y          = (uint16_t) y;
         viewport.m_W          = (uint16_t) width;
         viewport.m_H          = (uint16_t) height;
 
-        context->m_ViewportChanged = 1;
+        draw_state->m_ViewportChanged = 1;
     }
 
     static void VulkanEnableState(HContext context, State state)
     {
         assert(context);
-        SetPipelineStateValue(context->m_PipelineState, state, 1);
+        SetPipelineStateValue(GetDrawState(context)->m_PipelineState, state, 1);
     }
 
     static void VulkanDisableState(HContext context, State state)
     {
         assert(context);
-        SetPipelineStateValue(context->m_PipelineState, state, 0);
+        SetPipelineStateValue(GetDrawState(context)->m_PipelineState, state, 0);
     }
 
     static void VulkanSetBlendFunc(HContext context, BlendFactor source_factor, BlendFactor destinaton_factor)
     {
         assert(context);
-        context->m_PipelineState.m_BlendSrcFactor = source_factor;
-        context->m_PipelineState.m_BlendDstFactor = destinaton_factor;
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
+        pipeline_state.m_BlendSrcFactor = source_factor;
+        pipeline_state.m_BlendDstFactor = destinaton_factor;
     }
 
     static void VulkanSetColorMask(HContext context, bool red, bool green, bool blue, bool alpha)
     {
         assert(context);
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
         uint8_t write_mask = red   ? DM_GRAPHICS_STATE_WRITE_R : 0;
         write_mask        |= green ? DM_GRAPHICS_STATE_WRITE_G : 0;
         write_mask        |= blue  ? DM_GRAPHICS_STATE_WRITE_B : 0;
         write_mask        |= alpha ? DM_GRAPHICS_STATE_WRITE_A : 0;
 
-        context->m_PipelineState.m_WriteColorMask = write_mask;
+        pipeline_state.m_WriteColorMask = write_mask;
     }
 
     static void VulkanSetDepthMask(HContext context, bool mask)
     {
-        context->m_PipelineState.m_WriteDepth = mask;
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
+        pipeline_state.m_WriteDepth = mask;
     }
 
     static void VulkanSetDepthFunc(HContext context, CompareFunc func)
     {
-        context->m_PipelineState.m_DepthTestFunc = func;
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
+        pipeline_state.m_DepthTestFunc = func;
     }
 
     static void VulkanSetScissor(HContext context, int32_t x, int32_t y, int32_t width, int32_t height)
@@ -2639,65 +3123,71 @@ bail:
 
     static void VulkanSetStencilMask(HContext context, uint32_t mask)
     {
-        context->m_PipelineState.m_StencilWriteMask = mask;
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
+        pipeline_state.m_StencilWriteMask = mask;
     }
 
     static void VulkanSetStencilFunc(HContext context, CompareFunc func, uint32_t ref, uint32_t mask)
     {
         assert(context);
-        context->m_PipelineState.m_StencilFrontTestFunc = (uint8_t) func;
-        context->m_PipelineState.m_StencilBackTestFunc  = (uint8_t) func;
-        context->m_PipelineState.m_StencilReference     = (uint8_t) ref;
-        context->m_PipelineState.m_StencilCompareMask   = (uint8_t) mask;
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
+        pipeline_state.m_StencilFrontTestFunc = (uint8_t) func;
+        pipeline_state.m_StencilBackTestFunc  = (uint8_t) func;
+        pipeline_state.m_StencilReference     = (uint8_t) ref;
+        pipeline_state.m_StencilCompareMask   = (uint8_t) mask;
     }
 
     static void VulkanSetStencilFuncSeparate(HContext context, FaceType face_type, CompareFunc func, uint32_t ref, uint32_t mask)
     {
         assert(context);
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
         if (face_type == FACE_TYPE_BACK)
         {
-            context->m_PipelineState.m_StencilBackTestFunc  = (uint8_t) func;
+            pipeline_state.m_StencilBackTestFunc  = (uint8_t) func;
         }
         else
         {
-            context->m_PipelineState.m_StencilFrontTestFunc = (uint8_t) func;
+            pipeline_state.m_StencilFrontTestFunc = (uint8_t) func;
         }
-        context->m_PipelineState.m_StencilReference     = (uint8_t) ref;
-        context->m_PipelineState.m_StencilCompareMask   = (uint8_t) mask;
+        pipeline_state.m_StencilReference     = (uint8_t) ref;
+        pipeline_state.m_StencilCompareMask   = (uint8_t) mask;
     }
 
     static void VulkanSetStencilOp(HContext context, StencilOp sfail, StencilOp dpfail, StencilOp dppass)
     {
         assert(context);
-        context->m_PipelineState.m_StencilFrontOpFail      = sfail;
-        context->m_PipelineState.m_StencilFrontOpDepthFail = dpfail;
-        context->m_PipelineState.m_StencilFrontOpPass      = dppass;
-        context->m_PipelineState.m_StencilBackOpFail       = sfail;
-        context->m_PipelineState.m_StencilBackOpDepthFail  = dpfail;
-        context->m_PipelineState.m_StencilBackOpPass       = dppass;
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
+        pipeline_state.m_StencilFrontOpFail      = sfail;
+        pipeline_state.m_StencilFrontOpDepthFail = dpfail;
+        pipeline_state.m_StencilFrontOpPass      = dppass;
+        pipeline_state.m_StencilBackOpFail       = sfail;
+        pipeline_state.m_StencilBackOpDepthFail  = dpfail;
+        pipeline_state.m_StencilBackOpPass       = dppass;
     }
 
     static void VulkanSetStencilOpSeparate(HContext context, FaceType face_type, StencilOp sfail, StencilOp dpfail, StencilOp dppass)
     {
+        PipelineState& pipeline_state = GetDrawState(context)->m_PipelineState;
         if (face_type == FACE_TYPE_BACK)
         {
-            context->m_PipelineState.m_StencilBackOpFail       = sfail;
-            context->m_PipelineState.m_StencilBackOpDepthFail  = dpfail;
-            context->m_PipelineState.m_StencilBackOpPass       = dppass;
+            pipeline_state.m_StencilBackOpFail       = sfail;
+            pipeline_state.m_StencilBackOpDepthFail  = dpfail;
+            pipeline_state.m_StencilBackOpPass       = dppass;
         }
         else
         {
-            context->m_PipelineState.m_StencilFrontOpFail      = sfail;
-            context->m_PipelineState.m_StencilFrontOpDepthFail = dpfail;
-            context->m_PipelineState.m_StencilFrontOpPass      = dppass;
+            pipeline_state.m_StencilFrontOpFail      = sfail;
+            pipeline_state.m_StencilFrontOpDepthFail = dpfail;
+            pipeline_state.m_StencilFrontOpPass      = dppass;
         }
     }
 
     static void VulkanSetCullFace(HContext context, FaceType face_type)
     {
         assert(context);
-        context->m_PipelineState.m_CullFaceType = face_type;
-        context->m_CullFaceChanged              = true;
+        DrawState* draw_state = GetDrawState(context);
+        draw_state->m_PipelineState.m_CullFaceType = face_type;
+        draw_state->m_CullFaceChanged              = true;
     }
 
     static void VulkanSetFaceWinding(HContext, FaceWinding face_winding)
@@ -2708,7 +3198,7 @@ bail:
     static void VulkanSetPolygonOffset(HContext context, float factor, float units)
     {
         assert(context);
-        vkCmdSetDepthBias(context->m_MainCommandBuffers[context->m_SwapChain->m_ImageIndex],
+        vkCmdSetDepthBias(GetCommandRecorder(context)->m_CommandBuffer,
             factor, 0.0, units);
     }
 
@@ -2798,7 +3288,13 @@ bail:
             fb_attachments[fb_attachment_count++] = depthStencilTexture->m_Handle.m_ImageView;
         }
 
-        VkResult res = CreateRenderPass(vk_device, VK_SAMPLE_COUNT_1_BIT, rp_attachments, num_color_textures, rp_attachment_depth_stencil, 0, &rtOut->m_RenderPass);
+        VkResult res = CreateRenderPass(vk_device, VK_SAMPLE_COUNT_1_BIT, rp_attachments, num_color_textures, rp_attachment_depth_stencil, 0, false, &rtOut->m_RenderPass);
+        if (res != VK_SUCCESS)
+        {
+            return res;
+        }
+
+        res = CreateRenderPass(vk_device, VK_SAMPLE_COUNT_1_BIT, rp_attachments, num_color_textures, rp_attachment_depth_stencil, 0, true, &rtOut->m_RenderPassContinue);
         if (res != VK_SUCCESS)
         {
             return res;
@@ -2831,8 +3327,10 @@ bail:
         assert(renderTarget);
         DestroyFrameBuffer(logicalDevice->m_Device, renderTarget->m_Framebuffer);
         DestroyRenderPass(logicalDevice->m_Device, renderTarget->m_RenderPass);
+        DestroyRenderPass(logicalDevice->m_Device, renderTarget->m_RenderPassContinue);
         renderTarget->m_Framebuffer = VK_NULL_HANDLE;
         renderTarget->m_RenderPass = VK_NULL_HANDLE;
+        renderTarget->m_RenderPassContinue = VK_NULL_HANDLE;
     }
 
     static HRenderTarget VulkanNewRenderTarget(HContext context, uint32_t buffer_type_flags, const TextureCreationParams creation_params[MAX_BUFFER_TYPE_COUNT], const TextureParams params[MAX_BUFFER_TYPE_COUNT])
@@ -2967,8 +3465,9 @@ bail:
     static void VulkanSetRenderTarget(HContext context, HRenderTarget render_target, uint32_t transient_buffer_types)
     {
         (void) transient_buffer_types;
-        context->m_ViewportChanged = 1;
-        BeginRenderPass(context, render_target != 0x0 ? render_target : &context->m_MainRenderTarget);
+        assert(GetCommandRecorder(context) == &context->m_MainCommandRecorder && "The render target can't be changed by a command recorder");
+        context->m_MainCommandRecorder.m_DrawState.m_ViewportChanged = 1;
+        BeginRenderPass(context, render_target != 0x0 ? render_target : &context->m_MainRenderTarget, VK_SUBPASS_CONTENTS_INLINE, false);
     }
 
     static HTexture VulkanGetRenderTargetTexture(HRenderTarget render_target, BufferType buffer_type)
@@ -3074,6 +3573,10 @@ bail:
 
     static void VulkanDeleteTexture(HTexture t)
     {
+        if (t->m_PendingUploads > 0)
+        {
+            UpdateTextureUploads(g_VulkanContext, true);
+        }
         DestroyResourceDeferred(g_VulkanContext->m_MainResourcesToDestroy[g_VulkanContext->m_SwapChain->m_ImageIndex], t);
         delete t;
     }
@@ -3101,6 +3604,114 @@ bail:
         return texture->m_Type == TEXTURE_TYPE_CUBE_MAP ? 6 : 1;
     }
 
+    void UpdateTextureUploads(HContext context, bool wait)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        uint32_t i = 0;
+        while (i < context->m_TextureUploads.Size())
+        {
+            TextureUpload& upload = context->m_TextureUploads[i];
+            if (vkWaitForFences(vk_device, 1, &upload.m_Fence, VK_TRUE, wait ? UINT64_MAX : 0) != VK_SUCCESS)
+            {
+                ++i;
+                continue;
+            }
+
+            vkDestroyFence(vk_device, upload.m_Fence, 0);
+            vkFreeCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &upload.m_CommandBuffer);
+            DestroyDeviceBuffer(vk_device, &upload.m_StageBuffer.m_Handle);
+            upload.m_Texture->m_PendingUploads--;
+            context->m_TextureUploads.EraseSwap(i);
+        }
+    }
+
+    // Same as the staged path of CopyToTexture, but the transitions and the copy are recorded into a single
+    // command buffer that is submitted without waiting for the queue. The stage buffer is released in
+    // UpdateTextureUploads once the fence of the upload has been signaled.
+    static void CopyToTextureAsync(HContext context, const TextureParams& params,
+        uint32_t texDataSize, void* texDataPtr, Texture* textureOut)
+    {
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+        uint8_t layer_count = GetLayerCount(textureOut);
+
+        TextureUpload upload;
+        upload.m_Texture = textureOut;
+
+        VkResult res = CreateDeviceBuffer(context->m_PhysicalDevice.m_Device, vk_device, texDataSize,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &upload.m_StageBuffer);
+        CHECK_VK_ERROR(res);
+
+        res = WriteToDeviceBuffer(vk_device, texDataSize, 0, texDataPtr, &upload.m_StageBuffer);
+        CHECK_VK_ERROR(res);
+
+        CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &upload.m_CommandBuffer);
+
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
+        vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        res = vkBeginCommandBuffer(upload.m_CommandBuffer, &vk_command_buffer_begin_info);
+        CHECK_VK_ERROR(res);
+
+        CmdTransitionImageLayout(upload.m_CommandBuffer, textureOut->m_Handle.m_Image, VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, params.m_MipMap, layer_count);
+
+        uint32_t slice_size = texDataSize / layer_count;
+
+        VkBufferImageCopy vk_copy_regions[6];
+        for (int i = 0; i < layer_count; ++i)
+        {
+            VkBufferImageCopy& vk_copy_region = vk_copy_regions[i];
+            vk_copy_region.bufferOffset                    = i * slice_size;
+            vk_copy_region.bufferRowLength                 = 0;
+            vk_copy_region.bufferImageHeight               = 0;
+            vk_copy_region.imageOffset.x                   = params.m_X;
+            vk_copy_region.imageOffset.y                   = params.m_Y;
+            vk_copy_region.imageOffset.z                   = 0;
+            vk_copy_region.imageExtent.width               = params.m_Width;
+            vk_copy_region.imageExtent.height              = params.m_Height;
+            vk_copy_region.imageExtent.depth               = 1;
+            vk_copy_region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+            vk_copy_region.imageSubresource.mipLevel       = params.m_MipMap;
+            vk_copy_region.imageSubresource.baseArrayLayer = i;
+            vk_copy_region.imageSubresource.layerCount     = 1;
+        }
+
+        vkCmdCopyBufferToImage(upload.m_CommandBuffer, upload.m_StageBuffer.m_Handle.m_Buffer,
+            textureOut->m_Handle.m_Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            layer_count, vk_copy_regions);
+
+        CmdTransitionImageLayout(upload.m_CommandBuffer, textureOut->m_Handle.m_Image, VK_IMAGE_ASPECT_COLOR_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, params.m_MipMap, layer_count);
+
+        res = vkEndCommandBuffer(upload.m_CommandBuffer);
+        CHECK_VK_ERROR(res);
+
+        VkFenceCreateInfo vk_fence_create_info;
+        memset(&vk_fence_create_info, 0, sizeof(vk_fence_create_info));
+        vk_fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        res = vkCreateFence(vk_device, &vk_fence_create_info, 0, &upload.m_Fence);
+        CHECK_VK_ERROR(res);
+
+        // Commands submitted later to the same queue, such as the main command buffer of this frame,
+        // are ordered after the transitions of the upload
+        VkSubmitInfo vk_submit_info;
+        memset(&vk_submit_info, 0, sizeof(vk_submit_info));
+        vk_submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        vk_submit_info.commandBufferCount = 1;
+        vk_submit_info.pCommandBuffers    = &upload.m_CommandBuffer;
+
+        res = vkQueueSubmit(context->m_LogicalDevice.m_GraphicsQueue, 1, &vk_submit_info, upload.m_Fence);
+        CHECK_VK_ERROR(res);
+
+        textureOut->m_PendingUploads++;
+        if (context->m_TextureUploads.Full())
+        {
+            context->m_TextureUploads.OffsetCapacity(16);
+        }
+        context->m_TextureUploads.Push(upload);
+    }
+
     static void CopyToTexture(HContext context, const TextureParams& params,
         bool useStageBuffer, uint32_t texDataSize, void* texDataPtr, Texture* textureOut)
     {
@@ -3117,7 +3728,7 @@ bail:
         {
             // Create one-time commandbuffer to carry the copy command
             VkCommandBuffer vk_command_buffer;
-            CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, 1, &vk_command_buffer);
+            CreateCommandBuffers(vk_device, context->m_LogicalDevice.m_CommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &vk_command_buffer);
             VkCommandBufferBeginInfo vk_command_buffer_begin_info;
             memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
 
@@ -3214,7 +3825,7 @@ bail:
         }
     }
 
-    static void VulkanSetTexture(HTexture texture, const TextureParams& params)
+    static void SetTexture(HTexture texture, const TextureParams& params, bool async)
     {
         // Same as graphics_opengl.cpp
         switch (params.m_Format)
@@ -3280,7 +3891,11 @@ bail:
             if (texture->m_Format != vk_format || texture->m_Width != params.m_Width || texture->m_Height != params.m_Height)
             {
                 DestroyResourceDeferred(g_VulkanContext->m_MainResourcesToDestroy[g_VulkanContext->m_SwapChain->m_ImageIndex], texture);
-                texture->m_Format = vk_format;
+                texture->m_Format      = vk_format;
+                if (params.m_ResizeMipChain)
+                    texture->m_MipMapCount = GetResizedMipMapCount(texture->m_MipMapCount, texture->m_Width, texture->m_Height, params.m_Width, params.m_Height);
+                texture->m_Width       = params.m_Width;
+                texture->m_Height      = params.m_Height;
             }
         }
 
@@ -3329,7 +3944,15 @@ bail:
 
         tex_data_size = (int) ceil((float) tex_data_size / 8.0f);
 
-        CopyToTexture(g_VulkanContext, params, use_stage_buffer, tex_data_size, tex_data_ptr, texture);
+        // The async upload copies the data to its stage buffer before returning, so the expanded RGB data can be deleted here as well
+        if (async && use_stage_buffer)
+        {
+            CopyToTextureAsync(g_VulkanContext, params, tex_data_size, tex_data_ptr, texture);
+        }
+        else
+        {
+            CopyToTexture(g_VulkanContext, params, use_stage_buffer, tex_data_size, tex_data_ptr, texture);
+        }
 
         if (format_orig == TEXTURE_FORMAT_RGB)
         {
@@ -3337,10 +3960,14 @@ bail:
         }
     }
 
+    static void VulkanSetTexture(HTexture texture, const TextureParams& params)
+    {
+        SetTexture(texture, params, false);
+    }
+
     static void VulkanSetTextureAsync(HTexture texture, const TextureParams& params)
     {
-        // Async texture loading is not supported in Vulkan, defaulting to syncronous loading until then
-        VulkanSetTexture(texture, params);
+        SetTexture(texture, params, true);
     }
 
     static float GetMaxAnisotrophyClamped(float max_anisotropy_requested)
@@ -3410,13 +4037,13 @@ bail:
     static void VulkanEnableTexture(HContext context, uint32_t unit, HTexture texture)
     {
         assert(unit < DM_MAX_TEXTURE_UNITS);
-        context->m_TextureUnits[unit] = texture;
+        GetDrawState(context)->m_TextureUnits[unit] = texture;
     }
 
     static void VulkanDisableTexture(HContext context, uint32_t unit, HTexture texture)
     {
         assert(unit < DM_MAX_TEXTURE_UNITS);
-        context->m_TextureUnits[unit] = context->m_DefaultTexture;
+        GetDrawState(context)->m_TextureUnits[unit] = context->m_DefaultTexture;
     }
 
     static uint32_t VulkanGetMaxTextureSize(HContext context)
@@ -3426,7 +4053,11 @@ bail:
 
     static uint32_t VulkanGetTextureStatusFlags(HTexture texture)
     {
-        return 0;
+        if (texture->m_PendingUploads > 0)
+        {
+            UpdateTextureUploads(g_VulkanContext, false);
+        }
+        return texture->m_PendingUploads > 0 ? TEXTURE_STATUS_DATA_PENDING : TEXTURE_STATUS_OK;
     }
 
     static void VulkanReadPixels(HContext context, void* buffer, uint32_t buffer_size)
@@ -3440,6 +4071,247 @@ bail:
         }
     }
 
+    static bool VulkanIsCommandRecorderSupported(HContext context)
+    {
+        return true;
+    }
+
+    static HCommandRecorder VulkanNewCommandRecorder(HContext context)
+    {
+        VkDevice vk_device                   = context->m_LogicalDevice.m_Device;
+        const uint8_t num_swap_chain_images  = context->m_SwapChain->m_Images.Size();
+        CommandRecorder* recorder            = new CommandRecorder();
+
+        // Command pools must only be used by one thread at a time, so each recorder has a pool of its own
+        VkResult res = CreateCommandPool(vk_device, context->m_SwapChain->m_QueueFamily.m_GraphicsQueueIx, &recorder->m_CommandPool);
+        CHECK_VK_ERROR(res);
+
+        recorder->m_CommandBuffers.SetCapacity(num_swap_chain_images);
+        recorder->m_CommandBuffers.SetSize(num_swap_chain_images);
+        res = CreateCommandBuffers(vk_device, recorder->m_CommandPool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, num_swap_chain_images, recorder->m_CommandBuffers.Begin());
+        CHECK_VK_ERROR(res);
+
+        // Same as the main scratch buffers, but smaller since the draw calls are split between several recorders
+        const uint16_t descriptor_count_per_pool = 128;
+        const uint32_t buffer_size               = 256 * descriptor_count_per_pool;
+
+        recorder->m_ScratchBuffers.SetCapacity(num_swap_chain_images);
+        recorder->m_ScratchBuffers.SetSize(num_swap_chain_images);
+        recorder->m_DescriptorAllocators.SetCapacity(num_swap_chain_images);
+        recorder->m_DescriptorAllocators.SetSize(num_swap_chain_images);
+
+        res = CreateScratchBuffers(context->m_PhysicalDevice.m_Device, vk_device,
+            num_swap_chain_images, buffer_size, descriptor_count_per_pool,
+            recorder->m_DescriptorAllocators.Begin(), recorder->m_ScratchBuffers.Begin());
+        CHECK_VK_ERROR(res);
+
+        recorder->m_PipelineCache.SetCapacity(32, 64);
+        return (HCommandRecorder) recorder;
+    }
+
+    static void VulkanDeleteCommandRecorder(HContext context, HCommandRecorder command_recorder)
+    {
+        CommandRecorder* recorder = (CommandRecorder*) command_recorder;
+        assert(!recorder->m_IsRecording);
+        VkDevice vk_device = context->m_LogicalDevice.m_Device;
+
+        // The command buffers of the recorder might still be in flight
+        SynchronizeDevice(vk_device);
+
+        for (uint32_t i = 0; i < recorder->m_ScratchBuffers.Size(); ++i)
+        {
+            DestroyDeviceBuffer(vk_device, &recorder->m_ScratchBuffers[i].m_DeviceBuffer.m_Handle);
+            DestroyDescriptorAllocator(vk_device, &recorder->m_DescriptorAllocators[i].m_Handle);
+        }
+
+        vkFreeCommandBuffers(vk_device, recorder->m_CommandPool, recorder->m_CommandBuffers.Size(), recorder->m_CommandBuffers.Begin());
+        vkDestroyCommandPool(vk_device, recorder->m_CommandPool, 0);
+
+        if (recorder->m_DrawState.m_DynamicOffsetBuffer)
+        {
+            free(recorder->m_DrawState.m_DynamicOffsetBuffer);
+        }
+
+        delete recorder;
+    }
+
+    static void VulkanBeginCommandRecorder(HContext context, HCommandRecorder command_recorder)
+    {
+        CommandRecorder* recorder = (CommandRecorder*) command_recorder;
+        assert(context->m_FrameBegun);
+        assert(!recorder->m_IsRecording);
+        assert(dmThread::GetTlsValue(context->m_CommandRecorderKey) == 0);
+
+        VkDevice vk_device     = context->m_LogicalDevice.m_Device;
+        const uint8_t image_ix = context->m_SwapChain->m_ImageIndex;
+
+        // The recorder starts out with the draw state of the main thread, but keeps its own dynamic offset buffer
+        DrawState& draw_state                   = recorder->m_DrawState;
+        uint32_t* dynamic_offset_buffer         = draw_state.m_DynamicOffsetBuffer;
+        uint16_t dynamic_offset_buffer_size     = draw_state.m_DynamicOffsetBufferSize;
+        draw_state                              = context->m_MainCommandRecorder.m_DrawState;
+        draw_state.m_DynamicOffsetBuffer        = dynamic_offset_buffer;
+        draw_state.m_DynamicOffsetBufferSize    = dynamic_offset_buffer_size;
+        // Dynamic state isn't inherited by secondary command buffers
+        draw_state.m_ViewportChanged            = 1;
+        draw_state.m_UniformData                = 0;
+        draw_state.m_SamplerUnits               = 0;
+
+        // The resolved declarations were copied along with the draw state, so they must point to the copies of the recorder
+        const DrawState& main_draw_state = context->m_MainCommandRecorder.m_DrawState;
+        if (draw_state.m_CurrentVertexDeclaration == &main_draw_state.m_ResolvedVertexDeclaration)
+        {
+            draw_state.m_CurrentVertexDeclaration = &draw_state.m_ResolvedVertexDeclaration;
+        }
+        if (draw_state.m_CurrentInstanceVertexDeclaration == &main_draw_state.m_ResolvedInstanceVertexDeclaration)
+        {
+            draw_state.m_CurrentInstanceVertexDeclaration = &draw_state.m_ResolvedInstanceVertexDeclaration;
+        }
+
+        if (draw_state.m_CurrentProgram)
+        {
+            CopyProgramUniformData(recorder, draw_state.m_CurrentProgram);
+        }
+
+        ScratchBuffer* scratch_buffer = &recorder->m_ScratchBuffers[image_ix];
+        ResetScratchBuffer(vk_device, scratch_buffer);
+        VkResult res = scratch_buffer->m_DeviceBuffer.MapMemory(vk_device);
+        CHECK_VK_ERROR(res);
+
+        RenderTarget* rt = context->m_CurrentRenderTarget;
+
+        VkCommandBufferInheritanceInfo vk_inheritance_info;
+        memset(&vk_inheritance_info, 0, sizeof(vk_inheritance_info));
+        vk_inheritance_info.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        vk_inheritance_info.renderPass  = rt->m_RenderPass;
+        vk_inheritance_info.subpass     = 0;
+        vk_inheritance_info.framebuffer = rt->m_Framebuffer;
+
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        vk_command_buffer_begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vk_command_buffer_begin_info.pInheritanceInfo = &vk_inheritance_info;
+        vk_command_buffer_begin_info.pNext            = 0;
+
+        recorder->m_CommandBuffer = recorder->m_CommandBuffers[image_ix];
+        res = vkBeginCommandBuffer(recorder->m_CommandBuffer, &vk_command_buffer_begin_info);
+        CHECK_VK_ERROR(res);
+
+        recorder->m_ScratchBuffer = scratch_buffer;
+        recorder->m_RenderTarget  = rt;
+        recorder->m_IsRecording   = 1;
+        dmThread::SetTlsValue(context->m_CommandRecorderKey, recorder);
+    }
+
+    static void VulkanEndCommandRecorder(HContext context, HCommandRecorder command_recorder)
+    {
+        CommandRecorder* recorder = (CommandRecorder*) command_recorder;
+        assert(recorder->m_IsRecording);
+        assert(dmThread::GetTlsValue(context->m_CommandRecorderKey) == recorder);
+
+        VkResult res = vkEndCommandBuffer(recorder->m_CommandBuffer);
+        CHECK_VK_ERROR(res);
+
+        recorder->m_ScratchBuffer->m_DeviceBuffer.UnmapMemory(context->m_LogicalDevice.m_Device);
+        recorder->m_IsRecording = 0;
+        dmThread::SetTlsValue(context->m_CommandRecorderKey, 0);
+    }
+
+    static void VulkanExecuteCommandRecorders(HContext context, HCommandRecorder* command_recorders, uint32_t command_recorder_count)
+    {
+        DM_PROFILE(__FUNCTION__);
+        assert(context->m_FrameBegun);
+        assert(GetCommandRecorder(context) == &context->m_MainCommandRecorder);
+
+        if (command_recorder_count == 0)
+        {
+            return;
+        }
+
+        RenderTarget* rt                  = context->m_CurrentRenderTarget;
+        VkCommandBuffer vk_command_buffer = context->m_MainCommandRecorder.m_CommandBuffer;
+
+        // Secondary command buffers can only be executed in a render pass that was begun for them,
+        // so the current render pass is restarted with secondary command buffer contents. The continue
+        // pass loads the attachments, so what was drawn before and after the recorders is kept.
+        EndRenderPass(context);
+        BeginRenderPass(context, rt, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, true);
+
+        const uint32_t max_batch_size = 32;
+        VkCommandBuffer vk_command_buffers[max_batch_size];
+        uint32_t batch_size = 0;
+
+        for (uint32_t i = 0; i < command_recorder_count; ++i)
+        {
+            CommandRecorder* recorder = (CommandRecorder*) command_recorders[i];
+            assert(!recorder->m_IsRecording);
+            assert(recorder->m_RenderTarget == rt);
+
+            // Each recording is only executed once
+            if (recorder->m_CommandBuffer == VK_NULL_HANDLE)
+            {
+                continue;
+            }
+
+            vk_command_buffers[batch_size++] = recorder->m_CommandBuffer;
+            recorder->m_CommandBuffer        = VK_NULL_HANDLE;
+
+            if (batch_size == max_batch_size)
+            {
+                vkCmdExecuteCommands(vk_command_buffer, batch_size, vk_command_buffers);
+                batch_size = 0;
+            }
+        }
+
+        if (batch_size > 0)
+        {
+            vkCmdExecuteCommands(vk_command_buffer, batch_size, vk_command_buffers);
+        }
+
+        EndRenderPass(context);
+        BeginRenderPass(context, rt, VK_SUBPASS_CONTENTS_INLINE, true);
+
+        // The dynamic state of the main command buffer is undefined after executing secondary command buffers
+        context->m_MainCommandRecorder.m_DrawState.m_ViewportChanged = 1;
+    }
+
+    static void WriteGpuTimestamp(HContext context, uint32_t query, VkPipelineStageFlagBits vk_stage)
+    {
+        uint32_t first_query = context->m_GpuTimers.m_FrameIndex * MAX_GPU_TIMER_QUERIES * 2;
+        vkCmdWriteTimestamp(context->m_MainCommandRecorder.m_CommandBuffer, vk_stage, context->m_GpuTimerQueryPool, first_query + query);
+    }
+
+    static void VulkanBeginGpuTimer(HContext context, uint32_t timer)
+    {
+        if (context->m_GpuTimerQueryPool == VK_NULL_HANDLE || !context->m_FrameBegun)
+        {
+            return;
+        }
+        int32_t query = BeginGpuTimerQuery(&context->m_GpuTimers, timer);
+        if (query >= 0)
+        {
+            WriteGpuTimestamp(context, query * 2, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        }
+    }
+
+    static void VulkanEndGpuTimer(HContext context, uint32_t timer)
+    {
+        if (context->m_GpuTimerQueryPool == VK_NULL_HANDLE || !context->m_FrameBegun)
+        {
+            return;
+        }
+        int32_t query = EndGpuTimerQuery(&context->m_GpuTimers, timer);
+        if (query >= 0)
+        {
+            WriteGpuTimestamp(context, query * 2 + 1, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        }
+    }
+
+    static bool VulkanGetGpuTimerResult(HContext context, uint32_t timer, uint64_t* out_nanoseconds)
+    {
+        return GetGpuTimerResult(&context->m_GpuTimers, timer, out_nanoseconds);
+    }
+
     void DestroyPipelineCacheCb(HContext context, const uint64_t* key, Pipeline* value)
     {
         DestroyPipeline(context->m_LogicalDevice.m_Device, value);
@@ -3491,6 +4363,16 @@ bail:
         fn_table.m_HashVertexDeclaration = VulkanHashVertexDeclaration;
         fn_table.m_DrawElements = VulkanDrawElements;
         fn_table.m_Draw = VulkanDraw;
+        fn_table.m_IsInstancingSupported = VulkanIsInstancingSupported;
+        fn_table.m_EnableInstanceVertexDeclaration = VulkanEnableInstanceVertexDeclaration;
+        fn_table.m_DisableInstanceVertexDeclaration = VulkanDisableInstanceVertexDeclaration;
+        fn_table.m_DrawElementsInstanced = VulkanDrawElementsInstanced;
+        fn_table.m_DrawInstanced = VulkanDrawInstanced;
+        fn_table.m_NewTransientBuffer = VulkanNewTransientBuffer;
+        fn_table.m_DeleteTransientBuffer = VulkanDeleteTransientBuffer;
+        fn_table.m_AllocTransientBuffer = VulkanAllocTransientBuffer;
+        fn_table.m_FlushTransientBuffer = VulkanFlushTransientBuffer;
+        fn_table.m_GetTransientBufferSize = VulkanGetTransientBufferSize;
         fn_table.m_NewVertexProgram = VulkanNewVertexProgram;
         fn_table.m_NewFragmentProgram = VulkanNewFragmentProgram;
         fn_table.m_NewProgram = VulkanNewProgram;
@@ -3506,6 +4388,7 @@ bail:
         fn_table.m_GetUniformName = VulkanGetUniformName;
         fn_table.m_GetUniformCount = VulkanGetUniformCount;
         fn_table.m_GetUniformLocation = VulkanGetUniformLocation;
+        fn_table.m_GetAttributeLocation = VulkanGetAttributeLocation;
         fn_table.m_SetConstantV4 = VulkanSetConstantV4;
         fn_table.m_SetConstantM4 = VulkanSetConstantM4;
         fn_table.m_SetSampler = VulkanSetSampler;
@@ -3552,6 +4435,15 @@ bail:
         fn_table.m_GetNumSupportedExtensions = VulkanGetNumSupportedExtensions;
         fn_table.m_GetSupportedExtension = VulkanGetSupportedExtension;
         fn_table.m_IsMultiTargetRenderingSupported = VulkanIsMultiTargetRenderingSupported;
+        fn_table.m_IsCommandRecorderSupported = VulkanIsCommandRecorderSupported;
+        fn_table.m_NewCommandRecorder = VulkanNewCommandRecorder;
+        fn_table.m_DeleteCommandRecorder = VulkanDeleteCommandRecorder;
+        fn_table.m_BeginCommandRecorder = VulkanBeginCommandRecorder;
+        fn_table.m_EndCommandRecorder = VulkanEndCommandRecorder;
+        fn_table.m_ExecuteCommandRecorders = VulkanExecuteCommandRecorders;
+        fn_table.m_BeginGpuTimer = VulkanBeginGpuTimer;
+        fn_table.m_EndGpuTimer = VulkanEndGpuTimer;
+        fn_table.m_GetGpuTimerResult = VulkanGetGpuTimerResult;
         return fn_table;
     }
 }
@@ -32,12 +32,14 @@ namespace dmGraphics
         t->m_MipMapCount         = 0;
         t->m_TextureSamplerIndex = 0;
         t->m_Destroyed           = 0;
+        t->m_PendingUploads      = 0;
         memset(&t->m_Handle, 0, sizeof(t->m_Handle));
     }
 
     RenderTarget::RenderTarget(const uint32_t rtId)
         : m_TextureDepthStencil(0)
         , m_RenderPass(VK_NULL_HANDLE)
+        , m_RenderPassContinue(VK_NULL_HANDLE)
         , m_Framebuffer(VK_NULL_HANDLE)
         , m_Id(rtId)
         , m_IsBound(0)
@@ -52,7 +54,7 @@ namespace dmGraphics
         memset(this, 0, sizeof(*this));
     }
 
-    static uint16_t FillVertexInputAttributeDesc(HVertexDeclaration vertexDeclaration, VkVertexInputAttributeDescription* vk_vertex_input_descs)
+    static uint16_t FillVertexInputAttributeDesc(HVertexDeclaration vertexDeclaration, uint32_t binding, VkVertexInputAttributeDescription* vk_vertex_input_descs)
     {
         uint16_t num_attributes = 0;
         for (uint16_t i = 0; i < vertexDeclaration->m_StreamCount; ++i)
@@ -62,7 +64,7 @@ namespace dmGraphics
                 continue;
             }
 
-            vk_vertex_input_descs[num_attributes].binding  = 0;
+            vk_vertex_input_descs[num_attributes].binding  = binding;
             vk_vertex_input_descs[num_attributes].location = vertexDeclaration->m_Streams[i].m_Location;
             vk_vertex_input_descs[num_attributes].format   = vertexDeclaration->m_Streams[i].m_Format;
             vk_vertex_input_descs[num_attributes].offset   = vertexDeclaration->m_Streams[i].m_Offset;
@@ -258,22 +260,10 @@ namespace dmGraphics
         return vk_count_bits[dmMath::Min<uint8_t>(sample_count_index_requested, sample_count_index_max)];
     }
 
-    VkResult TransitionImageLayout(VkDevice vk_device, VkCommandPool vk_command_pool, VkQueue vk_graphics_queue, VkImage vk_image,
+    void CmdTransitionImageLayout(VkCommandBuffer vk_command_buffer, VkImage vk_image,
         VkImageAspectFlags vk_image_aspect, VkImageLayout vk_from_layout, VkImageLayout vk_to_layout,
         uint32_t baseMipLevel, uint32_t layer_count)
     {
-        // Create a one-time-execute command buffer that will only be used for the transition
-        VkCommandBuffer vk_command_buffer;
-        CreateCommandBuffers(vk_device, vk_command_pool, 1, &vk_command_buffer);
-
-        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
-        memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
-
-        vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        vkBeginCommandBuffer(vk_command_buffer, &vk_command_buffer_begin_info);
-
         VkImageMemoryBarrier vk_memory_barrier;
         memset(&vk_memory_barrier, 0, sizeof(vk_memory_barrier));
 
@@ -349,6 +339,25 @@ namespace dmGraphics
             vk_destination_stage,
             0, 0, 0, 0, 0, 1,
             &vk_memory_barrier);
+    }
+
+    VkResult TransitionImageLayout(VkDevice vk_device, VkCommandPool vk_command_pool, VkQueue vk_graphics_queue, VkImage vk_image,
+        VkImageAspectFlags vk_image_aspect, VkImageLayout vk_from_layout, VkImageLayout vk_to_layout,
+        uint32_t baseMipLevel, uint32_t layer_count)
+    {
+        // Create a one-time-execute command buffer that will only be used for the transition
+        VkCommandBuffer vk_command_buffer;
+        CreateCommandBuffers(vk_device, vk_command_pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &vk_command_buffer);
+
+        VkCommandBufferBeginInfo vk_command_buffer_begin_info;
+        memset(&vk_command_buffer_begin_info, 0, sizeof(VkCommandBufferBeginInfo));
+
+        vk_command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        vk_command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(vk_command_buffer, &vk_command_buffer_begin_info);
+
+        CmdTransitionImageLayout(vk_command_buffer, vk_image, vk_image_aspect, vk_from_layout, vk_to_layout, baseMipLevel, layer_count);
 
         vkEndCommandBuffer(vk_command_buffer);
 
@@ -431,14 +440,24 @@ namespace dmGraphics
         return VK_SUCCESS;
     }
 
-    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out)
+    VkResult CreateCommandPool(VkDevice vk_device, uint16_t queue_family_index, VkCommandPool* vk_command_pool_out)
+    {
+        VkCommandPoolCreateInfo vk_create_pool_info;
+        memset(&vk_create_pool_info, 0, sizeof(vk_create_pool_info));
+        vk_create_pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        vk_create_pool_info.queueFamilyIndex = (uint32_t) queue_family_index;
+        vk_create_pool_info.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        return vkCreateCommandPool(vk_device, &vk_create_pool_info, 0, vk_command_pool_out);
+    }
+
+    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, VkCommandBufferLevel vk_level, uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out)
     {
         VkCommandBufferAllocateInfo vk_buffers_allocate_info;
         memset(&vk_buffers_allocate_info, 0, sizeof(vk_buffers_allocate_info));
 
         vk_buffers_allocate_info.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         vk_buffers_allocate_info.commandPool        = vk_command_pool;
-        vk_buffers_allocate_info.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        vk_buffers_allocate_info.level              = vk_level;
         vk_buffers_allocate_info.commandBufferCount = numBuffersToCreate;
 
         return vkAllocateCommandBuffers(vk_device, &vk_buffers_allocate_info, vk_command_buffers_out);
@@ -727,6 +746,7 @@ bail:
         RenderPassAttachment* colorAttachments, uint8_t numColorAttachments,
         RenderPassAttachment* depthStencilAttachment,
         RenderPassAttachment* resolveAttachment,
+        bool continuePass,
         VkRenderPass* renderPassOut)
     {
         assert(*renderPassOut == VK_NULL_HANDLE);
@@ -747,11 +767,11 @@ bail:
 
             attachment_color.format         = colorAttachments[i].m_Format;
             attachment_color.samples        = vk_sample_flags;
-            attachment_color.loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment_color.loadOp         = continuePass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachment_color.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
             attachment_color.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachment_color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachment_color.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment_color.initialLayout  = continuePass ? colorAttachments[i].m_ImageLayout : VK_IMAGE_LAYOUT_UNDEFINED;
             attachment_color.finalLayout    = colorAttachments[i].m_ImageLayout;
 
             VkAttachmentReference& ref = vk_attachment_color_ref[i];
@@ -763,13 +783,14 @@ bail:
         {
             VkAttachmentDescription& attachment_depth = vk_attachment_desc[numColorAttachments];
 
+            // The stencil is stored as well, so that a continue pass can load it
             attachment_depth.format         = depthStencilAttachment->m_Format;
             attachment_depth.samples        = vk_sample_flags;
-            attachment_depth.loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment_depth.loadOp         = continuePass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             attachment_depth.storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
-            attachment_depth.stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            attachment_depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            attachment_depth.initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachment_depth.stencilLoadOp  = continuePass ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachment_depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachment_depth.initialLayout  = continuePass ? depthStencilAttachment->m_ImageLayout : VK_IMAGE_LAYOUT_UNDEFINED;
             attachment_depth.finalLayout    = depthStencilAttachment->m_ImageLayout;
 
             vk_attachment_depth_ref.attachment = numColorAttachments;
@@ -809,6 +830,15 @@ bail:
         vk_sub_pass_dependency.dstStageMask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
         vk_sub_pass_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+        // A continue pass loads what the previous pass on the same attachments has written
+        if (continuePass)
+        {
+            vk_sub_pass_dependency.srcStageMask  |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            vk_sub_pass_dependency.srcAccessMask  = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            vk_sub_pass_dependency.dstStageMask  |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+            vk_sub_pass_dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        }
+
         // The subpass description connects the input attachments to the render pass,
         // in a MRT situation writing to specific color outputs (gl_FragData[x]) match these numbers.
         VkSubpassDescription vk_sub_pass_description;
@@ -897,29 +927,41 @@ bail:
         VK_COMPARE_OP_ALWAYS
     };
 
-    VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
+    VkResult CreatePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
-        HVertexDeclaration vertexDeclaration, RenderTarget* render_target, Pipeline* pipelineOut)
+        HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceVertexDeclaration, RenderTarget* render_target, Pipeline* pipelineOut)
     {
         assert(pipelineOut && *pipelineOut == VK_NULL_HANDLE);
 
-        VkVertexInputAttributeDescription vk_vertex_input_descs[DM_MAX_VERTEX_STREAM_COUNT];
-        uint16_t active_attributes = FillVertexInputAttributeDesc(vertexDeclaration, vk_vertex_input_descs);
+        // Binding 0 holds the per-vertex streams, and binding 1 the (optional) per-instance streams
+        VkVertexInputAttributeDescription vk_vertex_input_descs[DM_MAX_VERTEX_STREAM_COUNT * 2];
+        uint16_t active_attributes = FillVertexInputAttributeDesc(vertexDeclaration, 0, vk_vertex_input_descs);
         assert(active_attributes != 0);
 
-        VkVertexInputBindingDescription vk_vx_input_description;
-        memset(&vk_vx_input_description, 0, sizeof(vk_vx_input_description));
+        VkVertexInputBindingDescription vk_vx_input_descriptions[2];
+        memset(vk_vx_input_descriptions, 0, sizeof(vk_vx_input_descriptions));
+        uint32_t num_bindings = 1;
 
-        vk_vx_input_description.binding   = 0;
-        vk_vx_input_description.stride    = vertexDeclaration->m_Stride;
-        vk_vx_input_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        vk_vx_input_descriptions[0].binding   = 0;
+        vk_vx_input_descriptions[0].stride    = vertexDeclaration->m_Stride;
+        vk_vx_input_descriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        if (instanceVertexDeclaration)
+        {
+            active_attributes += FillVertexInputAttributeDesc(instanceVertexDeclaration, 1, &vk_vertex_input_descs[active_attributes]);
+
+            vk_vx_input_descriptions[1].binding   = 1;
+            vk_vx_input_descriptions[1].stride    = instanceVertexDeclaration->m_Stride;
+            vk_vx_input_descriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            num_bindings++;
+        }
 
         VkPipelineVertexInputStateCreateInfo vk_vertex_input_info;
         memset(&vk_vertex_input_info, 0, sizeof(vk_vertex_input_info));
 
         vk_vertex_input_info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vk_vertex_input_info.vertexBindingDescriptionCount   = 1;
-        vk_vertex_input_info.pVertexBindingDescriptions      = &vk_vx_input_description;
+        vk_vertex_input_info.vertexBindingDescriptionCount   = num_bindings;
+        vk_vertex_input_info.pVertexBindingDescriptions      = vk_vx_input_descriptions;
         vk_vertex_input_info.vertexAttributeDescriptionCount = active_attributes;
         vk_vertex_input_info.pVertexAttributeDescriptions    = vk_vertex_input_descs;
 
@@ -1073,7 +1115,7 @@ bail:
         vk_pipeline_info.basePipelineHandle  = VK_NULL_HANDLE;
         vk_pipeline_info.basePipelineIndex   = -1;
 
-        return vkCreateGraphicsPipelines(vk_device, VK_NULL_HANDLE, 1, &vk_pipeline_info, 0, pipelineOut);
+        return vkCreateGraphicsPipelines(vk_device, vk_pipeline_cache, 1, &vk_pipeline_info, 0, pipelineOut);
     }
 
     void ResetScratchBuffer(VkDevice vk_device, ScratchBuffer* scratchBuffer)
@@ -1320,12 +1362,7 @@ bail:
             vkGetDeviceQueue(logicalDeviceOut->m_Device, queueFamily.m_PresentQueueIx, 0, &logicalDeviceOut->m_PresentQueue);
 
             // Create command pool
-            VkCommandPoolCreateInfo vk_create_pool_info;
-            memset(&vk_create_pool_info, 0, sizeof(vk_create_pool_info));
-            vk_create_pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-            vk_create_pool_info.queueFamilyIndex = (uint32_t) queueFamily.m_GraphicsQueueIx;
-            vk_create_pool_info.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-            res = vkCreateCommandPool(logicalDeviceOut->m_Device, &vk_create_pool_info, 0, &logicalDeviceOut->m_CommandPool);
+            res = CreateCommandPool(logicalDeviceOut->m_Device, queueFamily.m_GraphicsQueueIx, &logicalDeviceOut->m_CommandPool);
         }
 
         return res;
@@ -17,6 +17,8 @@
 
 #include <stdint.h>
 #include <dlib/hashtable.h>
+#include <dlib/mutex.h>
+#include <dlib/thread.h>
 
 #include "../graphics_private.h"
 
@@ -85,10 +87,21 @@ namespace dmGraphics
         uint16_t       m_MipMapCount         : 5;
         uint16_t       m_TextureSamplerIndex : 10;
         uint32_t       m_Destroyed           : 1;
+        uint32_t       m_PendingUploads      : 16; // Uploads from SetTextureAsync that haven't completed on the GPU
 
         const VulkanResourceType GetType();
     };
 
+    // A texture upload from SetTextureAsync, that is submitted without waiting for it to complete
+    struct TextureUpload
+    {
+        TextureUpload() : m_StageBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT) {}
+        DeviceBuffer    m_StageBuffer;
+        VkCommandBuffer m_CommandBuffer;
+        VkFence         m_Fence;
+        Texture*        m_Texture;
+    };
+
     struct TextureSampler
     {
         VkSampler     m_Sampler;
@@ -168,6 +181,7 @@ namespace dmGraphics
         BufferType     m_ColorAttachmentBufferTypes[MAX_BUFFER_COLOR_ATTACHMENTS];
         TextureParams  m_BufferTextureParams[MAX_BUFFER_TYPE_COUNT];
         VkRenderPass   m_RenderPass;
+        VkRenderPass   m_RenderPassContinue; // Loads the attachments instead of discarding them, to restart the render pass within a frame
         VkFramebuffer  m_Framebuffer;
         VkExtent2D     m_Extent;
         const uint16_t m_Id;
@@ -279,6 +293,7 @@ namespace dmGraphics
         uint64_t                        m_Hash;
         uint32_t*                       m_UniformDataOffsets;
         uint8_t*                        m_UniformData;
+        uint32_t                        m_UniformDataSize;
         VulkanHandle                    m_Handle;
         ShaderModule*                   m_VertexModule;
         ShaderModule*                   m_FragmentModule;
@@ -343,13 +358,66 @@ namespace dmGraphics
     // In flight frames - number of concurrent frames being processed
     static const uint8_t g_max_frames_in_flight       = 2;
 
+    struct TransientBuffer
+    {
+        dmArray<DeviceBuffer*>          m_DeviceBuffers; // One per swap chain image, persistently mapped
+        uint32_t                        m_Size;
+        uint32_t                        m_Offset;        // End of the slices allocated this frame
+        uint32_t                        m_Frame;         // The frame m_Offset was allocated in
+    };
+
+    // The state that draw calls are recorded with
+    struct DrawState
+    {
+        Texture*                        m_TextureUnits[DM_MAX_TEXTURE_UNITS];
+        PipelineState                   m_PipelineState;
+        Viewport                        m_Viewport;
+        DeviceBuffer*                   m_CurrentVertexBuffer;
+        uint32_t                        m_CurrentVertexBufferOffset;
+        VertexDeclaration*              m_CurrentVertexDeclaration;
+        DeviceBuffer*                   m_CurrentInstanceVertexBuffer;
+        VertexDeclaration*              m_CurrentInstanceVertexDeclaration;
+        Program*                        m_CurrentProgram;
+        uint8_t*                        m_UniformData;  // Uniform data of the current program, or 0 to use the data of the program itself
+        uint16_t*                       m_SamplerUnits; // Texture unit of each uniform of the current program, or 0 to use the units of the program itself
+        VertexDeclaration               m_ResolvedVertexDeclaration;         // Current vertex declaration with the locations of the current program
+        VertexDeclaration               m_ResolvedInstanceVertexDeclaration; // Current instance vertex declaration with the locations of the current program
+        uint32_t*                       m_DynamicOffsetBuffer;
+        uint16_t                        m_DynamicOffsetBufferSize;
+        uint8_t                         m_ViewportChanged : 1;
+        uint8_t                         m_CullFaceChanged : 1;
+    };
+
+    // Records draw calls into a command buffer.
+    // The main thread records into the main command buffer with the main recorder of the context.
+    // Worker threads record into secondary command buffers, each with a recorder of its own,
+    // which are executed by the main command buffer in the order given to ExecuteCommandRecorders.
+    struct CommandRecorder
+    {
+        DrawState                       m_DrawState;
+        VkCommandBuffer                 m_CommandBuffer;
+        ScratchBuffer*                  m_ScratchBuffer;
+        // Worker thread recorders only
+        VkCommandPool                   m_CommandPool;
+        dmArray<VkCommandBuffer>        m_CommandBuffers;       // One per swap chain image
+        dmArray<ScratchBuffer>          m_ScratchBuffers;       // One per swap chain image
+        dmArray<DescriptorAllocator>    m_DescriptorAllocators; // One per swap chain image
+        dmArray<uint8_t>                m_UniformData;
+        dmArray<uint16_t>               m_SamplerUnits;
+        PipelineCache                   m_PipelineCache;        // Pipelines used by this recorder, looked up without locking the context cache
+        RenderTarget*                   m_RenderTarget;
+        uint8_t                         m_IsRecording : 1;
+    };
+
     struct Context
     {
         Context(const ContextParams& params, const VkInstance vk_instance);
 
-        Texture*                        m_TextureUnits[DM_MAX_TEXTURE_UNITS];
         PipelineCache                   m_PipelineCache;
-        PipelineState                   m_PipelineState;
+        VkPipelineCache                 m_VkPipelineCache;              // Driver side cache, persisted to m_PipelineCachePath
+        char*                           m_PipelineCachePath;
+        uint64_t                        m_PipelineCacheVersionHash;
+        uint32_t                        m_PipelineCacheSavedCount;      // Number of pipelines in m_PipelineCache when it was last saved
         SwapChain*                      m_SwapChain;
         SwapChainCapabilities           m_SwapChainCapabilities;
         PhysicalDevice                  m_PhysicalDevice;
@@ -358,8 +426,6 @@ namespace dmGraphics
         VkInstance                      m_Instance;
         VkSurfaceKHR                    m_WindowSurface;
         dmArray<TextureSampler>         m_TextureSamplers;
-        uint32_t*                       m_DynamicOffsetBuffer;
-        uint16_t                        m_DynamicOffsetBufferSize;
         // Window callbacks
         WindowResizeCallback            m_WindowResizeCallback;
         void*                           m_WindowResizeCallbackUserData;
@@ -377,14 +443,21 @@ namespace dmGraphics
         dmArray<ScratchBuffer>          m_MainScratchBuffers;
         dmArray<DescriptorAllocator>    m_MainDescriptorAllocators;
         VkRenderPass                    m_MainRenderPass;
+        VkRenderPass                    m_MainRenderPassContinue;
         Texture                         m_MainTextureDepthStencil;
         RenderTarget                    m_MainRenderTarget;
-        Viewport                        m_MainViewport;
+        CommandRecorder                 m_MainCommandRecorder;
+        dmArray<TextureUpload>          m_TextureUploads;
+        // Timestamp queries of the gpu timers, GPU_TIMER_FRAME_LATENCY * MAX_GPU_TIMER_QUERIES * 2 of them
+        GpuTimers                       m_GpuTimers;
+        VkQueryPool                     m_GpuTimerQueryPool;
+        uint64_t                        m_GpuTimestampMask;     // The timestampValidBits of the graphics queue, 0 if it has no timestamps
+        float                           m_GpuTimestampPeriod;   // Nanoseconds per timestamp tick
+        // Command recorders of worker threads
+        dmThread::TlsKey                m_CommandRecorderKey;
+        dmMutex::HMutex                 m_CommandRecorderMutex;
         // Rendering state
         RenderTarget*                   m_CurrentRenderTarget;
-        DeviceBuffer*                   m_CurrentVertexBuffer;
-        VertexDeclaration*              m_CurrentVertexDeclaration;
-        Program*                        m_CurrentProgram;
         // Misc state
         TextureFilter                   m_DefaultTextureMinFilter;
         TextureFilter                   m_DefaultTextureMagFilter;
@@ -394,15 +467,14 @@ namespace dmGraphics
         uint32_t                        m_Height;
         uint32_t                        m_WindowWidth;
         uint32_t                        m_WindowHeight;
+        uint32_t                        m_FrameCount;
         uint32_t                        m_FrameBegun           : 1;
         uint32_t                        m_CurrentFrameInFlight : 1;
         uint32_t                        m_WindowOpened         : 1;
         uint32_t                        m_VerifyGraphicsCalls  : 1;
-        uint32_t                        m_ViewportChanged      : 1;
-        uint32_t                        m_CullFaceChanged      : 1;
         uint32_t                        m_UseValidationLayers  : 1;
         uint32_t                        m_RenderDocSupport     : 1;
-        uint32_t                                               : 24;
+        uint32_t                                               : 26;
     };
 
     // Implemented in graphics_vulkan_context.cpp
@@ -419,6 +491,7 @@ namespace dmGraphics
     VkResult CreateMainFrameBuffers(HContext context);
     VkResult DestroyMainFrameBuffers(HContext context);
     void SwapChainChanged(HContext context, uint32_t* width, uint32_t* height, VkResult (*cb)(void* ctx), void* cb_ctx);
+    void SavePipelineCache(HContext context);
 
     // Implemented in graphics_vulkan_device.cpp
     // Create functions
@@ -427,7 +500,8 @@ namespace dmGraphics
         VkImageView* vk_attachments, uint8_t attachmentCount, // Color & depth/stencil attachments
         VkFramebuffer* vk_framebuffer_out);
     VkResult DestroyFrameBuffer(VkDevice vk_device, VkFramebuffer vk_framebuffer);
-    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool,
+    VkResult CreateCommandPool(VkDevice vk_device, uint16_t queue_family_index, VkCommandPool* vk_command_pool_out);
+    VkResult CreateCommandBuffers(VkDevice vk_device, VkCommandPool vk_command_pool, VkCommandBufferLevel vk_level,
         uint32_t numBuffersToCreate, VkCommandBuffer* vk_command_buffers_out);
     VkResult CreateDescriptorPool(VkDevice vk_device, VkDescriptorPoolSize* vk_pool_sizes, uint8_t numPoolSizes,
         uint16_t maxDescriptors, VkDescriptorPool* vk_descriptor_pool_out);
@@ -450,15 +524,15 @@ namespace dmGraphics
     VkResult CreateRenderPass(VkDevice vk_device, VkSampleCountFlagBits vk_sample_flags,
         RenderPassAttachment* colorAttachments, uint8_t numColorAttachments,
         RenderPassAttachment* depthStencilAttachment,
-        RenderPassAttachment* resolveAttachment, VkRenderPass* renderPassOut);
+        RenderPassAttachment* resolveAttachment, bool continuePass, VkRenderPass* renderPassOut);
     void DestroyRenderPass(VkDevice vk_device, VkRenderPass render_pass);
     VkResult CreateDeviceBuffer(VkPhysicalDevice vk_physical_device, VkDevice vk_device,
         VkDeviceSize vk_size, VkMemoryPropertyFlags vk_memory_flags, DeviceBuffer* bufferOut);
     VkResult CreateShaderModule(VkDevice vk_device,
         const void* source, uint32_t sourceSize, ShaderModule* shaderModuleOut);
-    VkResult CreatePipeline(VkDevice vk_device, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
+    VkResult CreatePipeline(VkDevice vk_device, VkPipelineCache vk_pipeline_cache, VkRect2D vk_scissor, VkSampleCountFlagBits vk_sample_count,
         const PipelineState pipelineState, Program* program, DeviceBuffer* vertexBuffer,
-        HVertexDeclaration vertexDeclaration, RenderTarget* render_target, Pipeline* pipelineOut);
+        HVertexDeclaration vertexDeclaration, HVertexDeclaration instanceVertexDeclaration, RenderTarget* render_target, Pipeline* pipelineOut);
     // Reset functions
     void           ResetScratchBuffer(VkDevice vk_device, ScratchBuffer* scratchBuffer);
     // Destroy funcions
@@ -485,10 +559,16 @@ namespace dmGraphics
     VkResult TransitionImageLayout(VkDevice vk_device, VkCommandPool vk_command_pool, VkQueue vk_graphics_queue, VkImage vk_image,
         VkImageAspectFlags vk_image_aspect, VkImageLayout vk_from_layout, VkImageLayout vk_to_layout,
         uint32_t baseMipLevel = 0, uint32_t layer_count = 1);
+    // Records the layout transition into a command buffer, instead of submitting and waiting for it
+    void CmdTransitionImageLayout(VkCommandBuffer vk_command_buffer, VkImage vk_image,
+        VkImageAspectFlags vk_image_aspect, VkImageLayout vk_from_layout, VkImageLayout vk_to_layout,
+        uint32_t baseMipLevel, uint32_t layer_count);
     VkResult WriteToDeviceBuffer(VkDevice vk_device, VkDeviceSize size, VkDeviceSize offset, const void* data, DeviceBuffer* buffer);
 
     void DestroyPipelineCacheCb(HContext context, const uint64_t* key, Pipeline* value);
     void FlushResourcesToDestroy(VkDevice vk_device, ResourcesToDestroyList* resource_list);
+    // Releases the completed uploads of SetTextureAsync. If wait is set, waits for all uploads to complete
+    void UpdateTextureUploads(HContext context, bool wait);
 
     // Implemented in graphics_vulkan_swap_chain.cpp
     //   wantedWidth and wantedHeight might be written to, we might not get the
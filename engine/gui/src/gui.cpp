@@ -1791,7 +1791,7 @@ Result DeleteDynamicTexture(HScene scene, const dmhash_t texture_hash)
                         }
                         if (message->m_DataSize > 0)
                         {
-                            dmScript::PushTable(L, (const char*) message->m_Data, message->m_DataSize);
+                            dmScript::PushMessageTable(L, (const char*) message->m_Data, message->m_DataSize);
                         }
                         else
                         {
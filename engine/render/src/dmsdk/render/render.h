@@ -170,6 +170,10 @@ namespace dmRender
      * @member m_StencilTestParams [type: dmRender::StencilTestParams] the stencil test params
      * @member m_VertexStart [type: uint32_t] the vertex start
      * @member m_VertexCount [type: uint32_t] the vertex count
+     * @member m_VertexBufferOffset [type: uint32_t] the byte offset of the vertices in the vertex buffer, e.g. of a dmGraphics transient buffer slice
+     * @member m_InstanceVertexBuffer [type: dmGraphics::HVertexBuffer] the per-instance vertex buffer (only used if m_InstanceCount > 0)
+     * @member m_InstanceVertexDeclaration [type: dmGraphics::HVertexDeclaration] the per-instance vertex declaration
+     * @member m_InstanceCount [type: uint32_t] the number of instances to draw. If 0, the object is drawn without instancing
      * @member m_SetBlendFactors [type: uint8_t:1] use the blend factors
      * @member m_SetStencilTest [type: uint8_t:1] use the stencil test
      */
@@ -196,6 +200,10 @@ namespace dmRender
         StencilTestParams               m_StencilTestParams;
         uint32_t                        m_VertexStart;
         uint32_t                        m_VertexCount;
+        uint32_t                        m_VertexBufferOffset;
+        dmGraphics::HVertexBuffer       m_InstanceVertexBuffer;
+        dmGraphics::HVertexDeclaration  m_InstanceVertexDeclaration;
+        uint32_t                        m_InstanceCount;
         uint8_t                         m_SetBlendFactors : 1;
         uint8_t                         m_SetStencilTest : 1;
         uint8_t                         m_SetFaceWinding : 1;
@@ -112,9 +112,12 @@ namespace dmRender
 
         debug_renderer.m_3dPredicate.m_Tags[0] = dmHashString64(DEBUG_3D_NAME);
         debug_renderer.m_3dPredicate.m_TagCount = 1;
+        debug_renderer.m_3dPredicate.m_TagsHash = dmHashBuffer64(debug_renderer.m_3dPredicate.m_Tags, sizeof(dmhash_t));
         debug_renderer.m_2dPredicate.m_Tags[0] = dmHashString64(DEBUG_2D_NAME);
         debug_renderer.m_2dPredicate.m_TagCount = 1;
+        debug_renderer.m_2dPredicate.m_TagsHash = dmHashBuffer64(debug_renderer.m_2dPredicate.m_Tags, sizeof(dmhash_t));
         debug_renderer.m_RenderBatchVersion = 0;
+        debug_renderer.m_FlushedVertexCount = 0xFFFFFFFF;
     }
 
     void FinalizeDebugRenderer(HRenderContext context)
@@ -152,6 +155,7 @@ namespace dmRender
             context->m_DebugRenderer.m_TypeData[i].m_RenderObject.m_VertexCount = 0;
         }
         context->m_DebugRenderer.m_RenderBatchVersion = 0;
+        context->m_DebugRenderer.m_FlushedVertexCount = 0xFFFFFFFF;
     }
 
     static void LogVertexWarning(HRenderContext context)
@@ -289,6 +293,17 @@ namespace dmRender
         DebugRenderer& debug_renderer = render_context->m_DebugRenderer;
         uint32_t total_vertex_count = 0;
         uint32_t total_render_objects = 0;
+        for (uint32_t i = 0; i < MAX_DEBUG_RENDER_TYPE_COUNT; ++i)
+        {
+            total_vertex_count += debug_renderer.m_TypeData[i].m_RenderObject.m_VertexCount;
+        }
+
+        // The vertices are only ever appended until cleared, so the entries from the last flush are still valid
+        if (total_vertex_count == debug_renderer.m_FlushedVertexCount)
+            return;
+        debug_renderer.m_FlushedVertexCount = total_vertex_count;
+
+        total_vertex_count = 0;
         dmGraphics::SetVertexBufferData(debug_renderer.m_VertexBuffer, 0, 0, dmGraphics::BUFFER_USAGE_STREAM_DRAW);
         for (uint32_t i = 0; i < MAX_DEBUG_RENDER_TYPE_COUNT; ++i)
         {
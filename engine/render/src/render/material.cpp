@@ -186,121 +186,150 @@ namespace dmRender
         delete material;
     }
 
-    void ApplyMaterialConstants(dmRender::HRenderContext render_context, HMaterial material, const RenderObject* ro)
+    // Constants that depend on the render object, and not only on the material and the render context
+    static inline bool IsObjectConstant(dmRenderDDF::MaterialDesc::ConstantType type)
     {
-        const dmArray<MaterialConstant>& constants = material->m_Constants;
-        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
-        uint32_t n = constants.Size();
-        for (uint32_t i = 0; i < n; ++i)
-        {
-            const MaterialConstant& material_constant = constants[i];
-            const HConstant constant = material_constant.m_Constant;
-            int32_t location = GetConstantLocation(constant);
-            dmRenderDDF::MaterialDesc::ConstantType type = GetConstantType(constant);
+        return type == dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLD ||
+               type == dmRenderDDF::MaterialDesc::CONSTANT_TYPE_TEXTURE ||
+               type == dmRenderDDF::MaterialDesc::CONSTANT_TYPE_NORMAL ||
+               type == dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEW ||
+               type == dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEWPROJ;
+    }
 
-            switch (type)
+    static void ApplyMaterialConstant(dmRender::HRenderContext render_context, dmGraphics::HContext graphics_context, const HConstant constant, dmRenderDDF::MaterialDesc::ConstantType type, const RenderObject* ro)
+    {
+        int32_t location = GetConstantLocation(constant);
+
+        switch (type)
+        {
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_USER:
             {
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_USER:
-                {
-                    uint32_t num_values;
-                    dmVMath::Vector4* values = GetConstantValues(constant, &num_values);
-                    dmGraphics::SetConstantV4(graphics_context, values, num_values, location);
-                    break;
-                }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_USER_MATRIX4:
-                {
-                    uint32_t num_values;
-                    dmVMath::Vector4* values = GetConstantValues(constant, &num_values);
-                    dmGraphics::SetConstantM4(graphics_context, values, num_values / 4, location);
-                    break;
-                }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEWPROJ:
+                uint32_t num_values;
+                dmVMath::Vector4* values = GetConstantValues(constant, &num_values);
+                dmGraphics::SetConstantV4(graphics_context, values, num_values, location);
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_USER_MATRIX4:
+            {
+                uint32_t num_values;
+                dmVMath::Vector4* values = GetConstantValues(constant, &num_values);
+                dmGraphics::SetConstantM4(graphics_context, values, num_values / 4, location);
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEWPROJ:
+            {
+                if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
                 {
-                    if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
-                    {
-                        Matrix4 ndc_matrix = Matrix4::identity();
-                        ndc_matrix.setElem(2, 2, 0.5f );
-                        ndc_matrix.setElem(3, 2, 0.5f );
-                        const Matrix4 view_projection = ndc_matrix * render_context->m_ViewProj;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&view_projection, 1, location);
-                    }
-                    else
-                    {
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_ViewProj, 1, location);
-                    }
-                    break;
+                    Matrix4 ndc_matrix = Matrix4::identity();
+                    ndc_matrix.setElem(2, 2, 0.5f );
+                    ndc_matrix.setElem(3, 2, 0.5f );
+                    const Matrix4 view_projection = ndc_matrix * render_context->m_ViewProj;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&view_projection, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLD:
+                else
                 {
-                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&ro->m_WorldTransform, 1, location);
-                    break;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_ViewProj, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_TEXTURE:
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLD:
+            {
+                dmGraphics::SetConstantM4(graphics_context, (Vector4*)&ro->m_WorldTransform, 1, location);
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_TEXTURE:
+            {
+                dmGraphics::SetConstantM4(graphics_context, (Vector4*)&ro->m_TextureTransform, 1, location);
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEW:
+            {
+                dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_View, 1, location);
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_PROJECTION:
+            {
+                // Vulkan NDC is [0..1] for z, so we must transform
+                // the projection before setting the constant.
+                if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
                 {
-                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&ro->m_TextureTransform, 1, location);
-                    break;
+                    Matrix4 ndc_matrix = Matrix4::identity();
+                    ndc_matrix.setElem(2, 2, 0.5f );
+                    ndc_matrix.setElem(3, 2, 0.5f );
+                    const Matrix4 proj = ndc_matrix * render_context->m_Projection;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&proj, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_VIEW:
+                else
                 {
-                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_View, 1, location);
-                    break;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_Projection, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_PROJECTION:
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_NORMAL:
+            {
                 {
-                    // Vulkan NDC is [0..1] for z, so we must transform
-                    // the projection before setting the constant.
-                    if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
-                    {
-                        Matrix4 ndc_matrix = Matrix4::identity();
-                        ndc_matrix.setElem(2, 2, 0.5f );
-                        ndc_matrix.setElem(3, 2, 0.5f );
-                        const Matrix4 proj = ndc_matrix * render_context->m_Projection;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&proj, 1, location);
-                    }
-                    else
-                    {
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&render_context->m_Projection, 1, location);
-                    }
-                    break;
+                    // normalT = transp(inv(view * world))
+                    Matrix4 normalT = render_context->m_View * ro->m_WorldTransform;
+                    // The world transform might include non-uniform scaling, which breaks the orthogonality of the combined model-view transform
+                    // It is always affine however
+                    normalT = affineInverse(normalT);
+                    normalT = transpose(normalT);
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&normalT, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_NORMAL:
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEW:
+            {
                 {
-                    {
-                        // normalT = transp(inv(view * world))
-                        Matrix4 normalT = render_context->m_View * ro->m_WorldTransform;
-                        // The world transform might include non-uniform scaling, which breaks the orthogonality of the combined model-view transform
-                        // It is always affine however
-                        normalT = affineInverse(normalT);
-                        normalT = transpose(normalT);
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&normalT, 1, location);
-                    }
-                    break;
+                    Matrix4 world_view = render_context->m_View * ro->m_WorldTransform;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEW:
+                break;
+            }
+            case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEWPROJ:
+            {
+                if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
                 {
-                    {
-                        Matrix4 world_view = render_context->m_View * ro->m_WorldTransform;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view, 1, location);
-                    }
-                    break;
+                    Matrix4 ndc_matrix = Matrix4::identity();
+                    ndc_matrix.setElem(2, 2, 0.5f );
+                    ndc_matrix.setElem(3, 2, 0.5f );
+                    const Matrix4 world_view_projection = ndc_matrix * render_context->m_ViewProj * ro->m_WorldTransform;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, 1, location);
                 }
-                case dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLDVIEWPROJ:
+                else
                 {
-                    if (dmGraphics::GetShaderProgramLanguage(graphics_context) == dmGraphics::ShaderDesc::LANGUAGE_SPIRV)
-                    {
-                        Matrix4 ndc_matrix = Matrix4::identity();
-                        ndc_matrix.setElem(2, 2, 0.5f );
-                        ndc_matrix.setElem(3, 2, 0.5f );
-                        const Matrix4 world_view_projection = ndc_matrix * render_context->m_ViewProj * ro->m_WorldTransform;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, 1, location);
-                    }
-                    else
-                    {
-                        const Matrix4 world_view_projection = render_context->m_ViewProj * ro->m_WorldTransform;
-                        dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, 1, location);
-                    }
-                    break;
+                    const Matrix4 world_view_projection = render_context->m_ViewProj * ro->m_WorldTransform;
+                    dmGraphics::SetConstantM4(graphics_context, (Vector4*)&world_view_projection, 1, location);
                 }
+                break;
+            }
+        }
+    }
+
+    void ApplyMaterialConstants(dmRender::HRenderContext render_context, HMaterial material, const RenderObject* ro)
+    {
+        const dmArray<MaterialConstant>& constants = material->m_Constants;
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        uint32_t n = constants.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const HConstant constant = constants[i].m_Constant;
+            ApplyMaterialConstant(render_context, graphics_context, constant, GetConstantType(constant), ro);
+        }
+    }
+
+    void ApplyMaterialObjectConstants(dmRender::HRenderContext render_context, HMaterial material, const RenderObject* ro)
+    {
+        const dmArray<MaterialConstant>& constants = material->m_Constants;
+        dmGraphics::HContext graphics_context = dmRender::GetGraphicsContext(render_context);
+        uint32_t n = constants.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const HConstant constant = constants[i].m_Constant;
+            dmRenderDDF::MaterialDesc::ConstantType type = GetConstantType(constant);
+            if (IsObjectConstant(type))
+            {
+                ApplyMaterialConstant(render_context, graphics_context, constant, type, ro);
             }
         }
     }
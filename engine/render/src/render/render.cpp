@@ -32,6 +32,10 @@
 #include "font_renderer.h"
 
 DM_PROPERTY_GROUP(rmtp_Render, "Renderer");
+DM_PROPERTY_U32(rmtp_RenderStateIssued, 0, FrameReset, "# state changes issued by Draw", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_RenderStateSkipped, 0, FrameReset, "# redundant state changes skipped by Draw", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_RenderListDispatchReused, 0, FrameReset, "# render list draws reusing the previous dispatch", &rmtp_Render);
+DM_PROPERTY_U32(rmtp_RenderGpuDrawTime, 0, NoFlags, "gpu time of render.draw() calls in a recent frame (us)", &rmtp_Render);
 
 namespace dmRender
 {
@@ -132,6 +136,10 @@ namespace dmRender
 
         context->m_StencilBufferCleared = 0;
 
+        context->m_DispatchCacheValid = 0;
+
+        context->m_GpuTimedPredicateCount = 0;
+
         context->m_RenderListDispatch.SetCapacity(255);
 
         dmMessage::Result r = dmMessage::NewSocket(RENDER_SOCKET_NAME, &context->m_Socket);
@@ -157,13 +165,54 @@ namespace dmRender
         return render_context->m_ScriptContext;
     }
 
+    uint32_t GetPredicateGpuTimer(HRenderContext context, HPredicate predicate)
+    {
+        // A draw without a predicate is timed as a predicate without tags
+        uint32_t tag_count = predicate ? predicate->m_TagCount : 0;
+        dmhash_t tags_hash = tag_count > 0 ? predicate->m_TagsHash : 0;
+        for (uint32_t i = 0; i < context->m_GpuTimedPredicateCount; ++i)
+        {
+            if (context->m_GpuTimedPredicates[i] == tags_hash)
+            {
+                return dmGraphics::GPU_TIMER_USER + i;
+            }
+        }
+        if (context->m_GpuTimedPredicateCount == MAX_GPU_TIMED_PREDICATES)
+        {
+            return dmGraphics::MAX_GPU_TIMERS;
+        }
+        context->m_GpuTimedPredicates[context->m_GpuTimedPredicateCount] = tags_hash;
+        context->m_GpuTimedPredicateNames[context->m_GpuTimedPredicateCount] = tag_count > 0 ? predicate->m_Tags[0] : 0;
+        return dmGraphics::GPU_TIMER_USER + context->m_GpuTimedPredicateCount++;
+    }
+
+    static void ProfileGpuTimers(HRenderContext render_context)
+    {
+        uint64_t total_time = 0;
+        for (uint32_t i = 0; i < render_context->m_GpuTimedPredicateCount; ++i)
+        {
+            uint64_t time;
+            if (!dmGraphics::GetGpuTimerResult(render_context->m_GraphicsContext, dmGraphics::GPU_TIMER_USER + i, &time))
+            {
+                return;
+            }
+            total_time += time;
+            DM_PROFILE_TEXT("gpu draw %s: %u us", dmHashReverseSafe64(render_context->m_GpuTimedPredicateNames[i]), (uint32_t) (time / 1000));
+        }
+        DM_PROPERTY_SET_U32(rmtp_RenderGpuDrawTime, (uint32_t) (total_time / 1000));
+    }
+
     void RenderListBegin(HRenderContext render_context)
     {
+        ProfileGpuTimers(render_context);
+
         render_context->m_RenderList.SetSize(0);
         render_context->m_RenderListSortIndices.SetSize(0);
         render_context->m_RenderListDispatch.SetSize(0);
         render_context->m_RenderListRanges.SetSize(0);
         render_context->m_FrustumHash = 0xFFFFFFFF; // trigger a first recalculation each frame
+        render_context->m_DispatchCacheValid = 0;
+        render_context->m_DebugRenderer.m_FlushedVertexCount = 0xFFFFFFFF;
     }
 
     HRenderListDispatch RenderListMakeDispatch(HRenderContext render_context, RenderListDispatchFn dispatch_fn, RenderListVisibilityFn visibility_fn, void* user_data)
@@ -209,6 +258,7 @@ namespace dmRender
 
         // If we push new items after the last frustum culling, we need to reevaluate it
         render_context->m_FrustumHash = 0xFFFFFFFF;
+        render_context->m_DispatchCacheValid = 0;
 
         return (render_list.Begin() + size);
     }
@@ -310,6 +360,7 @@ namespace dmRender
     Result ClearRenderObjects(HRenderContext context)
     {
         context->m_RenderObjects.SetSize(0);
+        context->m_DispatchCacheValid = 0;
         ClearDebugRenderObjects(context);
 
         // Should probably be moved and/or refactored, see case 2261
@@ -660,6 +711,18 @@ namespace dmRender
         }
     }
 
+    static dmhash_t GetDispatchCacheKey(HRenderContext context, HPredicate predicate, dmhash_t frustum_hash)
+    {
+        HashState64 state;
+        dmHashInit64(&state, false);
+        if (predicate)
+            dmHashUpdateBuffer64(&state, predicate->m_Tags, predicate->m_TagCount * sizeof(dmhash_t));
+        dmHashUpdateBuffer64(&state, &frustum_hash, sizeof(frustum_hash));
+        // The view projection decides the sort order of the world entries
+        dmHashUpdateBuffer64(&state, &context->m_ViewProj, sizeof(context->m_ViewProj));
+        return dmHashFinal64(&state);
+    }
+
     Result DrawRenderList(HRenderContext context, HPredicate predicate, HNamedConstantBuffer constant_buffer, const dmVMath::Matrix4* frustum_matrix)
     {
         DM_PROFILE("DrawRenderList");
@@ -676,6 +739,17 @@ namespace dmRender
         }
 
         dmhash_t frustum_hash = frustum_matrix ? dmHashBuffer64((const void*)frustum_matrix, 16*sizeof(float)) : 0;
+
+        // Drawing the same predicate and frustum again (e.g. into another render target) reuses the render objects
+        // of the previous draw. Only the last dispatch can be reused, since the components reuse their vertex
+        // buffers and render objects for each dispatch.
+        dmhash_t dispatch_key = GetDispatchCacheKey(context, predicate, frustum_hash);
+        if (context->m_DispatchCacheValid && context->m_DispatchCacheKey == dispatch_key)
+        {
+            DM_PROPERTY_ADD_U32(rmtp_RenderListDispatchReused, 1);
+            return Draw(context, predicate, constant_buffer);
+        }
+
         if (context->m_FrustumHash != frustum_hash)
         {
             // We use this to avoid calling the culling functions more than once in a row
@@ -696,6 +770,9 @@ namespace dmRender
 
         MakeSortBuffer(context, predicate?predicate->m_TagCount:0, predicate?predicate->m_Tags:0);
 
+        // The render objects are rebuilt below (or left as is if there's nothing to draw)
+        context->m_DispatchCacheValid = 0;
+
         if (context->m_RenderListSortBuffer.Empty())
             return RESULT_OK;
 
@@ -765,11 +842,31 @@ namespace dmRender
             d.m_DispatchFn(params);
         }
 
+        context->m_DispatchCacheKey = dispatch_key;
+        context->m_DispatchCacheValid = 1;
+
         return Draw(context, predicate, constant_buffer);
     }
 
     // NOTE: Currently only used externally in 1 test (fontview.cpp)
     // TODO: Replace that occurrance with DrawRenderList
+    struct DrawState
+    {
+        Matrix4                         m_WorldTransform;
+        Matrix4                         m_TextureTransform;
+        HMaterial                       m_Material;
+        HNamedConstantBuffer            m_ConstantBuffer;
+        dmGraphics::HTexture            m_Textures[RenderObject::MAX_TEXTURE_COUNT];
+        dmGraphics::HVertexDeclaration  m_VertexDeclaration;
+        dmGraphics::HVertexBuffer       m_VertexBuffer;
+        uint32_t                        m_VertexBufferOffset;
+    };
+
+    static inline bool IsEqual(const Matrix4& a, const Matrix4& b)
+    {
+        return memcmp(&a, &b, sizeof(Matrix4)) == 0;
+    }
+
     Result Draw(HRenderContext render_context, HPredicate predicate, HNamedConstantBuffer constant_buffer)
     {
         if (render_context == 0x0)
@@ -787,6 +884,17 @@ namespace dmRender
 
         dmGraphics::PipelineState ps_orig = dmGraphics::GetPipelineState(context);
 
+        // The state bound by the previous render object in this call, used to skip redundant state changes
+        DrawState state;
+        state.m_Material = 0;
+        state.m_ConstantBuffer = 0;
+        state.m_VertexDeclaration = 0;
+        state.m_VertexBuffer = 0;
+        state.m_VertexBufferOffset = 0;
+        memset(state.m_Textures, 0, sizeof(state.m_Textures));
+        uint32_t issued = 0;
+        uint32_t skipped = 0;
+
         for (uint32_t i = 0; i < render_context->m_RenderObjects.Size(); ++i)
         {
             RenderObject* ro = render_context->m_RenderObjects[i];
@@ -811,13 +919,40 @@ namespace dmRender
                 }
             }
 
-            ApplyMaterialConstants(render_context, material, ro);
+            // Material constants only depend on the material, unless they were overridden by a constant buffer
+            if (material != state.m_Material || ro->m_ConstantBuffer != state.m_ConstantBuffer)
+            {
+                ApplyMaterialConstants(render_context, material, ro);
 
-            if (ro->m_ConstantBuffer) // from components/scripts
-                ApplyNamedConstantBuffer(render_context, material, ro->m_ConstantBuffer);
+                if (ro->m_ConstantBuffer) // from components/scripts
+                    ApplyNamedConstantBuffer(render_context, material, ro->m_ConstantBuffer);
 
-            if (constant_buffer) // from render script
-                ApplyNamedConstantBuffer(render_context, material, constant_buffer);
+                if (constant_buffer) // from render script
+                    ApplyNamedConstantBuffer(render_context, material, constant_buffer);
+
+                state.m_WorldTransform = ro->m_WorldTransform;
+                state.m_TextureTransform = ro->m_TextureTransform;
+                issued++;
+            }
+            else if (!IsEqual(state.m_WorldTransform, ro->m_WorldTransform) || !IsEqual(state.m_TextureTransform, ro->m_TextureTransform))
+            {
+                ApplyMaterialObjectConstants(render_context, material, ro);
+
+                // The constant buffers are applied last, and might override the object constants
+                if (ro->m_ConstantBuffer)
+                    ApplyNamedConstantBuffer(render_context, material, ro->m_ConstantBuffer);
+
+                if (constant_buffer)
+                    ApplyNamedConstantBuffer(render_context, material, constant_buffer);
+
+                state.m_WorldTransform = ro->m_WorldTransform;
+                state.m_TextureTransform = ro->m_TextureTransform;
+                issued++;
+            }
+            else
+            {
+                skipped++;
+            }
 
             ApplyRenderState(render_context, render_context->m_GraphicsContext, ps_orig, ro);
 
@@ -826,32 +961,75 @@ namespace dmRender
                 dmGraphics::HTexture texture = ro->m_Textures[i];
                 if (render_context->m_Textures[i])
                     texture = render_context->m_Textures[i];
+
+                // The texture is bound with the sampler settings of the material
+                if (texture == state.m_Textures[i] && (texture == 0 || material == state.m_Material))
+                {
+                    if (texture)
+                        skipped++;
+                    continue;
+                }
+
                 if (texture)
                 {
                     dmGraphics::EnableTexture(context, i, texture);
                     ApplyMaterialSampler(render_context, material, i, texture);
                 }
+                else
+                {
+                    dmGraphics::DisableTexture(context, i, state.m_Textures[i]);
+                }
+                state.m_Textures[i] = texture;
+                issued++;
+            }
+
+            if (ro->m_VertexDeclaration != state.m_VertexDeclaration || ro->m_VertexBuffer != state.m_VertexBuffer ||
+                ro->m_VertexBufferOffset != state.m_VertexBufferOffset || material != state.m_Material)
+            {
+                if (state.m_VertexDeclaration)
+                    dmGraphics::DisableVertexDeclaration(context, state.m_VertexDeclaration);
+                dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclaration, ro->m_VertexBuffer, ro->m_VertexBufferOffset, GetMaterialProgram(material));
+                state.m_VertexDeclaration = ro->m_VertexDeclaration;
+                state.m_VertexBuffer = ro->m_VertexBuffer;
+                state.m_VertexBufferOffset = ro->m_VertexBufferOffset;
+                issued++;
+            }
+            else
+            {
+                skipped++;
             }
 
-            dmGraphics::EnableVertexDeclaration(context, ro->m_VertexDeclaration, ro->m_VertexBuffer, GetMaterialProgram(material));
+            state.m_Material = material;
+            state.m_ConstantBuffer = ro->m_ConstantBuffer;
 
-            if (ro->m_IndexBuffer)
+            if (ro->m_InstanceCount > 0)
+            {
+                // The instance streams are rarely shared between render objects, so they're always rebound
+                dmGraphics::EnableInstanceVertexDeclaration(context, ro->m_InstanceVertexDeclaration, ro->m_InstanceVertexBuffer, GetMaterialProgram(material));
+                if (ro->m_IndexBuffer)
+                    dmGraphics::DrawElementsInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount, ro->m_IndexType, ro->m_IndexBuffer);
+                else
+                    dmGraphics::DrawInstanced(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_InstanceCount);
+                dmGraphics::DisableInstanceVertexDeclaration(context, ro->m_InstanceVertexDeclaration);
+            }
+            else if (ro->m_IndexBuffer)
                 dmGraphics::DrawElements(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount, ro->m_IndexType, ro->m_IndexBuffer);
             else
                 dmGraphics::Draw(context, ro->m_PrimitiveType, ro->m_VertexStart, ro->m_VertexCount);
+        }
 
-            dmGraphics::DisableVertexDeclaration(context, ro->m_VertexDeclaration);
+        if (state.m_VertexDeclaration)
+            dmGraphics::DisableVertexDeclaration(context, state.m_VertexDeclaration);
 
-            for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
-            {
-                dmGraphics::HTexture texture = ro->m_Textures[i];
-                if (render_context->m_Textures[i])
-                    texture = render_context->m_Textures[i];
-                if (texture)
-                    dmGraphics::DisableTexture(context, i, texture);
-            }
+        for (uint32_t i = 0; i < RenderObject::MAX_TEXTURE_COUNT; ++i)
+        {
+            if (state.m_Textures[i])
+                dmGraphics::DisableTexture(context, i, state.m_Textures[i]);
         }
 
+        DM_PROPERTY_ADD_U32(rmtp_RenderStateIssued, issued);
+        DM_PROPERTY_ADD_U32(rmtp_RenderStateSkipped, skipped);
+
         ResetRenderStateIfChanged(context, ps_orig, dmGraphics::GetPipelineState(context));
 
         return RESULT_OK;
@@ -892,6 +1070,7 @@ namespace dmRender
         }
         predicate->m_Tags[predicate->m_TagCount++] = tag;
         std::sort(predicate->m_Tags, predicate->m_Tags+predicate->m_TagCount);
+        predicate->m_TagsHash = dmHashBuffer64(predicate->m_Tags, predicate->m_TagCount * sizeof(dmhash_t));
         return RESULT_OK;
     }
 }
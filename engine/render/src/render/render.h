@@ -69,6 +69,7 @@ namespace dmRender
         static const uint32_t MAX_TAG_COUNT = 32;
         dmhash_t m_Tags[MAX_TAG_COUNT];
         uint32_t m_TagCount;
+        dmhash_t m_TagsHash; // Hash of the sorted tags, updated by AddPredicateTag
     };
 
     struct Constant
@@ -199,6 +200,7 @@ namespace dmRender
     HMaterial                       NewMaterial(dmRender::HRenderContext render_context, dmGraphics::HVertexProgram vertex_program, dmGraphics::HFragmentProgram fragment_program);
     void                            DeleteMaterial(dmRender::HRenderContext render_context, HMaterial material);
     void                            ApplyMaterialConstants(dmRender::HRenderContext render_context, HMaterial material, const RenderObject* ro);
+    void                            ApplyMaterialObjectConstants(dmRender::HRenderContext render_context, HMaterial material, const RenderObject* ro);
     void                            ApplyMaterialSampler(dmRender::HRenderContext render_context, HMaterial material, uint32_t unit, dmGraphics::HTexture texture);
 
     dmGraphics::HProgram            GetMaterialProgram(HMaterial material);
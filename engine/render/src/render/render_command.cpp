@@ -55,13 +55,16 @@ namespace dmRender
         m_Operands[3] = op3;
     }
 
-    void ParseCommands(dmRender::HRenderContext render_context, Command* commands, uint32_t command_count)
+    static void ExecuteCommands(dmRender::HRenderContext render_context, const Command* commands, uint32_t command_count, const CommandListExecution* execution)
     {
         dmGraphics::HContext context = dmRender::GetGraphicsContext(render_context);
+        // The gpu timers are only used while profiling
+        bool gpu_timers = dmGraphics::IsGpuTimerEnabled();
+        bool render_target_timer = false;
 
         for (uint32_t i=0; i<command_count; i++)
         {
-            Command* c = &commands[i];
+            const Command* c = &commands[i];
             switch (c->m_Type)
             {
                 case COMMAND_TYPE_ENABLE_STATE:
@@ -76,7 +79,18 @@ namespace dmRender
                 }
                 case COMMAND_TYPE_SET_RENDER_TARGET:
                 {
-                    dmGraphics::SetRenderTarget(context, (dmGraphics::HRenderTarget)c->m_Operands[0], c->m_Operands[1] );
+                    dmGraphics::HRenderTarget render_target = (dmGraphics::HRenderTarget)c->m_Operands[0];
+                    if (render_target_timer && render_target == 0)
+                    {
+                        dmGraphics::EndGpuTimer(context, dmGraphics::GPU_TIMER_RENDER_TARGET);
+                        render_target_timer = false;
+                    }
+                    dmGraphics::SetRenderTarget(context, render_target, c->m_Operands[1] );
+                    if (gpu_timers && !render_target_timer && render_target != 0)
+                    {
+                        dmGraphics::BeginGpuTimer(context, dmGraphics::GPU_TIMER_RENDER_TARGET);
+                        render_target_timer = true;
+                    }
                     break;
                 }
                 case COMMAND_TYPE_ENABLE_TEXTURE:
@@ -109,16 +123,18 @@ namespace dmRender
                 }
                 case COMMAND_TYPE_SET_VIEW:
                 {
-                    dmVMath::Matrix4* matrix = (dmVMath::Matrix4*)c->m_Operands[0];
+                    const dmVMath::Matrix4* matrix = (const dmVMath::Matrix4*)c->m_Operands[0];
+                    if (execution && execution->m_PatchView)
+                        matrix = &execution->m_View;
                     dmRender::SetViewMatrix(render_context, *matrix);
-                    delete matrix;
                     break;
                 }
                 case COMMAND_TYPE_SET_PROJECTION:
                 {
-                    dmVMath::Matrix4* matrix = (dmVMath::Matrix4*)c->m_Operands[0];
+                    const dmVMath::Matrix4* matrix = (const dmVMath::Matrix4*)c->m_Operands[0];
+                    if (execution && execution->m_PatchProjection)
+                        matrix = &execution->m_Projection;
                     dmRender::SetProjectionMatrix(render_context, *matrix);
-                    delete matrix;
                     break;
                 }
                 case COMMAND_TYPE_SET_BLEND_FUNC:
@@ -168,18 +184,26 @@ namespace dmRender
                 }
                 case COMMAND_TYPE_DRAW:
                 {
-                    dmVMath::Matrix4* matrix = (dmVMath::Matrix4*)c->m_Operands[2];
-                    dmRender::DrawRenderList(render_context, (dmRender::Predicate*)c->m_Operands[0],
+                    const dmVMath::Matrix4* matrix = (const dmVMath::Matrix4*)c->m_Operands[2];
+                    if (matrix && execution && execution->m_PatchFrustum)
+                        matrix = &execution->m_Frustum;
+                    dmRender::Predicate* predicate = (dmRender::Predicate*)c->m_Operands[0];
+                    uint32_t gpu_timer = gpu_timers ? dmRender::GetPredicateGpuTimer(render_context, predicate) : dmGraphics::MAX_GPU_TIMERS;
+                    if (gpu_timers)
+                        dmGraphics::BeginGpuTimer(context, gpu_timer);
+                    dmRender::DrawRenderList(render_context, predicate,
                                                              (dmRender::HNamedConstantBuffer)c->m_Operands[1],
                                                              matrix);
-                    delete matrix;
+                    if (gpu_timers)
+                        dmGraphics::EndGpuTimer(context, gpu_timer);
                     break;
                 }
                 case COMMAND_TYPE_DRAW_DEBUG3D:
                 {
-                    dmVMath::Matrix4* matrix = (dmVMath::Matrix4*)c->m_Operands[0];
+                    const dmVMath::Matrix4* matrix = (const dmVMath::Matrix4*)c->m_Operands[0];
+                    if (matrix && execution && execution->m_PatchFrustum)
+                        matrix = &execution->m_Frustum;
                     dmRender::DrawDebug3d(render_context, matrix);
-                    delete matrix;
                     break;
                 }
                 case COMMAND_TYPE_DRAW_DEBUG2D:
@@ -197,12 +221,52 @@ namespace dmRender
                     render_context->m_Material = 0;
                     break;
                 }
+                case COMMAND_TYPE_EXECUTE_COMMANDS:
+                {
+                    const CommandListExecution* list = (const CommandListExecution*)c->m_Operands[0];
+                    ExecuteCommands(render_context, list->m_Commands, list->m_CommandCount, list);
+                    break;
+                }
                 default:
                 {
                     dmLogError("No such render command (%d).", c->m_Type);
                 }
             }
         }
+
+        if (render_target_timer)
+        {
+            dmGraphics::EndGpuTimer(context, dmGraphics::GPU_TIMER_RENDER_TARGET);
+        }
     }
 
+    void ParseCommands(dmRender::HRenderContext render_context, Command* commands, uint32_t command_count)
+    {
+        ExecuteCommands(render_context, commands, command_count, 0);
+        FreeCommandOperands(commands, command_count);
+    }
+
+    void FreeCommandOperands(Command* commands, uint32_t command_count)
+    {
+        for (uint32_t i=0; i<command_count; i++)
+        {
+            Command* c = &commands[i];
+            switch (c->m_Type)
+            {
+                case COMMAND_TYPE_SET_VIEW:
+                case COMMAND_TYPE_SET_PROJECTION:
+                case COMMAND_TYPE_DRAW_DEBUG3D:
+                    delete (dmVMath::Matrix4*)c->m_Operands[0];
+                    break;
+                case COMMAND_TYPE_DRAW:
+                    delete (dmVMath::Matrix4*)c->m_Operands[2];
+                    break;
+                case COMMAND_TYPE_EXECUTE_COMMANDS:
+                    delete (CommandListExecution*)c->m_Operands[0];
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
 }
@@ -46,6 +46,7 @@ namespace dmRender
         COMMAND_TYPE_DRAW_DEBUG2D,
         COMMAND_TYPE_ENABLE_MATERIAL,
         COMMAND_TYPE_DISABLE_MATERIAL,
+        COMMAND_TYPE_EXECUTE_COMMANDS,
         COMMAND_TYPE_MAX
     };
 
@@ -61,7 +62,25 @@ namespace dmRender
         uintptr_t   m_Operands[4];
     };
 
+    // Executes a list of commands recorded with render.begin_commands()/render.end_commands().
+    // The recorded commands are left untouched, so that the list can be executed again next frame.
+    // The view, projection and frustum matrices of the recorded commands may be replaced for this execution only.
+    struct CommandListExecution
+    {
+        const Command*      m_Commands;
+        uint32_t            m_CommandCount;
+        dmVMath::Matrix4    m_View;
+        dmVMath::Matrix4    m_Projection;
+        dmVMath::Matrix4    m_Frustum;
+        uint8_t             m_PatchView : 1;
+        uint8_t             m_PatchProjection : 1;
+        uint8_t             m_PatchFrustum : 1;
+    };
+
+    // Executes the commands and frees the operands owned by them
     void ParseCommands(dmRender::HRenderContext render_context, Command* commands, uint32_t command_count);
+    // Frees the operands owned by the commands (matrices and command list executions)
+    void FreeCommandOperands(Command* commands, uint32_t command_count);
 }
 
 #endif /* RENDER_COMMANDS_H_ */
@@ -115,6 +115,7 @@ namespace dmRender
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         uint32_t                        m_MaxVertexCount;
         uint32_t                        m_RenderBatchVersion;
+        uint32_t                        m_FlushedVertexCount;   // The vertex count at the last flush, or ~0 if the render list was reset since
     };
 
     const int MAX_TEXT_RENDER_CONSTANTS = 16;
@@ -216,6 +217,9 @@ namespace dmRender
         dmhash_t m_Tags[MAX_MATERIAL_TAG_COUNT];
     };
 
+    // Draw predicates that are timed on the gpu, each with its own gpu timer from dmGraphics::GPU_TIMER_USER
+    const static uint32_t MAX_GPU_TIMED_PREDICATES = dmGraphics::MAX_GPU_TIMERS - dmGraphics::GPU_TIMER_USER;
+
     struct RenderContext
     {
         dmGraphics::HTexture        m_Textures[RenderObject::MAX_TEXTURE_COUNT];
@@ -233,6 +237,7 @@ namespace dmRender
         dmArray<uint32_t>           m_RenderListSortIndices;
         dmArray<RenderListRange>    m_RenderListRanges;         // Maps tagmask to a range in the (sorted) render list
         dmhash_t                    m_FrustumHash;
+        dmhash_t                    m_DispatchCacheKey;         // The predicate, frustum and view projection of the last dispatched render list
 
         dmHashTable32<MaterialTagList>  m_MaterialTagLists;
 
@@ -248,8 +253,13 @@ namespace dmRender
 
         dmMessage::HSocket          m_Socket;
 
+        dmhash_t                    m_GpuTimedPredicates[MAX_GPU_TIMED_PREDICATES]; // Hash of the predicate tags
+        dmhash_t                    m_GpuTimedPredicateNames[MAX_GPU_TIMED_PREDICATES]; // First tag of the predicate
+        uint32_t                    m_GpuTimedPredicateCount;
+
         uint32_t                    m_OutOfResources : 1;
         uint32_t                    m_StencilBufferCleared : 1;
+        uint32_t                    m_DispatchCacheValid : 1;   // If the render objects are still those of the last dispatched render list
     };
 
     void RenderTypeTextBegin(HRenderContext rendercontext, void* user_context);
@@ -260,6 +270,9 @@ namespace dmRender
 
     Result GenerateKey(HRenderContext render_context, const Matrix4& view_matrix);
 
+    // Returns the gpu timer of the draw predicate, or dmGraphics::MAX_GPU_TIMERS if all timers are taken
+    uint32_t                        GetPredicateGpuTimer(HRenderContext context, HPredicate predicate);
+
     // Return true if the predicate tags all exist in the material tag list
     bool                            MatchMaterialTags(uint32_t material_tag_count, const dmhash_t* material_tags, uint32_t tag_count, const dmhash_t* tags);
     // Returns a hashkey that the material can use to get the list
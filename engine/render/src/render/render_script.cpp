@@ -19,6 +19,7 @@
 
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/hash.h>
 #include <dlib/message.h>
 #include <dlib/profile.h>
@@ -56,6 +57,8 @@ namespace dmRender
 
     #define RENDER_SCRIPT_PREDICATE "RenderScriptPredicate"
 
+    #define RENDER_SCRIPT_COMMAND_LIST "RenderScriptCommandList"
+
     #define RENDER_SCRIPT_LIB_NAME "render"
     #define RENDER_SCRIPT_FORMAT_NAME "format"
     #define RENDER_SCRIPT_WIDTH_NAME "width"
@@ -70,6 +73,7 @@ namespace dmRender
     static uint32_t RENDER_SCRIPT_CONSTANTBUFFER_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_PREDICATE_TYPE_HASH = 0;
     static uint32_t RENDER_SCRIPT_CONSTANTBUFFER_ARRAY_TYPE_HASH = 0;
+    static uint32_t RENDER_SCRIPT_COMMAND_LIST_TYPE_HASH = 0;
 
     const char* RENDER_SCRIPT_FUNCTION_NAMES[MAX_RENDER_SCRIPT_FUNCTION_COUNT] =
     {
@@ -357,6 +361,41 @@ namespace dmRender
         {0, 0}
     };
 
+    static RenderScriptCommandList* RenderScriptCommandList_Check(lua_State *L, int index)
+    {
+        return (RenderScriptCommandList*)dmScript::CheckUserType(L, index, RENDER_SCRIPT_COMMAND_LIST_TYPE_HASH, "Expected a command list (acquired from the render.end_commands function)");
+    }
+
+    static int RenderScriptCommandList_gc (lua_State *L)
+    {
+        RenderScriptCommandList* list = (RenderScriptCommandList*)lua_touserdata(L, 1);
+        if (!list->m_Commands.Empty())
+            FreeCommandOperands(list->m_Commands.Begin(), list->m_Commands.Size());
+        for (uint32_t i = 0; i < list->m_LuaReferences.Size(); ++i)
+            dmScript::Unref(L, LUA_REGISTRYINDEX, list->m_LuaReferences[i]);
+        list->~RenderScriptCommandList();
+        return 0;
+    }
+
+    static int RenderScriptCommandList_tostring (lua_State *L)
+    {
+        RenderScriptCommandList* list = (RenderScriptCommandList*)lua_touserdata(L, 1);
+        lua_pushfstring(L, "CommandList: %p (%d commands)", list, list->m_Commands.Size());
+        return 1;
+    }
+
+    static const luaL_reg RenderScriptCommandList_methods[] =
+    {
+        {0,0}
+    };
+
+    static const luaL_reg RenderScriptCommandList_meta[] =
+    {
+        {"__gc",        RenderScriptCommandList_gc},
+        {"__tostring",  RenderScriptCommandList_tostring},
+        {0, 0}
+    };
+
     /*# create a new constant buffer.
      *
      * Constant buffers are used to set shader program variables and are optionally passed to the `render.draw()` function.
@@ -573,6 +612,16 @@ namespace dmRender
 
     bool InsertCommand(RenderScriptInstance* i, const Command& command)
     {
+        // A recorded command list isn't bound by the size of the frame command buffer
+        if (i->m_RecordingCommandList)
+        {
+            dmArray<Command>& commands = i->m_RecordingCommandList->m_Commands;
+            if (commands.Full())
+                commands.OffsetCapacity(dmMath::Max(16U, commands.Capacity()));
+            commands.Push(command);
+            return true;
+        }
+
         if (i->m_CommandBuffer.Full())
             return false;
         else
@@ -580,6 +629,18 @@ namespace dmRender
         return true;
     }
 
+    // Keeps a predicate or constant buffer alive for as long as the command list being recorded
+    static void RetainCommandListValue(lua_State* L, RenderScriptInstance* i, int index)
+    {
+        RenderScriptCommandList* list = i->m_RecordingCommandList;
+        if (!list)
+            return;
+        if (list->m_LuaReferences.Full())
+            list->m_LuaReferences.OffsetCapacity(8);
+        lua_pushvalue(L, index);
+        list->m_LuaReferences.Push(dmScript::Ref(L, LUA_REGISTRYINDEX));
+    }
+
     /*#
      * @name render.STATE_DEPTH_TEST
      * @variable
@@ -1698,6 +1759,8 @@ namespace dmRender
 
             lua_getfield(L, -1, "constants");
             constant_buffer = lua_isnil(L, -1) ? 0 : *RenderScriptConstantBuffer_Check(L, -1);
+            if (constant_buffer)
+                RetainCommandListValue(L, i, -1);
             lua_pop(L, 1);
 
             lua_pop(L, 1);
@@ -1707,8 +1770,11 @@ namespace dmRender
             dmLogOnceWarning("This interface for render.draw() is deprecated. Please see documentation at https://defold.com/ref/stable/render/#render.draw:predicate-[constants]")
             HNamedConstantBuffer* tmp = RenderScriptConstantBuffer_Check(L, 2);
             constant_buffer = *tmp;
+            RetainCommandListValue(L, i, 2);
         }
 
+        RetainCommandListValue(L, i, 1);
+
         if (frustum_matrix)
         {
             // we need to pass ownership to the command queue
@@ -1785,6 +1851,163 @@ namespace dmRender
         return 0;
     }
 
+    /*# starts recording a command list
+     * Starts recording render commands into a command list instead of the command buffer of the frame.
+     * All render commands (e.g. state changes, clears and draw calls) issued until
+     * [ref:render.end_commands] is called are recorded, and can then be executed any number of times
+     * with [ref:render.execute_commands]. This saves the cost of issuing the same commands from Lua every frame.
+     *
+     * The predicates and constant buffers used by the recorded commands are kept alive by the command list.
+     * Render targets and textures used by the recorded commands must not be deleted while the command list is in use.
+     *
+     * @name render.begin_commands
+     * @examples
+     *
+     * ```lua
+     * function init(self)
+     *     self.tile_pred = render.predicate({"tile"})
+     *     render.begin_commands()
+     *     render.set_depth_mask(false)
+     *     render.disable_state(render.STATE_DEPTH_TEST)
+     *     render.enable_state(render.STATE_BLEND)
+     *     render.draw(self.tile_pred)
+     *     self.commands = render.end_commands()
+     * end
+     *
+     * function update(self)
+     *     render.execute_commands(self.commands)
+     * end
+     * ```
+     */
+    int RenderScript_BeginCommands(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        (void) top;
+
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        if (i->m_RecordingCommandList)
+            return luaL_error(L, "Already recording a command list, call render.end_commands() first.");
+
+        RenderScriptCommandList* list = (RenderScriptCommandList*)lua_newuserdata(L, sizeof(RenderScriptCommandList));
+        new (list) RenderScriptCommandList;
+        luaL_getmetatable(L, RENDER_SCRIPT_COMMAND_LIST);
+        lua_setmetatable(L, -2);
+
+        i->m_RecordingCommandList = list;
+        i->m_RecordingCommandListReference = dmScript::Ref(L, LUA_REGISTRYINDEX);
+
+        assert(top == lua_gettop(L));
+        return 0;
+    }
+
+    /*# stops recording a command list
+     * Stops recording render commands, and returns the command list recorded since [ref:render.begin_commands] was called.
+     *
+     * @name render.end_commands
+     * @return commands [type:command_list] the recorded command list
+     */
+    int RenderScript_EndCommands(lua_State* L)
+    {
+        int top = lua_gettop(L);
+        (void) top;
+
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        if (!i->m_RecordingCommandList)
+            return luaL_error(L, "Not recording a command list, call render.begin_commands() first.");
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, i->m_RecordingCommandListReference);
+        dmScript::Unref(L, LUA_REGISTRYINDEX, i->m_RecordingCommandListReference);
+        i->m_RecordingCommandList = 0;
+        i->m_RecordingCommandListReference = LUA_NOREF;
+
+        assert(top + 1 == lua_gettop(L));
+        return 1;
+    }
+
+    /*# executes a recorded command list
+     * Executes the commands of a command list recorded with [ref:render.begin_commands] and [ref:render.end_commands].
+     * The view and projection matrices, and the frustum used to cull the recorded draw calls, can be replaced
+     * for this execution only, which allows the same command list to be used with a moving camera.
+     *
+     * @name render.execute_commands
+     * @param commands [type:command_list] the command list to execute
+     * @param [options] [type:table] optional table with properties:
+     *
+     * `view`
+     * : [type:vmath.matrix4] Replaces the matrix of every recorded render.set_view() call.
+     *
+     * `projection`
+     * : [type:vmath.matrix4] Replaces the matrix of every recorded render.set_projection() call.
+     *
+     * `frustum`
+     * : [type:vmath.matrix4] Replaces the frustum of every recorded draw call that was recorded with a frustum.
+     *
+     * @examples
+     *
+     * ```lua
+     * function update(self)
+     *     local frustum = self.proj * self.view
+     *     render.execute_commands(self.commands, {view = self.view, projection = self.proj, frustum = frustum})
+     * end
+     * ```
+     */
+    int RenderScript_ExecuteCommands(lua_State* L)
+    {
+        RenderScriptInstance* i = RenderScriptInstance_Check(L);
+        RenderScriptCommandList* list = RenderScriptCommandList_Check(L, 1);
+        if (i->m_RecordingCommandList)
+            return luaL_error(L, "Cannot execute a command list while recording a command list.");
+        if (list->m_Commands.Empty())
+            return 0;
+
+        dmVMath::Matrix4* view = 0;
+        dmVMath::Matrix4* projection = 0;
+        dmVMath::Matrix4* frustum = 0;
+        if (lua_istable(L, 2))
+        {
+            lua_pushvalue(L, 2);
+
+            lua_getfield(L, -1, "view");
+            view = lua_isnil(L, -1) ? 0 : dmScript::CheckMatrix4(L, -1);
+            lua_pop(L, 1);
+
+            lua_getfield(L, -1, "projection");
+            projection = lua_isnil(L, -1) ? 0 : dmScript::CheckMatrix4(L, -1);
+            lua_pop(L, 1);
+
+            lua_getfield(L, -1, "frustum");
+            frustum = lua_isnil(L, -1) ? 0 : dmScript::CheckMatrix4(L, -1);
+            lua_pop(L, 1);
+
+            lua_pop(L, 1);
+        }
+
+        if (i->m_CommandBuffer.Full())
+            return luaL_error(L, "Command buffer is full (%d).", i->m_CommandBuffer.Capacity());
+
+        // we need to pass ownership to the command queue
+        CommandListExecution* execution = new CommandListExecution;
+        execution->m_Commands        = list->m_Commands.Begin();
+        execution->m_CommandCount    = list->m_Commands.Size();
+        execution->m_PatchView       = view != 0;
+        execution->m_PatchProjection = projection != 0;
+        execution->m_PatchFrustum    = frustum != 0;
+        if (view)
+            execution->m_View = *view;
+        if (projection)
+            execution->m_Projection = *projection;
+        if (frustum)
+            execution->m_Frustum = *frustum;
+        InsertCommand(i, Command(COMMAND_TYPE_EXECUTE_COMMANDS, (uintptr_t)execution));
+
+        // Keep the command list alive until the command buffer has been parsed
+        if (i->m_CommandListReferences.Full())
+            i->m_CommandListReferences.OffsetCapacity(8);
+        lua_pushvalue(L, 1);
+        i->m_CommandListReferences.Push(dmScript::Ref(L, LUA_REGISTRYINDEX));
+        return 0;
+    }
+
     /*# sets the view matrix
      *
      * Sets the view matrix to use when rendering.
@@ -2774,6 +2997,9 @@ namespace dmRender
         {"get_window_width",                RenderScript_GetWindowWidth},
         {"get_window_height",               RenderScript_GetWindowHeight},
         {"predicate",                       RenderScript_Predicate},
+        {"begin_commands",                  RenderScript_BeginCommands},
+        {"end_commands",                    RenderScript_EndCommands},
+        {"execute_commands",                RenderScript_ExecuteCommands},
         {"constant_buffer",                 RenderScript_ConstantBuffer},
         {"enable_material",                 RenderScript_EnableMaterial},
         {"disable_material",                RenderScript_DisableMaterial},
@@ -2797,6 +3023,7 @@ namespace dmRender
         RENDER_SCRIPT_CONSTANTBUFFER_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_CONSTANTBUFFER, RenderScriptConstantBuffer_methods, RenderScriptConstantBuffer_meta);
 
         RENDER_SCRIPT_PREDICATE_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_PREDICATE, RenderScriptPredicate_methods, RenderScriptPredicate_meta);
+        RENDER_SCRIPT_COMMAND_LIST_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_COMMAND_LIST, RenderScriptCommandList_methods, RenderScriptCommandList_meta);
 
         RENDER_SCRIPT_CONSTANTBUFFER_ARRAY_TYPE_HASH = dmScript::RegisterUserType(L, RENDER_SCRIPT_CONSTANTBUFFER_ARRAY, RenderScriptConstantBuffer_methods, RenderScriptConstantBufferArray_meta);
 
@@ -3075,6 +3302,24 @@ bail:
         render_script_instance->m_InstanceReference = LUA_NOREF;
         render_script_instance->m_RenderScriptDataReference = LUA_NOREF;
         render_script_instance->m_ContextTableReference = LUA_NOREF;
+        render_script_instance->m_RecordingCommandListReference = LUA_NOREF;
+    }
+
+    // Releases the command lists executed by the command buffer, and any command list left recording
+    static void ReleaseCommandLists(HRenderScriptInstance instance)
+    {
+        lua_State* L = instance->m_RenderContext->m_RenderScriptContext.m_LuaState;
+        for (uint32_t i = 0; i < instance->m_CommandListReferences.Size(); ++i)
+            dmScript::Unref(L, LUA_REGISTRYINDEX, instance->m_CommandListReferences[i]);
+        instance->m_CommandListReferences.SetSize(0);
+
+        if (instance->m_RecordingCommandList)
+        {
+            dmLogError("render.begin_commands() was called without a matching call to render.end_commands().");
+            dmScript::Unref(L, LUA_REGISTRYINDEX, instance->m_RecordingCommandListReference);
+            instance->m_RecordingCommandList = 0;
+            instance->m_RecordingCommandListReference = LUA_NOREF;
+        }
     }
 
     HRenderScriptInstance NewRenderScriptInstance(dmRender::HRenderContext render_context, HRenderScript render_script)
@@ -3131,6 +3376,7 @@ bail:
         dmScript::Unref(L, LUA_REGISTRYINDEX, render_script_instance->m_InstanceReference);
         dmScript::Unref(L, LUA_REGISTRYINDEX, render_script_instance->m_RenderScriptDataReference);
         dmScript::Unref(L, LUA_REGISTRYINDEX, render_script_instance->m_ContextTableReference);
+        ReleaseCommandLists(render_script_instance);
 
         assert(top == lua_gettop(L));
 
@@ -3205,7 +3451,7 @@ bail:
                     }
                     if (message->m_DataSize > 0)
                     {
-                        dmScript::PushTable(L, (const char*)message->m_Data, message->m_DataSize);
+                        dmScript::PushMessageTable(L, (const char*)message->m_Data, message->m_DataSize);
                     }
                     else
                     {
@@ -3319,6 +3565,7 @@ bail:
     {
         DM_PROFILE("UpdateRSI");
         instance->m_CommandBuffer.SetSize(0);
+        ReleaseCommandLists(instance);
 
         dmScript::UpdateScriptWorld(instance->m_ScriptWorld, dt);
 
@@ -3326,6 +3573,7 @@ bail:
 
         if (instance->m_CommandBuffer.Size() > 0)
             ParseCommands(instance->m_RenderContext, &instance->m_CommandBuffer.Front(), instance->m_CommandBuffer.Size());
+        ReleaseCommandLists(instance);
         return result;
     }
 
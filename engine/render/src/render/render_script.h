@@ -45,10 +45,19 @@ namespace dmRender
         int             m_InstanceReference;
     };
 
+    // Commands recorded with render.begin_commands()/render.end_commands()
+    struct RenderScriptCommandList
+    {
+        dmArray<Command>            m_Commands;         // Owns the matrix operands of the commands
+        dmArray<int>                m_LuaReferences;    // Predicates and constant buffers used by the commands
+    };
+
     static const uint32_t MAX_PREDICATE_COUNT = 64;
     struct RenderScriptInstance
     {
         dmArray<Command>            m_CommandBuffer;
+        dmArray<int>                m_CommandListReferences;    // Command lists executed by m_CommandBuffer
+        RenderScriptCommandList*    m_RecordingCommandList;
         dmHashTable64<HMaterial>    m_Materials;
         Predicate*                  m_Predicates[MAX_PREDICATE_COUNT];
         RenderContext*              m_RenderContext;
@@ -58,6 +67,7 @@ namespace dmRender
         int                         m_InstanceReference;
         int                         m_RenderScriptDataReference;
         int                         m_ContextTableReference;
+        int                         m_RecordingCommandListReference;
     };
 
     void InitializeRenderScriptContext(RenderScriptContext& context, dmGraphics::HContext graphics_context, dmScript::HContext script_context, uint32_t command_buffer_size);
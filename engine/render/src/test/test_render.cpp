@@ -27,6 +27,7 @@
 #include "render/render.h"
 #include "render/render_private.h"
 #include "render/font_renderer_private.h"
+#include "../../../graphics/src/graphics_private.h"
 
 const static uint32_t WIDTH = 600;
 const static uint32_t HEIGHT = 400;
@@ -462,6 +463,131 @@ TEST_F(dmRenderTest, TestRenderListDrawState)
 }
 
 
+struct TestDrawSharedStateDispatchCtx
+{
+    dmRender::HRenderContext       m_Context;
+    dmRender::HMaterial            m_Material;
+    dmRender::RenderObject         m_RenderObjects[4];
+    dmRender::HNamedConstantBuffer m_ConstantBuffer;
+    dmGraphics::HTexture           m_Texture;
+    dmGraphics::HVertexDeclaration m_VertexDeclaration;
+    dmGraphics::HVertexBuffer      m_VertexBuffer;
+};
+
+static void TestDrawSharedStateDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    if (params.m_Operation == dmRender::RENDER_LIST_OPERATION_BATCH)
+    {
+        TestDrawSharedStateDispatchCtx* user_ctx = (TestDrawSharedStateDispatchCtx*) params.m_UserData;
+        for (uint32_t i = 0; i < DM_ARRAY_SIZE(user_ctx->m_RenderObjects); ++i)
+        {
+            dmRender::RenderObject* ro = &user_ctx->m_RenderObjects[i];
+            ro->Init();
+            ro->m_Material          = user_ctx->m_Material;
+            ro->m_VertexCount       = 1;
+            ro->m_VertexDeclaration = user_ctx->m_VertexDeclaration;
+            ro->m_VertexBuffer      = user_ctx->m_VertexBuffer;
+            ro->m_WorldTransform    = Matrix4::translation(Vector3((float)(i / 2), 0, 0));
+            // Only the first object uses the texture, and the last one the constant buffer
+            ro->m_Textures[0]       = i == 0 ? user_ctx->m_Texture : 0;
+            ro->m_ConstantBuffer    = i == 3 ? user_ctx->m_ConstantBuffer : 0;
+            AddToRender(user_ctx->m_Context, ro);
+        }
+    }
+}
+
+// Render objects sharing material, textures and buffers skip the redundant state changes
+TEST_F(dmRenderTest, TestRenderListDrawSharedState)
+{
+    dmRender::RenderListBegin(m_Context);
+
+    const char* vp_source = "uniform vec4 tint;\nuniform mat4 world;\n";
+    dmGraphics::ShaderDesc::Shader vp_shader = MakeDDFShader(vp_source, strlen(vp_source));
+    dmGraphics::ShaderDesc::Shader fp_shader = MakeDDFShader("foo", 3);
+    dmGraphics::HVertexProgram vp = dmGraphics::NewVertexProgram(m_GraphicsContext, &vp_shader);
+    dmGraphics::HFragmentProgram fp = dmGraphics::NewFragmentProgram(m_GraphicsContext, &fp_shader);
+    dmRender::HMaterial material = dmRender::NewMaterial(m_Context, vp, fp);
+    dmRender::SetMaterialProgramConstantType(material, dmHashString64("world"), dmRenderDDF::MaterialDesc::CONSTANT_TYPE_WORLD);
+
+    dmGraphics::HVertexDeclaration vx_decl = dmGraphics::NewVertexDeclaration(m_GraphicsContext, 0, 0);
+    dmGraphics::HVertexBuffer vx_buffer = dmGraphics::NewVertexBuffer(m_GraphicsContext, 0, 0, dmGraphics::BUFFER_USAGE_STATIC_DRAW);
+
+    uint8_t texture_data[4] = {0xff, 0xff, 0xff, 0xff};
+    dmGraphics::TextureCreationParams creation_params;
+    creation_params.m_Width = 1;
+    creation_params.m_Height = 1;
+    creation_params.m_OriginalWidth = 1;
+    creation_params.m_OriginalHeight = 1;
+    dmGraphics::HTexture texture = dmGraphics::NewTexture(m_GraphicsContext, creation_params);
+    dmGraphics::TextureParams texture_params;
+    texture_params.m_Format = dmGraphics::TEXTURE_FORMAT_RGBA;
+    texture_params.m_Data = texture_data;
+    texture_params.m_DataSize = sizeof(texture_data);
+    texture_params.m_Width = 1;
+    texture_params.m_Height = 1;
+    dmGraphics::SetTexture(texture, texture_params);
+
+    dmVMath::Vector4 value(1, 2, 3, 4);
+    dmRender::HNamedConstantBuffer constant_buffer = dmRender::NewNamedConstantBuffer();
+    dmRender::SetNamedConstant(constant_buffer, dmHashString64("tint"), &value, 1);
+
+    TestDrawSharedStateDispatchCtx user_ctx;
+    user_ctx.m_Context           = m_Context;
+    user_ctx.m_Material          = material;
+    user_ctx.m_ConstantBuffer    = constant_buffer;
+    user_ctx.m_Texture           = texture;
+    user_ctx.m_VertexDeclaration = vx_decl;
+    user_ctx.m_VertexBuffer      = vx_buffer;
+
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestDrawSharedStateDispatch, 0, &user_ctx);
+
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, 1);
+    dmRender::RenderListEntry & entry = out[0];
+    entry.m_WorldPosition             = Point3(0,0,0);
+    entry.m_MajorOrder                = 0;
+    entry.m_MinorOrder                = 0;
+    entry.m_TagListKey                = 0;
+    entry.m_Order                     = 1;
+    entry.m_BatchKey                  = 0;
+    entry.m_Dispatch                  = dispatch;
+    entry.m_UserData                  = 0;
+
+    dmGraphics::PipelineState ps_before = dmGraphics::GetPipelineState(m_GraphicsContext);
+    uint64_t draw_count = dmGraphics::GetDrawCount();
+
+    dmRender::RenderListSubmit(m_Context, out, out + 1);
+    dmRender::RenderListEnd(m_Context);
+    dmGraphics::ResetNullStateCallCounts();
+    ASSERT_EQ(dmRender::RESULT_OK, dmRender::DrawRenderList(m_Context, 0, 0, 0));
+
+    dmGraphics::PipelineState ps_after = dmGraphics::GetPipelineState(m_GraphicsContext);
+    ASSERT_EQ(0, memcmp(&ps_before, &ps_after, sizeof(dmGraphics::PipelineState)));
+
+    // All objects are drawn, but the shared material, vertex declaration and buffer are only bound once
+    dmGraphics::NullStateCallCounts counts = dmGraphics::GetNullStateCallCounts();
+    ASSERT_EQ(4U, dmGraphics::GetDrawCount() - draw_count);
+    ASSERT_EQ(1U, counts.m_EnableProgram);
+    ASSERT_EQ(1U, counts.m_EnableVertexDeclaration);
+
+    // The texture is bound for the first object and unbound for the second, which has none
+    ASSERT_EQ(1U, counts.m_EnableTexture);
+    ASSERT_EQ(1U, counts.m_DisableTexture);
+
+    // Object 0 applies both material constants, object 1 shares its transform and applies none,
+    // object 2 only applies the changed world transform, and object 3 reapplies both for its
+    // constant buffer before applying the buffer itself
+    ASSERT_EQ(2U + 0U + 1U + 3U, counts.m_SetConstant);
+
+    dmRender::DeleteNamedConstantBuffer(constant_buffer);
+    dmGraphics::DeleteTexture(texture);
+    dmGraphics::DeleteVertexProgram(vp);
+    dmGraphics::DeleteFragmentProgram(fp);
+    dmRender::DeleteMaterial(m_Context, material);
+
+    dmGraphics::DeleteVertexBuffer(vx_buffer);
+    dmGraphics::DeleteVertexDeclaration(vx_decl);
+}
+
 static void TestDrawVisibilityDispatch(dmRender::RenderListDispatchParams const & params)
 {
     TestDrawDispatchCtx *ctx = (TestDrawDispatchCtx*) params.m_UserData;
@@ -607,6 +733,73 @@ TEST_F(dmRenderTest, TestRenderListCulling)
     }
 }
 
+static void TestCountDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    TestDrawDispatchCtx* ctx = (TestDrawDispatchCtx*)params.m_UserData;
+    switch (params.m_Operation)
+    {
+        case dmRender::RENDER_LIST_OPERATION_BEGIN: ctx->m_BeginCalls++; break;
+        case dmRender::RENDER_LIST_OPERATION_BATCH: ctx->m_BatchCalls++; break;
+        case dmRender::RENDER_LIST_OPERATION_END:   ctx->m_EndCalls++; break;
+    }
+}
+
+TEST_F(dmRenderTest, TestRenderListDispatchReuse)
+{
+    dmVMath::Matrix4 view = dmVMath::Matrix4::identity();
+    dmVMath::Matrix4 proj = dmVMath::Matrix4::orthographic(0.0f, WIDTH, 0.0f, HEIGHT, -1.0f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, view);
+    dmRender::SetProjectionMatrix(m_Context, proj);
+    dmVMath::Matrix4 view_proj = proj * view;
+
+    const uint32_t n = 16;
+
+    TestDrawDispatchCtx ctx;
+    memset(&ctx, 0x00, sizeof(TestDrawDispatchCtx));
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestCountDispatch, TestDrawVisibility, &ctx);
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = Point3(i * WIDTH / n, i * HEIGHT / n, 0);
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = 0;
+        entry.m_TagListKey = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = 1;
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = 0;
+        entry.m_Visibility = dmRender::VISIBILITY_NONE;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+    dmRender::RenderListEnd(m_Context);
+
+    dmRender::DrawRenderList(m_Context, 0, 0, &view_proj);
+    ASSERT_EQ(1, ctx.m_BeginCalls);
+    ASSERT_EQ(1, ctx.m_EndCalls);
+
+    // Same predicate and frustum, the render objects are reused
+    dmRender::DrawRenderList(m_Context, 0, 0, &view_proj);
+    ASSERT_EQ(1, ctx.m_BeginCalls);
+    ASSERT_EQ(1, ctx.m_EndCalls);
+
+    // Another frustum
+    dmRender::DrawRenderList(m_Context, 0, 0, 0);
+    ASSERT_EQ(2, ctx.m_BeginCalls);
+    ASSERT_EQ(2, ctx.m_EndCalls);
+
+    dmRender::DrawRenderList(m_Context, 0, 0, 0);
+    ASSERT_EQ(2, ctx.m_BeginCalls);
+
+    // The render objects are cleared at the end of the frame
+    dmRender::ClearRenderObjects(m_Context);
+    dmRender::DrawRenderList(m_Context, 0, 0, 0);
+    ASSERT_EQ(3, ctx.m_BeginCalls);
+    ASSERT_EQ(3, ctx.m_EndCalls);
+}
+
 struct TestRenderListOrderDispatchCtx
 {
     int m_BeginCalls;
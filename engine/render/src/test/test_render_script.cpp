@@ -811,6 +811,97 @@ TEST_F(dmRenderScriptTest, TestLuaDraw_NoPredicate)
     dmRender::DeleteRenderScript(m_Context, render_script);
 }
 
+TEST_F(dmRenderScriptTest, TestLuaCommandList)
+{
+    const char* script =
+    "function init(self)\n"
+    "    self.test_pred = render.predicate({\"one\"})\n"
+    "    render.begin_commands()\n"
+    "    render.set_view(vmath.matrix4())\n"
+    "    render.draw(self.test_pred, {frustum = vmath.matrix4()})\n"
+    "    self.commands = render.end_commands()\n"
+    "    render.execute_commands(self.commands)\n"
+    "    render.execute_commands(self.commands, {view = vmath.matrix4_translation(vmath.vector3(1, 2, 3))})\n"
+    "end\n"
+    "function update(self)\n"
+    "    render.execute_commands(self.commands, {view = vmath.matrix4_translation(vmath.vector3(4, 5, 6))})\n"
+    "end\n";
+    dmRender::HRenderScript render_script = dmRender::NewRenderScript(m_Context, LuaSourceFromString(script));
+    dmRender::HRenderScriptInstance render_script_instance = dmRender::NewRenderScriptInstance(m_Context, render_script);
+
+    ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::InitRenderScriptInstance(render_script_instance));
+
+    dmArray<dmRender::Command>& commands = render_script_instance->m_CommandBuffer;
+    ASSERT_EQ(2u, commands.Size());
+
+    for (uint32_t i = 0; i < commands.Size(); ++i)
+    {
+        ASSERT_EQ(dmRender::COMMAND_TYPE_EXECUTE_COMMANDS, commands[i].m_Type);
+        dmRender::CommandListExecution* execution = (dmRender::CommandListExecution*)commands[i].m_Operands[0];
+        ASSERT_EQ(2u, execution->m_CommandCount);
+        ASSERT_EQ(dmRender::COMMAND_TYPE_SET_VIEW, execution->m_Commands[0].m_Type);
+        ASSERT_EQ(dmRender::COMMAND_TYPE_DRAW, execution->m_Commands[1].m_Type);
+        ASSERT_NE((void*)0, (void*)execution->m_Commands[1].m_Operands[2]);
+        ASSERT_EQ(i == 1, execution->m_PatchView != 0);
+        ASSERT_FALSE(execution->m_PatchProjection);
+        ASSERT_FALSE(execution->m_PatchFrustum);
+    }
+
+    dmRender::ParseCommands(m_Context, &commands[0], commands.Size());
+    ASSERT_EQ(1.0f, m_Context->m_View.getTranslation().getX());
+    ASSERT_EQ(3.0f, m_Context->m_View.getTranslation().getZ());
+
+    // The recorded commands are kept, and executed again every frame
+    for (int i = 0; i < 2; ++i)
+    {
+        m_Context->m_View = Matrix4::identity();
+        ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::UpdateRenderScriptInstance(render_script_instance, 0.0f));
+        ASSERT_EQ(1u, commands.Size());
+        ASSERT_EQ(4.0f, m_Context->m_View.getTranslation().getX());
+        ASSERT_EQ(6.0f, m_Context->m_View.getTranslation().getZ());
+    }
+
+    dmRender::DeleteRenderScriptInstance(render_script_instance);
+    dmRender::DeleteRenderScript(m_Context, render_script);
+}
+
+TEST_F(dmRenderScriptTest, TestLuaCommandList_InvalidUsage)
+{
+    const char* scripts[] =
+    {
+        "function init(self)\n"
+        "    render.end_commands()\n"
+        "end\n",
+
+        "function init(self)\n"
+        "    render.begin_commands()\n"
+        "    render.begin_commands()\n"
+        "end\n",
+
+        "function init(self)\n"
+        "    render.begin_commands()\n"
+        "    local commands = render.end_commands()\n"
+        "    render.begin_commands()\n"
+        "    render.execute_commands(commands)\n"
+        "end\n",
+
+        "function init(self)\n"
+        "    render.execute_commands(render.predicate({\"one\"}))\n"
+        "end\n",
+    };
+
+    for (uint32_t i = 0; i < DM_ARRAY_SIZE(scripts); ++i)
+    {
+        dmRender::HRenderScript render_script = dmRender::NewRenderScript(m_Context, LuaSourceFromString(scripts[i]));
+        dmRender::HRenderScriptInstance render_script_instance = dmRender::NewRenderScriptInstance(m_Context, render_script);
+
+        ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_FAILED, dmRender::InitRenderScriptInstance(render_script_instance));
+
+        dmRender::DeleteRenderScriptInstance(render_script_instance);
+        dmRender::DeleteRenderScript(m_Context, render_script);
+    }
+}
+
 TEST_F(dmRenderScriptTest, TestLuaWindowSize)
 {
     const char* script =
@@ -999,11 +999,196 @@ static Result DoLoadResourceLocked(HFactory factory, const char* path, const cha
     }
 }
 
+static const char* GetExtFromPath(const char* name, char* buffer, uint32_t buffersize)
+{
+    const char* ext = strrchr(name, '.');
+    if( !ext )
+        return 0;
+
+    int result = dmStrlCpy(buffer, ext, buffersize);
+    if( result >= 0 )
+    {
+        return buffer;
+    }
+    return 0;
+}
+
+struct ResourceStream
+{
+    dmResourceArchive::EntryStream m_Stream;
+};
+
+// Finds an archive entry that can be streamed. Returns RESULT_NOT_SUPPORTED if the entry is compressed or encrypted
+static Result FindStreamableEntry(const Manifest* manifest, const char* path, dmResourceArchive::HArchiveIndexContainer* archive, dmResourceArchive::EntryData* entry)
+{
+    int index = FindEntryIndex(manifest, dmHashString64(path));
+    if (index < 0) {
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    dmLiveUpdateDDF::HashAlgorithm algorithm = manifest->m_DDFData->m_Header.m_ResourceHashAlgorithm;
+    dmLiveUpdateDDF::ResourceEntry* entries = manifest->m_DDFData->m_Resources.m_Data;
+    uint8_t* hash = entries[index].m_Hash.m_Data.m_Data;
+    uint32_t hash_len = dmResource::HashLength(algorithm);
+    dmResourceArchive::Result res = dmResourceArchive::FindEntry(manifest->m_ArchiveIndex, hash, hash_len, archive, entry);
+    if (res == dmResourceArchive::RESULT_NOT_FOUND)
+        return RESULT_RESOURCE_NOT_FOUND;
+    if (res != dmResourceArchive::RESULT_OK)
+        return RESULT_IO_ERROR;
+
+    if (!dmResourceArchive::CanReadEntryPartial(*archive, entry))
+        return RESULT_NOT_SUPPORTED;
+    return RESULT_OK;
+}
+
+// Assumes m_LoadMutex is already held
+// Finds where a streamable resource is stored, either in an archive (*archive != 0) or on the local file system (fs_path)
+static Result FindStreamableResourceLocked(HFactory factory, const char* canonical_path, dmResourceArchive::HArchiveIndexContainer* archive,
+                                           dmResourceArchive::EntryData* entry, char* fs_path, uint32_t fs_path_size, uint32_t* resource_size)
+{
+    *archive = 0;
+    if (factory->m_BuiltinsManifest)
+    {
+        Result r = FindStreamableEntry(factory->m_BuiltinsManifest, canonical_path, archive, entry);
+        if (r != RESULT_RESOURCE_NOT_FOUND)
+        {
+            *resource_size = entry->m_ResourceSize;
+            return r;
+        }
+    }
+
+    if (factory->m_HttpClient)
+    {
+        return RESULT_NOT_SUPPORTED;
+    }
+    else if (factory->m_Manifest)
+    {
+        Result r = FindStreamableEntry(factory->m_Manifest, canonical_path, archive, entry);
+        *resource_size = entry->m_ResourceSize;
+        return r;
+    }
+
+    char factory_path[RESOURCE_PATH_MAX];
+    GetCanonicalPathFromBase(factory->m_UriParts.m_Path, canonical_path, factory_path);
+    if (dmSys::RESULT_OK != dmSys::ResolveMountFileName(fs_path, fs_path_size, factory_path))
+    {
+        return RESULT_RESOURCE_NOT_FOUND;
+    }
+
+    dmSys::Result r = dmSys::ResourceSize(fs_path, resource_size);
+    if (r != dmSys::RESULT_OK)
+    {
+        // E.g. packed application assets, that can only be loaded as a whole
+        return r == dmSys::RESULT_NOENT ? RESULT_RESOURCE_NOT_FOUND : RESULT_NOT_SUPPORTED;
+    }
+    return RESULT_OK;
+}
+
+// Assumes m_LoadMutex is already held
+// Returns true if the resource shouldn't be loaded when created, since its type reads the data on demand. See SetStreamingThreshold
+static bool IsStreamedResourceLocked(HFactory factory, const char* canonical_path)
+{
+    char extbuffer[64];
+    const char* ext = GetExtFromPath(canonical_path, extbuffer, sizeof(extbuffer));
+    SResourceType* resource_type = ext ? FindResourceType(factory, ext + 1) : 0;
+    if (resource_type == 0 || resource_type->m_StreamingThreshold == 0)
+        return false;
+
+    dmResourceArchive::HArchiveIndexContainer archive;
+    dmResourceArchive::EntryData entry;
+    char fs_path[RESOURCE_PATH_MAX];
+    uint32_t resource_size = 0;
+    Result r = FindStreamableResourceLocked(factory, canonical_path, &archive, &entry, fs_path, sizeof(fs_path), &resource_size);
+    return r == RESULT_OK && resource_size >= resource_type->m_StreamingThreshold;
+}
+
+Result OpenResourceStream(HFactory factory, const char* name, HResourceStream* stream, uint32_t* resource_size)
+{
+    DM_PROFILE(__FUNCTION__);
+
+    assert(name);
+    assert(stream);
+
+    *stream = 0;
+
+    char canonical_path[RESOURCE_PATH_MAX];
+    GetCanonicalPath(name, canonical_path);
+
+    dmResourceArchive::HArchiveIndexContainer archive;
+    dmResourceArchive::EntryData entry;
+    char fs_path[RESOURCE_PATH_MAX];
+    uint32_t size = 0;
+    ResourceStream* s = 0;
+    {
+        dmMutex::ScopedLock lk(factory->m_LoadMutex);
+
+        Result r = FindStreamableResourceLocked(factory, canonical_path, &archive, &entry, fs_path, sizeof(fs_path), &size);
+        if (r != RESULT_OK)
+            return r;
+
+        s = new ResourceStream;
+        if (archive)
+        {
+            // Opened with the lock held, since liveupdate may replace the archives
+            if (dmResourceArchive::OpenEntryStream(archive, &entry, &s->m_Stream) != dmResourceArchive::RESULT_OK)
+            {
+                delete s;
+                return RESULT_IO_ERROR;
+            }
+        }
+    }
+
+    if (!archive)
+    {
+        memset(&s->m_Stream, 0, sizeof(s->m_Stream));
+        s->m_Stream.m_Size = size;
+        s->m_Stream.m_File = fopen(fs_path, "rb");
+        if (!s->m_Stream.m_File)
+        {
+            delete s;
+            return RESULT_IO_ERROR;
+        }
+    }
+
+    *stream = s;
+    *resource_size = size;
+    return RESULT_OK;
+}
+
+Result ReadResourceStream(HResourceStream stream, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+{
+    DM_PROFILE(__FUNCTION__);
+    dmResourceArchive::Result r = dmResourceArchive::ReadEntryStream(&stream->m_Stream, offset, size, buffer, nread);
+    return r == dmResourceArchive::RESULT_OK ? RESULT_OK : RESULT_IO_ERROR;
+}
+
+void CloseResourceStream(HResourceStream stream)
+{
+    dmResourceArchive::CloseEntryStream(&stream->m_Stream);
+    delete stream;
+}
+
+Result SetStreamingThreshold(HFactory factory, const char* extension, uint32_t threshold)
+{
+    SResourceType* resource_type = FindResourceType(factory, extension);
+    if (resource_type == 0)
+        return RESULT_UNKNOWN_RESOURCE_TYPE;
+    resource_type->m_StreamingThreshold = threshold;
+    return RESULT_OK;
+}
+
 // Takes the lock.
 Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
 {
     // Called from async queue so we wrap around a lock
     dmMutex::ScopedLock lk(factory->m_LoadMutex);
+    if (IsStreamedResourceLocked(factory, path))
+    {
+        // Created from an empty buffer, the data is read on demand
+        buffer->SetSize(0);
+        *resource_size = 0;
+        return RESULT_OK;
+    }
     return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer);
 }
 
@@ -1023,20 +1208,6 @@ Result LoadResource(HFactory factory, const char* path, const char* original_nam
 }
 
 
-static const char* GetExtFromPath(const char* name, char* buffer, uint32_t buffersize)
-{
-    const char* ext = strrchr(name, '.');
-    if( !ext )
-        return 0;
-
-    int result = dmStrlCpy(buffer, ext, buffersize);
-    if( result >= 0 )
-    {
-        return buffer;
-    }
-    return 0;
-}
-
 // Assumes m_LoadMutex is already held
 static Result DoGet(HFactory factory, const char* name, void** resource)
 {
@@ -1083,7 +1254,19 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
 
         void *buffer;
         uint32_t file_size;
-        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+        Result result;
+        if (IsStreamedResourceLocked(factory, canonical_path))
+        {
+            // Created from an empty buffer, the data is read on demand
+            factory->m_Buffer.SetSize(0);
+            buffer = factory->m_Buffer.Begin();
+            file_size = 0;
+            result = RESULT_OK;
+        }
+        else
+        {
+            result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+        }
         if (result != RESULT_OK) {
             if (result == RESULT_RESOURCE_NOT_FOUND) {
                 dmLogWarning("Resource not found: %s", name);
@@ -180,6 +180,53 @@ namespace dmResource
      */
     Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* resource_size);
 
+    /**
+     * Handle to a stream of raw resource data, see OpenResourceStream()
+     */
+    typedef struct ResourceStream* HResourceStream;
+
+    /**
+     * Open a stream for reading ranges of raw resource data, without loading the whole resource.
+     * Only supported for resources that are stored uncompressed and unencrypted,
+     * either in an archive or on the local file system.
+     * The stream has a file handle of its own and is read without the factory lock, so it may be read
+     * from any thread, one thread at a time.
+     * @param factory Factory handle
+     * @param name Resource name
+     * @param stream [out] The stream
+     * @param resource_size [out] The size of the resource data
+     * @return RESULT_OK on success, RESULT_NOT_SUPPORTED if the resource cannot be streamed
+     */
+    Result OpenResourceStream(HFactory factory, const char* name, HResourceStream* stream, uint32_t* resource_size);
+
+    /**
+     * Read a range of raw resource data
+     * @param stream Stream handle
+     * @param offset Offset into the resource data
+     * @param size Number of bytes to read
+     * @param buffer Buffer to read to, at least size bytes large
+     * @param nread Number of bytes actually read. Less than size at the end of the resource
+     * @return RESULT_OK on success
+     */
+    Result ReadResourceStream(HResourceStream stream, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
+    /**
+     * Close a stream opened with OpenResourceStream()
+     * @param stream Stream handle
+     */
+    void CloseResourceStream(HResourceStream stream);
+
+    /**
+     * Set the min size of resources of a type that are streamed instead of loaded.
+     * Streamed resources are created from an empty buffer (m_BufferSize is 0), and the resource type
+     * reads the data with OpenResourceStream() instead. Resources that cannot be streamed are loaded as usual.
+     * @param factory Factory handle
+     * @param extension File extension of the type, e.g. "oggc"
+     * @param threshold Min size in bytes. 0 disables streaming for the type
+     * @return RESULT_OK on success
+     */
+    Result SetStreamingThreshold(HFactory factory, const char* extension, uint32_t threshold);
+
     /**
      * Updates a preexisting resource with new data
      * @param factory Factory handle
@@ -33,6 +33,7 @@
 #include <dlib/endian.h>
 #include <dlib/log.h>
 #include <dlib/lz4.h>
+#include <dlib/math.h>
 #include <dlib/memory.h>
 #include <dlib/path.h>
 #include <dlib/sys.h>
@@ -312,6 +313,7 @@ namespace dmResourceArchive
         }
 
         aic->m_ArchiveFileIndex->m_FileResourceData = f_data; // game.arcd file handle
+        dmStrlCpy(aic->m_ArchiveFileIndex->m_DataPath, data_file_path, DMPATH_MAX_PATH);
         *archive = aic;
 
         fclose(f_index);
@@ -547,6 +549,74 @@ namespace dmResourceArchive
         return RESULT_OK;
     }
 
+    bool CanReadEntryPartial(HArchiveIndexContainer archive, const EntryData* entry)
+    {
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        if (archive->m_Loader.m_Read != ReadEntryFromArchive || afi == 0)
+            return false;
+        if (!afi->m_IsMemMapped && afi->m_DataPath[0] == 0)
+            return false;
+        if (entry->m_Flags & (ENTRY_FLAG_ENCRYPTED | ENTRY_FLAG_LIVEUPDATE_DATA))
+            return false;
+        return entry->m_ResourceCompressedSize == 0xFFFFFFFF;
+    }
+
+    Result OpenEntryStream(HArchiveIndexContainer archive, const EntryData* entry, EntryStream* stream)
+    {
+        assert(CanReadEntryPartial(archive, entry));
+
+        const ArchiveFileIndex* afi = archive->m_ArchiveFileIndex;
+        memset(stream, 0, sizeof(*stream));
+        stream->m_Size = entry->m_ResourceSize;
+        if (afi->m_IsMemMapped)
+        {
+            stream->m_Data = afi->m_ResourceData + entry->m_ResourceDataOffset;
+            return RESULT_OK;
+        }
+
+        // Not sharing the archive file handle, since the stream is read from other threads
+        stream->m_File = fopen(afi->m_DataPath, "rb");
+        if (!stream->m_File)
+        {
+            return RESULT_IO_ERROR;
+        }
+        stream->m_Offset = entry->m_ResourceDataOffset;
+        return RESULT_OK;
+    }
+
+    Result ReadEntryStream(EntryStream* stream, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread)
+    {
+        *nread = 0;
+        if (offset >= stream->m_Size)
+            return RESULT_OK;
+
+        uint32_t to_read = dmMath::Min(size, stream->m_Size - offset);
+        if (stream->m_Data)
+        {
+            memcpy(buffer, stream->m_Data + offset, to_read);
+        }
+        else
+        {
+            if (fseek(stream->m_File, stream->m_Offset + offset, SEEK_SET) != 0 ||
+                fread(buffer, 1, to_read, stream->m_File) != to_read)
+            {
+                return RESULT_IO_ERROR;
+            }
+        }
+
+        *nread = to_read;
+        return RESULT_OK;
+    }
+
+    void CloseEntryStream(EntryStream* stream)
+    {
+        if (stream->m_File)
+        {
+            fclose(stream->m_File);
+        }
+        memset(stream, 0, sizeof(*stream));
+    }
+
     void RegisterDefaultArchiveLoader()
     {
         dmResourceArchive::ArchiveLoader loader;
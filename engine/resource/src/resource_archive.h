@@ -106,6 +106,7 @@ namespace dmResourceArchive
         char        m_Path[DMPATH_MAX_PATH];
         uint8_t*    m_Hashes;           // Sorted list of filenames (i.e. hashes)
         EntryData*  m_Entries;          // Indices of this list matches indices of m_Hashes
+        char        m_DataPath[DMPATH_MAX_PATH]; // game.arcd path, if loaded from file
         FILE*       m_FileResourceData; // game.arcd file handle
         uint8_t*    m_ResourceData;     // mem-mapped game.arcd
         uint32_t    m_ResourceSize;     // the size of the memory mapped region
@@ -204,6 +205,53 @@ namespace dmResourceArchive
     // Reads an entry from a single archive
     Result ReadEntryFromArchive(HArchiveIndexContainer archive, const uint8_t* hash, uint32_t hash_len, const EntryData* entry, void* buffer);
 
+    /**
+     * Check if an entry can be read in ranges with an EntryStream, i.e.
+     * the entry is neither compressed nor encrypted, and the archive uses the default reader
+     * @param archive archive index handle
+     * @param entry entry data
+     * @return true if OpenEntryStream() can be used for the entry
+     */
+    bool CanReadEntryPartial(HArchiveIndexContainer archive, const EntryData* entry);
+
+    /**
+     * Reads ranges of a single entry, with a file handle of its own (if the archive isn't memory mapped).
+     * A stream may be used from another thread than the archive, but not from several threads at once.
+     */
+    struct EntryStream
+    {
+        FILE*           m_File;     // 0 if the data is memory mapped
+        const uint8_t*  m_Data;     // The entry data, if memory mapped
+        uint32_t        m_Offset;   // Offset of the entry in m_File
+        uint32_t        m_Size;     // Size of the entry
+    };
+
+    /**
+     * Open a stream for reading an entry. The entry must satisfy CanReadEntryPartial()
+     * @param archive archive index handle
+     * @param entry entry data
+     * @param stream [out] the stream
+     * @return RESULT_OK on success
+     */
+    Result OpenEntryStream(HArchiveIndexContainer archive, const EntryData* entry, EntryStream* stream);
+
+    /**
+     * Read a range of an entry
+     * @param stream stream opened with OpenEntryStream()
+     * @param offset offset into the entry
+     * @param size number of bytes to read
+     * @param buffer buffer to load to, at least size bytes large
+     * @param nread number of bytes actually read (less than size at the end of the entry)
+     * @return RESULT_OK on success
+     */
+    Result ReadEntryStream(EntryStream* stream, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
+    /**
+     * Close a stream opened with OpenEntryStream()
+     * @param stream stream
+     */
+    void CloseEntryStream(EntryStream* stream);
+
     // Calls each loader in sequence
 
     /*# Loads the archives, calling each registered loader in sequence
@@ -42,6 +42,7 @@ namespace dmResource
         FResourcePostCreate m_PostCreateFunction;
         FResourceDestroy    m_DestroyFunction;
         FResourceRecreate   m_RecreateFunction;
+        uint32_t            m_StreamingThreshold; // See SetStreamingThreshold
     };
 
     typedef dmArray<char> LoadBufferType;
@@ -1056,6 +1056,102 @@ TEST(RecreateTest, RecreateTest)
     dmResource::DeleteFactory(factory);
 }
 
+static dmResource::Result StreamedResourceCreate(const dmResource::ResourceCreateParams& params)
+{
+    // The data of streamed resources is read with a stream instead of being passed in the buffer
+    uint32_t* buffer_size = new uint32_t;
+    *buffer_size = params.m_BufferSize;
+    params.m_Resource->m_Resource = (void*) buffer_size;
+    return dmResource::RESULT_OK;
+}
+
+static dmResource::Result StreamedResourceDestroy(const dmResource::ResourceDestroyParams& params)
+{
+    delete (uint32_t*) params.m_Resource->m_Resource;
+    return dmResource::RESULT_OK;
+}
+
+TEST(StreamingTest, StreamingTest)
+{
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    dmResource::HFactory factory = dmResource::NewFactory(&params, ".");
+    ASSERT_NE((void*) 0, factory);
+
+    dmResource::Result e;
+    e = dmResource::RegisterType(factory, "foo", 0, 0, &StreamedResourceCreate, 0, &StreamedResourceDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    e = dmResource::SetStreamingThreshold(factory, "foo", 8);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    e = dmResource::SetStreamingThreshold(factory, "bar", 8);
+    ASSERT_EQ(dmResource::RESULT_UNKNOWN_RESOURCE_TYPE, e);
+
+    const char* small_name = "/__teststreamsmall__.foo";
+    const char* large_name = "/__teststreamlarge__.foo";
+    const char* large_content = "0123456789abcdef";
+    char file_name[512];
+    char host_name[512];
+
+    dmSnPrintf(file_name, sizeof(file_name), "./%s", small_name);
+    const char* small_path = MakeHostPath(host_name, sizeof(host_name), file_name);
+    FILE* f = fopen(small_path, "wb");
+    ASSERT_NE((FILE*) 0, f);
+    fprintf(f, "123");
+    fclose(f);
+
+    dmSnPrintf(file_name, sizeof(file_name), "./%s", large_name);
+    char large_host_name[512];
+    const char* large_path = MakeHostPath(large_host_name, sizeof(large_host_name), file_name);
+    f = fopen(large_path, "wb");
+    ASSERT_NE((FILE*) 0, f);
+    fprintf(f, "%s", large_content);
+    fclose(f);
+
+    // Resources below the threshold are loaded as usual
+    uint32_t* buffer_size;
+    e = dmResource::Get(factory, small_name, (void**) &buffer_size);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(3U, *buffer_size);
+    dmResource::Release(factory, buffer_size);
+
+    // ...but larger ones aren't loaded at all
+    e = dmResource::Get(factory, large_name, (void**) &buffer_size);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(0U, *buffer_size);
+    dmResource::Release(factory, buffer_size);
+
+    dmResource::HResourceStream stream = 0;
+    uint32_t resource_size = 0;
+    e = dmResource::OpenResourceStream(factory, large_name, &stream, &resource_size);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ((uint32_t) strlen(large_content), resource_size);
+
+    char buffer[32] = { 0 };
+    uint32_t nread = 0;
+    e = dmResource::ReadResourceStream(stream, 10, sizeof(buffer) - 1, buffer, &nread);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(6U, nread);
+    ASSERT_STREQ(large_content + 10, buffer);
+
+    e = dmResource::ReadResourceStream(stream, 0, 4, buffer, &nread);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(4U, nread);
+    ASSERT_EQ(0, memcmp(large_content, buffer, 4));
+
+    e = dmResource::ReadResourceStream(stream, resource_size, 4, buffer, &nread);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(0U, nread);
+
+    dmResource::CloseResourceStream(stream);
+
+    e = dmResource::OpenResourceStream(factory, "/__teststreammissing__.foo", &stream, &resource_size);
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, e);
+
+    dmSys::Unlink(small_path);
+    dmSys::Unlink(large_path);
+    dmResource::DeleteFactory(factory);
+}
+
 volatile bool SendReloadDone = false;
 void SendReloadThread(void*)
 {
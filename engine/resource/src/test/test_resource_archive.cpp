@@ -745,6 +745,58 @@ TEST(dmResourceArchive, Wrap)
     dmResourceArchive::Delete(archive);
 }
 
+TEST(dmResourceArchive, EntryStream)
+{
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_ARCI, RESOURCES_ARCI_SIZE, true, RESOURCES_ARCD, RESOURCES_ARCD_SIZE, true, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+    dmResourceArchive::SetDefaultReader(archive);
+
+    dmResourceArchive::HArchiveIndexContainer entryarchive;
+    dmResourceArchive::EntryData entry;
+    for (uint32_t i = 0; i < (sizeof(path_hash) / sizeof(path_hash[0])); ++i)
+    {
+        if (IsLiveUpdateResource(path_hash[i])) continue;
+
+        result = dmResourceArchive::FindEntry(archive, content_hash[i], sizeof(content_hash[i]), &entryarchive, &entry);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+        if (entry.m_Flags & dmResourceArchive::ENTRY_FLAG_ENCRYPTED)
+        {
+            ASSERT_FALSE(dmResourceArchive::CanReadEntryPartial(entryarchive, &entry));
+            continue;
+        }
+        ASSERT_TRUE(dmResourceArchive::CanReadEntryPartial(entryarchive, &entry));
+
+        dmResourceArchive::EntryStream stream;
+        result = dmResourceArchive::OpenEntryStream(entryarchive, &entry, &stream);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        uint32_t len = strlen(content[i]);
+        uint32_t offset = len / 2;
+        char buffer[1024] = { 0 };
+        uint32_t nread = 0;
+        result = dmResourceArchive::ReadEntryStream(&stream, offset, sizeof(buffer) - 1, buffer, &nread);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+        ASSERT_EQ(len - offset, nread);
+        ASSERT_STREQ(content[i] + offset, buffer);
+
+        memset(buffer, 0, sizeof(buffer));
+        result = dmResourceArchive::ReadEntryStream(&stream, 0, 1, buffer, &nread);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+        ASSERT_EQ(1U, nread);
+        ASSERT_EQ(content[i][0], buffer[0]);
+
+        result = dmResourceArchive::ReadEntryStream(&stream, len, sizeof(buffer), buffer, &nread);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+        ASSERT_EQ(0U, nread);
+
+        dmResourceArchive::CloseEntryStream(&stream);
+    }
+
+    dmResourceArchive::Delete(archive);
+}
+
 TEST(dmResourceArchive, Wrap_Compressed)
 {
     dmResourceArchive::HArchiveIndexContainer archive = 0;
@@ -805,6 +857,24 @@ TEST(dmResourceArchive, LoadFromDisk)
 
         ASSERT_EQ(strlen(content[i]), strlen(buffer));
         ASSERT_STREQ(content[i], buffer);
+
+        if (dmResourceArchive::CanReadEntryPartial(entryarchive, &entry))
+        {
+            // Read through a file handle of its own
+            dmResourceArchive::EntryStream stream;
+            result = dmResourceArchive::OpenEntryStream(entryarchive, &entry, &stream);
+            ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+            ASSERT_NE((FILE*) 0, stream.m_File);
+
+            uint32_t nread = 0;
+            memset(buffer, 0, sizeof(buffer));
+            result = dmResourceArchive::ReadEntryStream(&stream, 0, sizeof(buffer) - 1, buffer, &nread);
+            ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+            ASSERT_EQ(strlen(content[i]), nread);
+            ASSERT_STREQ(content[i], buffer);
+
+            dmResourceArchive::CloseEntryStream(&stream);
+        }
     }
 
     uint8_t invalid_hash[] = { 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U, 10U };
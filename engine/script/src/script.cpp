@@ -17,8 +17,11 @@
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/pprint.h>
 #include <dlib/profile.h>
+#include <dlib/size_class_allocator.h>
+#include <dlib/time.h>
 
 #include "script_private.h"
 #include "script_hash.h"
@@ -42,6 +45,11 @@ extern "C"
 }
 
 DM_PROPERTY_GROUP(rmtp_Script, "");
+DM_PROPERTY_U32(rmtp_ScriptGCTime, 0, FrameReset, "Time spent in frame garbage collection steps (us)", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptHeapSize, 0, FrameReset, "Lua heap size after garbage collection (kb)", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptSmallAllocBytes, 0, FrameReset, "Live bytes in the Lua size class pools", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptSmallAllocCount, 0, FrameReset, "Live allocations in the Lua size class pools", &rmtp_Script);
+DM_PROPERTY_U32(rmtp_ScriptLargeAllocBytes, 0, FrameReset, "Live bytes in Lua allocations larger than the size classes", &rmtp_Script);
 
 namespace dmScript
 {
@@ -72,6 +80,37 @@ namespace dmScript
     // A debug value for profiling lua references
     int g_LuaReferenceCount = 0;
 
+    static void* LuaAlloc(void* user_data, void* ptr, size_t old_size, size_t new_size)
+    {
+        return dmSizeClassAllocator::Realloc((dmSizeClassAllocator::HAllocator) user_data, ptr, (uint32_t) old_size, (uint32_t) new_size);
+    }
+
+    static int LuaPanic(lua_State* L)
+    {
+        dmLogFatal("Unprotected error in call to Lua API (%s)", lua_tostring(L, -1));
+        return 0;
+    }
+
+    static lua_State* NewLuaState(Context* context)
+    {
+        context->m_Allocator = dmSizeClassAllocator::New();
+        lua_State* L = lua_newstate(LuaAlloc, context->m_Allocator);
+        if (L)
+        {
+            lua_atpanic(L, LuaPanic);
+            return L;
+        }
+
+        // 64 bit LuaJIT builds without GC64 don't support custom allocators
+        dmSizeClassAllocator::Delete(context->m_Allocator);
+        context->m_Allocator = 0;
+        return lua_open();
+    }
+
+    static const uint32_t STRING_CACHE_TABLE_SIZE = 683;
+    static const uint32_t STRING_CACHE_CAPACITY = 1024;
+    static const uint32_t STRING_CACHE_MAX_LENGTH = 64;
+
     HContext NewContext(dmConfigFile::HConfig config_file, dmResource::HFactory factory, bool enable_extensions)
     {
         Context* context = new Context();
@@ -79,10 +118,24 @@ namespace dmScript
         context->m_PathToModule.SetCapacity(127, 256);
         context->m_HashInstances.SetCapacity(443, 256);
         context->m_ScriptExtensions.SetCapacity(8);
+        context->m_StringCache.SetCapacity(STRING_CACHE_TABLE_SIZE, STRING_CACHE_CAPACITY);
+        context->m_StringCacheKeys.SetCapacity(STRING_CACHE_CAPACITY);
+        context->m_StringCacheHand = 0;
         context->m_ConfigFile = config_file;
         context->m_ResourceFactory = factory;
-        context->m_LuaState = lua_open();
+        context->m_LuaState = NewLuaState(context);
         context->m_ContextTableRef = LUA_NOREF;
+        context->m_StringCacheTableRef = LUA_NOREF;
+        context->m_TableBuffer = 0;
+        context->m_TableBufferSize = 0;
+        context->m_TableReferenceOwner = new TableReferenceOwner();
+        context->m_TableReferenceOwner->m_LuaState = 0;
+        context->m_TableReferenceOwner->m_TableRef = LUA_NOREF;
+        context->m_TableReferenceOwner->m_RefCount = 1;
+        context->m_GCFrameBudget = 0;
+        context->m_GCHeapGrowthLimit = 0;
+        context->m_GCBaseHeapSize = 0;
+        context->m_GCCycleActive = 0;
         context->m_EnableExtensions = enable_extensions;
         return context;
     }
@@ -91,6 +144,19 @@ namespace dmScript
     {
         ClearModules(context);
         lua_close(context->m_LuaState);
+        if (context->m_TableBuffer)
+        {
+            dmMemory::AlignedFree(context->m_TableBuffer);
+        }
+        if (context->m_Allocator)
+        {
+            dmSizeClassAllocator::Delete(context->m_Allocator);
+        }
+        // Messages still holding table references release the owner when they are destroyed
+        if (--context->m_TableReferenceOwner->m_RefCount == 0)
+        {
+            delete context->m_TableReferenceOwner;
+        }
         delete context;
     }
 
@@ -162,8 +228,8 @@ namespace dmScript
         lua_setfield(L, -2, "mod");
         lua_pop(L, 1);
 
-        InitializeHash(L);
-        InitializeMsg(L);
+        InitializeHash(context);
+        InitializeMsg(context);
         InitializeVmath(L);
         InitializeSys(L);
         InitializeModule(L);
@@ -206,6 +272,13 @@ namespace dmScript
         lua_newtable(L);
         context->m_ContextTableRef = Ref(L, LUA_REGISTRYINDEX);
 
+        lua_newtable(L);
+        context->m_StringCacheTableRef = Ref(L, LUA_REGISTRYINDEX);
+
+        lua_newtable(L);
+        context->m_TableReferenceOwner->m_TableRef = Ref(L, LUA_REGISTRYINDEX);
+        context->m_TableReferenceOwner->m_LuaState = L;
+
         InitializeHttp(context);
         InitializeTimer(context);
         if (context->m_EnableExtensions)
@@ -233,6 +306,8 @@ namespace dmScript
 
     void Update(HContext context)
     {
+        TrimTableBuffer(context);
+
         for (HScriptExtension* l = context->m_ScriptExtensions.Begin(); l != context->m_ScriptExtensions.End(); ++l)
         {
             if ((*l)->Update != 0x0)
@@ -242,6 +317,90 @@ namespace dmScript
         }
     }
 
+    void SetGarbageCollectionBudget(HContext context, uint32_t frame_budget_us, uint32_t heap_growth_limit)
+    {
+        lua_State* L = context->m_LuaState;
+        context->m_GCFrameBudget = frame_budget_us;
+        context->m_GCHeapGrowthLimit = heap_growth_limit;
+        context->m_GCBaseHeapSize = 0; // Captured by the next step, once the scripts have been loaded and updated
+        context->m_GCCycleActive = 0;
+        lua_gc(L, frame_budget_us > 0 ? LUA_GCSTOP : LUA_GCRESTART, 0);
+    }
+
+    static void ProfileAllocator(HContext context)
+    {
+        if (!context->m_Allocator)
+        {
+            return;
+        }
+
+        dmSizeClassAllocator::Stats stats;
+        dmSizeClassAllocator::GetStats(context->m_Allocator, &stats);
+
+        uint32_t small_bytes = 0;
+        uint32_t small_count = 0;
+        for (uint32_t i = 0; i < dmSizeClassAllocator::MAX_SIZE_CLASSES; ++i)
+        {
+            const dmSizeClassAllocator::SizeClassStats& s = stats.m_SizeClasses[i];
+            small_bytes += s.m_Size * s.m_LiveCount;
+            small_count += s.m_LiveCount;
+            if (s.m_LiveCount > 0)
+            {
+                DM_PROFILE_TEXT("lua alloc %u b: %u live, %u kb, %u allocs", s.m_Size, s.m_LiveCount, (s.m_Size * s.m_LiveCount) / 1024, s.m_AllocationCount);
+            }
+        }
+
+        DM_PROPERTY_ADD_U32(rmtp_ScriptSmallAllocBytes, small_bytes);
+        DM_PROPERTY_ADD_U32(rmtp_ScriptSmallAllocCount, small_count);
+        DM_PROPERTY_ADD_U32(rmtp_ScriptLargeAllocBytes, (uint32_t) stats.m_LargeLiveBytes);
+    }
+
+    void StepGarbageCollection(HContext context, uint64_t end_time)
+    {
+        DM_PROFILE(__FUNCTION__);
+        lua_State* L = context->m_LuaState;
+        uint32_t heap_size = (uint32_t)lua_gc(L, LUA_GCCOUNT, 0);
+
+        // The budget is set before the main collection is loaded, so the heap size of the first frame is the base
+        if (context->m_GCFrameBudget > 0 && context->m_GCBaseHeapSize == 0)
+        {
+            context->m_GCBaseHeapSize = dmMath::Max(1U, heap_size);
+        }
+
+        if (context->m_GCFrameBudget > 0 && (context->m_GCCycleActive || heap_size > context->m_GCBaseHeapSize))
+        {
+            // When the heap has outgrown the limit, the current cycle is finished regardless of the budget
+            bool spill = context->m_GCHeapGrowthLimit > 0 &&
+                         (uint64_t)heap_size * 100 > (uint64_t)context->m_GCBaseHeapSize * context->m_GCHeapGrowthLimit;
+
+            uint64_t start = dmTime::GetTime();
+            context->m_GCCycleActive = 1;
+            while (true)
+            {
+                if (lua_gc(L, LUA_GCSTEP, 0))
+                {
+                    context->m_GCCycleActive = 0;
+                    context->m_GCBaseHeapSize = (uint32_t)lua_gc(L, LUA_GCCOUNT, 0);
+                    break;
+                }
+                if (!spill && dmTime::GetTime() >= end_time)
+                {
+                    break;
+                }
+            }
+
+            // Stepping re-arms the automatic collector
+            lua_gc(L, LUA_GCSTOP, 0);
+
+            heap_size = (uint32_t)lua_gc(L, LUA_GCCOUNT, 0);
+            DM_PROPERTY_ADD_U32(rmtp_ScriptGCTime, (uint32_t)(dmTime::GetTime() - start));
+        }
+
+        DM_PROPERTY_ADD_U32(rmtp_ScriptHeapSize, heap_size);
+
+        ProfileAllocator(context);
+    }
+
     void Finalize(HContext context)
     {
         lua_State* L = context->m_LuaState;
@@ -260,6 +419,16 @@ namespace dmScript
         lua_pop(L, 1);
 
         Unref(L, LUA_REGISTRYINDEX, context->m_ContextTableRef);
+        Unref(L, LUA_REGISTRYINDEX, context->m_StringCacheTableRef);
+        context->m_StringCacheTableRef = LUA_NOREF;
+        context->m_StringCache.Clear();
+        context->m_StringCacheKeys.SetSize(0);
+
+        // Release the tables of the messages that are still pending, the messages ignore their references from now on
+        Unref(L, LUA_REGISTRYINDEX, context->m_TableReferenceOwner->m_TableRef);
+        context->m_TableReferenceOwner->m_TableRef = LUA_NOREF;
+        context->m_TableReferenceOwner->m_LuaState = 0;
+        context->m_StringCacheHand = 0;
     }
 
     lua_State* GetLuaState(HContext context)
@@ -807,6 +976,79 @@ namespace dmScript
         return false;
     }
 
+    StringCacheEntry* GetStringCacheEntry(HContext context, lua_State* L, int index)
+    {
+        if (context == 0 || context->m_StringCacheTableRef == LUA_NOREF || lua_type(L, index) != LUA_TSTRING)
+        {
+            return 0;
+        }
+        size_t length;
+        uintptr_t key = (uintptr_t)lua_tolstring(L, index, &length);
+        StringCacheEntry* entry = context->m_StringCache.Get(key);
+        if (entry != 0)
+        {
+            entry->m_Referenced = 1;
+            return entry;
+        }
+        // Long strings are rarely reused literals, and would only push the short ones out
+        if (length > STRING_CACHE_MAX_LENGTH)
+        {
+            return 0;
+        }
+
+        // The string must stay alive while it is cached, otherwise a new string could be allocated at the same address
+        lua_pushvalue(L, index);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, context->m_StringCacheTableRef);
+
+        dmArray<uintptr_t>& keys = context->m_StringCacheKeys;
+        uint32_t slot = keys.Size();
+        if (context->m_StringCache.Full())
+        {
+            // Clock eviction, the hand skips (and clears) the entries used since it last passed them
+            for (;;)
+            {
+                uint32_t hand = context->m_StringCacheHand;
+                context->m_StringCacheHand = (hand + 1) % keys.Size();
+                StringCacheEntry* evict = context->m_StringCache.Get(keys[hand]);
+                if (!evict->m_Referenced)
+                {
+                    context->m_StringCache.Erase(keys[hand]);
+                    lua_pushlightuserdata(L, (void*)keys[hand]);
+                    lua_pushnil(L);
+                    lua_rawset(L, -3);
+                    slot = hand;
+                    break;
+                }
+                evict->m_Referenced = 0;
+            }
+            keys[slot] = key;
+        }
+        else
+        {
+            keys.Push(key);
+        }
+
+        lua_pushlightuserdata(L, (void*)key);
+        lua_pushvalue(L, -3);
+        lua_rawset(L, -3);
+        lua_pop(L, 2);
+
+        StringCacheEntry new_entry;
+        memset(&new_entry, 0, sizeof(new_entry));
+        context->m_StringCache.Put(key, new_entry);
+        return context->m_StringCache.Get(key);
+    }
+
+    static void InvalidateURLCallback(void*, const uintptr_t*, StringCacheEntry* entry)
+    {
+        entry->m_URLValid = 0;
+    }
+
+    void InvalidateStringCacheURLs(HContext context)
+    {
+        context->m_StringCache.Iterate(InvalidateURLCallback, (void*)0);
+    }
+
     bool GetURL(lua_State* L, dmMessage::URL& out_url) {
         DM_LUA_STACK_CHECK(L, 0);
         GetInstance(L);
@@ -1088,6 +1330,7 @@ namespace dmScript
         lua_State* L = script_world->m_Context->m_LuaState;
         lua_newtable(L);
         script_world->m_WorldContextTableRef = Ref(L, LUA_REGISTRYINDEX);
+        InvalidateStringCacheURLs(context);
         for (HScriptExtension* l = context->m_ScriptExtensions.Begin(); l != context->m_ScriptExtensions.End(); ++l)
         {
             if ((*l)->NewScriptWorld != 0x0)
@@ -1111,6 +1354,7 @@ namespace dmScript
         }
         lua_State* L = script_world->m_Context->m_LuaState;
         Unref(L, LUA_REGISTRYINDEX, script_world->m_WorldContextTableRef);
+        InvalidateStringCacheURLs(context);
 
         free(script_world);
     }
@@ -196,6 +196,28 @@ namespace dmScript
      */
     void Update(HContext context);
 
+    /**
+     * Puts the Lua garbage collector of the context under frame control. The automatic
+     * collector is stopped and StepGarbageCollection() performs incremental steps
+     * until the end time of the frame, that is passed to each call. If the heap has grown past
+     * heap_growth_limit percent of its size after the last full cycle, the step runs
+     * until the cycle is complete. Until the first cycle is complete, the size is taken
+     * by the first StepGarbageCollection() call, which doesn't collect.
+     * @param context script context
+     * @param frame_budget_us time budget per frame in microseconds, 0 restores the automatic collector
+     * @param heap_growth_limit heap growth in percent before the budget may be exceeded, 0 disables the limit
+     */
+    void SetGarbageCollectionBudget(HContext context, uint32_t frame_budget_us, uint32_t heap_growth_limit);
+
+    /**
+     * Performs the garbage collection work of a frame, see SetGarbageCollectionBudget()
+     * When there is collection work to do, at least one step is performed even if the end time has passed.
+     * @param context script context
+     * @param end_time time, as returned by dmTime::GetTime(), to stop stepping at. Contexts collected
+     *                 in the same frame share the frame budget by passing the same end time
+     */
+    void StepGarbageCollection(HContext context, uint64_t end_time);
+
     /**
      * Finalize script libraries
      * @param context script context
@@ -265,6 +287,16 @@ namespace dmScript
      */
     uint32_t CheckTable(lua_State* L, char* buffer, uint32_t buffer_size, int index);
     
+    /**
+     * Serialize a table in a single pass to a buffer owned by the script context, that grows to fit the table.
+     * The buffer is DM_ALIGNED(16) and is valid until the next table is serialized in the context, or the context is updated.
+     * @param L Lua state
+     * @param index Index of the table
+     * @param size [out] Number of bytes used in the buffer
+     * @return Buffer with the serialized table
+     */
+    const char* CheckTableBuffer(lua_State* L, int index, uint32_t* size);
+
     /**
      * Get the size of a table when serialized
      * @param L Lua state
@@ -281,6 +313,15 @@ namespace dmScript
      */
     void PushTable(lua_State*L, const char* data, uint32_t data_size);
 
+    /**
+     * Push the table of a message to the supplied lua state, will increase the stack by 1.
+     * Unlike PushTable(), this also pushes tables posted by reference from the same script context.
+     * @param L Lua state
+     * @param data Message data with a serialized table or a table reference
+     * @param data_size Size of the message data
+     */
+    void PushMessageTable(lua_State* L, const char* data, uint32_t data_size);
+
     /**
      * Removes a hash value from the currently known hashes.
      * @param L Lua state
@@ -303,6 +344,19 @@ namespace dmScript
      */
     void PushVector(lua_State* L, dmVMath::FloatVector* v);
 
+    /**
+     * Stores a value in the optional output argument at out_index and pushes that argument,
+     * or pushes a new value if the argument is none or nil. Will increase the stack by 1.
+     * Raises a lua error if the output argument is of the wrong type.
+     * @param L Lua state
+     * @param v value to store
+     * @param out_index Index of the optional output argument
+     */
+    void PushVector3(lua_State* L, const dmVMath::Vector3& v, int out_index);
+    void PushVector4(lua_State* L, const dmVMath::Vector4& v, int out_index);
+    void PushQuat(lua_State* L, const dmVMath::Quat& q, int out_index);
+    void PushMatrix4(lua_State* L, const dmVMath::Matrix4& m, int out_index);
+
     /**
      * Check if the value in the supplied index on the lua stack is a Vector.
      * @param L Lua state
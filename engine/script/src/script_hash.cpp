@@ -48,6 +48,21 @@ namespace dmScript
         return (dmhash_t*)dmScript::ToUserType(L, index, SCRIPT_HASH_TYPE_HASH);
     }
 
+    dmhash_t GetStringHash(HContext context, lua_State* L, int index)
+    {
+        StringCacheEntry* entry = GetStringCacheEntry(context, L, index);
+        if (entry == 0)
+        {
+            return dmHashString64(lua_tostring(L, index));
+        }
+        if (!entry->m_HashValid)
+        {
+            entry->m_Hash = dmHashString64(lua_tostring(L, index));
+            entry->m_HashValid = 1;
+        }
+        return entry->m_Hash;
+    }
+
     /*# hashes a string
      * All ids in the engine are represented as hashes, so a string needs to be hashed
      * before it can be compared with an id.
@@ -78,8 +93,9 @@ namespace dmScript
         }
         else
         {
-            const char* str = luaL_checkstring(L, 1);
-            hash = dmHashString64(str);
+            luaL_checkstring(L, 1);
+            HContext context = (HContext)lua_touserdata(L, lua_upvalueindex(1));
+            hash = GetStringHash(context, L, 1);
         }
         PushHash(L, hash);
 
@@ -346,14 +362,16 @@ namespace dmScript
         {0, 0}
     };
 
-    void InitializeHash(lua_State* L)
+    void InitializeHash(HContext context)
     {
+        lua_State* L = context->m_LuaState;
         int top = lua_gettop(L);
         luaL_newmetatable(L, SCRIPT_TYPE_NAME_HASH);
 
         SCRIPT_HASH_TYPE_HASH = dmScript::SetUserType(L, -1, SCRIPT_TYPE_NAME_HASH);
 
-        luaL_openlib(L, 0x0, ScriptHash_methods, 0);
+        lua_pushlightuserdata(L, (void*)context);
+        luaL_openlib(L, 0x0, ScriptHash_methods, 1);
 
         lua_pushstring(L, "__eq");
         lua_pushcfunction(L, Script_eq);
@@ -367,7 +385,9 @@ namespace dmScript
         lua_pushcfunction(L, Script_concat);
         lua_settable(L, -3);
 
-        lua_pushcfunction(L, Script_Hash);
+        // The context is an upvalue, so the string cache is reached without a global lookup
+        lua_pushlightuserdata(L, (void*)context);
+        lua_pushcclosure(L, Script_Hash, 1);
         lua_setglobal(L, SCRIPT_TYPE_NAME_HASH);
 
         lua_pushcfunction(L, Script_HashToHex);
@@ -22,7 +22,9 @@ extern "C"
 
 namespace dmScript
 {
-    void InitializeHash(lua_State* L);
+    typedef struct Context* HContext;
+
+    void InitializeHash(HContext context);
 }
 
 #endif // DM_SCRIPT_HASH_H
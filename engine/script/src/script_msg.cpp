@@ -51,6 +51,14 @@ namespace dmScript
 
     const uint32_t MAX_MESSAGE_DATA_SIZE = 2048;
 
+    static int ResolveURL(HContext context, lua_State* L, int index, dmMessage::URL* out_url, dmMessage::URL* out_default_url);
+
+    // The msg functions have the script context as upvalue
+    static HContext GetMsgContext(lua_State* L)
+    {
+        return (HContext)lua_touserdata(L, lua_upvalueindex(1));
+    }
+
     bool IsURL(lua_State *L, int index)
     {
         return (dmMessage::URL*)dmScript::ToUserType(L, index, SCRIPT_URL_TYPE_HASH);
@@ -337,7 +345,7 @@ namespace dmScript
         dmMessage::ResetURL(&url);
         if (top < 2)
         {
-            ResolveURL(L, 1, &url, 0x0);
+            ResolveURL(GetMsgContext(L), L, 1, &url, 0x0);
         }
         else if (top == 3)
         {
@@ -457,12 +465,23 @@ namespace dmScript
      * - `"."` the current game object
      * - `"#"` the current component
      *
-     * [icon:attention] There is a 2 kilobyte limit to the message parameter table size.
+     * Message parameter tables are copied when the message is posted. Large tables cost
+     * more to copy, but there is no fixed limit to their size.
+     *
+     * A table can instead be passed by reference with the `by_reference` option. The receiver
+     * gets the same table without any copying, so the sender must not modify it after posting.
+     * This only works for receivers running in the same script context as the sender, i.e. game
+     * object scripts sending to game object scripts unless the script contexts are shared.
      *
      * @name msg.post
      * @param receiver [type:string|url|hash] The receiver must be a string in URL-format, a URL object or a hashed string.
      * @param message_id [type:string|hash] The id must be a string or a hashed string.
      * @param [message] [type:table|nil] a lua table with message parameters to send.
+     * @param [options] [type:table] optional table with the following fields:
+     *
+     * `by_reference`
+     * : [type:boolean] pass the message table by reference instead of copying it. Not used for system messages.
+     *
      * @examples
      *
      * Send "enable" to the sprite "my_sprite" in "my_gameobject":
@@ -477,7 +496,32 @@ namespace dmScript
      * local params = {my_parameter = "my_value"}
      * msg.post(my_url, "my_message", params)
      * ```
+     *
+     * Send a large state snapshot to another game object without copying it:
+     *
+     * ```lua
+     * msg.post("/enemy", "snapshot", self.snapshot, { by_reference = true })
+     * self.snapshot = {}
+     * ```
      */
+    static bool IsPostByReference(lua_State* L, int index)
+    {
+        if (lua_gettop(L) < index || lua_isnil(L, index))
+        {
+            return false;
+        }
+        luaL_checktype(L, index, LUA_TTABLE);
+        lua_getfield(L, index, "by_reference");
+        bool by_reference = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+        return by_reference;
+    }
+
+    static void ReleaseTableReferenceCallback(dmMessage::Message* message)
+    {
+        ReleaseTableReference((const char*)message->m_Data, message->m_DataSize);
+    }
+
     int Msg_Post(lua_State* L)
     {
         int top = lua_gettop(L);
@@ -488,20 +532,23 @@ namespace dmScript
 
         dmMessage::URL receiver;
         dmMessage::URL sender;
-        ResolveURL(L, 1, &receiver, &sender);
+        HContext context = GetMsgContext(L);
+        ResolveURL(context, L, 1, &receiver, &sender);
 
         dmhash_t message_id;
         if (lua_isstring(L, 2))
         {
-            message_id = dmHashString64(lua_tostring(L, 2));
+            message_id = GetStringHash(context, L, 2);
         }
         else
         {
             message_id = CheckHash(L, 2);
         }
 
-        char DM_ALIGNED(16) data[MAX_MESSAGE_DATA_SIZE];
+        char DM_ALIGNED(16) data_buffer[MAX_MESSAGE_DATA_SIZE];
+        const char* data = data_buffer;
         uint32_t data_size = 0;
+        dmMessage::MessageDestroyCallback destroy_callback = 0;
 
 
         const dmDDF::Descriptor* desc = dmDDF::GetDescriptorFromHash(message_id);
@@ -520,20 +567,32 @@ namespace dmScript
             {
                 lua_newtable(L);
             }
-            data_size = dmScript::CheckDDF(L, desc, data, MAX_MESSAGE_DATA_SIZE, -1);
+            data_size = dmScript::CheckDDF(L, desc, data_buffer, MAX_MESSAGE_DATA_SIZE, -1);
             lua_pop(L, 1);
         }
         else if (top > 2)
         {
             if (!lua_isnil(L, 3))
             {
-                data_size = dmScript::CheckTable(L, data, MAX_MESSAGE_DATA_SIZE, 3);
+                if (IsPostByReference(L, 4))
+                {
+                    data_size = CheckTableReference(L, data_buffer, MAX_MESSAGE_DATA_SIZE, 3);
+                    destroy_callback = ReleaseTableReferenceCallback;
+                }
+                else
+                {
+                    data = dmScript::CheckTableBuffer(L, 3, &data_size);
+                }
             }
         }
 
         assert(top == lua_gettop(L));
 
-        dmMessage::Result result = dmMessage::Post(&sender, &receiver, message_id, 0, (uintptr_t) desc, data, data_size, 0);
+        dmMessage::Result result = dmMessage::Post(&sender, &receiver, message_id, 0, (uintptr_t) desc, data, data_size, destroy_callback);
+        if (result != dmMessage::RESULT_OK && destroy_callback != 0)
+        {
+            ReleaseTableReference(data, data_size);
+        }
         if (result == dmMessage::RESULT_SOCKET_NOT_FOUND)
         {
             char receiver_buffer[64];
@@ -557,13 +616,15 @@ namespace dmScript
         {0, 0}
     };
 
-    void InitializeMsg(lua_State* L)
+    void InitializeMsg(HContext context)
     {
+        lua_State* L = context->m_LuaState;
         int top = lua_gettop(L);
 
         SCRIPT_URL_TYPE_HASH = dmScript::RegisterUserType(L, SCRIPT_TYPE_NAME_URL, URL_methods, URL_meta);
 
-        luaL_register(L, SCRIPT_LIB_NAME, ScriptMsg_methods);
+        lua_pushlightuserdata(L, (void*)context);
+        luaL_openlib(L, SCRIPT_LIB_NAME, ScriptMsg_methods, 1);
         lua_pop(L, 1);
 
         assert(top == lua_gettop(L));
@@ -657,7 +718,45 @@ namespace dmScript
         return url->m_SocketSize > 0 && url->m_PathSize > 0 && *url->m_Path == '/';
     }
 
+    static void CacheURL(StringCacheEntry* entry, const char* url, const dmMessage::StringURL& string_url, const dmMessage::URL& resolved_url, const dmMessage::URL& default_url)
+    {
+        bool default_path = url[0] == '.' && url[1] == '\0';
+        bool default_all = url[0] == '#' && url[1] == '\0';
+        bool global = !default_path && !default_all && string_url.m_SocketSize > 0;
+        bool relative = !default_path && !default_all && !global;
+        entry->m_URL = resolved_url;
+        entry->m_DefaultURL = default_url;
+        entry->m_URLValid = 1;
+        entry->m_URLGlobal = global;
+        entry->m_URLDefaultSocket = !global;
+        entry->m_URLDefaultPath = default_path || default_all || (relative && string_url.m_PathSize == 0);
+        entry->m_URLDefaultFragment = default_all || (relative && string_url.m_PathSize == 0 && string_url.m_FragmentSize == 0);
+        entry->m_URLResolvedPath = relative && string_url.m_PathSize > 0;
+    }
+
+    static bool GetCachedURL(const StringCacheEntry* entry, const dmMessage::URL& default_url, dmMessage::URL* out_url)
+    {
+        // A path resolved relative to another instance must be resolved again
+        if (entry->m_URLResolvedPath && (entry->m_DefaultURL.m_Socket != default_url.m_Socket || entry->m_DefaultURL.m_Path != default_url.m_Path))
+        {
+            return false;
+        }
+        *out_url = entry->m_URL;
+        if (entry->m_URLDefaultSocket)
+            out_url->m_Socket = default_url.m_Socket;
+        if (entry->m_URLDefaultPath)
+            out_url->m_Path = default_url.m_Path;
+        if (entry->m_URLDefaultFragment)
+            out_url->m_Fragment = default_url.m_Fragment;
+        return true;
+    }
+
     int ResolveURL(lua_State* L, int index, dmMessage::URL* out_url, dmMessage::URL* out_default_url)
+    {
+        return ResolveURL(GetScriptContext(L), L, index, out_url, out_default_url);
+    }
+
+    static int ResolveURL(HContext context, lua_State* L, int index, dmMessage::URL* out_url, dmMessage::URL* out_default_url)
     {
         if (dmScript::IsURL(L, index))
         {
@@ -670,6 +769,31 @@ namespace dmScript
         }
         else
         {
+            // Strings that resolved without errors are cached, so repeated posts to string literals skip the parsing and hashing
+            StringCacheEntry* entry = GetStringCacheEntry(context, L, index);
+            dmMessage::URL default_url;
+            dmMessage::ResetURL(&default_url);
+            bool has_default_url = false;
+            if (entry != 0 && entry->m_URLValid)
+            {
+                if (!entry->m_URLGlobal)
+                {
+                    GetURL(L, &default_url);
+                    has_default_url = true;
+                }
+                if (GetCachedURL(entry, default_url, out_url))
+                {
+                    if (out_default_url != 0x0)
+                    {
+                        if (!has_default_url)
+                        {
+                            GetURL(L, &default_url);
+                        }
+                        *out_default_url = default_url;
+                    }
+                    return 0;
+                }
+            }
 
             const char* url = 0;
             dmMessage::StringURL string_url;
@@ -705,6 +829,10 @@ namespace dmScript
                                 out_url->m_Socket = socket;
                                 out_url->m_Path = dmHashBuffer64(string_url.m_Path, string_url.m_PathSize);
                                 out_url->m_Fragment = dmHashBuffer64(string_url.m_Fragment, string_url.m_FragmentSize);
+                                if (entry != 0)
+                                {
+                                    CacheURL(entry, url, string_url, *out_url, default_url);
+                                }
                                 if (out_default_url != 0x0)
                                 {
                                     dmMessage::ResetURL(out_default_url);
@@ -720,9 +848,10 @@ namespace dmScript
                 }
             }
             // Fetch default URL from the lua state
-            dmMessage::URL default_url;
-            dmMessage::ResetURL(&default_url);
-            GetURL(L, &default_url);
+            if (!has_default_url)
+            {
+                GetURL(L, &default_url);
+            }
             if (out_default_url != 0x0)
             {
                 *out_default_url = default_url;
@@ -739,6 +868,15 @@ namespace dmScript
                 if (parse_url_result == dmMessage::RESULT_OK)
                 {
                     result = ResolveURL(L, url, out_url, &default_url);
+                    if (result == dmMessage::RESULT_OK)
+                    {
+                        // Resolving the path calls into lua, get the entry again
+                        entry = GetStringCacheEntry(context, L, index);
+                        if (entry != 0)
+                        {
+                            CacheURL(entry, url, string_url, *out_url, default_url);
+                        }
+                    }
                 }
                 if (result != dmMessage::RESULT_OK)
                 {
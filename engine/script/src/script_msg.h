@@ -22,7 +22,9 @@ extern "C"
 
 namespace dmScript
 {
-    void InitializeMsg(lua_State* L);
+    typedef struct Context* HContext;
+
+    void InitializeMsg(HContext context);
 }
 
 #endif // DM_SCRIPT_MSG_H
@@ -16,6 +16,7 @@
 #define SCRIPT_PRIVATE_H
 
 #include <dlib/hashtable.h>
+#include <dlib/size_class_allocator.h>
 
 #define SCRIPT_MAIN_THREAD "__script_main_thread"
 #define SCRIPT_ERROR_HANDLER_VAR "__error_handler"
@@ -65,8 +66,38 @@ namespace dmScript
         char*       m_Filename;
     };
 
+    /**
+     * Cached results for a Lua string, keyed by the string pointer. Lua strings are interned,
+     * so every use of the same string literal maps to the same entry.
+     */
+    struct StringCacheEntry
+    {
+        dmhash_t        m_Hash;         // dmHashString64 of the string
+        dmMessage::URL  m_URL;          // URL the string resolved to
+        dmMessage::URL  m_DefaultURL;   // Default URL m_URL was resolved against
+        uint8_t         m_HashValid:1;
+        uint8_t         m_URLValid:1;
+        uint8_t         m_URLGlobal:1;          // m_URL doesn't depend on the default URL
+        uint8_t         m_URLDefaultSocket:1;   // The socket is taken from the default URL
+        uint8_t         m_URLDefaultPath:1;     // The path is taken from the default URL
+        uint8_t         m_URLDefaultFragment:1; // The fragment is taken from the default URL
+        uint8_t         m_URLResolvedPath:1;    // The path was resolved relative to m_DefaultURL
+        uint8_t         m_Referenced:1;         // Used since the eviction hand last passed it
+    };
+
     typedef struct ScriptExtension* HScriptExtension;
 
+    /*
+     * Owns the tables passed by reference in messages. It is shared by the context and the messages,
+     * since a message can be destroyed after the context, e.g. when its socket is deleted later.
+     */
+    struct TableReferenceOwner
+    {
+        lua_State*  m_LuaState;     // 0 once the context is finalized
+        int         m_TableRef;     // Registry reference of the table holding the referenced tables
+        uint32_t    m_RefCount;     // One for the context, plus one per table reference
+    };
+
     struct Context
     {
         dmConfigFile::HConfig       m_ConfigFile;
@@ -76,7 +107,20 @@ namespace dmScript
         dmHashTable64<int>          m_HashInstances;
         dmArray<HScriptExtension>   m_ScriptExtensions;
         lua_State*                  m_LuaState;
+        dmSizeClassAllocator::HAllocator m_Allocator;   // 0 if the Lua state uses the default allocator
         int                         m_ContextTableRef;
+        dmHashTable<uintptr_t, StringCacheEntry> m_StringCache;
+        dmArray<uintptr_t>          m_StringCacheKeys;      // Eviction ring of the cached string pointers
+        uint32_t                    m_StringCacheHand;      // Next slot in m_StringCacheKeys to consider for eviction
+        int                         m_StringCacheTableRef;  // Keeps the cached strings alive, so their pointers aren't reused
+        char*                       m_TableBuffer;          // Grows to fit the tables serialized with CheckTableBuffer(), see TrimTableBuffer()
+        uint32_t                    m_TableBufferSize;
+        dmHashTable<uintptr_t, uint32_t> m_TableStrings;    // Index of each string written to the serialized table
+        TableReferenceOwner*        m_TableReferenceOwner;
+        uint32_t                    m_GCFrameBudget;        // Microseconds per frame, 0 means the automatic Lua collector is used
+        uint32_t                    m_GCHeapGrowthLimit;    // Percent of m_GCBaseHeapSize before a step may exceed the budget
+        uint32_t                    m_GCBaseHeapSize;       // Heap size in KB after the last completed cycle
+        uint8_t                     m_GCCycleActive:1;
         bool                        m_EnableExtensions;
     };
 
@@ -88,6 +132,56 @@ namespace dmScript
 
     bool IsValidInstance(lua_State* L);
 
+    /**
+     * Get the string cache entry of the string at index, a new entry is zero initialized.
+     * Only short strings are cached. When the cache is full, an entry that hasn't been used
+     * recently is evicted. The entry is only valid until the next call.
+     * @param context script context
+     * @param L lua state
+     * @param index index of the value
+     * @return cache entry, 0 if the value isn't a short string
+     */
+    StringCacheEntry* GetStringCacheEntry(HContext context, lua_State* L, int index);
+
+    /**
+     * Hash the string at index, through the string cache
+     * @param context script context
+     * @param L lua state
+     * @param index index of the string
+     * @return hash of the string
+     */
+    dmhash_t GetStringHash(HContext context, lua_State* L, int index);
+
+    /**
+     * Write a reference to the table at index, instead of serializing it. The table is kept alive
+     * until ReleaseTableReference() is called or the context is finalized, and PushMessageTable() pushes the same table.
+     * @param L lua state
+     * @param buffer buffer to write the reference to, 16 byte aligned
+     * @param buffer_size size of the buffer
+     * @param index index of the table
+     * @return number of bytes written
+     */
+    uint32_t CheckTableReference(lua_State* L, char* buffer, uint32_t buffer_size, int index);
+
+    /**
+     * Release a table reference written by CheckTableReference(). Serialized tables are ignored.
+     * @param buffer the buffer
+     * @param buffer_size size of the buffer
+     */
+    void ReleaseTableReference(const char* buffer, uint32_t buffer_size);
+
+    /**
+     * Release the buffers used to serialize tables, if a large table made them grow. Called once per frame.
+     * @param context script context
+     */
+    void TrimTableBuffer(HContext context);
+
+    /**
+     * Invalidate the cached URLs, which depend on the collections that are loaded.
+     * @param context script context
+     */
+    void InvalidateStringCacheURLs(HContext context);
+
     /**
      * Remove all modules.
      * @param context script context
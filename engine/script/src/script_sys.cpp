@@ -98,12 +98,9 @@ union SaveLoadBuffer
     /*# saves a lua table to a file stored on disk
      * The table can later be loaded by <code>sys.load</code>.
      * Use <code>sys.get_save_file</code> to obtain a valid location for the file.
-     * Internally, this function uses a workspace buffer sized output file sized 512kb.
-     * This size reflects the output file size which must not exceed this limit.
-     * Additionally, the total number of rows that any one table may contain is limited to 65536
-     * (i.e. a 16 bit range). When tables are used to represent arrays, the values of
-     * keys are permitted to fall within a 32 bit range, supporting sparse arrays, however
-     * the limit on the total number of rows remains in effect.
+     * The table is serialized in a single pass to a workspace buffer that grows to fit the table
+     * and is reused by later calls. Numeric keys are limited to a 32 bit range
+     * (i.e. -4294967295 to 4294967295), supporting sparse arrays.
      *
      * @name sys.save
      * @param filename [type:string] file to write to
@@ -129,14 +126,8 @@ union SaveLoadBuffer
 
         luaL_checktype(L, 2, LUA_TTABLE);
 
-        uint32_t table_size = CheckTableSize(L, 2);
-
-        char* buffer = Sys_SetupTableSerializationBuffer(table_size);
-        if (!buffer)
-        {
-            return luaL_error(L, "Could not allocate %d bytes for table serialization.", table_size);
-        }
-        uint32_t n_used = CheckTable(L, buffer, table_size, 2);
+        uint32_t n_used = 0;
+        const char* buffer = CheckTableBuffer(L, 2, &n_used);
 
 #if !defined(__EMSCRIPTEN__)
 
@@ -148,14 +139,12 @@ union SaveLoadBuffer
         int res = dmSnPrintf(tmp_filename, sizeof(tmp_filename), "%s.defoldtmp_%x_%d", filename, hash, save_counter++);
         if (res == -1)
         {
-            Sys_FreeTableSerializationBuffer(buffer);
             return luaL_error(L, "Could not write to the file %s. Path too long.", filename);
         }
 
         FILE* file = fopen(tmp_filename, "wb");
         if (!file)
         {
-            Sys_FreeTableSerializationBuffer(buffer);
             char errmsg[128] = {};
             dmStrError(errmsg, sizeof(errmsg), errno);
             return luaL_error(L, "Could not open the file %s, reason: %s.", tmp_filename, errmsg);
@@ -163,7 +152,6 @@ union SaveLoadBuffer
 
         bool result = fwrite(buffer, 1, n_used, file) == n_used;
         result = (fclose(file) == 0) && result;
-        Sys_FreeTableSerializationBuffer(buffer);
 
         if (!result)
         {
@@ -184,13 +172,11 @@ union SaveLoadBuffer
         FILE* file = fopen(filename, "wb");
         if (!file)
         {
-            Sys_FreeTableSerializationBuffer(buffer);
             return luaL_error(L, "Could not write to the file %s.", filename);
         }
 
         bool result = fwrite(buffer, 1, n_used, file) == n_used;
         result = (fclose(file) == 0) && result;
-        Sys_FreeTableSerializationBuffer(buffer);
 
         if (!result)
         {
@@ -1210,16 +1196,9 @@ union SaveLoadBuffer
         DM_LUA_STACK_CHECK(L, 1);
         luaL_checktype(L, 1, LUA_TTABLE);
 
-        uint32_t table_size = CheckTableSize(L, 1);
-        char* buffer = Sys_SetupTableSerializationBuffer(table_size);
-        if (!buffer)
-        {
-            return luaL_error(L, "Could not allocate %d bytes for table serialization.", table_size);
-        }
-
-        uint32_t n_used = CheckTable(L, buffer, table_size, 1);
-        lua_pushlstring(L, (const char*)buffer, n_used);
-        Sys_FreeTableSerializationBuffer(buffer);
+        uint32_t n_used = 0;
+        const char* buffer = CheckTableBuffer(L, 1, &n_used);
+        lua_pushlstring(L, buffer, n_used);
         return 1;
 
     }
@@ -14,8 +14,11 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <math.h>
 #include <dlib/log.h>
 #include <dlib/dstrings.h>
+#include <dlib/math.h>
+#include <dlib/memory.h>
 #include <dlib/static_assert.h>
 #include "script.h"
 #include "script_private.h"
@@ -45,7 +48,8 @@ typedef lua_Number lua_Number_4_align;
 namespace dmScript
 {
     const int TABLE_MAGIC = 0x42544448;
-    const uint32_t TABLE_VERSION_CURRENT = 4;
+    const int TABLE_REFERENCE_MAGIC = 0x42545246;
+    const uint32_t TABLE_VERSION_CURRENT = 5;
 
     /*
      * Original table serialization format:
@@ -95,6 +99,22 @@ namespace dmScript
      *
      *    Version 4:
      *    Adds support for more than 65535 keys in a table.
+     *
+     *    Version 5:
+     *    Written in a single pass, without the size check, to a buffer that may grow. Tables are written as:
+     *
+     *    uint32_t   count of the hash part, the MSB is set if there is an array part
+     *    varint     array count (if array part)
+     *    uint8_t    array type (if array part), ARRAY_TYPE_NUMBERS for a packed lua_Number array or ARRAY_TYPE_VALUES
+     *    T          array values
+     *    T          key, value
+     *    ...
+     *
+     *    The array part holds the values 1..n, the hash part all other keys. Keys and values start with a ValueTag.
+     *    Integral numbers are written as zigzag varints. Strings of up to STRING_DEDUP_MAX_LENGTH bytes are numbered
+     *    in the order they are written and a repeated string is written as a reference to that number.
+     *    Nothing is aligned and the reader copies each value out of the buffer, reading it front to back.
+     *    Versions 0 to 4 can still be read.
      */
 
     struct TableHeader
@@ -107,28 +127,17 @@ namespace dmScript
         }
     };
 
-    static bool EncodeMSB(uint32_t value, char*& buffer, const char* buffer_end)
+    /*
+     * A table reference is written in place of a serialized table when a table is passed by reference
+     * to a receiver in the same script context. The table is kept alive by a reference in the table of
+     * the owner, that is released with ReleaseTableReference() or when the context is finalized.
+     */
+    struct TableReference
     {
-        bool ok = true;
-        while (0x7f < value)
-        {
-            if (buffer >= buffer_end)
-            {
-                break;
-            }
-            *buffer++ = ((uint8_t)(value & 0x7f)) | 0x80;
-            value >>= 7;
-        }
-        if (buffer < buffer_end)
-        {
-            *buffer++ = ((uint8_t)value) & 0x7f;
-        }
-        else
-        {
-            ok = false;
-        }
-        return ok;
-    }
+        TableHeader             m_Header;
+        TableReferenceOwner*    m_Owner;
+        int                     m_Reference;
+    };
 
     static bool DecodeMSB(uint32_t& value, const char*& buffer)
     {
@@ -193,6 +202,7 @@ namespace dmScript
         case 2:
         case 3:
         case 4:
+        case 5:
             supported = true;
             break;
         default:
@@ -201,69 +211,6 @@ namespace dmScript
         return supported;
     }
 
-    static char* WriteEncodedIndex(lua_State* L, lua_Number index, const TableHeader& header, char* buffer, const char* buffer_end)
-    {
-        if (0 == header.m_Version)
-        {
-            if (buffer_end - buffer < 2)
-                luaL_error(L, "table too large");
-            if (index > 0xffff)
-                luaL_error(L, "index out of bounds, max is %d", 0xffff);
-            uint16_t key = (uint16_t)index;
-            memcpy(buffer, &key, sizeof(uint16_t));
-            buffer += sizeof(uint16_t);
-        }
-        else if ((1 == header.m_Version) || (2 == header.m_Version))
-        {
-            if (index > 0xffffffff) {
-                luaL_error(L, "index out of bounds, max is %d", 0xffffffff);
-            }
-            uint32_t key = (uint32_t)index;
-            bool encoded = EncodeMSB(key, buffer, buffer_end);
-            if (!encoded)
-            {
-                luaL_error(L, "table too large");
-            }
-        }
-        else if ((3 == header.m_Version) || (4 == header.m_Version))
-        {
-            if (buffer_end - buffer < 4)
-                luaL_error(L, "table too large");
-            if (index < 0)
-                index = -index;
-            if (index > 0xffffffff)
-                luaL_error(L, "index out of bounds, max is %d", 0xffffffff);
-            uint32_t key = (uint32_t)index;
-            *buffer++ = (uint8_t)(key & 0xFF);
-            *buffer++ = (uint8_t)((key >> 8) & 0xFF);
-            *buffer++ = (uint8_t)((key >> 16) & 0xFF);
-            *buffer++ = (uint8_t)((key >> 24) & 0xFF);
-        }
-        else
-        {
-            assert(0);
-        }
-        return buffer;
-    }
-
-    // When storing/packing lua data to a byte array, we now use the binary lua string interface
-    static uint32_t SaveTSTRING(lua_State* L, int index, char* buffer, uint32_t buffer_size, const char* buffer_end, uint32_t count)
-    {
-        size_t value_len = 0;
-        const char* value = lua_tolstring(L, index, &value_len);
-        uint32_t total_size = value_len + sizeof(uint32_t);
-        if (buffer_end - buffer < (intptr_t)total_size)
-        {
-            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at '%s' for element #%d", buffer_size, value, count);
-        }
-
-        uint32_t len = (uint32_t)value_len;
-        memcpy(buffer, &len, sizeof(uint32_t));
-        buffer += sizeof(uint32_t);
-        memcpy(buffer, value, value_len);
-        return total_size;
-    }
-
     // When loading older save games, we will use the old unpack method (with truncated c strings)
     static uint32_t LoadOldTSTRING(lua_State* L, const char* buffer, const char* buffer_end, uint32_t count, PushTableLogger& logger)
     {
@@ -299,398 +246,541 @@ namespace dmScript
         return total_size;
     }
 
-    uint32_t DoCheckTableSize(lua_State* L, int index, int parent_offset)
+    /*
+     * Version 5 value tags. Every value, and every key in the hash part of a table, starts with one of these.
+     */
+    enum ValueTag
     {
-        int top = lua_gettop(L);
-        (void)top;
+        TAG_FALSE       = 0,
+        TAG_TRUE        = 1,
+        TAG_INTEGER     = 2,  // zigzag encoded varint
+        TAG_NUMBER      = 3,  // lua_Number
+        TAG_STRING      = 4,  // varint length + bytes
+        TAG_STRING_REF  = 5,  // varint index of a previous string
+        TAG_TABLE       = 6,
+        TAG_VECTOR3     = 7,
+        TAG_VECTOR4     = 8,
+        TAG_QUAT        = 9,
+        TAG_MATRIX4     = 10,
+        TAG_HASH        = 11,
+        TAG_URL         = 12,
+    };
 
-        luaL_checktype(L, index, LUA_TTABLE);
-        lua_pushvalue(L, index);
-        lua_pushnil(L);
+    enum ArrayType
+    {
+        ARRAY_TYPE_NUMBERS  = 0,  // lua_Number[count]
+        ARRAY_TYPE_VALUES   = 1,  // tagged values
+    };
 
-        uint32_t size = 0;
+    const uint32_t TABLE_ARRAY_FLAG = 0x80000000;
+    const uint32_t TABLE_MAX_HASH_COUNT = 0x7fffffff;
+    // Longer strings are rarely repeated and are written without an entry in the string table
+    const uint32_t STRING_DEDUP_MAX_LENGTH = 256;
+    const uint32_t STRING_TABLE_MIN_CAPACITY = 256;
+    const uint32_t TABLE_BUFFER_MIN_CAPACITY = 4096;
+    const uint32_t TABLE_BUFFER_MAX_CAPACITY = 0x7fffffff;
+    // Larger buffers are released at the end of the frame, instead of being held by the context
+    const uint32_t TABLE_BUFFER_KEEP_CAPACITY = 64 * 1024;
+    const uint32_t STRING_TABLE_KEEP_CAPACITY = 4096;
+
+    struct TableWriter
+    {
+        lua_State*  m_L;
+        HContext    m_Context;      // Grows the context table buffer when set, otherwise the buffer is fixed
+        char*       m_Buffer;       // 0 when only the size is counted
+        uint32_t    m_Size;
+        uint32_t    m_Capacity;
+        dmHashTable<uintptr_t, uint32_t>* m_Strings; // String index by Lua string pointer
+        uint32_t    m_StringCount;
+    };
 
-        // count
-        size += 4;
-        while (lua_next(L, -2) != 0)
+    static void GrowTableBuffer(TableWriter& writer, uint32_t size)
+    {
+        lua_State* L = writer.m_L;
+        uint64_t required = (uint64_t)writer.m_Size + size;
+        if (required > TABLE_BUFFER_MAX_CAPACITY)
         {
-            int key_type = lua_type(L, -2);
-            int value_type = lua_type(L, -1);
-            if (key_type != LUA_TSTRING && key_type != LUA_TNUMBER)
+            luaL_error(L, "table too large");
+        }
+        if (!writer.m_Context)
+        {
+            luaL_error(L, "buffer (%d bytes) too small for table", writer.m_Capacity);
+        }
+        uint64_t capacity = dmMath::Max((uint64_t)writer.m_Capacity * 2, (uint64_t)TABLE_BUFFER_MIN_CAPACITY);
+        capacity = dmMath::Min(dmMath::Max(capacity, required), (uint64_t)TABLE_BUFFER_MAX_CAPACITY);
+
+        // The buffer is owned by the context, so it isn't leaked if the serialization raises a lua error
+        char* buffer = 0;
+        if (dmMemory::AlignedMalloc((void**)&buffer, 16, (uint32_t)capacity) != dmMemory::RESULT_OK)
+        {
+            luaL_error(L, "Could not allocate %d bytes for table serialization.", (uint32_t)capacity);
+        }
+        if (writer.m_Buffer)
+        {
+            memcpy(buffer, writer.m_Buffer, writer.m_Size);
+            dmMemory::AlignedFree(writer.m_Buffer);
+        }
+        writer.m_Buffer = buffer;
+        writer.m_Capacity = (uint32_t)capacity;
+        writer.m_Context->m_TableBuffer = buffer;
+        writer.m_Context->m_TableBufferSize = (uint32_t)capacity;
+    }
+
+    // Returns 0 when the writer only counts the size
+    static inline char* Reserve(TableWriter& writer, uint32_t size)
+    {
+        if (writer.m_Capacity - writer.m_Size < size)
+        {
+            GrowTableBuffer(writer, size);
+        }
+        return writer.m_Buffer ? writer.m_Buffer + writer.m_Size : 0;
+    }
+
+    static inline void WriteByte(TableWriter& writer, uint8_t value)
+    {
+        char* buffer = Reserve(writer, 1);
+        if (buffer)
+        {
+            *buffer = (char)value;
+        }
+        writer.m_Size += 1;
+    }
+
+    static inline void WriteBytes(TableWriter& writer, const void* data, uint32_t size)
+    {
+        char* buffer = Reserve(writer, size);
+        if (buffer)
+        {
+            memcpy(buffer, data, size);
+        }
+        writer.m_Size += size;
+    }
+
+    static inline void WriteVarUInt(TableWriter& writer, uint64_t value)
+    {
+        uint32_t size = 1;
+        for (uint64_t v = value; v > 0x7f; v >>= 7)
+        {
+            ++size;
+        }
+        char* buffer = Reserve(writer, size);
+        writer.m_Size += size;
+        if (!buffer)
+        {
+            return;
+        }
+        while (value > 0x7f)
+        {
+            *buffer++ = (char)((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        *buffer = (char)value;
+    }
+
+    // Integral numbers within the exact range of a double are written as varints
+    static inline bool IsInteger(lua_Number value, int64_t& out)
+    {
+        if (value >= -9007199254740992.0 && value <= 9007199254740992.0)
+        {
+            int64_t integer = (int64_t)value;
+            if ((lua_Number)integer == value && (integer != 0 || !signbit(value)))
             {
-                luaL_error(L, "keys in table must be of type number or string (found %s)", lua_typename(L, key_type));
+                out = integer;
+                return true;
             }
+        }
+        return false;
+    }
 
-            // key + value type
-            size += 2;
-            if (key_type == LUA_TSTRING)
+    static inline void WriteNumber(TableWriter& writer, lua_Number value)
+    {
+        int64_t integer;
+        if (IsInteger(value, integer))
+        {
+            WriteByte(writer, TAG_INTEGER);
+            WriteVarUInt(writer, ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63));
+        }
+        else
+        {
+            WriteByte(writer, TAG_NUMBER);
+            WriteBytes(writer, &value, sizeof(lua_Number));
+        }
+    }
+
+    static void WriteString(TableWriter& writer, int index)
+    {
+        lua_State* L = writer.m_L;
+        size_t length = 0;
+        const char* value = lua_tolstring(L, index, &length);
+        if (length <= STRING_DEDUP_MAX_LENGTH)
+        {
+            // The strings are kept alive by the table, so their pointers are unique while it is written
+            dmHashTable<uintptr_t, uint32_t>* strings = writer.m_Strings;
+            uint32_t* string_index = strings->Get((uintptr_t)value);
+            if (string_index)
             {
-                size += sizeof(uint32_t) + lua_objlen(L, -2);
+                WriteByte(writer, TAG_STRING_REF);
+                WriteVarUInt(writer, *string_index);
+                return;
             }
-            else if (key_type == LUA_TNUMBER)
+            if (strings->Full())
             {
-                size += 4;
+                uint32_t capacity = dmMath::Max(strings->Capacity() * 2, STRING_TABLE_MIN_CAPACITY);
+                strings->SetCapacity(capacity * 2 / 3, capacity);
             }
+            strings->Put((uintptr_t)value, ++writer.m_StringCount);
+        }
+        else if (length > TABLE_BUFFER_MAX_CAPACITY)
+        {
+            luaL_error(L, "table too large");
+        }
+        WriteByte(writer, TAG_STRING);
+        WriteVarUInt(writer, length);
+        WriteBytes(writer, value, (uint32_t)length);
+    }
 
-            switch (value_type)
+    static void WriteTable(TableWriter& writer, int index);
+
+    static void WriteValue(TableWriter& writer, int index)
+    {
+        lua_State* L = writer.m_L;
+        int value_type = lua_type(L, index);
+        switch (value_type)
+        {
+            case LUA_TBOOLEAN:
+                WriteByte(writer, lua_toboolean(L, index) ? TAG_TRUE : TAG_FALSE);
+                break;
+
+            case LUA_TNUMBER:
+                WriteNumber(writer, lua_tonumber(L, index));
+                break;
+
+            case LUA_TSTRING:
+                WriteString(writer, index);
+                break;
+
+            case LUA_TUSERDATA:
             {
-                case LUA_TBOOLEAN:
+                dmVMath::Vector3* v3;
+                dmVMath::Vector4* v4;
+                dmVMath::Quat* q;
+                dmVMath::Matrix4* m;
+                if ((v3 = ToVector3(L, index)))
                 {
-                    size += 1;
+                    float f[3] = { v3->getX(), v3->getY(), v3->getZ() };
+                    WriteByte(writer, TAG_VECTOR3);
+                    WriteBytes(writer, f, sizeof(f));
                 }
-                break;
-
-                case LUA_TNUMBER:
+                else if ((v4 = ToVector4(L, index)))
                 {
-                    int offset = parent_offset + size;
-                    int aligned_offset = (offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    int align_size = aligned_offset - offset;
-                    size += align_size;
-                    size += sizeof(lua_Number);
+                    float f[4] = { v4->getX(), v4->getY(), v4->getZ(), v4->getW() };
+                    WriteByte(writer, TAG_VECTOR4);
+                    WriteBytes(writer, f, sizeof(f));
                 }
-                break;
-
-                case LUA_TSTRING:
+                else if ((q = ToQuat(L, index)))
                 {
-                    size += sizeof(uint32_t) + lua_objlen(L, -1);
+                    float f[4] = { q->getX(), q->getY(), q->getZ(), q->getW() };
+                    WriteByte(writer, TAG_QUAT);
+                    WriteBytes(writer, f, sizeof(f));
                 }
-                break;
-
-                case LUA_TUSERDATA:
+                else if ((m = ToMatrix4(L, index)))
                 {
-                    // subtype
-                    size += 1;
-
-                    int offset = parent_offset + size;
-                    int aligned_offset = (offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    int align_size = aligned_offset - offset;
-                    size += align_size;
-
-
-                    if (IsVector3(L, -1))
-                    {
-                        size += sizeof(float) * 3;
-                    }
-                    else if (IsVector4(L, -1))
-                    {
-                        size += sizeof(float) * 4;
-                    }
-                    else if (IsQuat(L, -1))
-                    {
-                        size += sizeof(float) * 4;
-                    }
-                    else if (IsMatrix4(L, -1))
-                    {
-                        size += sizeof(float) * 16;
-                    }
-                    else if (IsHash(L, -1))
-                    {
-                        size += sizeof(dmhash_t);
-                    }
-                    else if (IsURL(L, -1))
-                    {
-                        size += sizeof(dmMessage::URL);
-                    }
-                    else
-                    {
-                        luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
-                    }
+                    float f[16];
+                    for (uint32_t i = 0; i < 4; ++i)
+                        for (uint32_t j = 0; j < 4; ++j)
+                            f[i * 4 + j] = m->getElem(i, j);
+                    WriteByte(writer, TAG_MATRIX4);
+                    WriteBytes(writer, f, sizeof(f));
                 }
-                break;
-
-                case LUA_TTABLE:
+                else if (IsHash(L, index))
                 {
-                    size += DoCheckTableSize(L, -1, parent_offset + size);
+                    WriteByte(writer, TAG_HASH);
+                    WriteBytes(writer, lua_touserdata(L, index), sizeof(dmhash_t));
                 }
-                break;
-
-                default:
+                else if (IsURL(L, index))
+                {
+                    WriteByte(writer, TAG_URL);
+                    WriteBytes(writer, lua_touserdata(L, index), sizeof(dmMessage::URL));
+                }
+                else
+                {
                     luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
-                    break;
+                }
             }
+            break;
 
-            lua_pop(L, 1);
-        }
-        lua_pop(L, 1);
-        return size;
-    }
+            case LUA_TTABLE:
+                WriteByte(writer, TAG_TABLE);
+                WriteTable(writer, index);
+                break;
 
-    uint32_t CheckTableSize(lua_State* L, int index)
-    {
-        uint32_t size = sizeof(TableHeader) + DoCheckTableSize(L, index, 0);
-        return size;
+            default:
+                luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
+                break;
+        }
     }
 
-    uint32_t DoCheckTable(lua_State* L, const TableHeader& header, const char* original_buffer, char* buffer, uint32_t buffer_size, int index)
+    static void WriteTable(TableWriter& writer, int index)
     {
-        int top = lua_gettop(L);
-        (void)top;
-
-        char* buffer_start = buffer;
-        char* buffer_end = buffer + buffer_size;
-        luaL_checktype(L, index, LUA_TTABLE);
-        lua_pushvalue(L, index);
-        lua_pushnil(L);
-
-        if (buffer_size < 4)
+        lua_State* L = writer.m_L;
+        luaL_checkstack(L, 4, "table nested too deep");
+
+        // The array part is the run of non nil values from 1 and up
+        uint32_t length = (uint32_t)lua_objlen(L, index);
+        uint32_t array_count = 0;
+        bool numbers_only = true;
+        for (; array_count < length; ++array_count)
         {
-            luaL_error(L, "table too large");
-        }
-        // Make room for count (4 bytes)
-        buffer += 4;
-
-        uint32_t count = 0;
-        while (lua_next(L, -2) != 0)
-        {
-            // Check overflow
-            if (count == (uint32_t)0xffffffff)
-            {
-                luaL_error(L, "too many values in table, %d is max", 0xffffffff);
-            }
-
-            count++;
-
-            int key_type = lua_type(L, -2);
+            lua_rawgeti(L, index, array_count + 1);
             int value_type = lua_type(L, -1);
-            if (key_type != LUA_TSTRING && key_type != LUA_TNUMBER)
-            {
-                luaL_error(L, "keys in table must be of type number or string (found %s)", lua_typename(L, key_type));
-            }
-
-            if (buffer_end - buffer < 2)
+            lua_pop(L, 1);
+            if (value_type == LUA_TNIL)
             {
-                luaL_error(L, "buffer (%d bytes) too small for table, exceeded at key for element #%d", buffer_size, count);
+                break;
             }
+            numbers_only = numbers_only && value_type == LUA_TNUMBER;
+        }
 
-            if (key_type == LUA_TSTRING)
-            {
-                (*buffer++) = (char) LUA_TSTRING;
-                (*buffer++) = (char) value_type;
-                buffer += SaveTSTRING(L, -2, buffer, buffer_size, buffer_end, count);
-            }
-            else if (key_type == LUA_TNUMBER)
-            {
-                lua_Number key = lua_tonumber(L, -2);
-                (*buffer++) = (char) (key >= 0 ? LUA_TNUMBER : LUA_TNEGATIVENUMBER);
-                (*buffer++) = (char) value_type;
-                buffer = WriteEncodedIndex(L, key, header, buffer, buffer_end);
-            }
+        // The count of the hash part is patched when the table has been written
+        uint32_t count_offset = writer.m_Size;
+        Reserve(writer, sizeof(uint32_t));
+        writer.m_Size += sizeof(uint32_t);
 
-            switch (value_type)
+        if (array_count > 0)
+        {
+            WriteVarUInt(writer, array_count);
+            if (numbers_only)
             {
-                case LUA_TBOOLEAN:
+                WriteByte(writer, ARRAY_TYPE_NUMBERS);
+                if (array_count > TABLE_BUFFER_MAX_CAPACITY / sizeof(lua_Number))
                 {
-                    if (buffer_end - buffer < 1)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-                    (*buffer++) = (char) lua_toboolean(L, -1);
+                    luaL_error(L, "table too large");
                 }
-                break;
-
-                case LUA_TNUMBER:
+                uint32_t size = array_count * sizeof(lua_Number);
+                char* buffer = Reserve(writer, size);
+                for (uint32_t i = 0; buffer && i < array_count; ++i)
                 {
-                    // NOTE: We align lua_Number to sizeof(float) even if lua_Number probably is of double type
-                    intptr_t offset = buffer - original_buffer;
-                    intptr_t aligned_buffer = ((intptr_t) offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    intptr_t align_size = aligned_buffer - (intptr_t) offset;
-
-                    if (buffer_end - buffer < align_size)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-#ifndef NDEBUG
-                    memset(buffer, 0, align_size);
-#endif
-                    buffer += align_size;
-
-                    if (buffer_end - buffer < int32_t(sizeof(lua_Number)) || buffer_end - buffer < align_size)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-                    union
-                    {
-                        lua_Number x;
-                        char buf[sizeof(lua_Number)];
-                    };
-
-                    x = lua_tonumber(L, -1);
-                    memcpy(buffer, buf, sizeof(lua_Number));
+                    lua_rawgeti(L, index, i + 1);
+                    lua_Number value = lua_tonumber(L, -1);
+                    lua_pop(L, 1);
+                    memcpy(buffer, &value, sizeof(lua_Number));
                     buffer += sizeof(lua_Number);
                 }
-                break;
-
-                case LUA_TSTRING:
+                writer.m_Size += size;
+            }
+            else
+            {
+                WriteByte(writer, ARRAY_TYPE_VALUES);
+                for (uint32_t i = 0; i < array_count; ++i)
                 {
-                    buffer += SaveTSTRING(L, -1, buffer, buffer_size, buffer_end, count);
+                    lua_rawgeti(L, index, i + 1);
+                    WriteValue(writer, lua_gettop(L));
+                    lua_pop(L, 1);
                 }
-                break;
+            }
+        }
 
-                case LUA_TUSERDATA:
+        uint32_t count = 0;
+        lua_pushnil(L);
+        while (lua_next(L, index) != 0)
+        {
+            int key_index = lua_gettop(L) - 1;
+            int key_type = lua_type(L, key_index);
+            if (key_type == LUA_TNUMBER)
+            {
+                lua_Number key = lua_tonumber(L, key_index);
+                if (key >= 1 && key <= array_count && key == (lua_Number)(uint32_t)key)
                 {
-                    if (buffer_end - buffer < 1)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-                    char* sub_type = buffer++;
-
-                    // NOTE: We align lua_Number to sizeof(float) even if lua_Number probably is of double type
-                    intptr_t offset = buffer - original_buffer;
-                    intptr_t aligned_buffer = ((intptr_t) offset + sizeof(float)-1) & ~(sizeof(float)-1);
-                    intptr_t align_size = aligned_buffer - (intptr_t) offset;
-
-                    if (buffer_end - buffer < align_size)
-                    {
-                        luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                    }
-
-#ifndef NDEBUG
-                    memset(buffer, 0, align_size);
-#endif
-                    buffer += align_size;
-
-                    float* f = (float*) (buffer);
-                    dmVMath::Vector3* v3;
-                    dmVMath::Vector4* v4;
-                    dmVMath::Quat* q;
-                    dmVMath::Matrix4* m;
-                    if ((v3 = ToVector3(L, -1)))
-                    {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 3))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_VECTOR3;
-                        *f++ = v3->getX();
-                        *f++ = v3->getY();
-                        *f++ = v3->getZ();
-
-                        buffer += sizeof(float) * 3;
-                    }
-                    else if ((v4 = ToVector4(L, -1)))
-                    {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 4))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
-
-                        *sub_type = (char) SUB_TYPE_VECTOR4;
-                        *f++ = v4->getX();
-                        *f++ = v4->getY();
-                        *f++ = v4->getZ();
-                        *f++ = v4->getW();
-
-                        buffer += sizeof(float) * 4;
-                    }
-                    else if ((q = ToQuat(L, -1)))
-                    {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 4))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
+                    lua_pop(L, 1);
+                    continue;
+                }
+                if (key > 0xffffffff || key < -(lua_Number)0xffffffff)
+                {
+                    luaL_error(L, "index out of bounds, max is %d", 0xffffffff);
+                }
+                WriteNumber(writer, key);
+            }
+            else if (key_type == LUA_TSTRING)
+            {
+                WriteString(writer, key_index);
+            }
+            else
+            {
+                luaL_error(L, "keys in table must be of type number or string (found %s)", lua_typename(L, key_type));
+            }
 
-                        *sub_type = (char) SUB_TYPE_QUAT;
-                        *f++ = q->getX();
-                        *f++ = q->getY();
-                        *f++ = q->getZ();
-                        *f++ = q->getW();
+            WriteValue(writer, key_index + 1);
+            lua_pop(L, 1);
 
-                        buffer += sizeof(float) * 4;
-                    }
-                    else if ((m = ToMatrix4(L, -1)))
-                    {
-                        if (buffer_end - buffer < int32_t(sizeof(float) * 16))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
+            if (++count > TABLE_MAX_HASH_COUNT)
+            {
+                luaL_error(L, "too many values in table, %d is max", TABLE_MAX_HASH_COUNT);
+            }
+        }
 
-                        *sub_type = (char) SUB_TYPE_MATRIX4;
-                        for (uint32_t i = 0; i < 4; ++i)
-                            for (uint32_t j = 0; j < 4; ++j)
-                                *f++ = m->getElem(i, j);
+        if (array_count > 0)
+        {
+            count |= TABLE_ARRAY_FLAG;
+        }
+        if (writer.m_Buffer)
+        {
+            memcpy(writer.m_Buffer + count_offset, &count, sizeof(uint32_t));
+        }
+    }
 
-                        buffer += sizeof(float) * 16;
-                    }
-                    else if (IsHash(L, -1))
-                    {
-                        dmhash_t hash = *(dmhash_t*)lua_touserdata(L, -1);
-                        const uint32_t hash_size = sizeof(dmhash_t);
+    static uint32_t DoCheckTable(TableWriter& writer, int index)
+    {
+        lua_State* L = writer.m_L;
+        int top = lua_gettop(L);
+        (void)top;
 
-                        if (buffer_end - buffer < int32_t(hash_size))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
+        luaL_checktype(L, index, LUA_TTABLE);
+        if (index < 0)
+        {
+            index = top + index + 1;
+        }
 
-                        *sub_type = (char) SUB_TYPE_HASH;
+        TableHeader header;
+        header.m_Magic = TABLE_MAGIC;
+        header.m_Version = TABLE_VERSION_CURRENT;
+        WriteBytes(writer, &header, sizeof(TableHeader));
 
-                        memcpy(buffer, (const void*)&hash, hash_size);
-                        buffer += hash_size;
-                    }
-                    else if (IsURL(L, -1))
-                    {
-                        dmMessage::URL* url = (dmMessage::URL*)lua_touserdata(L, -1);
-                        const uint32_t url_size = sizeof(dmMessage::URL);
+        if (!writer.m_Strings->Empty())
+        {
+            writer.m_Strings->Clear();
+        }
+        writer.m_StringCount = 0;
+        WriteTable(writer, index);
 
-                        if (buffer_end - buffer < int32_t(url_size))
-                        {
-                            luaL_error(L, "buffer (%d bytes) too small for table, exceeded at value (%s) for element #%d", buffer_size, lua_typename(L, key_type), count);
-                        }
+        assert(top == lua_gettop(L));
+        return writer.m_Size;
+    }
 
-                        *sub_type = (char) SUB_TYPE_URL;
+    uint32_t CheckTable(lua_State* L, char* buffer, uint32_t buffer_size, int index)
+    {
+        assert((intptr_t)buffer % 16 == 0);
+        if (buffer_size > sizeof(TableHeader)) {
+            // The string table of the context is reused when there is one
+            dmHashTable<uintptr_t, uint32_t> strings;
+            HContext context = GetScriptContext(L);
+            TableWriter writer;
+            writer.m_L = L;
+            writer.m_Context = 0;
+            writer.m_Strings = context ? &context->m_TableStrings : &strings;
+            writer.m_Buffer = buffer;
+            writer.m_Size = 0;
+            writer.m_Capacity = buffer_size;
+            return DoCheckTable(writer, index);
+        } else {
+            luaL_error(L, "buffer (%d bytes) too small for header (%zu bytes)", buffer_size, sizeof(TableHeader));
+            return 0;
+        }
+    }
 
-                        memcpy(buffer, (const void*)url, url_size);
-                        buffer += url_size;
-                    }
-                    else
-                    {
-                        luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
-                    }
-                }
-                break;
+    const char* CheckTableBuffer(lua_State* L, int index, uint32_t* size)
+    {
+        HContext context = GetScriptContext(L);
+        assert(context != 0);
+        TableWriter writer;
+        writer.m_L = L;
+        writer.m_Context = context;
+        writer.m_Strings = &context->m_TableStrings;
+        writer.m_Buffer = context->m_TableBuffer;
+        writer.m_Size = 0;
+        writer.m_Capacity = context->m_TableBufferSize;
+        *size = DoCheckTable(writer, index);
+        return writer.m_Buffer;
+    }
 
-                case LUA_TTABLE:
-                {
-                    uint32_t n_used = DoCheckTable(L, header, original_buffer, buffer, buffer_end - buffer, -1);
-                    buffer += n_used;
-                }
-                break;
+    uint32_t CheckTableSize(lua_State* L, int index)
+    {
+        // Walks the table like CheckTable(), but only counts the bytes
+        dmHashTable<uintptr_t, uint32_t> strings;
+        HContext context = GetScriptContext(L);
+        TableWriter writer;
+        writer.m_L = L;
+        writer.m_Context = 0;
+        writer.m_Strings = context ? &context->m_TableStrings : &strings;
+        writer.m_Buffer = 0;
+        writer.m_Size = 0;
+        writer.m_Capacity = TABLE_BUFFER_MAX_CAPACITY;
+        return DoCheckTable(writer, index);
+    }
 
-                default:
-                    luaL_error(L, "unsupported value type in table: %s", lua_typename(L, value_type));
-                    break;
-            }
+    void TrimTableBuffer(HContext context)
+    {
+        if (context->m_TableBufferSize > TABLE_BUFFER_KEEP_CAPACITY)
+        {
+            dmMemory::AlignedFree(context->m_TableBuffer);
+            context->m_TableBuffer = 0;
+            context->m_TableBufferSize = 0;
+        }
+        if (context->m_TableStrings.Capacity() > STRING_TABLE_KEEP_CAPACITY)
+        {
+            dmHashTable<uintptr_t, uint32_t> strings;
+            context->m_TableStrings.Swap(strings);
+        }
+    }
 
-            lua_pop(L, 1);
+    uint32_t CheckTableReference(lua_State* L, char* buffer, uint32_t buffer_size, int index)
+    {
+        luaL_checktype(L, index, LUA_TTABLE);
+        if (buffer_size < sizeof(TableReference))
+        {
+            luaL_error(L, "buffer (%d bytes) too small for table reference (%zu bytes)", buffer_size, sizeof(TableReference));
         }
+        TableReferenceOwner* owner = GetScriptContext(L)->m_TableReferenceOwner;
+        TableReference* reference = (TableReference*)buffer;
+        reference->m_Header.m_Magic = TABLE_REFERENCE_MAGIC;
+        reference->m_Header.m_Version = TABLE_VERSION_CURRENT;
+        reference->m_Owner = owner;
+        lua_pushvalue(L, index);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, owner->m_TableRef);
+        lua_insert(L, -2);
+        reference->m_Reference = luaL_ref(L, -2);
         lua_pop(L, 1);
-
-        memcpy(buffer_start, &count, sizeof(uint32_t));
-
-        assert(top == lua_gettop(L));
-        return buffer - buffer_start;
+        ++owner->m_RefCount;
+        return sizeof(TableReference);
     }
 
-    uint32_t CheckTable(lua_State* L, char* buffer, uint32_t buffer_size, int index)
+    static bool IsTableReference(const char* buffer, uint32_t buffer_size)
     {
-        assert((intptr_t)buffer % 16 == 0);
-        if (buffer_size > sizeof(TableHeader)) {
-            char* original_buffer = buffer;
+        return buffer_size == sizeof(TableReference) && ((const TableHeader*)buffer)->m_Magic == TABLE_REFERENCE_MAGIC;
+    }
 
-            TableHeader* header = (TableHeader*)buffer;
-            header->m_Magic = TABLE_MAGIC;
-            header->m_Version = TABLE_VERSION_CURRENT;
-            buffer += sizeof(TableHeader);
-            buffer_size -= (buffer - original_buffer);
+    void ReleaseTableReference(const char* buffer, uint32_t buffer_size)
+    {
+        if (IsTableReference(buffer, buffer_size))
+        {
+            TableReferenceOwner* owner = ((const TableReference*)buffer)->m_Owner;
+            // The table was already released if the context has been finalized
+            lua_State* L = owner->m_LuaState;
+            if (L != 0)
+            {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, owner->m_TableRef);
+                luaL_unref(L, -1, ((const TableReference*)buffer)->m_Reference);
+                lua_pop(L, 1);
+            }
+            if (--owner->m_RefCount == 0)
+            {
+                delete owner;
+            }
+        }
+    }
 
-            return sizeof(TableHeader) + DoCheckTable(L, *header, original_buffer, buffer, buffer_size, index);
-        } else {
-            luaL_error(L, "buffer (%d bytes) too small for header (%zu bytes)", buffer_size, sizeof(TableHeader));
-            return 0;
+    static void PushTableReference(lua_State* L, const TableReference* reference)
+    {
+        // Only the owner of this context is known to be valid, so the pointer is compared before it is used
+        TableReferenceOwner* owner = GetScriptContext(L)->m_TableReferenceOwner;
+        if (reference->m_Owner != owner || owner->m_LuaState == 0)
+        {
+            dmLogError("A table passed by reference can only be received in the script context it was sent from.");
+            lua_newtable(L);
+            return;
         }
+        lua_rawgeti(L, LUA_REGISTRYINDEX, owner->m_TableRef);
+        lua_rawgeti(L, -1, reference->m_Reference);
+        lua_remove(L, -2);
     }
 
     static const char* ReadHeader(const char* buffer, TableHeader& header)
@@ -1029,6 +1119,264 @@ namespace dmScript
 
 #undef CHECK_PUSHTABLE_OOB
 
+    struct TableReader
+    {
+        lua_State*  m_L;
+        const char* m_Start;
+        const char* m_Cursor;
+        const char* m_End;
+        int         m_StringTable;  // Stack index of the index -> string table
+        uint32_t    m_StringCount;
+    };
+
+    static inline const char* Read(TableReader& reader, uint32_t size, const char* element)
+    {
+        if ((uintptr_t)(reader.m_End - reader.m_Cursor) < size)
+        {
+            luaL_error(reader.m_L, "Reading outside of buffer at %s [Offset: %d, Wanted: %u bytes, Left: %d bytes]", element,
+                        (int)(reader.m_Cursor - reader.m_Start), size, (int)(reader.m_End - reader.m_Cursor));
+        }
+        const char* buffer = reader.m_Cursor;
+        reader.m_Cursor += size;
+        return buffer;
+    }
+
+    static inline uint8_t ReadByte(TableReader& reader, const char* element)
+    {
+        return (uint8_t)*Read(reader, 1, element);
+    }
+
+    static uint64_t ReadVarUInt(TableReader& reader, const char* element)
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t current = ReadByte(reader, element);
+            value |= (uint64_t)(current & 0x7f) << shift;
+            if (0 == (current & 0x80))
+            {
+                return value;
+            }
+        }
+        luaL_error(reader.m_L, "Invalid number encoding");
+        return 0;
+    }
+
+    static uint32_t ReadCount(TableReader& reader, uint32_t element_size, const char* element)
+    {
+        uint64_t count = ReadVarUInt(reader, element);
+        // Each element takes at least element_size bytes, which guards against allocating tables for corrupt counts
+        if (count > (uint64_t)(reader.m_End - reader.m_Cursor) / element_size)
+        {
+            luaL_error(reader.m_L, "Reading outside of buffer at %s [Offset: %d, Count: %llu]", element,
+                        (int)(reader.m_Cursor - reader.m_Start), (unsigned long long)count);
+        }
+        return (uint32_t)count;
+    }
+
+    static void ReadString(TableReader& reader, uint8_t tag)
+    {
+        lua_State* L = reader.m_L;
+        if (tag == TAG_STRING_REF)
+        {
+            uint64_t string_index = ReadVarUInt(reader, "string reference");
+            if (string_index == 0 || string_index > reader.m_StringCount)
+            {
+                luaL_error(L, "Invalid string reference %d (%d strings read)", (uint32_t)string_index, reader.m_StringCount);
+            }
+            lua_rawgeti(L, reader.m_StringTable, (int)string_index);
+            return;
+        }
+
+        uint32_t length = ReadCount(reader, 1, "string");
+        const char* value = Read(reader, length, "string");
+        lua_pushlstring(L, value, length);
+        if (length <= STRING_DEDUP_MAX_LENGTH)
+        {
+            lua_pushvalue(L, -1);
+            lua_rawseti(L, reader.m_StringTable, ++reader.m_StringCount);
+        }
+    }
+
+    static void ReadTable(TableReader& reader);
+
+    static void ReadValue(TableReader& reader, uint8_t tag)
+    {
+        lua_State* L = reader.m_L;
+        switch (tag)
+        {
+            case TAG_FALSE:
+            case TAG_TRUE:
+                lua_pushboolean(L, tag == TAG_TRUE);
+                break;
+
+            case TAG_INTEGER:
+            {
+                uint64_t value = ReadVarUInt(reader, "integer");
+                lua_pushnumber(L, (lua_Number)(int64_t)((value >> 1) ^ (0 - (value & 1))));
+            }
+            break;
+
+            case TAG_NUMBER:
+            {
+                lua_Number value;
+                memcpy(&value, Read(reader, sizeof(lua_Number), "number"), sizeof(lua_Number));
+                lua_pushnumber(L, value);
+            }
+            break;
+
+            case TAG_STRING:
+            case TAG_STRING_REF:
+                ReadString(reader, tag);
+                break;
+
+            case TAG_TABLE:
+                ReadTable(reader);
+                break;
+
+            case TAG_VECTOR3:
+            {
+                float f[3];
+                memcpy(f, Read(reader, sizeof(f), "vec3"), sizeof(f));
+                dmScript::PushVector3(L, dmVMath::Vector3(f[0], f[1], f[2]));
+            }
+            break;
+
+            case TAG_VECTOR4:
+            {
+                float f[4];
+                memcpy(f, Read(reader, sizeof(f), "vec4"), sizeof(f));
+                dmScript::PushVector4(L, dmVMath::Vector4(f[0], f[1], f[2], f[3]));
+            }
+            break;
+
+            case TAG_QUAT:
+            {
+                float f[4];
+                memcpy(f, Read(reader, sizeof(f), "quat"), sizeof(f));
+                dmScript::PushQuat(L, dmVMath::Quat(f[0], f[1], f[2], f[3]));
+            }
+            break;
+
+            case TAG_MATRIX4:
+            {
+                float f[16];
+                memcpy(f, Read(reader, sizeof(f), "mat4"), sizeof(f));
+                dmVMath::Matrix4 m;
+                for (uint32_t i = 0; i < 4; ++i)
+                    for (uint32_t j = 0; j < 4; ++j)
+                        m.setElem(i, j, f[i * 4 + j]);
+                dmScript::PushMatrix4(L, m);
+            }
+            break;
+
+            case TAG_HASH:
+            {
+                dmhash_t hash;
+                memcpy(&hash, Read(reader, sizeof(dmhash_t), "hash"), sizeof(dmhash_t));
+                dmScript::PushHash(L, hash);
+            }
+            break;
+
+            case TAG_URL:
+            {
+                dmMessage::URL url;
+                memcpy(&url, Read(reader, sizeof(dmMessage::URL), "url"), sizeof(dmMessage::URL));
+                dmScript::PushURL(L, url);
+            }
+            break;
+
+            default:
+                luaL_error(L, "Table contains invalid type (%d) at offset %d", tag, (int)(reader.m_Cursor - reader.m_Start - 1));
+                break;
+        }
+    }
+
+    static void ReadTable(TableReader& reader)
+    {
+        lua_State* L = reader.m_L;
+        luaL_checkstack(L, 4, "table nested too deep");
+
+        uint32_t count;
+        memcpy(&count, Read(reader, sizeof(uint32_t), "table header"), sizeof(uint32_t));
+
+        uint32_t array_count = 0;
+        uint8_t array_type = ARRAY_TYPE_VALUES;
+        if (count & TABLE_ARRAY_FLAG)
+        {
+            count &= ~TABLE_ARRAY_FLAG;
+            array_count = ReadCount(reader, 1, "array");
+            array_type = ReadByte(reader, "array");
+            if (array_type != ARRAY_TYPE_NUMBERS && array_type != ARRAY_TYPE_VALUES)
+            {
+                luaL_error(L, "Table contains invalid array type (%d)", array_type);
+            }
+        }
+        // A key-value pair is at least two bytes
+        if (count > (uintptr_t)(reader.m_End - reader.m_Cursor) / 2)
+        {
+            luaL_error(L, "Reading outside of buffer at table [Offset: %d, Count: %u]", (int)(reader.m_Cursor - reader.m_Start), count);
+        }
+
+        lua_createtable(L, array_count, count);
+
+        if (array_type == ARRAY_TYPE_NUMBERS)
+        {
+            if (array_count > (uintptr_t)(reader.m_End - reader.m_Cursor) / sizeof(lua_Number))
+            {
+                luaL_error(L, "Reading outside of buffer at array [Offset: %d, Count: %u]", (int)(reader.m_Cursor - reader.m_Start), array_count);
+            }
+            const char* buffer = Read(reader, array_count * sizeof(lua_Number), "array");
+            for (uint32_t i = 0; i < array_count; ++i)
+            {
+                lua_Number value;
+                memcpy(&value, buffer, sizeof(lua_Number));
+                buffer += sizeof(lua_Number);
+                lua_pushnumber(L, value);
+                lua_rawseti(L, -2, i + 1);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < array_count; ++i)
+            {
+                ReadValue(reader, ReadByte(reader, "value"));
+                lua_rawseti(L, -2, i + 1);
+            }
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint8_t key_tag = ReadByte(reader, "key");
+            if (key_tag != TAG_INTEGER && key_tag != TAG_NUMBER && key_tag != TAG_STRING && key_tag != TAG_STRING_REF)
+            {
+                luaL_error(L, "Unknown key type %d", key_tag);
+            }
+            ReadValue(reader, key_tag);
+            ReadValue(reader, ReadByte(reader, "value"));
+            lua_rawset(L, -3);
+        }
+    }
+
+    static void PushTableV5(lua_State* L, const char* buffer, uint32_t buffer_size)
+    {
+        int top = lua_gettop(L);
+        (void)top;
+
+        TableReader reader;
+        reader.m_L = L;
+        reader.m_Start = buffer;
+        reader.m_Cursor = buffer;
+        reader.m_End = buffer + buffer_size;
+        lua_newtable(L);
+        reader.m_StringTable = lua_gettop(L);
+        reader.m_StringCount = 0;
+        ReadTable(reader);
+        lua_remove(L, reader.m_StringTable);
+
+        assert(top + 1 == lua_gettop(L));
+    }
+
     void PushTable(lua_State*L, const char* buffer, uint32_t buffer_size)
     {
         TableHeader header;
@@ -1041,10 +1389,20 @@ namespace dmScript
             luaL_error(L, "%s", str);
         }
 
+        if (((const TableHeader*)buffer)->m_Magic == TABLE_REFERENCE_MAGIC)
+        {
+            luaL_error(L, "Table references can only be pushed as message data");
+        }
+
         buffer = ReadHeader(buffer, header);
         if (IsSupportedVersion(header))
         {
             buffer_size -= sizeof(TableHeader);
+            if (header.m_Version >= 5)
+            {
+                PushTableV5(L, buffer, buffer_size);
+                return;
+            }
             PushTableLogger logger;
             logger.m_BufferStart = buffer;
             logger.m_BufferSize = buffer_size;
@@ -1058,4 +1416,14 @@ namespace dmScript
         }
     }
 
+    void PushMessageTable(lua_State* L, const char* buffer, uint32_t buffer_size)
+    {
+        if (IsTableReference(buffer, buffer_size))
+        {
+            PushTableReference(L, (const TableReference*)buffer);
+            return;
+        }
+        PushTable(L, buffer, buffer_size);
+    }
+
 }
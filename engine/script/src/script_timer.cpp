@@ -16,6 +16,7 @@
 #include "script_timer_private.h"
 
 #include <string.h>
+#include <algorithm>
 #include <dlib/index_pool.h>
 #include <dlib/hashtable.h>
 #include <dlib/profile.h>
@@ -42,14 +43,19 @@ namespace dmScript
      */
 
     /*
-        The timers are stored in a flat array with no holes which we scan sequenctially on each update.
+        The timers are stored in a flat array with no holes. When a timer is removed the last timer in
+        the list may change location (EraseSwap).
 
-        When a timer is removed the last timer in the list may change location (EraseSwap).
+        The timers that are due are found with a separate binary min-heap (the schedule) sorted on the
+        absolute world time at which each timer triggers, with a sequence number to break ties. UpdateTimers
+        only touches the timers that are due, the cost of a frame is O(k log n) where k is the number of
+        triggered timers rather than O(n) of all the live timers. The heap entries reference the timers
+        via the lookup index so they stay valid when the flat array is reshuffled, and each timer keeps
+        its position in the heap so that it can be removed when cancelled or killed.
 
-        This is to keep the array sweep fast and handle cases where multiple short lived timers are
-        created followed by one long-lived timer. If we did not re-shuffle and keep holes we would keep
-        scanning the array to the end where the only live timer exists skipping all the holes.
-        How much of an issue this is guesswork at this point.
+        The timers that are due in the same update are triggered in the order they have in the flat array.
+        During the update, removed timers are only flagged as dead and are erased at the end of the update,
+        so the array order doesn't change while the callbacks run.
 
         The timer identity is an index into an indirection layer combined with a generation counter,
         this makes it possible to reuse the index for the indirection layer without risk of using
@@ -69,22 +75,33 @@ namespace dmScript
         uintptr_t       m_Owner;
         uintptr_t       m_UserData;
 
+        // The world time when the timer fires
+        double          m_TriggerTime;
+
         // Store complete timer handle with generation here to identify stale timer handles
         HTimer          m_Handle;
 
-        // How much time remaining until the timer fires
-        float           m_Remaining;
-
         // The timer delay, we need to keep this for repeating timers
         float           m_Delay;
 
+        // Position in the schedule, INVALID_SCHEDULE_INDEX while the timer is being triggered
+        uint16_t        m_ScheduleIndex;
+
         // Flag if the timer should repeat
-        uint32_t        m_Repeat : 1;
-        // Flag if the timer is alive
-        uint32_t        m_IsAlive : 1;
+        uint16_t        m_Repeat : 1;
+        // Flag if the timer is alive, dead timers are erased at the end of UpdateTimers
+        uint16_t        m_IsAlive : 1;
+    };
+
+    struct TimerScheduleEntry
+    {
+        double          m_TriggerTime;
+        uint32_t        m_Sequence;
+        uint16_t        m_LookupIndex;
     };
 
     #define INVALID_TIMER_LOOKUP_INDEX  0xffffu
+    #define INVALID_SCHEDULE_INDEX      0xffffu
     #define INITIAL_TIMER_CAPACITY      8u
     #define MAX_TIMER_CAPACITY          65000u  // Needs to be less that 65535 since 65535 is reserved for invalid index
     #define TIMER_CAPACITY_GROWTH       16u
@@ -92,8 +109,13 @@ namespace dmScript
     struct TimerWorld
     {
         dmArray<Timer>                      m_Timers;
+        dmArray<TimerScheduleEntry>         m_Schedule;  // Min-heap on trigger time
+        dmArray<uint16_t>                   m_Triggered; // Index of the timers that are due in the current UpdateTimers
+        dmArray<uint16_t>                   m_Dead;      // Index of the timers that died in the current UpdateTimers
         dmArray<uint16_t>                   m_IndexLookup;
         dmIndexPool<uint16_t>               m_IndexPool;
+        double                              m_Time;      // Accumulated time of all calls to UpdateTimers
+        uint32_t                            m_Sequence;  // Incremented each time a timer is scheduled, keeps the order of timers with the same trigger time
         uint16_t                            m_Version;   // Incremented to avoid collisions each time we push timer indexes back to the m_IndexPool
         uint16_t                            m_InUpdate : 1;
     };
@@ -108,6 +130,133 @@ namespace dmScript
         return (((uint32_t)generation) << 16) | (lookup_index);
     }
 
+    static Timer* GetTimer(HTimerWorld timer_world, HTimer handle)
+    {
+        uint16_t lookup_index = GetLookupIndex(handle);
+        if (lookup_index >= timer_world->m_IndexLookup.Size())
+        {
+            return 0x0;
+        }
+
+        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
+        if (timer_index >= timer_world->m_Timers.Size())
+        {
+            return 0x0;
+        }
+
+        Timer* timer = &timer_world->m_Timers[timer_index];
+        if (timer->m_Handle != handle || timer->m_IsAlive == 0)
+        {
+            return 0x0;
+        }
+        return timer;
+    }
+
+    static bool IsEarlier(const TimerScheduleEntry& a, const TimerScheduleEntry& b)
+    {
+        if (a.m_TriggerTime != b.m_TriggerTime)
+        {
+            return a.m_TriggerTime < b.m_TriggerTime;
+        }
+        return (int32_t)(a.m_Sequence - b.m_Sequence) < 0;
+    }
+
+    static void SetScheduleEntry(HTimerWorld timer_world, uint32_t schedule_index, const TimerScheduleEntry& entry)
+    {
+        timer_world->m_Schedule[schedule_index] = entry;
+        uint16_t timer_index = timer_world->m_IndexLookup[entry.m_LookupIndex];
+        timer_world->m_Timers[timer_index].m_ScheduleIndex = (uint16_t)schedule_index;
+    }
+
+    static void SiftUp(HTimerWorld timer_world, uint32_t schedule_index, const TimerScheduleEntry& entry)
+    {
+        dmArray<TimerScheduleEntry>& schedule = timer_world->m_Schedule;
+        while (schedule_index > 0)
+        {
+            uint32_t parent_index = (schedule_index - 1) / 2;
+            if (!IsEarlier(entry, schedule[parent_index]))
+            {
+                break;
+            }
+            SetScheduleEntry(timer_world, schedule_index, schedule[parent_index]);
+            schedule_index = parent_index;
+        }
+        SetScheduleEntry(timer_world, schedule_index, entry);
+    }
+
+    static void SiftDown(HTimerWorld timer_world, uint32_t schedule_index, const TimerScheduleEntry& entry)
+    {
+        dmArray<TimerScheduleEntry>& schedule = timer_world->m_Schedule;
+        uint32_t size = schedule.Size();
+        while (true)
+        {
+            uint32_t child_index = schedule_index * 2 + 1;
+            if (child_index >= size)
+            {
+                break;
+            }
+            if (child_index + 1 < size && IsEarlier(schedule[child_index + 1], schedule[child_index]))
+            {
+                ++child_index;
+            }
+            if (!IsEarlier(schedule[child_index], entry))
+            {
+                break;
+            }
+            SetScheduleEntry(timer_world, schedule_index, schedule[child_index]);
+            schedule_index = child_index;
+        }
+        SetScheduleEntry(timer_world, schedule_index, entry);
+    }
+
+    static void ScheduleTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        assert(timer.m_ScheduleIndex == INVALID_SCHEDULE_INDEX);
+        dmArray<TimerScheduleEntry>& schedule = timer_world->m_Schedule;
+        if (schedule.Full())
+        {
+            // The schedule never holds more entries than there are timers
+            schedule.SetCapacity(timer_world->m_Timers.Capacity());
+        }
+
+        TimerScheduleEntry entry;
+        entry.m_TriggerTime = timer.m_TriggerTime;
+        entry.m_Sequence = timer_world->m_Sequence++;
+        entry.m_LookupIndex = GetLookupIndex(timer.m_Handle);
+
+        uint32_t schedule_index = schedule.Size();
+        schedule.SetSize(schedule_index + 1);
+        SiftUp(timer_world, schedule_index, entry);
+    }
+
+    static void UnscheduleTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        uint32_t schedule_index = timer.m_ScheduleIndex;
+        if (schedule_index == INVALID_SCHEDULE_INDEX)
+        {
+            return;
+        }
+        timer.m_ScheduleIndex = INVALID_SCHEDULE_INDEX;
+
+        dmArray<TimerScheduleEntry>& schedule = timer_world->m_Schedule;
+        uint32_t last_index = schedule.Size() - 1;
+        TimerScheduleEntry last = schedule[last_index];
+        schedule.SetSize(last_index);
+        if (schedule_index == last_index)
+        {
+            return;
+        }
+
+        if (schedule_index > 0 && IsEarlier(last, schedule[(schedule_index - 1) / 2]))
+        {
+            SiftUp(timer_world, schedule_index, last);
+        }
+        else
+        {
+            SiftDown(timer_world, schedule_index, last);
+        }
+    }
+
     static Timer* AllocateTimer(HTimerWorld timer_world, uintptr_t owner)
     {
         assert(timer_world != 0x0);
@@ -141,6 +290,8 @@ namespace dmScript
         Timer& timer = timer_world->m_Timers[timer_count];
         timer.m_Handle = handle;
         timer.m_Owner = owner;
+        timer.m_ScheduleIndex = INVALID_SCHEDULE_INDEX;
+        timer.m_IsAlive = 1;
 
         uint16_t lookup_index = GetLookupIndex(handle);
 
@@ -161,26 +312,60 @@ namespace dmScript
         }
     }
 
+    // Removes the timer from the schedule and releases its handle, the timer reference is invalid afterwards
     static void FreeTimer(HTimerWorld timer_world, Timer& timer)
     {
         assert(timer_world != 0x0);
-        assert(timer.m_IsAlive == 0);
+
+        UnscheduleTimer(timer_world, timer);
 
         uint16_t lookup_index = GetLookupIndex(timer.m_Handle);
         uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
         timer_world->m_IndexPool.Push(lookup_index);
 
         EraseTimer(timer_world, timer_index);
+
+        ++timer_world->m_Version;
+    }
+
+    // Flags the timer as dead, it is erased at the end of UpdateTimers
+    static void SetTimerDead(HTimerWorld timer_world, Timer& timer)
+    {
+        timer.m_IsAlive = 0;
+        UnscheduleTimer(timer_world, timer);
+
+        dmArray<uint16_t>& dead = timer_world->m_Dead;
+        if (dead.Full())
+        {
+            dead.OffsetCapacity(TIMER_CAPACITY_GROWTH);
+        }
+        dead.Push(timer_world->m_IndexLookup[GetLookupIndex(timer.m_Handle)]);
+    }
+
+    // Frees the timer, or flags it as dead if it is removed during UpdateTimers
+    static void RemoveTimer(HTimerWorld timer_world, Timer& timer)
+    {
+        if (timer_world->m_InUpdate)
+        {
+            SetTimerDead(timer_world, timer);
+        }
+        else
+        {
+            FreeTimer(timer_world, timer);
+        }
     }
 
     HTimerWorld NewTimerWorld()
     {
         TimerWorld* timer_world = new TimerWorld();
         timer_world->m_Timers.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_Schedule.SetCapacity(INITIAL_TIMER_CAPACITY);
         timer_world->m_IndexLookup.SetCapacity(INITIAL_TIMER_CAPACITY);
         timer_world->m_IndexLookup.SetSize(INITIAL_TIMER_CAPACITY);
         memset(&timer_world->m_IndexLookup[0], 0u, INITIAL_TIMER_CAPACITY * sizeof(uint16_t));
         timer_world->m_IndexPool.SetCapacity(INITIAL_TIMER_CAPACITY);
+        timer_world->m_Time = 0.0;
+        timer_world->m_Sequence = 0;
         timer_world->m_Version = 0;
         timer_world->m_InUpdate = 0;
         return timer_world;
@@ -195,37 +380,55 @@ namespace dmScript
     void UpdateTimers(HTimerWorld timer_world, float dt)
     {
         assert(timer_world != 0x0);
+        assert(timer_world->m_InUpdate == 0);
         DM_PROFILE("Update");
 
         timer_world->m_InUpdate = 1;
+        timer_world->m_Time += dt;
+        const double time = timer_world->m_Time;
 
-        // We only scan timers for trigger if the timer *existed at entry to UpdateTimers*, any timers added
-        // in a trigger callback will always be added at the end of m_Timers and not triggered in this scope.
-        uint32_t size = timer_world->m_Timers.Size();
-        DM_PROPERTY_ADD_U32(rmtp_TimerCount, size);
+        DM_PROPERTY_ADD_U32(rmtp_TimerCount, timer_world->m_Timers.Size());
 
-        for (uint32_t i = 0; i < size; ++i)
+        // We only trigger timers that are due *at entry to UpdateTimers*, any timers added or rescheduled
+        // in a trigger callback are pushed to the schedule and not triggered in this scope.
+        dmArray<TimerScheduleEntry>& schedule = timer_world->m_Schedule;
+        dmArray<uint16_t>& triggered = timer_world->m_Triggered;
+        triggered.SetSize(0);
+        if (triggered.Capacity() < schedule.Size())
         {
-            Timer* timer = &timer_world->m_Timers[i];
-            if (timer->m_IsAlive == 0)
-            {
-                continue;
-            }
+            triggered.SetCapacity(schedule.Size());
+        }
+
+        while (!schedule.Empty() && schedule[0].m_TriggerTime <= time)
+        {
+            uint16_t timer_index = timer_world->m_IndexLookup[schedule[0].m_LookupIndex];
+            triggered.Push(timer_index);
+            UnscheduleTimer(timer_world, timer_world->m_Timers[timer_index]);
+        }
+
+        // The due timers are triggered in array order, the timers are only appended to the array until the end of the update
+        std::sort(triggered.Begin(), triggered.End());
 
-            timer->m_Remaining -= dt;
-            if (timer->m_Remaining > 0.0f)
+        uint32_t triggered_count = triggered.Size();
+        for (uint32_t i = 0; i < triggered_count; ++i)
+        {
+            uint16_t timer_index = triggered[i];
+            Timer* timer = &timer_world->m_Timers[timer_index];
+
+            // The timer may have been cancelled or killed by a callback earlier in this update
+            if (timer->m_IsAlive == 0)
             {
                 continue;
             }
 
-            float elapsed_time = timer->m_Delay - timer->m_Remaining;
+            float elapsed_time = (float)(timer->m_Delay + (time - timer->m_TriggerTime));
 
             TimerEventType eventType = timer->m_Repeat == 0 ? TIMER_EVENT_TRIGGER_WILL_DIE : TIMER_EVENT_TRIGGER_WILL_REPEAT;
 
             timer->m_Callback(timer_world, eventType, timer->m_Handle, elapsed_time, timer->m_Owner, timer->m_UserData);
 
             // The array might have been reallocated here! So grab the pointer again...
-            timer = &timer_world->m_Timers[i];
+            timer = &timer_world->m_Timers[timer_index];
 
             if (timer->m_IsAlive == 0)
             {
@@ -234,46 +437,41 @@ namespace dmScript
 
             if (timer->m_Repeat == 0)
             {
-                timer->m_IsAlive = 0;
+                SetTimerDead(timer_world, *timer);
                 continue;
             }
 
             if (timer->m_Delay == 0.0f)
             {
-                timer->m_Remaining = 0.0f;
-                continue;
+                timer->m_TriggerTime = time;
             }
-
-            float wrapped_count = ((-timer->m_Remaining) / timer->m_Delay) + 1.f;
-            float offset_to_next_trigger  = floor(wrapped_count) * timer->m_Delay;
-            timer->m_Remaining += offset_to_next_trigger;
-            if (timer->m_Remaining < 0) // If the delay is very small, the floating point precision might produce issues
-                timer->m_Remaining = timer->m_Delay; // reset the timer
+            else
+            {
+                double wrapped_count = ((time - timer->m_TriggerTime) / timer->m_Delay) + 1.0;
+                double offset_to_next_trigger = floor(wrapped_count) * timer->m_Delay;
+                timer->m_TriggerTime += offset_to_next_trigger;
+                if (timer->m_TriggerTime < time) // If the delay is very small, the floating point precision might produce issues
+                    timer->m_TriggerTime = time + timer->m_Delay; // reset the timer
+            }
+            ScheduleTimer(timer_world, *timer);
         }
 
+        triggered.SetSize(0);
         timer_world->m_InUpdate = 0;
 
-        size = timer_world->m_Timers.Size();
-        uint32_t original_size = size;
-        uint32_t i = 0;
-        while (i < size)
+        // Erase the dead timers front to back, a dead timer can be swapped into the place of an erased one
+        dmArray<uint16_t>& dead = timer_world->m_Dead;
+        std::sort(dead.Begin(), dead.End());
+        uint32_t dead_count = dead.Size();
+        for (uint32_t i = 0; i < dead_count; ++i)
         {
-            Timer& timer = timer_world->m_Timers[i];
-            if (timer.m_IsAlive == 0)
-            {
-                FreeTimer(timer_world, timer);
-                --size;
-            }
-            else
+            uint16_t timer_index = dead[i];
+            while (timer_index < timer_world->m_Timers.Size() && timer_world->m_Timers[timer_index].m_IsAlive == 0)
             {
-                ++i;
+                FreeTimer(timer_world, timer_world->m_Timers[timer_index]);
             }
         }
-
-        if (size != original_size)
-        {
-            ++timer_world->m_Version;
-        }
+        dead.SetSize(0);
     }
 
     HTimer AddTimer(HTimerWorld timer_world,
@@ -293,11 +491,12 @@ namespace dmScript
         }
 
         timer->m_Delay = delay;
-        timer->m_Remaining = delay;
+        timer->m_TriggerTime = timer_world->m_Time + delay;
         timer->m_UserData = userdata;
         timer->m_Callback = timer_callback;
         timer->m_Repeat = repeat;
-        timer->m_IsAlive = 1;
+
+        ScheduleTimer(timer_world, *timer);
 
         return timer->m_Handle;
     }
@@ -305,37 +504,19 @@ namespace dmScript
     bool CancelTimer(HTimerWorld timer_world, HTimer handle)
     {
         assert(timer_world != 0x0);
-        uint16_t lookup_index = GetLookupIndex(handle);
-        if (lookup_index >= timer_world->m_IndexLookup.Size())
-        {
-            return false;
-        }
-
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        if (timer_index >= timer_world->m_Timers.Size())
-        {
-            return false;
-        }
-
-        Timer& timer = timer_world->m_Timers[timer_index];
-        if (timer.m_Handle != handle)
+        Timer* timer = GetTimer(timer_world, handle);
+        if (timer == 0x0)
         {
             return false;
         }
 
-        if (timer.m_IsAlive == 0)
-        {
-            return false;
-        }
+        // Remove the timer before calling the callback so that it is safe to cancel or kill timers from it
+        TimerCallback callback = timer->m_Callback;
+        uintptr_t owner = timer->m_Owner;
+        uintptr_t userdata = timer->m_UserData;
+        RemoveTimer(timer_world, *timer);
 
-        timer.m_IsAlive = 0;
-        timer.m_Callback(timer_world, TIMER_EVENT_CANCELLED, timer.m_Handle, 0.f, timer.m_Owner, timer.m_UserData);
-
-        if (timer_world->m_InUpdate == 0)
-        {
-            FreeTimer(timer_world, timer);
-            ++timer_world->m_Version;
-        }
+        callback(timer_world, TIMER_EVENT_CANCELLED, handle, 0.f, owner, userdata);
         return true;
     }
 
@@ -349,32 +530,23 @@ namespace dmScript
         while (timer_index < size)
         {
             Timer& timer = timer_world->m_Timers[timer_index];
-            if (timer.m_Owner != owner)
+            if (timer.m_Owner != owner || timer.m_IsAlive == 0)
             {
                 ++timer_index;
                 continue;
             }
 
-            if (timer.m_IsAlive == 1)
+            ++cancelled_count;
+            if (timer_world->m_InUpdate)
             {
-                timer.m_IsAlive = 0;
-                ++cancelled_count;
+                RemoveTimer(timer_world, timer);
+                ++timer_index;
             }
-
-            if (timer_world->m_InUpdate == 0)
+            else
             {
                 FreeTimer(timer_world, timer);
                 --size;
             }
-            else
-            {
-                ++timer_index;
-            }
-        }
-
-        if (cancelled_count > 0)
-        {
-            ++timer_world->m_Version;
         }
 
         return cancelled_count;
@@ -383,20 +555,7 @@ namespace dmScript
     uint32_t GetAliveTimers(HTimerWorld timer_world)
     {
         assert(timer_world != 0x0);
-
-        uint32_t alive_timers = 0u;
-        uint32_t size = timer_world->m_Timers.Size();
-        uint32_t i = 0;
-        while (i < size)
-        {
-            Timer& timer = timer_world->m_Timers[i];
-            if(timer.m_IsAlive == 1)
-            {
-                ++alive_timers;
-            }
-            ++i;
-        }
-        return alive_timers;
+        return timer_world->m_Timers.Size() - timer_world->m_Dead.Size();
     }
 
     static void SetTimerWorld(HScriptWorld script_world, HTimerWorld timer_world)
@@ -646,30 +805,22 @@ namespace dmScript
             return 1;
         }
 
-        uint16_t lookup_index = GetLookupIndex(timer_handle);
-        if (lookup_index >= timer_world->m_IndexLookup.Size())
-        {
-            lua_pushboolean(L, 0);
-            return 1;
-        }
-
-        uint16_t timer_index = timer_world->m_IndexLookup[lookup_index];
-        if (timer_index >= timer_world->m_Timers.Size())
+        Timer* timer = GetTimer(timer_world, (dmScript::HTimer)timer_handle);
+        if (timer == 0x0)
         {
             lua_pushboolean(L, 0);
             return 1;
         }
 
-        Timer& timer = timer_world->m_Timers[timer_index];
-
-        LuaCallbackInfo* callback = (LuaCallbackInfo*)timer.m_UserData;
+        LuaCallbackInfo* callback = (LuaCallbackInfo*)timer->m_UserData;
         if (!IsCallbackValid(callback))
         {
             lua_pushboolean(L, 0);
             return 1;
         }
 
-        LuaTimerCallbackArgs args = { timer.m_Handle, timer.m_Delay - timer.m_Remaining };
+        float elapsed_time = (float)(timer->m_Delay - (timer->m_TriggerTime - timer_world->m_Time));
+        LuaTimerCallbackArgs args = { timer->m_Handle, elapsed_time };
         InvokeCallback(callback, LuaTimerCallbackArgsCB, &args);
 
         lua_pushboolean(L, 1);
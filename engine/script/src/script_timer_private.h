@@ -47,6 +47,8 @@ namespace dmScript
     /**
      * Update the all the timers in the world. Any timers whose time is elapsed will be triggered
      * The resolution of all timers are dictated to the time step used when calling UpdateTimers
+     * Timers that elapse in the same update are triggered in the order they were added, unless
+     * other timers were removed in between, which can move a timer earlier in the order
      * 
      * @param timer_world the timer world created with NewTimerWorld
      * @param dt time step during which to simulate (in seconds)
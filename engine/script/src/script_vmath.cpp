@@ -1665,6 +1665,7 @@ namespace dmScript
      *
      * @name vmath.inv
      * @param m1 [type:matrix4] matrix to invert
+     * @param [out] [type:matrix4] optional matrix to store the result in, it is returned instead of a new matrix
      * @return m [type:matrix4] inverse of the supplied matrix
      * @examples
      *
@@ -1679,7 +1680,7 @@ namespace dmScript
     {
         const Matrix4* m = CheckMatrix4(L, 1);
         Matrix4 mi = Vectormath::Aos::inverse(*m);
-        PushMatrix4(L, mi);
+        PushMatrix4(L, mi, 2);
         return 1;
     }
 
@@ -1693,6 +1694,7 @@ namespace dmScript
      *
      * @name vmath.ortho_inv
      * @param m1 [type:matrix4] ortho-normalized matrix to invert
+     * @param [out] [type:matrix4] optional matrix to store the result in, it is returned instead of a new matrix
      * @return m [type:matrix4] inverse of the supplied matrix
      * @examples
      *
@@ -1707,7 +1709,7 @@ namespace dmScript
     {
         const Matrix4* m = CheckMatrix4(L, 1);
         Matrix4 mi = Vectormath::Aos::orthoInverse(*m);
-        PushMatrix4(L, mi);
+        PushMatrix4(L, mi, 2);
         return 1;
     }
 
@@ -1864,6 +1866,7 @@ namespace dmScript
      *
      * @name vmath.normalize
      * @param v1 [type:vector3|vector4|quat] vector to normalize
+     * @param [out] [type:vector3|vector4|quat] optional vector to store the result in, it is returned instead of a new vector
      * @return v [type:vector3|vector4|quat] new normalized vector
      * @examples
      *
@@ -1880,17 +1883,17 @@ namespace dmScript
         if (type == SCRIPT_TYPE_VECTOR3)
         {
             Vector3* v = CheckVector3(L, 1);
-            PushVector3(L, Vectormath::Aos::normalize(*v));
+            PushVector3(L, Vectormath::Aos::normalize(*v), 2);
         }
         else if (type == SCRIPT_TYPE_VECTOR4)
         {
             Vector4* v = CheckVector4(L, 1);
-            PushVector4(L, Vectormath::Aos::normalize(*v));
+            PushVector4(L, Vectormath::Aos::normalize(*v), 2);
         }
         else if (type == SCRIPT_TYPE_QUAT)
         {
             Quat* value = CheckQuat(L, 1);
-            PushQuat(L, Vectormath::Aos::normalize(*value));
+            PushQuat(L, Vectormath::Aos::normalize(*value), 2);
         }
         else
         {
@@ -1912,6 +1915,7 @@ namespace dmScript
      * @name vmath.cross
      * @param v1 [type:vector3] first vector
      * @param v2 [type:vector3] second vector
+     * @param [out] [type:vector3] optional vector to store the result in, it is returned instead of a new vector
      * @return v [type:vector3] a new vector representing the cross product
      * @examples
      *
@@ -1927,7 +1931,7 @@ namespace dmScript
     {
         Vector3* v1 = CheckVector3(L, 1);
         Vector3* v2 = CheckVector3(L, 2);
-        PushVector3(L, Vectormath::Aos::cross(*v1, *v2));
+        PushVector3(L, Vectormath::Aos::cross(*v1, *v2), 3);
         return 1;
     }
 
@@ -1944,6 +1948,7 @@ namespace dmScript
      * @param t [type:number] interpolation parameter, 0-1
      * @param v1 [type:vector3|vector4] vector to lerp from
      * @param v2 [type:vector3|vector4] vector to lerp to
+     * @param [out] [type:vector3|vector4] optional vector to store the result in, it is returned instead of a new vector
      * @return v [type:vector3|vector4] the lerped vector
      * @examples
      *
@@ -1977,6 +1982,7 @@ namespace dmScript
      * @param t [type:number] interpolation parameter, 0-1
      * @param q1 [type:quaternion] quaternion to lerp from
      * @param q2 [type:quaternion] quaternion to lerp to
+     * @param [out] [type:quaternion] optional quaternion to store the result in, it is returned instead of a new quaternion
      * @return q [type:quaternion] the lerped quaternion
      * @examples
      *
@@ -2039,21 +2045,21 @@ namespace dmScript
             {
                 Vector3* v1 = CheckVector3(L, 2);
                 Vector3* v2 = CheckVector3(L, 3);
-                PushVector3(L, Vectormath::Aos::lerp(t, *v1, *v2));
+                PushVector3(L, Vectormath::Aos::lerp(t, *v1, *v2), 4);
                 return 1;
             }
             else if (type1 == SCRIPT_TYPE_VECTOR4 && type2 == SCRIPT_TYPE_VECTOR4)
             {
                 Vector4* v1 = CheckVector4(L, 2);
                 Vector4* v2 = CheckVector4(L, 3);
-                PushVector4(L, Vectormath::Aos::lerp(t, *v1, *v2));
+                PushVector4(L, Vectormath::Aos::lerp(t, *v1, *v2), 4);
                 return 1;
             }
             else if (type1 == SCRIPT_TYPE_QUAT && type2 == SCRIPT_TYPE_QUAT)
             {
                 Quat* q1 = CheckQuat(L, 2);
                 Quat* q2 = CheckQuat(L, 3);
-                PushQuat(L, Vectormath::Aos::lerp(t, *q1, *q2));
+                PushQuat(L, Vectormath::Aos::lerp(t, *q1, *q2), 4);
                 return 1;
             }
         }
@@ -2084,6 +2090,7 @@ namespace dmScript
      * @param t [type:number] interpolation parameter, 0-1
      * @param v1 [type:vector3|vector4] vector to slerp from
      * @param v2 [type:vector3|vector4] vector to slerp to
+     * @param [out] [type:vector3|vector4] optional vector to store the result in, it is returned instead of a new vector
      * @return v [type:vector3|vector4] the slerped vector
      * @examples
      *
@@ -2120,6 +2127,7 @@ namespace dmScript
      * @param t [type:number] interpolation parameter, 0-1
      * @param q1 [type:quaternion] quaternion to slerp from
      * @param q2 [type:quaternion] quaternion to slerp to
+     * @param [out] [type:quaternion] optional quaternion to store the result in, it is returned instead of a new quaternion
      * @return q [type:quaternion] the slerped quaternion
      * @examples
      *
@@ -2151,21 +2159,21 @@ namespace dmScript
             {
                 Quat* q1 = (Quat*)lua_touserdata(L, 2);
                 Quat* q2 = (Quat*)lua_touserdata(L, 3);
-                PushQuat(L, Vectormath::Aos::slerp(t, *q1, *q2));
+                PushQuat(L, Vectormath::Aos::slerp(t, *q1, *q2), 4);
                 return 1;
             }
             else if (type1 == SCRIPT_TYPE_VECTOR4 && type2 == SCRIPT_TYPE_VECTOR4)
             {
                 Vector4* v1 = CheckVector4(L, 2);
                 Vector4* v2 = CheckVector4(L, 3);
-                PushVector4(L, Vectormath::Aos::slerp(t, *v1, *v2));
+                PushVector4(L, Vectormath::Aos::slerp(t, *v1, *v2), 4);
                 return 1;
             }
             else if (type1 == SCRIPT_TYPE_VECTOR3 && type2 == SCRIPT_TYPE_VECTOR3)
             {
                 Vector3* v1 = CheckVector3(L, 2);
                 Vector3* v2 = CheckVector3(L, 3);
-                PushVector3(L, Vectormath::Aos::slerp(t, *v1, *v2));
+                PushVector3(L, Vectormath::Aos::slerp(t, *v1, *v2), 4);
                 return 1;
             }
         }
@@ -2182,6 +2190,7 @@ namespace dmScript
      *
      * @name vmath.conj
      * @param q1 [type:quaternion] quaternion of which to calculate the conjugate
+     * @param [out] [type:quaternion] optional quaternion to store the result in, it is returned instead of a new quaternion
      * @return q [type:quaternion] the conjugate
      * @examples
      *
@@ -2193,7 +2202,7 @@ namespace dmScript
     static int Conj(lua_State* L)
     {
         Quat* q = CheckQuat(L, 1);
-        PushQuat(L, Vectormath::Aos::conj(*q));
+        PushQuat(L, Vectormath::Aos::conj(*q), 2);
         return 1;
     }
 
@@ -2206,6 +2215,7 @@ namespace dmScript
      * @name vmath.rotate
      * @param q [type:quaternion] quaternion
      * @param v1 [type:vector3] vector to rotate
+     * @param [out] [type:vector3] optional vector to store the result in, it is returned instead of a new vector
      * @return v [type:vector3] the rotated vector
      * @examples
      *
@@ -2219,7 +2229,7 @@ namespace dmScript
     {
         Quat* q = CheckQuat(L, 1);
         Vector3* v = CheckVector3(L, 2);
-        PushVector3(L, Vectormath::Aos::rotate(*q, *v));
+        PushVector3(L, Vectormath::Aos::rotate(*q, *v), 3);
         return 1;
     }
 
@@ -2265,6 +2275,7 @@ namespace dmScript
      * @name vmath.mul_per_elem
      * @param v1 [type:vector3|vector4] first vector
      * @param v2 [type:vector3|vector4] second vector
+     * @param [out] [type:vector3|vector4] optional vector to store the result in, it is returned instead of a new vector
      * @return v [type:vector3|vector4] multiplied vector
      * @examples
      *
@@ -2285,13 +2296,13 @@ namespace dmScript
         {
             Vector3* v1 = CheckVector3(L, 1);
             Vector3* v2 = CheckVector3(L, 2);
-            PushVector3(L, Vectormath::Aos::mulPerElem(*v1, *v2));
+            PushVector3(L, Vectormath::Aos::mulPerElem(*v1, *v2), 3);
         }
         else if (type1 == SCRIPT_TYPE_VECTOR4 && type2 == SCRIPT_TYPE_VECTOR4)
         {
             Vector4* v1 = CheckVector4(L, 1);
             Vector4* v2 = CheckVector4(L, 2);
-            PushVector4(L, Vectormath::Aos::mulPerElem(*v1, *v2));
+            PushVector4(L, Vectormath::Aos::mulPerElem(*v1, *v2), 3);
         }
         else
         {
@@ -2300,6 +2311,197 @@ namespace dmScript
         return 1;
     }
 
+    /*# adds two vectors
+     *
+     * Adds two vectors of the same type. Unlike the `+` operator, the result
+     * can be stored in an existing vector, which avoids creating a new
+     * vector for each intermediate result in per frame calculations.
+     *
+     * @name vmath.add
+     * @param v1 [type:vector3|vector4] first vector
+     * @param v2 [type:vector3|vector4] second vector
+     * @param [out] [type:vector3|vector4] optional vector to store the result in, it is returned instead of a new vector
+     * @return v [type:vector3|vector4] the sum of the vectors
+     * @examples
+     *
+     * ```lua
+     * function update(self, dt)
+     *     -- self.pos and self.velocity are updated in place
+     *     vmath.add(self.pos, vmath.mul(self.velocity, dt, self.step), self.pos)
+     *     go.set_position(self.pos)
+     * end
+     * ```
+     */
+    static int Add(lua_State* L)
+    {
+        const ScriptUserType type1 = GetType(L, 1);
+        const ScriptUserType type2 = GetType(L, 2);
+        if (type1 == SCRIPT_TYPE_VECTOR3 && type2 == SCRIPT_TYPE_VECTOR3)
+        {
+            PushVector3(L, *CheckVector3(L, 1) + *CheckVector3(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_VECTOR4 && type2 == SCRIPT_TYPE_VECTOR4)
+        {
+            PushVector4(L, *CheckVector4(L, 1) + *CheckVector4(L, 2), 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts two %s or two %s as arguments.", SCRIPT_LIB_NAME, "add", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        return 1;
+    }
+
+    /*# subtracts two vectors
+     *
+     * Subtracts the second vector from the first. Unlike the `-` operator,
+     * the result can be stored in an existing vector.
+     *
+     * @name vmath.sub
+     * @param v1 [type:vector3|vector4] vector to subtract from
+     * @param v2 [type:vector3|vector4] vector to subtract
+     * @param [out] [type:vector3|vector4] optional vector to store the result in, it is returned instead of a new vector
+     * @return v [type:vector3|vector4] the difference of the vectors
+     * @examples
+     *
+     * ```lua
+     * local delta = vmath.vector3()
+     * vmath.sub(target_pos, pos, delta)
+     * ```
+     */
+    static int Sub(lua_State* L)
+    {
+        const ScriptUserType type1 = GetType(L, 1);
+        const ScriptUserType type2 = GetType(L, 2);
+        if (type1 == SCRIPT_TYPE_VECTOR3 && type2 == SCRIPT_TYPE_VECTOR3)
+        {
+            PushVector3(L, *CheckVector3(L, 1) - *CheckVector3(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_VECTOR4 && type2 == SCRIPT_TYPE_VECTOR4)
+        {
+            PushVector4(L, *CheckVector4(L, 1) - *CheckVector4(L, 2), 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts two %s or two %s as arguments.", SCRIPT_LIB_NAME, "sub", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4);
+        }
+        return 1;
+    }
+
+    /*# multiplies two values
+     *
+     * Multiplies the same combinations of values as the `*` operator:
+     * a vector or matrix by a number, two quaternions, two matrices or
+     * a matrix by a vector4. Unlike the operator, the result can be stored
+     * in an existing value of the result type.
+     *
+     * @name vmath.mul
+     * @param a [type:vector3|vector4|quaternion|matrix4] first value
+     * @param b [type:number|quaternion|matrix4|vector4] second value
+     * @param [out] [type:vector3|vector4|quaternion|matrix4] optional value to store the result in, it is returned instead of a new value
+     * @return v [type:vector3|vector4|quaternion|matrix4] the product
+     * @examples
+     *
+     * ```lua
+     * local step = vmath.vector3()
+     * vmath.mul(self.velocity, dt, step)
+     * ```
+     */
+    static int Mul(lua_State* L)
+    {
+        const ScriptUserType type1 = GetType(L, 1);
+        const ScriptUserType type2 = GetType(L, 2);
+        if (type1 == SCRIPT_TYPE_VECTOR3 && lua_isnumber(L, 2))
+        {
+            PushVector3(L, *CheckVector3(L, 1) * (float) lua_tonumber(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_VECTOR4 && lua_isnumber(L, 2))
+        {
+            PushVector4(L, *CheckVector4(L, 1) * (float) lua_tonumber(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_QUAT && type2 == SCRIPT_TYPE_QUAT)
+        {
+            PushQuat(L, *CheckQuat(L, 1) * *CheckQuat(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_MATRIX4 && type2 == SCRIPT_TYPE_MATRIX4)
+        {
+            PushMatrix4(L, *CheckMatrix4(L, 1) * *CheckMatrix4(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_MATRIX4 && type2 == SCRIPT_TYPE_VECTOR4)
+        {
+            PushVector4(L, *CheckMatrix4(L, 1) * *CheckVector4(L, 2), 3);
+        }
+        else if (type1 == SCRIPT_TYPE_MATRIX4 && lua_isnumber(L, 2))
+        {
+            PushMatrix4(L, *CheckMatrix4(L, 1) * (float) lua_tonumber(L, 2), 3);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s can't multiply the supplied arguments.", SCRIPT_LIB_NAME, "mul");
+        }
+        return 1;
+    }
+
+    /*# sets the components of a vector, quaternion or matrix
+     *
+     * Sets all components of an existing value, either from numbers or
+     * by copying another value of the same type. This is cheaper than
+     * setting the components one by one and doesn't create a new value.
+     *
+     * @name vmath.set
+     * @param v [type:vector3|vector4|quaternion|matrix4] value to modify
+     * @param ... [type:number|vector3|vector4|quaternion|matrix4] x, y, z (and w) components, or a value of the same type to copy
+     * @return v [type:vector3|vector4|quaternion|matrix4] the modified value
+     * @examples
+     *
+     * ```lua
+     * vmath.set(self.pos, 10, 20, 0)
+     * vmath.set(self.rot, other_rot)
+     * ```
+     */
+    static int Set(lua_State* L)
+    {
+        const ScriptUserType type = GetType(L, 1);
+        if (lua_isuserdata(L, 2) && type != GetType(L, 2))
+        {
+            return luaL_error(L, "%s.%s can only copy from a value of the same type.", SCRIPT_LIB_NAME, "set");
+        }
+
+        if (type == SCRIPT_TYPE_VECTOR3)
+        {
+            Vector3* v = (Vector3*)lua_touserdata(L, 1);
+            if (lua_isuserdata(L, 2))
+                *v = *(Vector3*)lua_touserdata(L, 2);
+            else
+                *v = Vector3((float) luaL_checknumber(L, 2), (float) luaL_checknumber(L, 3), (float) luaL_checknumber(L, 4));
+        }
+        else if (type == SCRIPT_TYPE_VECTOR4)
+        {
+            Vector4* v = (Vector4*)lua_touserdata(L, 1);
+            if (lua_isuserdata(L, 2))
+                *v = *(Vector4*)lua_touserdata(L, 2);
+            else
+                *v = Vector4((float) luaL_checknumber(L, 2), (float) luaL_checknumber(L, 3), (float) luaL_checknumber(L, 4), (float) luaL_checknumber(L, 5));
+        }
+        else if (type == SCRIPT_TYPE_QUAT)
+        {
+            Quat* q = (Quat*)lua_touserdata(L, 1);
+            if (lua_isuserdata(L, 2))
+                *q = *(Quat*)lua_touserdata(L, 2);
+            else
+                *q = Quat((float) luaL_checknumber(L, 2), (float) luaL_checknumber(L, 3), (float) luaL_checknumber(L, 4), (float) luaL_checknumber(L, 5));
+        }
+        else if (type == SCRIPT_TYPE_MATRIX4)
+        {
+            *(Matrix4*)lua_touserdata(L, 1) = *CheckMatrix4(L, 2);
+        }
+        else
+        {
+            return luaL_error(L, "%s.%s accepts (%s|%s|%s|%s) as first argument.", SCRIPT_LIB_NAME, "set", SCRIPT_TYPE_NAME_VECTOR3, SCRIPT_TYPE_NAME_VECTOR4, SCRIPT_TYPE_NAME_QUAT, SCRIPT_TYPE_NAME_MATRIX4);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
     static const luaL_reg methods[] =
     {
         {SCRIPT_TYPE_NAME_VECTOR, Vector_new},
@@ -2336,6 +2538,10 @@ namespace dmScript
         {"inv", Inverse},
         {"ortho_inv", OrthoInverse},
         {"mul_per_elem", MulPerElem},
+        {"add", Add},
+        {"sub", Sub},
+        {"mul", Mul},
+        {"set", Set},
         {0, 0}
     };
 
@@ -2389,6 +2595,17 @@ namespace dmScript
         lua_setmetatable(L, -2);
     }
 
+    void PushVector3(lua_State* L, const Vector3& v, int out_index)
+    {
+        if (lua_isnoneornil(L, out_index))
+        {
+            PushVector3(L, v);
+            return;
+        }
+        *(Vector3*)CheckUserType(L, out_index, TYPE_HASHES[SCRIPT_TYPE_VECTOR3], 0) = v;
+        lua_pushvalue(L, out_index);
+    }
+
     Vector3* CheckVector3(lua_State* L, int index)
     {
         Vector3* v = (Vector3*)CheckUserType(L, index, TYPE_HASHES[SCRIPT_TYPE_VECTOR3], 0);
@@ -2407,6 +2624,17 @@ namespace dmScript
         lua_setmetatable(L, -2);
     }
 
+    void PushVector4(lua_State* L, const Vector4& v, int out_index)
+    {
+        if (lua_isnoneornil(L, out_index))
+        {
+            PushVector4(L, v);
+            return;
+        }
+        *(Vector4*)CheckUserType(L, out_index, TYPE_HASHES[SCRIPT_TYPE_VECTOR4], 0) = v;
+        lua_pushvalue(L, out_index);
+    }
+
     Vector4* CheckVector4(lua_State* L, int index)
     {
         Vector4* v = (Vector4*)CheckUserType(L, index, TYPE_HASHES[SCRIPT_TYPE_VECTOR4], 0);
@@ -2425,6 +2653,17 @@ namespace dmScript
         lua_setmetatable(L, -2);
     }
 
+    void PushQuat(lua_State* L, const Quat& q, int out_index)
+    {
+        if (lua_isnoneornil(L, out_index))
+        {
+            PushQuat(L, q);
+            return;
+        }
+        *(Quat*)CheckUserType(L, out_index, TYPE_HASHES[SCRIPT_TYPE_QUAT], 0) = q;
+        lua_pushvalue(L, out_index);
+    }
+
     Quat* CheckQuat(lua_State* L, int index)
     {
         Quat* q = (Quat*)CheckUserType(L, index, TYPE_HASHES[SCRIPT_TYPE_QUAT], 0);
@@ -2443,6 +2682,17 @@ namespace dmScript
         lua_setmetatable(L, -2);
     }
 
+    void PushMatrix4(lua_State* L, const Matrix4& m, int out_index)
+    {
+        if (lua_isnoneornil(L, out_index))
+        {
+            PushMatrix4(L, m);
+            return;
+        }
+        *(Matrix4*)CheckUserType(L, out_index, TYPE_HASHES[SCRIPT_TYPE_MATRIX4], 0) = m;
+        lua_pushvalue(L, out_index);
+    }
+
     Matrix4* CheckMatrix4(lua_State* L, int index)
     {
         Matrix4* m = (Matrix4*)CheckUserType(L, index, TYPE_HASHES[SCRIPT_TYPE_MATRIX4], 0);
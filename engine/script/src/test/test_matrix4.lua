@@ -169,3 +169,16 @@ m.c1 = vmath.vector4(-10.01,-10.01,-10.01,-10.01)
 m.c2 = vmath.vector4(-10.01,-10.01,-10.01,-10.01)
 m.c3 = vmath.vector4(-10.01,-10.01,-10.01,-10.01)
 assert(tostring(m) == ("" .. m))
+
+-- in place operations
+local out = vmath.matrix4()
+local t = vmath.matrix4_translation(vmath.vector3(1, 2, 3))
+assert(vmath.ortho_inv(t, out) == out, "ortho_inv out")
+assert(out.m03 == -1 and out.m13 == -2 and out.m23 == -3, "ortho_inv out")
+vmath.mul(t, t, out)
+assert(out.m03 == 2 and out.m13 == 4 and out.m23 == 6, "mul out")
+vmath.set(out, t)
+assert(out.m03 == 1 and out.m13 == 2 and out.m23 == 3, "set copy")
+local v = vmath.vector4()
+vmath.mul(t, vmath.vector4(0, 0, 0, 1), v)
+assert(v.x == 1 and v.y == 2 and v.z == 3 and v.w == 1, "mul vector4 out")
@@ -114,3 +114,17 @@ assert(("foo " .. tostring(q)) == "foo vmath.quat(1, 2, 3, 4)")
 assert(("foo " .. q) == "foo vmath.quat(1, 2, 3, 4)")
 q = vmath.quat(-10.01, -10.01, -10.01, -10.01)
 assert(tostring(q) == ("" .. q))
+
+-- in place operations
+local out = vmath.quat()
+local q1 = vmath.quat_rotation_z(0)
+local q2 = vmath.quat_rotation_z(math.pi)
+assert(vmath.slerp(0.5, q1, q2, out) == out, "slerp out")
+local expected = vmath.slerp(0.5, q1, q2)
+assert(out.x == expected.x and out.y == expected.y and out.z == expected.z and out.w == expected.w, "slerp out")
+vmath.mul(q2, q2, out)
+expected = q2 * q2
+assert(out.x == expected.x and out.y == expected.y and out.z == expected.z and out.w == expected.w, "mul out")
+vmath.set(out, 1, 2, 3, 4)
+vmath.conj(out, out)
+assert(out.x == -1 and out.y == -2 and out.z == -3 and out.w == 4, "conj out")
@@ -1060,6 +1060,67 @@ TEST_F(ScriptTest, InstanceId)
     dmScript::Unref(L, LUA_REGISTRYINDEX, instanceref3);
 }
 
+TEST_F(ScriptTest, FrameGarbageCollection)
+{
+    int top = lua_gettop(L);
+
+    // A growth limit of 100% makes every step finish its cycle, regardless of the tiny budget
+    dmScript::SetGarbageCollectionBudget(m_Context, 1, 100);
+
+    // The first step only takes the heap size the growth limit is relative to
+    int base_size = lua_gc(L, LUA_GCCOUNT, 0);
+    dmScript::StepGarbageCollection(m_Context, dmTime::GetTime() + 1);
+    ASSERT_EQ(base_size, lua_gc(L, LUA_GCCOUNT, 0));
+
+    ASSERT_TRUE(RunString(L, "for i=1,10000 do g_garbage = { i, i + 1, i + 2 } end g_garbage = nil"));
+
+    // The automatic collector is stopped, so the garbage is still there
+    int garbage_size = lua_gc(L, LUA_GCCOUNT, 0);
+    ASSERT_GT(garbage_size, base_size + 100);
+
+    dmScript::StepGarbageCollection(m_Context, dmTime::GetTime() + 1);
+    ASSERT_LT(lua_gc(L, LUA_GCCOUNT, 0), garbage_size);
+
+    // Stepping must not re-enable the automatic collector
+    ASSERT_TRUE(RunString(L, "for i=1,10000 do g_garbage = { i, i + 1, i + 2 } end g_garbage = nil"));
+    ASSERT_GT(lua_gc(L, LUA_GCCOUNT, 0), base_size + 100);
+
+    dmScript::SetGarbageCollectionBudget(m_Context, 0, 0);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptTest, FrameGarbageCollectionBudget)
+{
+    int top = lua_gettop(L);
+
+    // Without a growth limit, a step stops when the budget is spent
+    const uint64_t budget = 100;
+    dmScript::SetGarbageCollectionBudget(m_Context, (uint32_t) budget, 0);
+    dmScript::StepGarbageCollection(m_Context, dmTime::GetTime() + budget);
+
+    ASSERT_TRUE(RunString(L, "for i=1,200000 do g_garbage = { i, i + 1, i + 2 } end g_garbage = nil"));
+    int garbage_size = lua_gc(L, LUA_GCCOUNT, 0);
+
+    uint32_t step_count = 0;
+    uint64_t max_step_time = 0;
+    while (lua_gc(L, LUA_GCCOUNT, 0) > garbage_size / 2 && step_count < 100000)
+    {
+        uint64_t start = dmTime::GetTime();
+        dmScript::StepGarbageCollection(m_Context, start + budget);
+        uint64_t step_time = dmTime::GetTime() - start;
+        max_step_time = step_time > max_step_time ? step_time : max_step_time;
+        ++step_count;
+    }
+
+    // The garbage takes many steps to collect, each overrunning the budget by at most a Lua collection step
+    ASSERT_GT(step_count, 1u);
+    ASSERT_LT(step_count, 100000u);
+    ASSERT_LT(max_step_time, budget + 10000);
+
+    dmScript::SetGarbageCollectionBudget(m_Context, 0, 0);
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 
 int main(int argc, char **argv)
 {
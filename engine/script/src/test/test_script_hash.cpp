@@ -21,6 +21,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/hash.h>
 #include <dlib/log.h>
+#include <dlib/time.h>
 
 extern "C"
 {
@@ -196,6 +197,53 @@ TEST_F(ScriptHashTest, TestHashTString) // def2821 - Making sure that the string
     ASSERT_EQ(hash_tostring, hash_tolstring);
 }
 
+TEST_F(ScriptHashTest, TestHashStringCache)
+{
+    int top = lua_gettop(L);
+
+    // More strings than the cache holds, the string in use stays cached while the others are evicted
+    ASSERT_TRUE(RunString(L,
+        "local hot = hash(\"hot\")\n"
+        "for i = 1,4096 do\n"
+        "    local s = \"string_\" .. i\n"
+        "    assert(hash(s) == hash(s))\n"
+        "    assert(hash(\"hot\") == hot)\n"
+        "end\n"
+        "assert(hash(\"string_1\") == hash(\"string_\" .. 1))\n"
+        ));
+
+    const char* long_string = "a_string_that_is_too_long_to_be_cached_a_string_that_is_too_long_to_be_cached";
+    lua_getglobal(L, "hash");
+    lua_pushstring(L, long_string);
+    lua_call(L, 1, 1);
+    ASSERT_EQ(dmHashString64(long_string), dmScript::CheckHash(L, -1));
+    lua_pop(L, 1);
+
+    lua_getglobal(L, "hash");
+    lua_pushstring(L, "string_1");
+    lua_call(L, 1, 1);
+    ASSERT_EQ(dmHashString64("string_1"), dmScript::CheckHash(L, -1));
+    lua_pop(L, 1);
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptHashTest, TestHashPerf)
+{
+    const uint32_t count = 100000;
+    char program[256];
+    dmSnPrintf(program, sizeof(program),
+        "local h\n"
+        "for i = 1,%u do\n"
+        "    h = hash(\"/a_game_object#a_component\")\n"
+        "end\n",
+        count);
+    uint64_t time = dmTime::GetTime();
+    ASSERT_TRUE(RunString(L, program));
+    time = dmTime::GetTime() - time;
+    dmLogInfo("Time per hash: %.4f us", time / (double)count);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
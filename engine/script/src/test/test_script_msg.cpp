@@ -611,6 +611,160 @@ void DispatchCallbackTable(dmMessage::Message *message, void* user_ptr)
     assert(user_data->m_URL.m_Fragment == message->m_Receiver.m_Fragment);
 }
 
+void DispatchCallbackReceive(dmMessage::Message *message, void* user_ptr)
+{
+    lua_State* L = (lua_State*)user_ptr;
+    dmScript::PushMessageTable(L, (const char*)message->m_Data, message->m_DataSize);
+    lua_setglobal(L, "received");
+}
+
+TEST_F(ScriptMsgTest, TestPostLargeTable)
+{
+    int top = lua_gettop(L);
+
+    dmMessage::HSocket socket;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("socket", &socket));
+
+    // Larger than both the msg.post stack buffer and a message page
+    ASSERT_TRUE(RunString(L,
+        "local t = {}\n"
+        "for i = 1, 2000 do t[i] = vmath.vector3(i, i, i) end\n"
+        "msg.post(\"socket:\", \"large\", t)\n"
+        ));
+    ASSERT_EQ(1u, dmMessage::Dispatch(socket, DispatchCallbackReceive, L));
+    ASSERT_TRUE(RunString(L,
+        "assert(#received == 2000)\n"
+        "assert(received[2000] == vmath.vector3(2000, 2000, 2000))\n"
+        ));
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(socket));
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptMsgTest, TestPostByReference)
+{
+    int top = lua_gettop(L);
+
+    dmMessage::HSocket socket;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("socket", &socket));
+    int ref_count = dmScript::GetLuaRefCount();
+
+    ASSERT_TRUE(RunString(L,
+        "sent = {value = 1}\n"
+        "msg.post(\"socket:\", \"by_reference\", sent, {by_reference = true})\n"
+        ));
+    ASSERT_EQ(1u, dmMessage::Dispatch(socket, DispatchCallbackReceive, L));
+    ASSERT_TRUE(RunString(L,
+        "assert(received == sent)\n"
+        ));
+    ASSERT_EQ(ref_count, dmScript::GetLuaRefCount());
+
+    // The reference is released when the message is never dispatched
+    ASSERT_TRUE(RunString(L,
+        "msg.post(\"socket:\", \"by_reference\", sent, {by_reference = true})\n"
+        ));
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(socket));
+    ASSERT_EQ(ref_count, dmScript::GetLuaRefCount());
+
+    ASSERT_FALSE(RunString(L,
+        "msg.post(\"socket:\", \"by_reference\", sent, {by_reference = true})\n"
+        ));
+    ASSERT_EQ(ref_count, dmScript::GetLuaRefCount());
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
+TEST_F(ScriptMsgTest, TestPostByReferenceContextDeleted)
+{
+    dmMessage::HSocket socket;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("socket", &socket));
+    int ref_count = dmScript::GetLuaRefCount();
+
+    dmScript::HContext context = dmScript::NewContext(0, 0, true);
+    dmScript::Initialize(context);
+    lua_State* context_L = dmScript::GetLuaState(context);
+    int context_ref_count = dmScript::GetLuaRefCount();
+
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(&receiver);
+    receiver.m_Socket = socket;
+    dmScript::PushURL(context_L, receiver);
+    lua_setglobal(context_L, "receiver");
+    ASSERT_TRUE(RunString(context_L,
+        "msg.post(receiver, \"by_reference\", {value = 1}, {by_reference = true})\n"
+        ));
+    ASSERT_EQ(context_ref_count, dmScript::GetLuaRefCount());
+
+    // The pending message outlives the context, and is destroyed with the socket
+    dmScript::Finalize(context);
+    dmScript::DeleteContext(context);
+    ASSERT_EQ(ref_count, dmScript::GetLuaRefCount());
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(socket));
+}
+
+TEST_F(ScriptMsgTest, ResolveURLCached)
+{
+    int top = lua_gettop(L);
+
+    dmMessage::HSocket socket;
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("other_socket", &socket));
+
+    dmMessage::URL other_url;
+    other_url.m_Socket = socket;
+    other_url.m_Path = dmHashString64("other_path");
+    other_url.m_Fragment = dmHashString64("other_fragment");
+
+    const char* urls[] = {"#", ".", "#fragment", "foo", "foo#bar", "/foo#bar", "default_socket:/foo#bar"};
+    const uint32_t url_count = sizeof(urls) / sizeof(urls[0]);
+    dmMessage::URL expected[url_count];
+
+    // Resolved URLs are the same whether they come from the cache or not
+    for (uint32_t i = 0; i < url_count; ++i)
+    {
+        lua_pushstring(L, urls[i]);
+        dmScript::ResolveURL(L, top + 1, &expected[i], 0x0);
+        for (uint32_t j = 0; j < 2; ++j)
+        {
+            dmMessage::URL receiver;
+            dmScript::ResolveURL(L, top + 1, &receiver, 0x0);
+            ASSERT_EQ(expected[i].m_Socket, receiver.m_Socket);
+            ASSERT_EQ(expected[i].m_Path, receiver.m_Path);
+            ASSERT_EQ(expected[i].m_Fragment, receiver.m_Fragment);
+        }
+        lua_pop(L, 1);
+    }
+
+    // Cached URLs follow the default URL
+    dmScript::PushURL(L, other_url);
+    lua_setglobal(L, DEFAULT_URL);
+    for (uint32_t i = 0; i < url_count; ++i)
+    {
+        lua_pushstring(L, urls[i]);
+        dmMessage::URL receiver;
+        dmMessage::URL sender;
+        dmScript::ResolveURL(L, top + 1, &receiver, &sender);
+        ASSERT_EQ(socket, sender.m_Socket);
+        ASSERT_EQ(other_url.m_Path, sender.m_Path);
+        bool global = strchr(urls[i], ':') != 0;
+        ASSERT_EQ(global ? expected[i].m_Socket : socket, receiver.m_Socket);
+        lua_pop(L, 1);
+    }
+
+    lua_pushstring(L, "#");
+    dmMessage::URL receiver;
+    dmScript::ResolveURL(L, top + 1, &receiver, 0x0);
+    ASSERT_EQ(other_url.m_Path, receiver.m_Path);
+    ASSERT_EQ(other_url.m_Fragment, receiver.m_Fragment);
+    lua_pop(L, 1);
+
+    dmScript::PushURL(L, m_DefaultURL);
+    lua_setglobal(L, DEFAULT_URL);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(socket));
+
+    ASSERT_EQ(top, lua_gettop(L));
+}
+
 TEST_F(ScriptMsgTest, TestPost)
 {
     int top = lua_gettop(L);
@@ -18,6 +18,7 @@
 #include <dlib/align.h>
 #include <dlib/memory.h>
 #include <dlib/math.h>
+#include <dlib/time.h>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include "../script.h"
@@ -31,6 +32,7 @@
 #include "data/table_tstring_v1.dat.embed.h"
 #include "data/table_tstring_v2.dat.embed.h"
 #include "data/table_tstring_v3.dat.embed.h"
+#include "data/table_tstring_v4.dat.embed.h"
 
 extern "C"
 {
@@ -171,7 +173,7 @@ TEST_F(LuaTableTest, AttemptReadUnsupportedVersion)
     int result = lua_cpcall(L, ReadUnsupportedVersion, 0x0);
     ASSERT_NE(0, result);
     char str[256];
-    dmSnPrintf(str, sizeof(str), "Unsupported serialized table data: version = 0x%x (current = 0x%x)", 818192, 4);
+    dmSnPrintf(str, sizeof(str), "Unsupported serialized table data: version = 0x%x (current = 0x%x)", 818192, 5);
     ASSERT_STREQ(str, lua_tostring(L, -1));
     // pop error message
     lua_pop(L, 1);
@@ -551,6 +553,30 @@ TEST_F(LuaTableTest, Verify_TSTRING_V3) // tolstring / pushlstring
     "));
 }
 
+TEST_F(LuaTableTest, Verify_TSTRING_V4) // last version before the single pass format
+{
+    dmScript::PushTable(L, (const char*)TABLE_TSTRING_V4_DAT, TABLE_TSTRING_V4_DAT_SIZE);
+    lua_setglobal(L, "t");
+
+    ASSERT_TRUE(RunString(L, " \
+        assert( t['binary\\0string'] == 'payload\\1\\0\\2\\3' ) \
+        assert( t['vector3'] == vmath.vector3(1,2,3) ) \
+        assert( t['vector4'] == vmath.vector4(4, 5, 6, 7) ) \
+        assert( t['quat'] == vmath.quat(1,2,3,4) ) \
+        assert( t['number'] == 0.5 ) \
+        assert( t['hash'] == hash('hashed value') ) \
+        assert( t['url'] == msg.url('a', 'b', 'c') ) \
+        assert( t[1] == 1 and t[2] == 2.5 and t[3] == 'three' ) \
+        assert( t[-7] == 'negative key' ) \
+        assert( t['negative'] == -12345 ) \
+        assert( t['large'] == 4294967295 ) \
+        assert( t['flags'][1] == true and t['flags'][2] == false ) \
+        assert( t['nested']['name'] == 'nested' ) \
+        assert( t['nested']['inner']['name'] == 'nested' ) \
+        assert( t['nested']['inner']['value'] == 42 ) \
+    "));
+}
+
 TEST_F(LuaTableTest, TSTRING) // binary strings (def2821)
 {
     lua_newtable(L);
@@ -828,6 +854,131 @@ TEST_F(LuaTableTest, MixedKeys)
     lua_pop(L, 1);
 }
 
+TEST_F(LuaTableTest, ArrayPart)
+{
+    ASSERT_TRUE(RunString(L,
+        "local t = { 1, 2.5, -3, 2^40, -0.5, n = 'x', [0] = 0, [-1] = -1, [5.5] = 5.5, [7] = 7 }\n"
+        "local r = sys.deserialize(sys.serialize(t))\n"
+        "for k, v in pairs(t) do assert(r[k] == v) end\n"
+        "for k, v in pairs(r) do assert(t[k] == v) end\n"
+        "local mixed = { 1, 'two', true, { 4 }, vmath.vector3(5, 6, 7), hash('h'), nil, 'eight' }\n"
+        "r = sys.deserialize(sys.serialize(mixed))\n"
+        "assert(r[1] == 1 and r[2] == 'two' and r[3] == true and r[4][1] == 4)\n"
+        "assert(r[5] == vmath.vector3(5, 6, 7) and r[6] == hash('h') and r[7] == nil and r[8] == 'eight')\n"
+        "-- numbers in an array are packed\n"
+        "local numbers = {}\n"
+        "for i = 1, 1000 do numbers[i] = i + 0.5 end\n"
+        "assert(#sys.serialize(numbers) < 1000 * 9)\n"
+        ));
+}
+
+TEST_F(LuaTableTest, RepeatedStrings)
+{
+    ASSERT_TRUE(RunString(L,
+        "local value = string.rep('v', 100)\n"
+        "local t = {}\n"
+        "for i = 1, 100 do t[i] = { name = value, [value] = i } end\n"
+        "local r = sys.deserialize(sys.serialize(t))\n"
+        "for i = 1, 100 do assert(r[i].name == value and r[i][value] == i) end\n"
+        "-- each repeated string is written once\n"
+        "assert(#sys.serialize(t) < 100 * 100)\n"
+        "-- long strings are always written in full\n"
+        "local long = string.rep('l', 1000)\n"
+        "r = sys.deserialize(sys.serialize({ long, long, x = long }))\n"
+        "assert(r[1] == long and r[2] == long and r.x == long)\n"
+        ));
+}
+
+TEST_F(LuaTableTest, DeserializeTableReference)
+{
+    // Same layout as a table reference written by msg.post with by_reference, with an invalid owner
+    struct ForgedReference
+    {
+        uint32_t    m_Magic;
+        uint32_t    m_Version;
+        void*       m_Owner;
+        int         m_Reference;
+    } forged;
+    memset(&forged, 0, sizeof(forged));
+    forged.m_Magic = 0x42545246;
+    forged.m_Version = 5;
+    forged.m_Owner = (void*)(uintptr_t)0xdeadbeef;
+    lua_pushlstring(L, (const char*)&forged, sizeof(forged));
+    lua_setglobal(L, "forged");
+
+    ASSERT_TRUE(RunString(L,
+        "local ok, err = pcall(sys.deserialize, forged)\n"
+        "assert(not ok and string.find(err, 'message data'))\n"
+        ));
+}
+
+TEST_F(LuaTableTest, CheckTableBuffer)
+{
+    ASSERT_TRUE(RunString(L,
+        "large_table = {}\n"
+        "for i = 1, 100000 do large_table['key' .. i] = { i, 'value' .. (i % 10) } end\n"
+        ));
+    lua_getglobal(L, "large_table");
+
+    uint32_t size = 0;
+    const char* buffer = dmScript::CheckTableBuffer(L, -1, &size);
+    ASSERT_EQ(0, (intptr_t)buffer % 16);
+    ASSERT_EQ(size, dmScript::CheckTableSize(L, -1));
+    // Larger than the fixed 512 kb buffer sys.save used before
+    ASSERT_LT(512U * 1024U, size);
+
+    // The buffer is reused and written again
+    buffer = dmScript::CheckTableBuffer(L, -1, &size);
+    dmScript::PushTable(L, buffer, size);
+    lua_getfield(L, -1, "key12345");
+    lua_rawgeti(L, -1, 1);
+    ASSERT_EQ(12345, lua_tonumber(L, -1));
+    lua_rawgeti(L, -2, 2);
+    ASSERT_STREQ("value5", lua_tostring(L, -1));
+    lua_pop(L, 5);
+
+    lua_pushnil(L);
+    lua_setglobal(L, "large_table");
+}
+
+#if 0
+// Performance test over tables of up to 50 MB, enable it locally to measure
+TEST_F(LuaTableTest, TestPerf)
+{
+    // A save file like table, about 20000 records per MB
+    uint32_t sizes[] = { 1, 10, 50 };
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        char program[512];
+        dmSnPrintf(program, sizeof(program),
+            "perf_table = { records = {}, history = {} }\n"
+            "for i = 1, %u do\n"
+            "    perf_table.records[i] = { id = i, name = 'item' .. (i %% 100), score = i * 1.5, unlocked = (i %% 2) == 0, pos = { x = i, y = -i } }\n"
+            "    perf_table.history[i] = i * 0.25\n"
+            "end\n",
+            sizes[i] * 20000);
+        ASSERT_TRUE(RunString(L, program));
+        lua_getglobal(L, "perf_table");
+
+        uint64_t time = dmTime::GetTime();
+        uint32_t size = 0;
+        const char* buffer = dmScript::CheckTableBuffer(L, -1, &size);
+        uint64_t write_time = dmTime::GetTime() - time;
+
+        time = dmTime::GetTime();
+        dmScript::PushTable(L, buffer, size);
+        uint64_t read_time = dmTime::GetTime() - time;
+
+        dmLogInfo("%u records, %.2f MB: write %.2f ms, read %.2f ms", sizes[i] * 20000, size / (1024.0 * 1024.0), write_time / 1000.0, read_time / 1000.0);
+        lua_pop(L, 2);
+
+        lua_pushnil(L);
+        lua_setglobal(L, "perf_table");
+        lua_gc(L, LUA_GCCOLLECT, 0);
+    }
+}
+#endif
+
 int static ParseTruncatedTable(lua_State* L)
 {
     size_t buffer_len = 0;
@@ -726,6 +726,100 @@ TEST_F(ScriptTimerTest, TestKillTimers)
     dmScript::DeleteTimerWorld(timer_world);
 }
 
+TEST_F(ScriptTimerTest, TestTriggerOrder)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    static uint32_t trigger_order[4];
+
+    struct Callback {
+        static void cb(dmScript::HTimerWorld timer_world, dmScript::TimerEventType event_type, dmScript::HTimer timer_handle, float time_elapsed, uintptr_t owner, uintptr_t userdata)
+        {
+            ASSERT_NE(dmScript::TIMER_EVENT_CANCELLED, event_type);
+            ASSERT_GT(4u, TimerTestCallback::callback_count);
+            trigger_order[TimerTestCallback::callback_count++] = (uint32_t)userdata;
+            TimerTestCallback::elapsed_time += time_elapsed;
+        }
+    };
+
+    // Timers that are due in the same update are triggered in the order they were added,
+    // not in the order of their trigger time
+    ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, 3.f, false, Callback::cb, 0x10, 0));
+    ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, 1.f, false, Callback::cb, 0x10, 1));
+    ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, 2.f, false, Callback::cb, 0x10, 2));
+    ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, dmScript::AddTimer(timer_world, 1.f, false, Callback::cb, 0x10, 3));
+    ASSERT_EQ(4u, GetAliveTimers(timer_world));
+
+    dmScript::UpdateTimers(timer_world, 4.f);
+    ASSERT_EQ(4u, TimerTestCallback::callback_count);
+    ASSERT_EQ(0u, trigger_order[0]);
+    ASSERT_EQ(1u, trigger_order[1]);
+    ASSERT_EQ(2u, trigger_order[2]);
+    ASSERT_EQ(3u, trigger_order[3]);
+    ASSERT_EQ(16.f, TimerTestCallback::elapsed_time);
+
+    ASSERT_EQ(0u, GetAliveTimers(timer_world));
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
+TEST_F(ScriptTimerTest, TestManyTimers)
+{
+    dmScript::HTimerWorld timer_world = dmScript::NewTimerWorld();
+
+    const uint32_t timer_count = 10000u;
+    const uint32_t max_delay = 100u;
+
+    // Add the timers out of order, each delay is used by timer_count / max_delay timers
+    dmArray<dmScript::HTimer> handles;
+    handles.SetCapacity(timer_count);
+    handles.SetSize(timer_count);
+    for (uint32_t i = 0; i < timer_count; ++i)
+    {
+        float delay = (float)(1u + ((i * 37u) % max_delay));
+        handles[i] = dmScript::AddTimer(timer_world, delay, false, TestCallback, i % 2, 0x0);
+        ASSERT_NE(dmScript::INVALID_TIMER_HANDLE, handles[i]);
+    }
+    ASSERT_EQ(timer_count, GetAliveTimers(timer_world));
+
+    const uint32_t timers_per_delay = timer_count / max_delay;
+    for (uint32_t i = 1; i <= max_delay / 2; ++i)
+    {
+        dmScript::UpdateTimers(timer_world, 1.f);
+        ASSERT_EQ(i * timers_per_delay, TimerTestCallback::callback_count);
+        ASSERT_EQ(timer_count - i * timers_per_delay, GetAliveTimers(timer_world));
+    }
+
+    // Handles of triggered timers are stale
+    for (uint32_t i = 0; i < timer_count; ++i)
+    {
+        uint32_t delay = 1u + ((i * 37u) % max_delay);
+        ASSERT_EQ(delay > max_delay / 2, dmScript::CancelTimer(timer_world, handles[i]));
+        if (TimerTestCallback::cancel_count == 10u)
+        {
+            break;
+        }
+    }
+    ASSERT_EQ(10u, TimerTestCallback::cancel_count);
+
+    uint32_t alive_count = GetAliveTimers(timer_world);
+    uint32_t kill_count = dmScript::KillTimers(timer_world, 0);
+    ASSERT_LT(0u, kill_count);
+    ASSERT_EQ(alive_count - kill_count, GetAliveTimers(timer_world));
+
+    uint32_t callback_count = TimerTestCallback::callback_count;
+    for (uint32_t i = max_delay / 2 + 1; i <= max_delay; ++i)
+    {
+        dmScript::UpdateTimers(timer_world, 1.f);
+    }
+    ASSERT_EQ(callback_count + alive_count - kill_count, TimerTestCallback::callback_count);
+    ASSERT_EQ(10u, TimerTestCallback::cancel_count);
+
+    ASSERT_EQ(0u, GetAliveTimers(timer_world));
+
+    dmScript::DeleteTimerWorld(timer_world);
+}
+
 static bool RunString(lua_State* L, const char* script)
 {
     luaL_loadstring(L, script);
@@ -130,3 +130,29 @@ assert(("foo " .. tostring(v)) == "foo vmath.vector3(1, 2, 3)")
 assert(("foo " .. v) == "foo vmath.vector3(1, 2, 3)")
 v = vmath.vector3(-10.01, -10.01, -10.01)
 assert(tostring(v) == ("" .. v))
+
+-- in place operations
+local out = vmath.vector3()
+local a = vmath.vector3(1, 2, 3)
+local b = vmath.vector3(4, 5, 6)
+assert(vmath.add(a, b, out) == out, "add out")
+assert(out.x == 5 and out.y == 7 and out.z == 9, "add")
+vmath.sub(b, a, out)
+assert(out.x == 3 and out.y == 3 and out.z == 3, "sub")
+vmath.mul(a, 2, out)
+assert(out.x == 2 and out.y == 4 and out.z == 6, "mul")
+vmath.lerp(0.5, a, b, out)
+assert(out.x == 2.5 and out.y == 3.5 and out.z == 4.5, "lerp out")
+vmath.cross(vmath.vector3(1, 0, 0), vmath.vector3(0, 1, 0), out)
+assert(out.x == 0 and out.y == 0 and out.z == 1, "cross out")
+vmath.set(out, 3, 0, 0)
+vmath.normalize(out, out)
+assert(out.x == 1 and out.y == 0 and out.z == 0, "normalize out")
+vmath.set(out, a)
+assert(out.x == 1 and out.y == 2 and out.z == 3, "set copy")
+-- aliasing the output with an input
+vmath.add(out, out, out)
+assert(out.x == 2 and out.y == 4 and out.z == 6, "add aliased")
+-- no output returns a new vector
+assert(vmath.add(a, b) ~= out, "add new")
+assert(not pcall(vmath.add, a, b, vmath.quat()), "add wrong out type")
@@ -13,6 +13,8 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
@@ -26,12 +28,199 @@ namespace dmSoundCodec
 {
     namespace
     {
+        // Initial size of the compressed data buffer for streamed sounds. Grows if a page doesn't fit
+        const uint32_t STREAMING_BUFFER_SIZE = 16 * 1024;
+        const uint32_t STREAMING_BUFFER_MAX_SIZE = 1024 * 1024;
+
+        // State for sounds that are read on demand, using the stb_vorbis pushdata api
+        struct StreamingState {
+            FStreamRead m_Read;
+            void*       m_ReadContext;
+            uint32_t    m_StreamSize;
+            uint32_t    m_StreamOffset;     // Next offset to read from the stream
+            uint8_t*    m_Buffer;           // Compressed data not yet consumed by the decoder
+            uint32_t    m_BufferCapacity;
+            uint32_t    m_BufferStart;
+            uint32_t    m_BufferEnd;
+            float**     m_Output;           // Last decoded frame, owned by stb_vorbis
+            int         m_OutputSamples;
+            int         m_OutputCursor;
+        };
+
         struct DecodeStreamInfo {
             Info m_Info;
             stb_vorbis *m_StbVorbis;
+            StreamingState* m_Streaming;    // 0 if decoding from memory
         };
     }
 
+    // Reads more compressed data. Returns RESULT_WOULDBLOCK if no data is available yet,
+    // and RESULT_DECODE_ERROR at the end of the stream, or on error
+    static Result StbVorbisFillBuffer(StreamingState* st)
+    {
+        if (st->m_BufferStart > 0) {
+            memmove(st->m_Buffer, st->m_Buffer + st->m_BufferStart, st->m_BufferEnd - st->m_BufferStart);
+            st->m_BufferEnd -= st->m_BufferStart;
+            st->m_BufferStart = 0;
+        }
+
+        if (st->m_BufferEnd == st->m_BufferCapacity) {
+            if (st->m_BufferCapacity >= STREAMING_BUFFER_MAX_SIZE) {
+                return RESULT_DECODE_ERROR;
+            }
+            st->m_BufferCapacity *= 2;
+            st->m_Buffer = (uint8_t*) realloc(st->m_Buffer, st->m_BufferCapacity);
+        }
+
+        if (st->m_StreamOffset >= st->m_StreamSize) {
+            return RESULT_DECODE_ERROR;
+        }
+
+        uint32_t nread = 0;
+        uint32_t to_read = dmMath::Min(st->m_BufferCapacity - st->m_BufferEnd, st->m_StreamSize - st->m_StreamOffset);
+        Result r = st->m_Read(st->m_ReadContext, st->m_StreamOffset, st->m_Buffer + st->m_BufferEnd, to_read, &nread);
+        if (r == RESULT_WOULDBLOCK) {
+            return r;
+        }
+        if (r != RESULT_OK || nread == 0) {
+            return RESULT_DECODE_ERROR;
+        }
+
+        st->m_StreamOffset += nread;
+        st->m_BufferEnd += nread;
+        return RESULT_OK;
+    }
+
+    // Opens the pushdata decoder from the start of the stream
+    static stb_vorbis* StbVorbisOpenPushData(StreamingState* st, Result* result)
+    {
+        st->m_StreamOffset = 0;
+        st->m_BufferStart = 0;
+        st->m_BufferEnd = 0;
+        st->m_Output = 0;
+        st->m_OutputSamples = 0;
+        st->m_OutputCursor = 0;
+
+        while ((*result = StbVorbisFillBuffer(st)) == RESULT_OK) {
+            int used = 0;
+            int error = 0;
+            stb_vorbis* vorbis = stb_vorbis_open_pushdata(st->m_Buffer, st->m_BufferEnd, &used, &error, NULL);
+            if (vorbis) {
+                st->m_BufferStart = used;
+                return vorbis;
+            }
+            if (error != VORBIS_need_more_data) {
+                *result = RESULT_INVALID_FORMAT;
+                break;
+            }
+        }
+        return 0;
+    }
+
+    // Decodes the next frame into m_Output. Returns RESULT_DECODE_ERROR at the end of the stream
+    static Result StbVorbisDecodeFrame(stb_vorbis* vorbis, StreamingState* st)
+    {
+        while (true) {
+            int samples = 0;
+            int used = stb_vorbis_decode_frame_pushdata(vorbis, st->m_Buffer + st->m_BufferStart, st->m_BufferEnd - st->m_BufferStart,
+                                                        0, &st->m_Output, &samples);
+            st->m_BufferStart += used;
+            if (samples > 0) {
+                st->m_OutputSamples = samples;
+                st->m_OutputCursor = 0;
+                return RESULT_OK;
+            }
+            if (used == 0) {
+                Result r = StbVorbisFillBuffer(st);
+                if (r != RESULT_OK) {
+                    return r;
+                }
+            }
+        }
+    }
+
+    static Result StbVorbisOpenStreamingStream(FStreamRead read, void* read_context, uint32_t size, HDecodeStream* stream)
+    {
+        StreamingState* st = new StreamingState;
+        memset(st, 0, sizeof(*st));
+        st->m_Read = read;
+        st->m_ReadContext = read_context;
+        st->m_StreamSize = size;
+        st->m_BufferCapacity = STREAMING_BUFFER_SIZE;
+        st->m_Buffer = (uint8_t*) malloc(st->m_BufferCapacity);
+
+        Result r;
+        stb_vorbis* vorbis = StbVorbisOpenPushData(st, &r);
+        if (!vorbis) {
+            free(st->m_Buffer);
+            delete st;
+            return r == RESULT_WOULDBLOCK ? r : RESULT_INVALID_FORMAT;
+        }
+
+        stb_vorbis_info info = stb_vorbis_get_info(vorbis);
+
+        DecodeStreamInfo *streamInfo = new DecodeStreamInfo;
+        streamInfo->m_Info.m_Rate = info.sample_rate;
+        streamInfo->m_Info.m_Size = 0;
+        streamInfo->m_Info.m_Channels = info.channels;
+        streamInfo->m_Info.m_BitsPerSample = 16;
+        streamInfo->m_StbVorbis = vorbis;
+        streamInfo->m_Streaming = st;
+
+        *stream = streamInfo;
+        return RESULT_OK;
+    }
+
+    // Converts (or skips, if buffer is 0) decoded frames to interleaved 16 bit samples
+    static Result StbVorbisDecodeStreaming(DecodeStreamInfo* streamInfo, char* buffer, uint32_t buffer_size, uint32_t* decoded)
+    {
+        StreamingState* st = streamInfo->m_Streaming;
+        *decoded = 0;
+        if (!streamInfo->m_StbVorbis) {
+            // Reopen after a reset that ran out of data
+            Result r;
+            streamInfo->m_StbVorbis = StbVorbisOpenPushData(st, &r);
+            if (!streamInfo->m_StbVorbis) {
+                return r == RESULT_WOULDBLOCK ? r : RESULT_DECODE_ERROR;
+            }
+        }
+
+        const int channels = streamInfo->m_Info.m_Channels;
+        const uint32_t stride = channels * sizeof(int16_t);
+        const uint32_t total_frames = buffer_size / stride;
+        int16_t* out = (int16_t*) buffer;
+
+        Result result = RESULT_OK;
+        uint32_t frames = 0;
+        while (frames < total_frames) {
+            if (st->m_OutputCursor == st->m_OutputSamples) {
+                Result r = StbVorbisDecodeFrame(streamInfo->m_StbVorbis, st);
+                if (r != RESULT_OK) {
+                    // Either the end of the stream, or out of data for now
+                    if (r == RESULT_WOULDBLOCK) {
+                        result = r;
+                    }
+                    break;
+                }
+            }
+
+            uint32_t n = dmMath::Min(total_frames - frames, (uint32_t) (st->m_OutputSamples - st->m_OutputCursor));
+            if (out) {
+                for (uint32_t i = 0; i < n; ++i) {
+                    for (int c = 0; c < channels; ++c) {
+                        float v = st->m_Output[c][st->m_OutputCursor + i] * 32767.0f;
+                        *out++ = (int16_t) dmMath::Clamp(v, -32768.0f, 32767.0f);
+                    }
+                }
+            }
+            st->m_OutputCursor += n;
+            frames += n;
+        }
+
+        *decoded = frames * stride;
+        return result;
+    }
+
     static Result StbVorbisOpenStream(const void* buffer, uint32_t buffer_size, HDecodeStream* stream)
     {
         int error;
@@ -46,6 +235,7 @@ namespace dmSoundCodec
             streamInfo->m_Info.m_Channels = info.channels;
             streamInfo->m_Info.m_BitsPerSample = 16;
             streamInfo->m_StbVorbis = vorbis;
+            streamInfo->m_Streaming = 0;
 
             *stream = streamInfo;
             return RESULT_OK;
@@ -60,6 +250,10 @@ namespace dmSoundCodec
 
         DM_PROFILE(__FUNCTION__);
 
+        if (streamInfo->m_Streaming) {
+            return StbVorbisDecodeStreaming(streamInfo, buffer, buffer_size, decoded);
+        }
+
         int ret = 0;
         if (streamInfo->m_Info.m_Channels == 1) {
             ret = stb_vorbis_get_samples_short_interleaved(streamInfo->m_StbVorbis, 1, (short*) buffer, buffer_size / 2);
@@ -86,7 +280,21 @@ namespace dmSoundCodec
 
     Result StbVorbisResetStream(HDecodeStream stream)
     {
-        stb_vorbis_seek_start(((DecodeStreamInfo*)stream)->m_StbVorbis);
+        DecodeStreamInfo *streamInfo = (DecodeStreamInfo*) stream;
+        if (streamInfo->m_Streaming) {
+            // The pushdata api can't seek, so reopen the stream from the start
+            if (streamInfo->m_StbVorbis) {
+                stb_vorbis_close(streamInfo->m_StbVorbis);
+            }
+            Result r;
+            streamInfo->m_StbVorbis = StbVorbisOpenPushData(streamInfo->m_Streaming, &r);
+            if (!streamInfo->m_StbVorbis && r != RESULT_WOULDBLOCK) {
+                return RESULT_DECODE_ERROR;
+            }
+            return RESULT_OK;
+        }
+
+        stb_vorbis_seek_start(streamInfo->m_StbVorbis);
         return RESULT_OK;
     }
 
@@ -102,7 +310,13 @@ namespace dmSoundCodec
     void StbVorbisCloseStream(HDecodeStream stream)
     {
         DecodeStreamInfo *streamInfo = (DecodeStreamInfo*) stream;
-        stb_vorbis_close(streamInfo->m_StbVorbis);
+        if (streamInfo->m_StbVorbis) {
+            stb_vorbis_close(streamInfo->m_StbVorbis);
+        }
+        if (streamInfo->m_Streaming) {
+            free(streamInfo->m_Streaming->m_Buffer);
+            delete streamInfo->m_Streaming;
+        }
         delete streamInfo;
     }
 
@@ -113,5 +327,6 @@ namespace dmSoundCodec
 
     DM_DECLARE_SOUND_DECODER(AudioDecoderStbVorbis, "VorbisDecoderStb", FORMAT_VORBIS,
                              5, // baseline score (1-10)
-                             StbVorbisOpenStream, StbVorbisCloseStream, StbVorbisDecode, StbVorbisResetStream, StbVorbisSkipInStream, StbVorbisGetInfo);
+                             StbVorbisOpenStream, StbVorbisCloseStream, StbVorbisDecode, StbVorbisResetStream, StbVorbisSkipInStream, StbVorbisGetInfo,
+                             StbVorbisOpenStreamingStream);
 }
@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <dlib/array.h>
+#include <dlib/condition_variable.h>
 #include <dlib/hashtable.h>
 #include <dlib/index_pool.h>
 #include <dlib/log.h>
@@ -31,6 +32,11 @@
 
 #include <math.h>
 #include <cfloat>
+#include <algorithm>
+
+DM_PROPERTY_GROUP(rmtp_Sound, "Sound");
+DM_PROPERTY_U32(rmtp_SoundVoices, 0, NoFlags, "# real voices", &rmtp_Sound);
+DM_PROPERTY_U32(rmtp_SoundVirtualVoices, 0, NoFlags, "# virtual voices", &rmtp_Sound);
 
 /**
  * Defold simple sound system
@@ -51,7 +57,18 @@ namespace dmSound
     const dmhash_t MASTER_GROUP_HASH = dmHashString64("master");
     const uint32_t GROUP_MEMORY_BUFFER_COUNT = 64;
 
+    // Size of the RIFF/WAVE header in front of decoded (cached) sound data
+    const uint32_t DECODED_WAV_HEADER_SIZE = 44;
+
+    // Streamed sounds: the size of the start of the sound kept in memory (see SoundData::m_StreamHead),
+    // the size of the read ahead buffer per instance and the max size of a single read
+    const uint32_t STREAM_HEAD_SIZE = 32 * 1024;
+    const uint32_t STREAM_BUFFER_SIZE = 64 * 1024;
+    const uint32_t STREAM_READ_SIZE = 16 * 1024;
+
     static void SoundThread(void* ctx);
+    static void DecodeThread(void* ctx);
+    static void StreamThread(void* ctx);
 
     /**
      * Value with memory for "ramping" of values. See also struct Ramp below.
@@ -153,15 +170,51 @@ namespace dmSound
         dmhash_t      m_NameHash;
         void*         m_Data;
         int           m_Size;
+        // Set for sounds that are read on demand. See NewSoundDataStreaming
+        FSoundDataRead  m_StreamRead;
+        FSoundDataClose m_StreamClose;
+        void*           m_StreamContext;
+        // The start of a streamed sound, with the headers needed to open a decoder without waiting for I/O
+        void*           m_StreamHead;
+        uint32_t        m_StreamHeadSize;
+        // Decoded data shared by all instances, stored as an in-memory wav. See DecodeSoundData
+        void*         m_DecodedData;
+        uint32_t      m_DecodedSize;
+        // Used for LRU eviction of the decoded data
+        uint32_t      m_DecodedLastUsed;
+        // Number of instances currently reading from m_DecodedData
+        uint16_t      m_DecodedInstanceCount;
         // Index in m_SoundData
         uint16_t      m_Index;
         SoundDataType m_Type;
     };
 
+    /*
+     * Compressed data of a streamed sound, read ahead for one instance by UpdateStreams so that decoding never
+     * waits for I/O. The buffer continues where SoundData::m_StreamHead ends, and wraps around to there again
+     * after the end of the sound, so that looping sounds don't run dry.
+     * Guarded by m_Mutex, except for the unfilled part of m_Data which is written by UpdateStreams without it.
+     */
+    struct StreamBuffer
+    {
+        SoundData*  m_SoundData;
+        uint8_t*    m_Data;     // Ring buffer of STREAM_BUFFER_SIZE bytes. 0 if the whole sound fits in the head
+        uint32_t    m_Offset;   // Stream offset of the first buffered byte
+        uint32_t    m_Start;    // Index in m_Data of the first buffered byte
+        uint32_t    m_Count;    // Number of buffered bytes
+        uint16_t    m_Version;  // Changed when the buffer is flushed, to discard reads in progress
+        uint16_t    m_Error : 1;
+        uint16_t    : 15;
+    };
+
     struct SoundInstance
     {
         dmSoundCodec::HDecoder m_Decoder;
         void*       m_Frames;
+        // The shared decoded data read by the decoder, if any. See SoundData::m_DecodedData
+        void*       m_DecodedData;
+        // Set for streamed sounds. Only changed with m_StreamMutex held
+        StreamBuffer* m_StreamBuffer;
         dmhash_t    m_Group;
 
         Value       m_Gain;     // default: 1.0f
@@ -175,10 +228,29 @@ namespace dmSound
         uint8_t     m_Looping : 1;
         uint8_t     m_EndOfStream : 1;
         uint8_t     m_Playing : 1;
-        uint8_t     : 5;
+        uint8_t     m_Virtual : 1; // Not decoded nor mixed, but time still advances. See UpdateVoices
+        uint8_t     : 4;
+        uint8_t     m_Priority; // Higher value is more important when choosing which voices to keep real
         int8_t      m_Loopcounter; // if set to 3, there will be 3 loops effectively playing the sound 4 times.
     };
 
+    // An instance to decode on the decode threads, before mixing. See StartDecodeJobs
+    struct DecodeJob
+    {
+        SoundInstance*      m_Instance;
+        dmSoundCodec::Info  m_Info;
+        bool                m_Mix;
+        bool                m_Done; // Guarded by m_DecodeMutex
+    };
+
+    // Decoded data that was replaced or deleted while instances still read from it. See FreeDecodedDataNoLock
+    struct RetiredDecodedData
+    {
+        void*       m_Data;
+        uint32_t    m_Size;
+        uint32_t    m_InstanceCount;
+    };
+
     struct SoundGroup
     {
         dmhash_t m_NameHash;
@@ -197,6 +269,22 @@ namespace dmSound
         dmThread::Thread              m_Thread;
         dmMutex::HMutex               m_Mutex;
 
+        // Reads ahead the data of streamed sounds. Started with the first streamed sound data, if m_Thread is used
+        dmThread::Thread              m_StreamThread;
+        // Held while reading streamed data, and when creating or deleting what is read. Taken before m_Mutex,
+        // and never by the sound thread
+        dmMutex::HMutex               m_StreamMutex;
+
+        // Worker threads decoding instances in parallel with the sound thread. Empty if decoding is done serially
+        dmArray<dmThread::Thread>     m_DecodeThreads;
+        dmMutex::HMutex               m_DecodeMutex;
+        dmConditionVariable::HConditionVariable m_DecodeStart;
+        dmConditionVariable::HConditionVariable m_DecodeDone;
+        // Guarded by m_DecodeMutex
+        dmArray<DecodeJob>            m_DecodeJobs;
+        uint32_t                      m_NextDecodeJob;
+        bool                          m_DecodeThreadsRunning;
+
         dmArray<SoundInstance>  m_Instances;
         dmIndexPool16           m_InstancesPool;
 
@@ -206,11 +294,23 @@ namespace dmSound
         dmHashTable<dmhash_t, int> m_GroupMap;
         SoundGroup              m_Groups[MAX_GROUPS];
 
+        // Scratch buffer for the currently active instances. See UpdateVoices
+        dmArray<SoundInstance*> m_Voices;
+        // Max number of decoded and mixed instances. 0 means no limit
+        uint32_t                m_MaxVoices;
+        uint32_t                m_StreamingThreshold;
+
         Result                  m_Status;
         uint32_t                m_MixRate;
         uint32_t                m_FrameCount;
         uint32_t                m_PlayCounter;
 
+        uint32_t                m_DecodedCacheSize;
+        uint32_t                m_DecodedCacheThreshold;
+        uint32_t                m_DecodedCacheUsed;
+        uint32_t                m_DecodedCacheTick;
+        dmArray<RetiredDecodedData> m_RetiredDecodedData;
+
         int16_t*                m_OutBuffers[SOUND_OUTBUFFER_COUNT];
         uint16_t                m_NextOutBuffer;
 
@@ -251,6 +351,11 @@ namespace dmSound
         params->m_BufferSize = 12 * 4096;
         params->m_FrameCount = 768;
         params->m_MaxInstances = 256;
+        params->m_DecodedCacheSize = 0;
+        params->m_DecodedCacheThreshold = 512 * 1024;
+        params->m_MaxVoices = 0;
+        params->m_StreamingThreshold = 0;
+        params->m_DecodeThreads = 0;
         params->m_UseThread = true;
     }
 
@@ -341,6 +446,11 @@ namespace dmSound
         uint32_t max_buffers = params->m_MaxBuffers;
         uint32_t max_sources = params->m_MaxSources;
         uint32_t max_instances = params->m_MaxInstances;
+        uint32_t decoded_cache_size = params->m_DecodedCacheSize;
+        uint32_t decoded_cache_threshold = params->m_DecodedCacheThreshold;
+        uint32_t max_voices = params->m_MaxVoices;
+        uint32_t streaming_threshold = params->m_StreamingThreshold;
+        uint32_t decode_threads = params->m_DecodeThreads;
 
         if (config)
         {
@@ -349,8 +459,22 @@ namespace dmSound
             max_buffers = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_buffers", (int32_t) max_buffers);
             max_sources = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_sources", (int32_t) max_sources);
             max_instances = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_instances", (int32_t) max_instances);
+            decoded_cache_size = (uint32_t) dmConfigFile::GetInt(config, "sound.decoded_cache_size", (int32_t) decoded_cache_size);
+            decoded_cache_threshold = (uint32_t) dmConfigFile::GetInt(config, "sound.decoded_cache_threshold", (int32_t) decoded_cache_threshold);
+            max_voices = (uint32_t) dmConfigFile::GetInt(config, "sound.max_voices", (int32_t) max_voices);
+            streaming_threshold = (uint32_t) dmConfigFile::GetInt(config, "sound.stream_threshold", (int32_t) streaming_threshold);
+            decode_threads = (uint32_t) dmConfigFile::GetInt(config, "sound.decode_threads", (int32_t) decode_threads);
         }
 
+        sound->m_DecodedCacheSize = decoded_cache_size;
+        sound->m_DecodedCacheThreshold = decoded_cache_threshold;
+        sound->m_DecodedCacheUsed = 0;
+        sound->m_DecodedCacheTick = 0;
+
+        sound->m_MaxVoices = max_voices;
+        sound->m_StreamingThreshold = streaming_threshold;
+        sound->m_Voices.SetCapacity(max_instances);
+
         sound->m_Instances.SetCapacity(max_instances);
         sound->m_Instances.SetSize(max_instances);
         sound->m_InstancesPool.SetCapacity(max_instances);
@@ -372,6 +496,7 @@ namespace dmSound
         sound->m_SoundDataPool.SetCapacity(max_sound_data);
         for (uint32_t i = 0; i < max_sound_data; ++i)
         {
+            memset(&sound->m_SoundData[i], 0, sizeof(SoundData));
             sound->m_SoundData[i].m_Index = 0xffff;
         }
 
@@ -395,11 +520,31 @@ namespace dmSound
         sound->m_IsPaused = false;
         sound->m_Status = RESULT_NOTHING_TO_PLAY;
 
+        sound->m_DecodeMutex = 0;
+        sound->m_DecodeThreadsRunning = true;
+        sound->m_NextDecodeJob = 0;
+        if (decode_threads > 0)
+        {
+            sound->m_DecodeMutex = dmMutex::New();
+            sound->m_DecodeStart = dmConditionVariable::New();
+            sound->m_DecodeDone = dmConditionVariable::New();
+            sound->m_DecodeJobs.SetCapacity(max_instances);
+            sound->m_DecodeThreads.SetCapacity(decode_threads);
+            for (uint32_t i = 0; i < decode_threads; ++i)
+            {
+                sound->m_DecodeThreads.Push(dmThread::New((dmThread::ThreadStart)DecodeThread, 0x80000, sound, "sound_decode"));
+            }
+        }
+
         sound->m_Thread = 0;
         sound->m_Mutex = 0;
+        sound->m_StreamThread = 0;
+        sound->m_StreamMutex = 0;
+        // Started last, since the sound thread uses everything above
         if (params->m_UseThread)
         {
             sound->m_Mutex = dmMutex::New();
+            sound->m_StreamMutex = dmMutex::New();
             sound->m_Thread = dmThread::New((dmThread::ThreadStart)SoundThread, 0x80000, sound, "sound");
         }
 
@@ -413,10 +558,31 @@ namespace dmSound
             return RESULT_OK;
 
         sound->m_IsRunning = false;
+        if (sound->m_StreamThread)
+        {
+            dmThread::Join(sound->m_StreamThread);
+        }
         if (sound->m_Thread)
         {
             dmThread::Join(sound->m_Thread);
             dmMutex::Delete(sound->m_Mutex);
+            dmMutex::Delete(sound->m_StreamMutex);
+        }
+
+        if (sound->m_DecodeMutex)
+        {
+            {
+                DM_MUTEX_SCOPED_LOCK(sound->m_DecodeMutex);
+                sound->m_DecodeThreadsRunning = false;
+                dmConditionVariable::Broadcast(sound->m_DecodeStart);
+            }
+            for (uint32_t i = 0; i < sound->m_DecodeThreads.Size(); ++i)
+            {
+                dmThread::Join(sound->m_DecodeThreads[i]);
+            }
+            dmConditionVariable::Delete(sound->m_DecodeStart);
+            dmConditionVariable::Delete(sound->m_DecodeDone);
+            dmMutex::Delete(sound->m_DecodeMutex);
         }
 
         PlatformFinalize();
@@ -440,6 +606,10 @@ namespace dmSound
                 free((void*) sound->m_OutBuffers[i]);
             }
 
+            for (uint32_t i = 0; i < sound->m_RetiredDecodedData.Size(); ++i) {
+                free(sound->m_RetiredDecodedData[i].m_Data);
+            }
+
             for (uint32_t i = 0; i < MAX_GROUPS; i++) {
                 SoundGroup* g = &sound->m_Groups[i];
                 if (g->m_MixBuffer) {
@@ -466,8 +636,185 @@ namespace dmSound
     }
 
 
+    static inline void WriteLE16(char* out, uint16_t value)
+    {
+        out[0] = (char) (value & 0xff);
+        out[1] = (char) ((value >> 8) & 0xff);
+    }
+
+    static inline void WriteLE32(char* out, uint32_t value)
+    {
+        WriteLE16(out, (uint16_t) (value & 0xffff));
+        WriteLE16(out + 2, (uint16_t) (value >> 16));
+    }
+
+    static void WriteWavHeader(char* out, const dmSoundCodec::Info* info)
+    {
+        uint32_t block_align = info->m_Channels * (info->m_BitsPerSample / 8);
+        memcpy(out + 0, "RIFF", 4);
+        WriteLE32(out + 4, DECODED_WAV_HEADER_SIZE - 8 + info->m_Size);
+        memcpy(out + 8, "WAVE", 4);
+        memcpy(out + 12, "fmt ", 4);
+        WriteLE32(out + 16, 16);
+        WriteLE16(out + 20, 1); // PCM
+        WriteLE16(out + 22, info->m_Channels);
+        WriteLE32(out + 24, info->m_Rate);
+        WriteLE32(out + 28, info->m_Rate * block_align);
+        WriteLE16(out + 32, (uint16_t) block_align);
+        WriteLE16(out + 34, info->m_BitsPerSample);
+        memcpy(out + 36, "data", 4);
+        WriteLE32(out + 40, info->m_Size);
+    }
+
+    /*
+     * Decodes a short compressed sound completely into memory, so that all instances can share the decoded
+     * frames instead of running the (vorbis) decoder per instance and mix cycle. The result is stored as an
+     * in-memory wav file and is read by the (memcpy) wav decoder.
+     * Called without the sound lock held.
+     */
+    static bool DecodeSoundData(SoundSystem* sound, SoundDataType type, const void* sound_buffer, uint32_t sound_buffer_size, void** decoded, uint32_t* decoded_size)
+    {
+        if (sound->m_DecodedCacheSize == 0 || type != SOUND_DATA_TYPE_OGG_VORBIS)
+            return false;
+
+        uint32_t max_size = dmMath::Min(sound->m_DecodedCacheThreshold, sound->m_DecodedCacheSize);
+        // The decoded data is always larger than the compressed data
+        if (sound_buffer_size > max_size)
+            return false;
+
+        dmSoundCodec::Info info;
+        dmSoundCodec::Result r = dmSoundCodec::DecodeToBuffer(dmSoundCodec::FORMAT_VORBIS, sound_buffer, sound_buffer_size,
+                                                              DECODED_WAV_HEADER_SIZE, max_size, &info, decoded, decoded_size);
+        if (r != dmSoundCodec::RESULT_OK)
+            return false;
+
+        WriteWavHeader((char*) *decoded, &info);
+        return true;
+    }
+
+    // Detaches the decoded data from the sound data. If instances still read from it, the data is
+    // kept until the last of them is deleted. See ReleaseDecodedDataNoLock
+    static void FreeDecodedDataNoLock(SoundSystem* sound, SoundData* sound_data)
+    {
+        if (sound_data->m_DecodedData == 0x0)
+            return;
+
+        if (sound_data->m_DecodedInstanceCount > 0)
+        {
+            if (sound->m_RetiredDecodedData.Full())
+                sound->m_RetiredDecodedData.OffsetCapacity(4);
+            RetiredDecodedData retired;
+            retired.m_Data = sound_data->m_DecodedData;
+            retired.m_Size = sound_data->m_DecodedSize;
+            retired.m_InstanceCount = sound_data->m_DecodedInstanceCount;
+            sound->m_RetiredDecodedData.Push(retired);
+        }
+        else
+        {
+            free(sound_data->m_DecodedData);
+            sound->m_DecodedCacheUsed -= sound_data->m_DecodedSize;
+        }
+
+        sound_data->m_DecodedData = 0;
+        sound_data->m_DecodedSize = 0;
+        sound_data->m_DecodedInstanceCount = 0;
+    }
+
+    // Called when an instance reading from "decoded_data" is deleted
+    static void ReleaseDecodedDataNoLock(SoundSystem* sound, SoundData* sound_data, void* decoded_data)
+    {
+        if (sound_data->m_Index != 0xffff && sound_data->m_DecodedData == decoded_data)
+        {
+            assert(sound_data->m_DecodedInstanceCount > 0);
+            sound_data->m_DecodedInstanceCount--;
+            return;
+        }
+
+        dmArray<RetiredDecodedData>& retired = sound->m_RetiredDecodedData;
+        for (uint32_t i = 0; i < retired.Size(); ++i)
+        {
+            if (retired[i].m_Data != decoded_data)
+                continue;
+
+            if (--retired[i].m_InstanceCount == 0)
+            {
+                free(retired[i].m_Data);
+                sound->m_DecodedCacheUsed -= retired[i].m_Size;
+                retired.EraseSwap(i);
+            }
+            return;
+        }
+        assert(false && "Decoded data not found");
+    }
+
+    // Evicts least recently used decoded data, which isn't used by any instance, until "size" bytes fits in the cache
+    static bool MakeRoomInDecodedCacheNoLock(SoundSystem* sound, uint32_t size)
+    {
+        if (size > sound->m_DecodedCacheSize)
+            return false;
+
+        while (sound->m_DecodedCacheSize - sound->m_DecodedCacheUsed < size)
+        {
+            SoundData* lru = 0;
+            uint32_t n = sound->m_SoundData.Size();
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                SoundData* sd = &sound->m_SoundData[i];
+                if (sd->m_Index == 0xffff || sd->m_DecodedData == 0x0 || sd->m_DecodedInstanceCount > 0)
+                    continue;
+                if (lru == 0 || (sound->m_DecodedCacheTick - sd->m_DecodedLastUsed) > (sound->m_DecodedCacheTick - lru->m_DecodedLastUsed))
+                    lru = sd;
+            }
+
+            if (lru == 0)
+                return false;
+
+            FreeDecodedDataNoLock(sound, lru);
+        }
+        return true;
+    }
+
+    // Takes ownership of the decoded buffer
+    static void AddDecodedDataNoLock(SoundSystem* sound, SoundData* sound_data, void* decoded, uint32_t decoded_size)
+    {
+        if (!MakeRoomInDecodedCacheNoLock(sound, decoded_size))
+        {
+            free(decoded);
+            return;
+        }
+
+        sound_data->m_DecodedData = decoded;
+        sound_data->m_DecodedSize = decoded_size;
+        sound_data->m_DecodedLastUsed = sound->m_DecodedCacheTick++;
+        sound->m_DecodedCacheUsed += decoded_size;
+    }
+
+    // Called with m_StreamMutex held, if the sound data is streamed
+    static void FreeStreamContextNoLock(SoundSystem* sound, SoundData* sound_data)
+    {
+        if (!sound_data->m_StreamRead)
+            return;
+
+        // Instances still playing the sound stop at the next decode
+        for (uint32_t i = 0; i < sound->m_Instances.Size(); ++i)
+        {
+            StreamBuffer* sb = sound->m_Instances[i].m_StreamBuffer;
+            if (sb && sb->m_SoundData == sound_data)
+                sb->m_Error = 1;
+        }
+
+        sound_data->m_StreamClose(sound_data->m_StreamContext);
+        free(sound_data->m_StreamHead);
+        sound_data->m_StreamContext = 0;
+        sound_data->m_StreamRead = 0;
+        sound_data->m_StreamClose = 0;
+        sound_data->m_StreamHead = 0;
+        sound_data->m_StreamHeadSize = 0;
+    }
+
     static Result SetSoundDataNoLock(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
+        FreeStreamContextNoLock(g_SoundSystem, sound_data);
         free(sound_data->m_Data);
         sound_data->m_Data = malloc(sound_buffer_size);
         sound_data->m_Size = sound_buffer_size;
@@ -485,6 +832,11 @@ namespace dmSound
             dmLogError("Out of sound data slots (%u). Increase the project setting 'sound.max_sound_data'", sound->m_SoundDataPool.Capacity());
             return RESULT_OUT_OF_INSTANCES;
         }
+
+        void* decoded = 0;
+        uint32_t decoded_size = 0;
+        bool is_decoded = DecodeSoundData(sound, type, sound_buffer, sound_buffer_size, &decoded, &decoded_size);
+
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
 
         uint16_t index = sound->m_SoundDataPool.Pop();
@@ -495,33 +847,307 @@ namespace dmSound
         sd->m_Index = index;
         sd->m_Data = 0;
         sd->m_Size = 0;
+        sd->m_StreamRead = 0;
+        sd->m_StreamClose = 0;
+        sd->m_StreamContext = 0;
+        sd->m_StreamHead = 0;
+        sd->m_StreamHeadSize = 0;
+        sd->m_DecodedData = 0;
+        sd->m_DecodedSize = 0;
+        sd->m_DecodedInstanceCount = 0;
 
         Result result = SetSoundDataNoLock(sd, sound_buffer, sound_buffer_size);
         if (result == RESULT_OK)
+        {
+            if (is_decoded)
+                AddDecodedDataNoLock(sound, sd, decoded, decoded_size);
             *sound_data = sd;
+        }
         else
+        {
+            if (is_decoded)
+                free(decoded);
             DeleteSoundData(sd);
+        }
 
         return result;
     }
 
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size)
     {
+        SoundSystem* sound = g_SoundSystem;
+
+        void* decoded = 0;
+        uint32_t decoded_size = 0;
+        bool is_decoded = DecodeSoundData(sound, sound_data->m_Type, sound_buffer, sound_buffer_size, &decoded, &decoded_size);
+
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound_data->m_StreamRead ? sound->m_StreamMutex : 0);
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
-        return SetSoundDataNoLock(sound_data, sound_buffer, sound_buffer_size);
+        FreeDecodedDataNoLock(sound, sound_data);
+
+        Result result = SetSoundDataNoLock(sound_data, sound_buffer, sound_buffer_size);
+        if (is_decoded)
+        {
+            if (result == RESULT_OK)
+                AddDecodedDataNoLock(sound, sound_data, decoded, decoded_size);
+            else
+                free(decoded);
+        }
+        return result;
+    }
+
+    Result NewSoundDataStreaming(FSoundDataRead read, FSoundDataClose close, void* context, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        *sound_data = 0;
+
+        if (type != SOUND_DATA_TYPE_OGG_VORBIS)
+        {
+            return RESULT_UNSUPPORTED;
+        }
+
+        // Read the start of the sound up front, so that instances can be created without waiting for the stream
+        uint32_t head_size = dmMath::Min(size, STREAM_HEAD_SIZE);
+        uint8_t* head = (uint8_t*) malloc(head_size);
+        uint32_t head_read = 0;
+        while (head_read < head_size)
+        {
+            uint32_t nread = 0;
+            Result r = read(context, head_read, head_size - head_read, head + head_read, &nread);
+            if (r != RESULT_OK || nread == 0)
+            {
+                free(head);
+                return RESULT_INVALID_STREAM_DATA;
+            }
+            head_read += nread;
+        }
+
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_StreamMutex);
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+
+        if (sound->m_SoundDataPool.Remaining() == 0)
+        {
+            free(head);
+            dmLogError("Out of sound data slots (%u). Increase the project setting 'sound.max_sound_data'", sound->m_SoundDataPool.Capacity());
+            return RESULT_OUT_OF_INSTANCES;
+        }
+
+        if (sound->m_Thread && !sound->m_StreamThread)
+        {
+            sound->m_StreamThread = dmThread::New((dmThread::ThreadStart)StreamThread, 0x80000, sound, "sound_stream");
+        }
+
+        uint16_t index = sound->m_SoundDataPool.Pop();
+
+        SoundData* sd = &sound->m_SoundData[index];
+        sd->m_NameHash = name;
+        sd->m_Type = type;
+        sd->m_Index = index;
+        sd->m_Data = 0;
+        sd->m_Size = size;
+        sd->m_StreamRead = read;
+        sd->m_StreamClose = close;
+        sd->m_StreamContext = context;
+        sd->m_StreamHead = head;
+        sd->m_StreamHeadSize = head_size;
+        sd->m_DecodedData = 0;
+        sd->m_DecodedSize = 0;
+        sd->m_DecodedInstanceCount = 0;
+
+        *sound_data = sd;
+        return RESULT_OK;
+    }
+
+    uint32_t GetStreamingThreshold()
+    {
+        return g_SoundSystem ? g_SoundSystem->m_StreamingThreshold : 0;
+    }
+
+    static StreamBuffer* NewStreamBuffer(SoundData* sound_data)
+    {
+        StreamBuffer* sb = new StreamBuffer;
+        memset(sb, 0, sizeof(*sb));
+        sb->m_SoundData = sound_data;
+        sb->m_Offset = sound_data->m_StreamHeadSize;
+        if (sound_data->m_StreamHeadSize < (uint32_t) sound_data->m_Size)
+        {
+            sb->m_Data = (uint8_t*) malloc(STREAM_BUFFER_SIZE);
+        }
+        return sb;
+    }
+
+    static void DeleteStreamBuffer(StreamBuffer* sb)
+    {
+        free(sb->m_Data);
+        delete sb;
+    }
+
+    static void FlushStreamBuffer(StreamBuffer* sb, uint32_t offset)
+    {
+        sb->m_Offset = offset;
+        sb->m_Start = 0;
+        sb->m_Count = 0;
+        sb->m_Version++;
+    }
+
+    static void ConsumeStreamBuffer(StreamBuffer* sb, uint32_t size)
+    {
+        const SoundData* sound_data = sb->m_SoundData;
+        sb->m_Start = (sb->m_Start + size) % STREAM_BUFFER_SIZE;
+        sb->m_Count -= size;
+        sb->m_Offset += size;
+        if (sb->m_Offset == (uint32_t) sound_data->m_Size)
+        {
+            // The buffered data after the end continues from the end of the head
+            sb->m_Offset = sound_data->m_StreamHeadSize;
+        }
+    }
+
+    /*
+     * Gets the next range to read ahead into a stream buffer, and where in the buffer to store it.
+     * Returns false if the buffer is full.
+     */
+    static bool GetStreamBufferFill(const StreamBuffer* sb, uint32_t* offset, uint32_t* size, uint32_t* index)
+    {
+        const SoundData* sound_data = sb->m_SoundData;
+        uint32_t head_size = sound_data->m_StreamHeadSize;
+        uint32_t loop_size = sound_data->m_Size - head_size;
+        uint32_t max_count = dmMath::Min(STREAM_BUFFER_SIZE, loop_size);
+        if (sb->m_Error || sb->m_Count >= max_count)
+            return false;
+
+        *offset = head_size + (sb->m_Offset - head_size + sb->m_Count) % loop_size;
+        *index = (sb->m_Start + sb->m_Count) % STREAM_BUFFER_SIZE;
+        *size = dmMath::Min(dmMath::Min(max_count - sb->m_Count, STREAM_BUFFER_SIZE - *index),
+                            dmMath::Min(STREAM_READ_SIZE, sound_data->m_Size - *offset));
+        return true;
+    }
+
+    /*
+     * Read callback of streaming decoders. Copies from the head of the sound or from the data read ahead by
+     * UpdateStreams, and returns RESULT_WOULDBLOCK instead of waiting if the data isn't there yet.
+     * Called with m_Mutex held.
+     */
+    static dmSoundCodec::Result ReadStream(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread)
+    {
+        StreamBuffer* sb = (StreamBuffer*) context;
+        const SoundData* sound_data = sb->m_SoundData;
+        *nread = 0;
+        if (sb->m_Error)
+            return dmSoundCodec::RESULT_DECODE_ERROR;
+        if (offset >= (uint32_t) sound_data->m_Size)
+            return dmSoundCodec::RESULT_OK;
+
+        uint32_t head_size = sound_data->m_StreamHeadSize;
+        if (offset < head_size)
+        {
+            if (offset == 0 && sb->m_Offset != head_size)
+            {
+                // Restarted from the beginning, so read ahead from the end of the head again
+                FlushStreamBuffer(sb, head_size);
+            }
+            *nread = dmMath::Min(buffer_size, head_size - offset);
+            memcpy(buffer, (const uint8_t*) sound_data->m_StreamHead + offset, *nread);
+            return dmSoundCodec::RESULT_OK;
+        }
+
+        if (offset != sb->m_Offset)
+        {
+            uint32_t contiguous = dmMath::Min(sb->m_Count, sound_data->m_Size - sb->m_Offset);
+            if (offset > sb->m_Offset && offset - sb->m_Offset <= contiguous)
+                ConsumeStreamBuffer(sb, offset - sb->m_Offset);
+            else
+                FlushStreamBuffer(sb, offset);
+        }
+
+        uint32_t n = dmMath::Min(dmMath::Min(buffer_size, sb->m_Count), sound_data->m_Size - offset);
+        if (n == 0)
+            return dmSoundCodec::RESULT_WOULDBLOCK;
+
+        uint32_t first = dmMath::Min(n, STREAM_BUFFER_SIZE - sb->m_Start);
+        memcpy(buffer, sb->m_Data + sb->m_Start, first);
+        memcpy((uint8_t*) buffer + first, sb->m_Data, n - first);
+        ConsumeStreamBuffer(sb, n);
+        *nread = n;
+        return dmSoundCodec::RESULT_OK;
+    }
+
+    /*
+     * Reads ahead the compressed data of all streamed instances. Called on the stream thread, or from Update
+     * when the sound thread isn't used. Only the reads are done without m_Mutex, so the sound thread never waits for I/O.
+     */
+    static void UpdateStreams(SoundSystem* sound)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_StreamMutex);
+
+        uint32_t instance_count = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            SoundInstance* instance = &sound->m_Instances[i];
+            StreamBuffer* sb = instance->m_StreamBuffer;
+            if (!sb)
+                continue;
+
+            while (true)
+            {
+                uint32_t offset, size, index;
+                uint16_t version;
+                {
+                    DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+                    if (!GetStreamBufferFill(sb, &offset, &size, &index))
+                        break;
+                    version = sb->m_Version;
+                }
+
+                // The decoder only reads the filled part of the buffer
+                const SoundData* sound_data = sb->m_SoundData;
+                uint32_t nread = 0;
+                Result r = sound_data->m_StreamRead(sound_data->m_StreamContext, offset, size, sb->m_Data + index, &nread);
+
+                DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
+                if (sb->m_Version != version)
+                    continue; // Flushed while reading
+                if (r != RESULT_OK || nread == 0)
+                {
+                    dmLogError("Failed to read streamed sound '%s' (%d)", GetSoundName(sound, instance), r);
+                    sb->m_Error = 1;
+                    break;
+                }
+                sb->m_Count += nread;
+            }
+        }
+    }
+
+    static void StreamThread(void* ctx)
+    {
+        SoundSystem* sound = (SoundSystem*)ctx;
+        while (sound->m_IsRunning)
+        {
+            UpdateStreams(sound);
+            dmTime::Sleep(8000);
+        }
     }
 
     uint32_t GetSoundResourceSize(HSoundData sound_data)
     {
-        return sound_data->m_Size + sizeof(SoundData);
+        // Streamed sounds only keep the head in memory. The read ahead and decoder buffers are per instance
+        if (sound_data->m_StreamRead)
+            return sound_data->m_StreamHeadSize + sizeof(SoundData);
+        return sound_data->m_Size + sound_data->m_DecodedSize + sizeof(SoundData);
     }
 
     Result DeleteSoundData(HSoundData sound_data)
     {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound_data->m_StreamRead ? g_SoundSystem->m_StreamMutex : 0);
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
 
         if (sound_data->m_Data != 0x0)
             free((void*) sound_data->m_Data);
+        sound_data->m_Data = 0;
+        FreeStreamContextNoLock(g_SoundSystem, sound_data);
+
+        FreeDecodedDataNoLock(g_SoundSystem, sound_data);
 
         SoundSystem* sound = g_SoundSystem;
         sound->m_SoundDataPool.Push(sound_data->m_Index);
@@ -553,16 +1179,38 @@ namespace dmSound
         }
 
         uint16_t index;
+        void* decoded_data;
+        StreamBuffer* stream_buffer = 0;
         {
+            DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound_data->m_StreamRead ? ss->m_StreamMutex : 0);
             DM_MUTEX_OPTIONAL_SCOPED_LOCK(ss->m_Mutex);
 
-            dmSoundCodec::Result r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
+            // NOTE: Sounds evicted from the decoded cache falls back to decoding per instance
+            dmSoundCodec::Result r;
+            decoded_data = sound_data->m_DecodedData;
+            if (decoded_data) {
+                r = dmSoundCodec::NewDecoder(ss->m_CodecContext, dmSoundCodec::FORMAT_WAV, decoded_data, sound_data->m_DecodedSize, &decoder);
+            } else if (sound_data->m_StreamRead) {
+                stream_buffer = NewStreamBuffer(sound_data);
+                r = dmSoundCodec::NewStreamingDecoder(ss->m_CodecContext, codec_format, ReadStream, stream_buffer, sound_data->m_Size, &decoder);
+                if (r != dmSoundCodec::RESULT_OK) {
+                    DeleteStreamBuffer(stream_buffer);
+                }
+            } else {
+                r = dmSoundCodec::NewDecoder(ss->m_CodecContext, codec_format, sound_data->m_Data, sound_data->m_Size, &decoder);
+            }
             if (r != dmSoundCodec::RESULT_OK) {
                 dmLogError("Failed to decode sound (%d)", r);
                 return RESULT_INVALID_STREAM_DATA;
             }
 
+            if (decoded_data) {
+                sound_data->m_DecodedInstanceCount++;
+                sound_data->m_DecodedLastUsed = ss->m_DecodedCacheTick++;
+            }
+
             index = ss->m_InstancesPool.Pop();
+            ss->m_Instances[index].m_StreamBuffer = stream_buffer;
         }
 
         SoundInstance* si = &ss->m_Instances[index];
@@ -575,6 +1223,9 @@ namespace dmSound
         si->m_Looping = 0;
         si->m_EndOfStream = 0;
         si->m_Playing = 0;
+        si->m_DecodedData = decoded_data;
+        si->m_Virtual = 0;
+        si->m_Priority = 0;
         si->m_Decoder = decoder;
         si->m_Group = MASTER_GROUP_HASH;
 
@@ -588,6 +1239,7 @@ namespace dmSound
     Result DeleteSoundInstance(HSoundInstance sound_instance)
     {
         SoundSystem* sound = g_SoundSystem;
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound_instance->m_StreamBuffer ? sound->m_StreamMutex : 0);
         DM_MUTEX_OPTIONAL_SCOPED_LOCK(sound->m_Mutex);
 
         if (IsPlaying(sound_instance))
@@ -596,12 +1248,24 @@ namespace dmSound
             StopNoLock(sound, sound_instance);
         }
 
+        if (sound_instance->m_DecodedData)
+        {
+            SoundData* sound_data = &sound->m_SoundData[sound_instance->m_SoundDataIndex];
+            ReleaseDecodedDataNoLock(sound, sound_data, sound_instance->m_DecodedData);
+            sound_instance->m_DecodedData = 0;
+        }
+
         uint16_t index = sound_instance->m_Index;
         sound->m_InstancesPool.Push(index);
         sound_instance->m_Index = 0xffff;
         sound_instance->m_SoundDataIndex = 0xffff;
         dmSoundCodec::DeleteDecoder(sound->m_CodecContext, sound_instance->m_Decoder);
         sound_instance->m_Decoder = 0;
+        if (sound_instance->m_StreamBuffer)
+        {
+            DeleteStreamBuffer(sound_instance->m_StreamBuffer);
+            sound_instance->m_StreamBuffer = 0;
+        }
         sound_instance->m_FrameCount = 0;
         sound_instance->m_Speed = 1.0f;
 
@@ -815,6 +1479,18 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result SetPriority(HSoundInstance sound_instance, uint8_t priority)
+    {
+        DM_MUTEX_OPTIONAL_SCOPED_LOCK(g_SoundSystem->m_Mutex);
+        sound_instance->m_Priority = priority;
+        return RESULT_OK;
+    }
+
+    bool IsVirtual(HSoundInstance sound_instance)
+    {
+        return sound_instance->m_Virtual;
+    }
+
     Result SetParameter(HSoundInstance sound_instance, Parameter parameter, const Vector4& value)
     {
         bool reset = !sound_instance->m_Playing;
@@ -1101,6 +1777,33 @@ namespace dmSound
         }
     }
 
+    /*
+     * Advances a virtual instance the same number of frames as Mix() would have, without mixing.
+     */
+    static void MixVirtual(SoundInstance* instance, const dmSoundCodec::Info* info)
+    {
+        SoundSystem* sound = g_SoundSystem;
+        uint64_t delta = (uint32_t) ((((uint64_t) info->m_Rate) << RESAMPLE_FRACTION_BITS) / sound->m_MixRate);
+        uint32_t mix_count = ((uint64_t) (instance->m_FrameCount) << RESAMPLE_FRACTION_BITS) / (delta * instance->m_Speed);
+        mix_count = dmMath::Min(mix_count, sound->m_FrameCount);
+
+        uint32_t consumed = mix_count;
+        bool identity_mixer = info->m_Rate == sound->m_MixRate && instance->m_Speed == 1.0f;
+        if (!identity_mixer)
+        {
+            // Same as accumulating the fraction per mixed frame in the resampling mixers
+            delta *= instance->m_Speed;
+            uint64_t frac = instance->m_FrameFraction + delta * mix_count;
+            consumed = (uint32_t) (frac >> RESAMPLE_FRACTION_BITS);
+            instance->m_FrameFraction = frac & ((1U << RESAMPLE_FRACTION_BITS) - 1U);
+        }
+        consumed = dmMath::Min(consumed, instance->m_FrameCount);
+
+        const uint32_t stride = info->m_Channels * (info->m_BitsPerSample / 8);
+        memmove(instance->m_Frames, (char*) instance->m_Frames + consumed * stride, (instance->m_FrameCount - consumed) * stride);
+        instance->m_FrameCount -= consumed;
+    }
+
     static bool IsMuted(SoundInstance* instance) {
         SoundSystem* sound = g_SoundSystem;
 
@@ -1131,27 +1834,43 @@ namespace dmSound
         return false;
     }
 
-    static void MixInstance(const MixContext* mix_context, SoundInstance* instance) {
+    // The read ahead of a streamed sound hasn't caught up. Play silence and continue from the same position next time
+    static void PadStreamUnderrun(SoundInstance* instance, uint32_t stride, uint32_t frame_count, dmSoundCodec::Result* r)
+    {
+        if (*r != dmSoundCodec::RESULT_WOULDBLOCK)
+            return;
+        memset(((char*) instance->m_Frames) + instance->m_FrameCount * stride, 0x00, (frame_count - instance->m_FrameCount) * stride);
+        instance->m_FrameCount = frame_count;
+        *r = dmSoundCodec::RESULT_OK;
+    }
+
+    /*
+     * Decodes the frames needed for the next mix into the instance frame buffer.
+     * Only touches the instance and its decoder, so that instances may be decoded in parallel. See StartDecodeJobs
+     * Returns false if the instance shouldn't be mixed.
+     */
+    static bool DecodeInstance(SoundInstance* instance, dmSoundCodec::Info* out_info) {
         SoundSystem* sound = g_SoundSystem;
         uint32_t decoded = 0;
 
-        dmSoundCodec::Info info;
+        dmSoundCodec::Info& info = *out_info;
         dmSoundCodec::GetInfo(sound->m_CodecContext, instance->m_Decoder, &info);
         bool correct_bit_depth = info.m_BitsPerSample == 16 || info.m_BitsPerSample == 8;
         bool correct_num_channels = info.m_Channels == 1 || info.m_Channels == 2;
         if (!correct_bit_depth || !correct_num_channels) {
             dmLogError("Only mono/stereo with 8/16 bits per sample is supported (%s): %u bpp %u ch", GetSoundName(sound, instance), (uint32_t)info.m_BitsPerSample, (uint32_t)info.m_Channels);
             instance->m_Playing = 0;
-            return;
+            return false;
         }
 
         if (info.m_Rate > sound->m_MixRate) {
             dmLogError("Sounds with rate higher than sample-rate not supported (%d hz > %d hz) (%s)", info.m_Rate, sound->m_MixRate, GetSoundName(sound, instance));
             instance->m_Playing = 0;
-            return;
+            return false;
         }
 
-        bool is_muted = dmSound::IsMuted(instance);
+        // Virtual instances are skipped in the stream in the same way as muted ones
+        bool is_muted = instance->m_Virtual || dmSound::IsMuted(instance);
 
         dmSoundCodec::Result r = dmSoundCodec::RESULT_OK;
         uint32_t mixed_instance_FrameCount = ceilf(sound->m_FrameCount * dmMath::Max(1.0f, instance->m_Speed));
@@ -1177,6 +1896,7 @@ namespace dmSound
 
             assert(decoded % stride == 0);
             instance->m_FrameCount += decoded / stride;
+            PadStreamUnderrun(instance, stride, mixed_instance_FrameCount, &r);
 
             if (instance->m_FrameCount < mixed_instance_FrameCount) {
 
@@ -1203,6 +1923,7 @@ namespace dmSound
 
                     assert(decoded % stride == 0);
                     instance->m_FrameCount += decoded / stride;
+                    PadStreamUnderrun(instance, stride, mixed_instance_FrameCount, &r);
 
                 } else {
 
@@ -1219,11 +1940,19 @@ namespace dmSound
         if (r != dmSoundCodec::RESULT_OK) {
             dmLogWarning("Unable to decode file '%s'. Result %d", GetSoundName(sound, instance), r);
             instance->m_Playing = 0;
-            return;
+            return false;
         }
+        return true;
+    }
 
+    static void MixDecodedInstance(const MixContext* mix_context, SoundInstance* instance, const dmSoundCodec::Info* info) {
         if (instance->m_FrameCount > 0)
-            Mix(mix_context, instance, &info);
+        {
+            if (instance->m_Virtual)
+                MixVirtual(instance, info);
+            else
+                Mix(mix_context, instance, info);
+        }
 
         if (instance->m_FrameCount <= 1 && instance->m_EndOfStream) {
             // NOTE: Due to round-off errors, e.g 32000 -> 44100,
@@ -1233,6 +1962,98 @@ namespace dmSound
         }
     }
 
+    static void MixInstance(const MixContext* mix_context, SoundInstance* instance) {
+        dmSoundCodec::Info info;
+        if (DecodeInstance(instance, &info))
+        {
+            MixDecodedInstance(mix_context, instance, &info);
+        }
+    }
+
+    // Runs the next decode job. Called with m_DecodeMutex held. Returns false if all jobs are taken
+    static bool RunDecodeJob(SoundSystem* sound)
+    {
+        if (sound->m_NextDecodeJob >= sound->m_DecodeJobs.Size())
+            return false;
+
+        DecodeJob* job = &sound->m_DecodeJobs[sound->m_NextDecodeJob++];
+
+        dmMutex::Unlock(sound->m_DecodeMutex);
+        job->m_Mix = DecodeInstance(job->m_Instance, &job->m_Info);
+        dmMutex::Lock(sound->m_DecodeMutex);
+
+        job->m_Done = true;
+        dmConditionVariable::Signal(sound->m_DecodeDone);
+        return true;
+    }
+
+    static void DecodeThread(void* ctx)
+    {
+        SoundSystem* sound = (SoundSystem*)ctx;
+        DM_MUTEX_SCOPED_LOCK(sound->m_DecodeMutex);
+        while (true)
+        {
+            while (sound->m_DecodeThreadsRunning && sound->m_NextDecodeJob >= sound->m_DecodeJobs.Size())
+            {
+                dmConditionVariable::Wait(sound->m_DecodeStart, sound->m_DecodeMutex);
+            }
+            if (!sound->m_DecodeThreadsRunning)
+                break;
+
+            while (RunDecodeJob(sound))
+            {
+            }
+        }
+    }
+
+    /*
+     * Queues all active instances for decoding on the decode threads, and returns without waiting.
+     * The jobs are in instance order, see WaitDecodeJob
+     */
+    static void StartDecodeJobs(SoundSystem* sound)
+    {
+        DM_PROFILE(__FUNCTION__);
+        DM_MUTEX_SCOPED_LOCK(sound->m_DecodeMutex);
+
+        sound->m_DecodeJobs.SetSize(0);
+        uint32_t instances = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (instance->m_Playing || instance->m_FrameCount > 0)
+            {
+                DecodeJob job;
+                job.m_Instance = instance;
+                job.m_Mix = false;
+                job.m_Done = false;
+                sound->m_DecodeJobs.Push(job);
+            }
+        }
+
+        sound->m_NextDecodeJob = 0;
+        if (sound->m_DecodeJobs.Size() > 1)
+        {
+            dmConditionVariable::Broadcast(sound->m_DecodeStart);
+        }
+    }
+
+    /*
+     * Waits until a decode job is done, so that it can be mixed while later jobs are still decoding.
+     * Jobs that no decode thread has taken yet are decoded on the calling thread instead of waiting.
+     */
+    static DecodeJob* WaitDecodeJob(SoundSystem* sound, uint32_t index)
+    {
+        DM_MUTEX_SCOPED_LOCK(sound->m_DecodeMutex);
+        DecodeJob* job = &sound->m_DecodeJobs[index];
+        while (!job->m_Done)
+        {
+            if (!RunDecodeJob(sound))
+            {
+                dmConditionVariable::Wait(sound->m_DecodeDone, sound->m_DecodeMutex);
+            }
+        }
+        return job;
+    }
+
     static void MixInstances(const MixContext* mix_context)
     {
         DM_PROFILE(__FUNCTION__);
@@ -1271,6 +2092,29 @@ namespace dmSound
         }
 
         uint32_t instances = sound->m_Instances.Size();
+        if (sound->m_DecodeThreads.Size() > 0)
+        {
+            StartDecodeJobs(sound);
+
+            // Mixed in instance order, the same as when decoding serially
+            uint32_t jobs = sound->m_DecodeJobs.Size();
+            for (uint32_t i = 0; i < jobs; ++i) {
+                DecodeJob* job = WaitDecodeJob(sound, i);
+                if (job->m_Mix)
+                {
+                    MixDecodedInstance(mix_context, job->m_Instance, &job->m_Info);
+                }
+            }
+
+            for (uint32_t i = 0; i < instances; ++i) {
+                SoundInstance* instance = &sound->m_Instances[i];
+                if (instance->m_EndOfStream && instance->m_FrameCount == 0) {
+                    instance->m_Playing = 0;
+                }
+            }
+            return;
+        }
+
         for (uint32_t i = 0; i < instances; ++i) {
             SoundInstance* instance = &sound->m_Instances[i];
             if (instance->m_Playing || instance->m_FrameCount > 0)
@@ -1367,6 +2211,93 @@ namespace dmSound
         }
     }
 
+    static float GetGroupGain(SoundSystem* sound, dmhash_t group_hash)
+    {
+        int* index = sound->m_GroupMap.Get(group_hash);
+        if (!index)
+            return 0.0f;
+        return sound->m_Groups[*index].m_Gain.m_Current;
+    }
+
+    static inline float GetAudibility(SoundSystem* sound, SoundInstance* instance)
+    {
+        if (instance->m_Speed == 0.0f)
+            return 0.0f;
+        return instance->m_Gain.m_Next * GetGroupGain(sound, instance->m_Group);
+    }
+
+    struct VoicePred
+    {
+        SoundSystem* m_Sound;
+        VoicePred(SoundSystem* sound) : m_Sound(sound) {}
+
+        bool operator ()(SoundInstance* a, SoundInstance* b) const
+        {
+            if (a->m_Priority != b->m_Priority)
+                return a->m_Priority > b->m_Priority;
+            return GetAudibility(m_Sound, a) > GetAudibility(m_Sound, b);
+        }
+    };
+
+    /*
+     * Decides which of the active instances are real (decoded and mixed) and which are virtual.
+     * Inaudible instances are always virtual. If there are more audible instances than m_MaxVoices,
+     * the ones with lowest priority, and then lowest gain, are made virtual.
+     * A real instance is first faded out before it becomes virtual, and a virtual instance is faded in
+     * when it becomes real again. Called once per update, after the values have been stepped.
+     */
+    static void UpdateVoices(SoundSystem* sound)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        sound->m_Voices.SetSize(0);
+        uint32_t instances = sound->m_Instances.Size();
+        for (uint32_t i = 0; i < instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[i];
+            if (instance->m_Playing || instance->m_FrameCount > 0)
+                sound->m_Voices.Push(instance);
+        }
+
+        uint32_t voice_count = sound->m_Voices.Size();
+        uint32_t max_voices = sound->m_MaxVoices > 0 ? sound->m_MaxVoices : voice_count;
+        if (voice_count > max_voices)
+        {
+            std::sort(sound->m_Voices.Begin(), sound->m_Voices.End(), VoicePred(sound));
+        }
+
+        uint32_t real_count = 0;
+        for (uint32_t i = 0; i < voice_count; ++i)
+        {
+            SoundInstance* instance = sound->m_Voices[i];
+            bool real = i < max_voices && GetAudibility(sound, instance) > 0.0f;
+            if (real)
+            {
+                if (instance->m_Virtual)
+                {
+                    instance->m_Gain.m_Prev = 0.0f;
+                    instance->m_Virtual = 0;
+                }
+                ++real_count;
+            }
+            else if (!instance->m_Virtual)
+            {
+                if (instance->m_Gain.m_Prev == 0.0f)
+                {
+                    instance->m_Virtual = 1;
+                }
+                else
+                {
+                    // Fade out during this update, and become virtual on the next
+                    instance->m_Gain.m_Current = 0.0f;
+                    ++real_count;
+                }
+            }
+        }
+
+        DM_PROPERTY_SET_U32(rmtp_SoundVoices, real_count);
+        DM_PROPERTY_SET_U32(rmtp_SoundVirtualVoices, voice_count - real_count);
+    }
+
     static Result UpdateInternal(SoundSystem* sound)
     {
         DM_PROFILE(__FUNCTION__);
@@ -1440,6 +2371,7 @@ namespace dmSound
         if (free_slots > 0) {
             StepGroupValues();
             StepInstanceValues();
+            UpdateVoices(sound);
         }
 
         uint32_t current_buffer = 0;
@@ -1483,7 +2415,10 @@ namespace dmSound
             return RESULT_OK;
 
         if (!sound->m_Thread)
+        {
+            UpdateStreams(sound);
             return UpdateInternal(sound);
+        }
         return sound->m_Status;
     }
 
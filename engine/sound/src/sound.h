@@ -67,9 +67,6 @@ namespace dmSound
 
     const uint32_t MAX_GROUPS = 32;
 
-    // TODO:
-    // - Music streaming.
-
     struct InitializeParams;
     void SetDefaultInitializeParams(InitializeParams* params);
 
@@ -83,6 +80,11 @@ namespace dmSound
         uint32_t m_BufferSize;
         uint32_t m_FrameCount;
         uint32_t m_MaxInstances;
+        uint32_t m_DecodedCacheSize;       // Max total bytes of decoded (PCM) ogg data kept in memory. 0 disables the cache
+        uint32_t m_DecodedCacheThreshold;  // Max decoded size in bytes for a single sound to be cached
+        uint32_t m_MaxVoices;              // Max number of decoded and mixed (real) sound instances. 0 means no limit
+        uint32_t m_StreamingThreshold;     // Min compressed size in bytes for an ogg sound to be streamed. 0 disables streaming
+        uint32_t m_DecodeThreads;          // Number of threads decoding sound instances in parallel with the mixer. 0 decodes on the mixer thread only
         bool     m_UseThread;
 
         InitializeParams()
@@ -103,6 +105,34 @@ namespace dmSound
     // Thread safe
     Result NewSoundData(const void* sound_buffer, uint32_t sound_buffer_size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
     Result SetSoundData(HSoundData sound_data, const void* sound_buffer, uint32_t sound_buffer_size);
+
+    /**
+     * Callback for reading sound data on demand, see NewSoundDataStreaming.
+     * Called from the sound stream thread, or from Update() if threads aren't used. Never called concurrently.
+     * Partial reads are allowed, and nread 0 is treated as an error.
+     */
+    typedef Result (*FSoundDataRead)(void* context, uint32_t offset, uint32_t size, void* buffer, uint32_t* nread);
+
+    /**
+     * Callback for releasing the context of streamed sound data, see NewSoundDataStreaming.
+     */
+    typedef void (*FSoundDataClose)(void* context);
+
+    /**
+     * Create sound data that is read on demand while playing, instead of being kept in memory.
+     * Only supported for ogg sounds. The start of the sound is read before returning, the rest is
+     * read ahead on a separate thread, so the sound thread never waits for the reads.
+     * @param read read callback
+     * @param close close callback. On success, it is called when the sound data is deleted or set
+     * @param context user context passed to the callbacks
+     * @param size size of the compressed sound data
+     * @return RESULT_OK on success
+     */
+    Result NewSoundDataStreaming(FSoundDataRead read, FSoundDataClose close, void* context, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name);
+
+    // Returns the min size for a sound to be streamed (project setting sound.stream_threshold). 0 if streaming is disabled
+    uint32_t GetStreamingThreshold();
+
     uint32_t GetSoundResourceSize(HSoundData sound_data);
     Result DeleteSoundData(HSoundData sound_data);
 
@@ -128,6 +158,11 @@ namespace dmSound
 
     Result SetLooping(HSoundInstance sound_instance, bool looping, int8_t loopcount);
 
+    // Higher priority instances are kept real before lower priority ones when the voice limit is reached
+    Result SetPriority(HSoundInstance sound_instance, uint8_t priority);
+    // True if the instance is playing, but is currently neither decoded nor mixed (i.e. inaudible or culled)
+    bool IsVirtual(HSoundInstance sound_instance);
+
     Result SetParameter(HSoundInstance sound_instance, Parameter parameter, const dmVMath::Vector4& value);
     Result GetParameter(HSoundInstance sound_instance, Parameter parameter, dmVMath::Vector4& value);
 
@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <dlib/array.h>
 #include <dlib/index_pool.h>
 #include <dlib/endian.h>
@@ -90,6 +91,32 @@ namespace dmSoundCodec
         return RESULT_OK;
     }
 
+    Result NewStreamingDecoder(HCodecContext context, Format format, FStreamRead read, void* read_context, uint32_t stream_size, HDecoder* decoder)
+    {
+        if (context->m_DecodersPool.Remaining() == 0) {
+            return RESULT_OUT_OF_RESOURCES;
+        }
+
+        const DecoderInfo* decoderImpl = FindBestStreamingDecoder(format);
+        if (!decoderImpl) {
+            return RESULT_UNSUPPORTED;
+        }
+
+        uint16_t index = context->m_DecodersPool.Pop();
+        Decoder* d = &context->m_Decoders[index];
+        d->m_Index = index;
+        d->m_DecoderInfo = decoderImpl;
+
+        Result r = decoderImpl->m_OpenStreamingStream(read, read_context, stream_size, &d->m_Stream);
+        if (r != RESULT_OK) {
+            context->m_DecodersPool.Push(index);
+            return r;
+        }
+
+        *decoder = d;
+        return RESULT_OK;
+    }
+
     void GetInfo(HCodecContext context, HDecoder decoder, Info* info)
     {
         assert(decoder);
@@ -116,6 +143,66 @@ namespace dmSoundCodec
         return decoder->m_DecoderInfo->m_ResetStream(decoder->m_Stream);
     }
 
+    Result DecodeToBuffer(Format format, const void* buffer, uint32_t buffer_size, uint32_t offset, uint32_t max_size, Info* info, void** out, uint32_t* out_size)
+    {
+        DM_PROFILE(__FUNCTION__);
+
+        const DecoderInfo* decoderImpl = FindBestDecoder(format);
+        if (!decoderImpl) {
+            return RESULT_UNSUPPORTED;
+        }
+
+        HDecodeStream stream;
+        Result r = decoderImpl->m_OpenStream(buffer, buffer_size, &stream);
+        if (r != RESULT_OK) {
+            return r;
+        }
+        decoderImpl->m_GetStreamInfo(stream, info);
+
+        const uint32_t stride = info->m_Channels * (info->m_BitsPerSample / 8);
+        if (stride == 0) {
+            decoderImpl->m_CloseStream(stream);
+            return RESULT_INVALID_FORMAT;
+        }
+
+        // Decode in chunks and grow the buffer as needed, since the decompressed size is unknown for e.g. ogg streams
+        const uint32_t chunk_size = stride * 4096;
+        uint32_t capacity = offset + chunk_size;
+        uint32_t size = offset;
+        char* data = (char*) malloc(capacity);
+
+        while (true) {
+            if (capacity - size < chunk_size) {
+                capacity = dmMath::Max(capacity * 2, size + chunk_size);
+                data = (char*) realloc(data, capacity);
+            }
+
+            uint32_t decoded = 0;
+            r = decoderImpl->m_DecodeStream(stream, data + size, chunk_size, &decoded);
+            if (r != RESULT_OK || decoded == 0) {
+                break;
+            }
+
+            size += decoded;
+            if (size - offset > max_size) {
+                r = RESULT_OUT_OF_RESOURCES;
+                break;
+            }
+        }
+
+        decoderImpl->m_CloseStream(stream);
+
+        if (r != RESULT_OK) {
+            free(data);
+            return r;
+        }
+
+        info->m_Size = size - offset;
+        *out = realloc(data, size);
+        *out_size = size;
+        return RESULT_OK;
+    }
+
     void DeleteDecoder(HCodecContext context, HDecoder decoder)
     {
         assert(decoder);
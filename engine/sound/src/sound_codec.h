@@ -35,6 +35,7 @@ namespace dmSoundCodec
         RESULT_INVALID_FORMAT = -2,  //!< RESULT_INVALID_FORMAT
         RESULT_DECODE_ERROR = -3,    //!< RESULT_DECODE_ERROR
         RESULT_UNSUPPORTED = -4,     //!< RESULT_UNSUPPORTED
+        RESULT_WOULDBLOCK = -5,      //!< RESULT_WOULDBLOCK
         RESULT_UNKNOWN_ERROR = -1000,//!< RESULT_UNKNOWN_ERROR
     };
 
@@ -62,6 +63,18 @@ namespace dmSoundCodec
         uint8_t  m_BitsPerSample;
     };
 
+    /**
+     * Callback used by streaming decoders to read compressed data on demand
+     * @param context user context
+     * @param offset offset in the compressed stream
+     * @param buffer buffer to read to
+     * @param buffer_size number of bytes to read
+     * @param nread actual number of bytes read. 0 at end of stream
+     * @return RESULT_OK on success. RESULT_WOULDBLOCK if the data isn't available yet, in which case
+     *         decoding stops with RESULT_WOULDBLOCK and may be retried later
+     */
+    typedef Result (*FStreamRead)(void* context, uint32_t offset, void* buffer, uint32_t buffer_size, uint32_t* nread);
+
     /**
      * Parameters for new codec context
      */
@@ -100,6 +113,18 @@ namespace dmSoundCodec
      */
     Result NewDecoder(HCodecContext context, Format format, const void* buffer, uint32_t buffer_size, HDecoder* decoder);
 
+    /**
+     * Create a new decoder that reads the compressed stream on demand, instead of from a buffer in memory
+     * @param context context
+     * @param format format
+     * @param read read callback
+     * @param read_context user context passed to the read callback
+     * @param stream_size size of the compressed stream
+     * @param decoder decoder (out)
+     * @return RESULT_OK on success. RESULT_UNSUPPORTED if no decoder supports streaming the format
+     */
+    Result NewStreamingDecoder(HCodecContext context, Format format, FStreamRead read, void* read_context, uint32_t stream_size, HDecoder* decoder);
+
     /**
      * Delete decoder
      * @param context context
@@ -122,7 +147,7 @@ namespace dmSoundCodec
      * @param buffer buffer
      * @param buffer_size buffer size in bytes
      * @param decoded actual bytes decoded
-     * @return RESULT_OK on success
+     * @return RESULT_OK on success. RESULT_WOULDBLOCK if a streaming decoder ran out of data before the end of the stream
      */
     Result Decode(HCodecContext context, HDecoder decoder, char* buffer, uint32_t buffer_size, uint32_t* decoded);
 
@@ -143,6 +168,21 @@ namespace dmSoundCodec
      * @return RESULT_OK on success
      */
     Result Reset(HCodecContext context, HDecoder decoder);
+
+    /**
+     * Decode a complete stream into a newly allocated buffer. Does not use any decoder slot in a context
+     * and may be called from any thread.
+     * @param format format
+     * @param buffer compressed buffer
+     * @param buffer_size compressed buffer size
+     * @param offset number of bytes to reserve (uninitialized) at the start of the output buffer
+     * @param max_size max number of decoded bytes. RESULT_OUT_OF_RESOURCES is returned if the stream is larger
+     * @param info info (out). m_Size is set to the number of decoded bytes
+     * @param out decoded buffer (out). Free with free()
+     * @param out_size size of decoded buffer, including offset (out)
+     * @return RESULT_OK on success
+     */
+    Result DecodeToBuffer(Format format, const void* buffer, uint32_t buffer_size, uint32_t offset, uint32_t max_size, Info* info, void** out, uint32_t* out_size);
 }
 
 #endif // #ifndef DM_SOUND_CODEC_H
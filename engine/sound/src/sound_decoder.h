@@ -77,6 +77,12 @@ namespace dmSoundCodec
          */
         void (*m_GetStreamInfo)(HDecodeStream, struct Info* out);
 
+        /**
+         * Open a stream for decoding, reading the compressed data on demand.
+         * Optional, 0 if the decoder doesn't support streaming.
+         */
+        Result (*m_OpenStreamingStream)(FStreamRead read, void* read_context, uint32_t size, HDecodeStream* out);
+
         DecoderInfo *m_Next;
     };
 
@@ -90,6 +96,12 @@ namespace dmSoundCodec
      */
     const DecoderInfo* FindBestDecoder(Format format);
 
+    /**
+     * Finds the best match for a stream among all registered decoders that support streaming.
+     * Returns 0 if no such decoder exists.
+     */
+    const DecoderInfo* FindBestStreamingDecoder(Format format);
+
     /**
      * Get by name of implementation
      */
@@ -119,7 +131,7 @@ namespace dmSoundCodec
     /**
      * Declare a new stream decoder
      */
-    #define DM_DECLARE_SOUND_DECODER(symbol, name, format, score, open, close, decode, reset, skip, getinfo) \
+    #define DM_DECLARE_SOUND_DECODER(symbol, name, format, score, open, close, decode, reset, skip, getinfo, openstreaming) \
             dmSoundCodec::DecoderInfo DM_SOUND_PASTE2(symbol, __LINE__) = { \
                     name, \
                     format, \
@@ -130,6 +142,7 @@ namespace dmSoundCodec
                     reset, \
                     skip, \
                     getinfo, \
+                    openstreaming, \
             };\
         DM_REGISTER_SOUND_DECODER(symbol, DM_SOUND_PASTE2(symbol, __LINE__))
 }
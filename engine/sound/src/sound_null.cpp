@@ -83,6 +83,17 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result NewSoundDataStreaming(FSoundDataRead read, FSoundDataClose close, void* context, uint32_t size, SoundDataType type, HSoundData* sound_data, dmhash_t name)
+    {
+        *sound_data = 0;
+        return RESULT_UNSUPPORTED;
+    }
+
+    uint32_t GetStreamingThreshold()
+    {
+        return 0;
+    }
+
     uint32_t GetSoundResourceSize(HSoundData sound_data)
     {
         return sizeof(SoundData) + sound_data->m_BufferSize;
@@ -222,6 +233,19 @@ namespace dmSound
         return RESULT_OK;
     }
 
+    Result SetPriority(HSoundInstance sound_instance, uint8_t priority)
+    {
+        (void)sound_instance;
+        (void)priority;
+        return RESULT_OK;
+    }
+
+    bool IsVirtual(HSoundInstance sound_instance)
+    {
+        (void)sound_instance;
+        return false;
+    }
+
     Result SetParameter(HSoundInstance sound_instance, Parameter parameter, const Vector4& value)
     {
         sound_instance->m_Parameters[parameter] = value;